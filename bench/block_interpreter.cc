@@ -0,0 +1,274 @@
+#include "harpoon/execution/block_interpreter.hh"
+#include "harpoon/execution/decode_cache.hh"
+#include "harpoon/execution/jit_compiler.hh"
+#include "harpoon/execution/processing_unit.hh"
+#include "harpoon/memory/linear_random_access_memory.hh"
+#include "harpoon/memory/main_memory.hh"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace {
+
+using harpoon::execution::instruction;
+using harpoon::execution::jit_context;
+using harpoon::execution::threaded_op;
+
+struct operands {
+	std::uint8_t r;
+	std::uint8_t n;
+	std::uint16_t a;
+};
+
+struct cpu_state {
+	std::uint32_t registers[4];
+	std::uint16_t pc;
+};
+
+/* add r, n (01 r n), dec r (02 r) and jnz r, a (03 r a a), one cycle each. */
+class cpu : public harpoon::execution::processing_unit,
+            public harpoon::execution::jit_translator {
+public:
+	explicit cpu(const harpoon::memory::main_memory_ptr &main_memory)
+	    : harpoon::execution::processing_unit("cpu"), _main_memory(main_memory) {}
+
+	cpu_state regs{};
+
+	virtual void step(harpoon::hardware_component *) override {}
+
+	/* The single instruction path: decode through the cache, then run the steps. */
+	bool run_instruction(harpoon::execution::decode_cache &cache) {
+		const instruction &prototype = cache.get(regs.pc, 0, [this](std::size_t &length) {
+			instruction i(nullptr);
+			operands o{};
+			switch (decode(regs.pc, o, length)) {
+			case 0x01:
+				i.add_step(instruction::no_delay, instruction::member_step<cpu, &cpu::add_step>);
+				break;
+			case 0x02:
+				i.add_step(instruction::no_delay, instruction::member_step<cpu, &cpu::dec_step>);
+				break;
+			case 0x03:
+				i.add_step(instruction::no_delay, instruction::member_step<cpu, &cpu::jnz_step>);
+				break;
+			}
+			i.set_operands(o);
+			return i;
+		});
+		if (!prototype.get_step_count()) {
+			return false;
+		}
+		set_current_instruction(prototype);
+		while (!get_current_instruction().done()) {
+			execute_instruction();
+		}
+		return true;
+	}
+
+	virtual harpoon::memory::address get_block_address() const override {
+		return regs.pc;
+	}
+
+	virtual std::size_t translate(harpoon::memory::address address,
+	                              harpoon::execution::block_cache::mode, threaded_op &op,
+	                              bool &ends_block) override {
+		operands o{};
+		std::size_t length = 0;
+		switch (decode(address, o, length)) {
+		case 0x01:
+			op.execute = threaded_op::member_handler<cpu, &cpu::add_op>;
+			break;
+		case 0x02:
+			op.execute = threaded_op::member_handler<cpu, &cpu::dec_op>;
+			break;
+		case 0x03:
+			op.execute = threaded_op::member_handler<cpu, &cpu::jnz_op>;
+			ends_block = true;
+			break;
+		default:
+			return 0;
+		}
+		op.set_operands(o);
+		return length;
+	}
+
+	virtual void *get_jit_state() override {
+		return &regs;
+	}
+
+	virtual std::size_t emit(harpoon::memory::address address,
+	                         harpoon::execution::block_cache::mode, jit_context &c) override {
+		using alu = harpoon::execution::x86_64_assembler::alu;
+		using mem = harpoon::execution::x86_64_assembler::mem;
+		operands o{};
+		std::size_t length = 0;
+		std::uint8_t opcode = decode(address, o, length);
+		const mem r{jit_context::state_register,
+		            static_cast<std::int32_t>(offsetof(cpu_state, registers) + o.r * 4)};
+		const mem pc{jit_context::state_register, offsetof(cpu_state, pc)};
+		switch (opcode) {
+		case 0x01:
+			c.op(alu::ADD, r, o.n, 32);
+			c.op(alu::ADD, pc, 3, 16);
+			break;
+		case 0x02:
+			c.op(alu::SUB, r, 1, 32);
+			c.op(alu::ADD, pc, 2, 16);
+			break;
+		case 0x03: {
+			auto taken = c.new_label(), next = c.new_label();
+			c.op(alu::CMP, r, 0, 32);
+			c.jump(harpoon::execution::x86_64_assembler::condition::NE, taken);
+			c.op(alu::ADD, pc, 4, 16);
+			c.jump(next);
+			c.bind(taken);
+			c.mov(pc, o.a, 16);
+			c.bind(next);
+			break;
+		}
+		default:
+			return 0;
+		}
+		c.emit_cycles(1);
+		return length;
+	}
+
+private:
+	std::uint8_t decode(harpoon::memory::address address, operands &o, std::size_t &length) {
+		std::uint8_t bytes[4];
+		for (harpoon::memory::address i = 0; i < 4; i++) {
+			_main_memory->get(address + i, bytes[i]);
+		}
+		o = {static_cast<std::uint8_t>(bytes[1] & 3), bytes[2],
+		     static_cast<std::uint16_t>(bytes[2] | bytes[3] << 8)};
+		length = bytes[0] == 0x01 ? 3 : bytes[0] == 0x02 ? 2 : 4;
+		return bytes[0];
+	}
+
+	void add(const operands &o) {
+		regs.registers[o.r] += o.n;
+		regs.pc = static_cast<std::uint16_t>(regs.pc + 3);
+	}
+
+	void dec(const operands &o) {
+		regs.registers[o.r]--;
+		regs.pc = static_cast<std::uint16_t>(regs.pc + 2);
+	}
+
+	void jnz(const operands &o) {
+		regs.pc = regs.registers[o.r] ? o.a : static_cast<std::uint16_t>(regs.pc + 4);
+	}
+
+	std::uint32_t add_step(instruction &i) {
+		add(i.get_operands<operands>());
+		return 1;
+	}
+
+	std::uint32_t dec_step(instruction &i) {
+		dec(i.get_operands<operands>());
+		return 1;
+	}
+
+	std::uint32_t jnz_step(instruction &i) {
+		jnz(i.get_operands<operands>());
+		return 1;
+	}
+
+	std::uint32_t add_op(const threaded_op &op) {
+		add(op.get_operands<operands>());
+		return 1;
+	}
+
+	std::uint32_t dec_op(const threaded_op &op) {
+		dec(op.get_operands<operands>());
+		return 1;
+	}
+
+	std::uint32_t jnz_op(const threaded_op &op) {
+		jnz(op.get_operands<operands>());
+		return 1;
+	}
+
+	harpoon::memory::main_memory_ptr _main_memory;
+};
+
+template<typename Run>
+void run(const std::string &name, cpu &processing_unit, std::uint32_t rounds, Run &&run) {
+	processing_unit.regs = {{rounds}, 0x0100};
+	auto instructions = processing_unit.get_executed_instructions();
+
+	auto start = std::chrono::steady_clock::now();
+	run();
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	instructions = processing_unit.get_executed_instructions() - instructions;
+	std::cout << std::left << std::setw(8) << name << std::right << std::fixed
+	          << std::setprecision(1) << std::setw(10)
+	          << static_cast<double>(instructions) / elapsed.count() / 1e6
+	          << " M instructions/s" << std::setw(12) << instructions << " instructions\n";
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+	std::uint32_t rounds = argc > 1 ? static_cast<std::uint32_t>(std::strtoul(argv[1], nullptr, 0))
+	                                : 4000000;
+	if (argc > 2 || !rounds) {
+		std::cerr << "Usage: " << argv[0] << " [loop rounds]" << std::endl;
+		return 1;
+	}
+
+	try {
+		auto main_memory = harpoon::memory::make_main_memory("main-memory");
+		main_memory->add_memory(harpoon::memory::make_linear_random_access_memory(
+		    "ram", harpoon::memory::address_range(0x0000, 0xffff)));
+		main_memory->prepare();
+
+		/* Six additions and the loop counter, then an unknown opcode. */
+		const std::uint8_t program[] = {0x01, 1, 1, 0x01, 2, 3, 0x01, 3, 5, 0x01, 1, 7,
+		                                0x01, 2, 9, 0x01, 3, 2, 0x02, 0, 0x03, 0, 0x00, 0x01,
+		                                0xff};
+		harpoon::memory::address address = 0x0100;
+		for (auto byte : program) {
+			main_memory->set(address++, byte);
+		}
+
+		cpu processing_unit(main_memory);
+
+		harpoon::execution::decode_cache cache;
+		cache.attach(main_memory);
+		run("single", processing_unit, rounds, [&processing_unit, &cache]() {
+			while (processing_unit.run_instruction(cache)) {
+			}
+		});
+
+		auto blocks = harpoon::execution::make_block_interpreter();
+		blocks->attach(main_memory);
+		processing_unit.set_block_interpreter(blocks);
+		run("blocks", processing_unit, rounds, [&processing_unit]() {
+			while (processing_unit.run_blocks(processing_unit, 10000)) {
+			}
+		});
+
+		if (harpoon::execution::jit_compiler::is_supported()) {
+			blocks->set_jit_compiler(harpoon::execution::make_jit_compiler());
+			run("jit", processing_unit, rounds, [&processing_unit]() {
+				while (processing_unit.run_blocks(processing_unit, 10000)) {
+				}
+			});
+		}
+
+		blocks->detach();
+		cache.detach();
+		main_memory->cleanup();
+	} catch (std::exception &error) {
+		std::cerr << error.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
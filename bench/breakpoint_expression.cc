@@ -0,0 +1,91 @@
+#include "harpoon/execution/breakpoint_expression.hh"
+#include "harpoon/execution/processing_unit.hh"
+#include "harpoon/memory/linear_random_access_memory.hh"
+#include "harpoon/memory/main_memory.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace {
+
+class cpu : public harpoon::execution::processing_unit {
+public:
+	cpu() : harpoon::execution::processing_unit("cpu") {}
+
+	std::uint16_t pc{};
+	std::uint8_t a{};
+	std::uint16_t hl{};
+
+	virtual void step(harpoon::hardware_component *) override {}
+
+	virtual harpoon::memory::address get_program_counter() const override {
+		return pc;
+	}
+};
+
+void run(const std::string &name, cpu &processing_unit, std::uint32_t rounds,
+         const std::function<bool(harpoon::execution::processing_unit *)> &condition) {
+	std::uint32_t hits = 0;
+	auto start = std::chrono::steady_clock::now();
+	for (std::uint32_t i = 0; i < rounds; i++) {
+		processing_unit.pc = static_cast<std::uint16_t>(i);
+		hits += condition(&processing_unit);
+	}
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	std::cout << std::left << std::setw(48) << name << std::right << std::fixed
+	          << std::setprecision(1) << std::setw(8) << elapsed.count() * 1e9 / rounds
+	          << " ns" << std::setw(10) << hits << " hits\n";
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+	std::uint32_t rounds = argc > 1 ? static_cast<std::uint32_t>(std::strtoul(argv[1], nullptr, 0))
+	                                : 10000000;
+	if (argc > 2 || !rounds) {
+		std::cerr << "Usage: " << argv[0] << " [evaluations]" << std::endl;
+		return 1;
+	}
+
+	try {
+		auto main_memory = harpoon::memory::make_main_memory("main-memory");
+		main_memory->add_memory(harpoon::memory::make_linear_random_access_memory(
+		    "ram", harpoon::memory::address_range(0x0000, 0xffff)));
+		main_memory->prepare();
+		main_memory->set(0x4002, std::uint16_t{0x1234});
+
+		cpu processing_unit;
+		processing_unit.a = 3;
+		processing_unit.hl = 0x4000;
+
+		harpoon::execution::breakpoint_expression::symbols symbols;
+		symbols.add_register("a", processing_unit.a);
+		symbols.add_register("hl", processing_unit.hl);
+		symbols.set_memory(main_memory);
+
+		/* The C++ condition a user would otherwise have to write and build. */
+		run("c++: a == 3 && mem16[hl + 2] == 0x1234 && pc & 1", processing_unit, rounds,
+		    [&processing_unit, &main_memory](harpoon::execution::processing_unit *) {
+			    std::uint16_t value;
+			    main_memory->get(processing_unit.hl + 2, value);
+			    return processing_unit.a == 3 && value == 0x1234 && (processing_unit.pc & 1);
+		    });
+		for (const char *expression :
+		     {"a == 3", "a == 3 && pc & 1", "a == 3 && mem16[hl + 2] == 0x1234 && pc & 1"}) {
+			run(expression, processing_unit, rounds,
+			    harpoon::execution::breakpoint_expression(expression, symbols));
+		}
+
+		main_memory->cleanup();
+	} catch (std::exception &error) {
+		std::cerr << error.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
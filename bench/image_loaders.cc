@@ -0,0 +1,163 @@
+#include "harpoon/memory/deserializer/elf_file.hh"
+#include "harpoon/memory/deserializer/hex_file.hh"
+#include "harpoon/memory/deserializer/srec_file.hh"
+#include "harpoon/memory/linear_random_access_memory.hh"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+const char digits[] = "0123456789ABCDEF";
+
+void put_byte(std::string &line, std::uint8_t byte, unsigned int &sum) {
+	line += digits[byte >> 4];
+	line += digits[byte & 0xf];
+	sum += byte;
+}
+
+std::string make_hex(const std::vector<std::uint8_t> &data) {
+	std::string contents, line;
+	for (std::size_t a = 0; a < data.size(); a += 32) {
+		unsigned int sum = 0;
+		if ((a & 0xffff) == 0) {
+			line = ":";
+			for (std::uint8_t b : {0x02, 0x00, 0x00, 0x04, static_cast<int>(a >> 24) & 0xff,
+			                       static_cast<int>(a >> 16) & 0xff}) {
+				put_byte(line, b, sum);
+			}
+			put_byte(line, static_cast<std::uint8_t>(-sum), sum);
+			contents += line + "\n";
+			sum = 0;
+		}
+
+		line = ":";
+		put_byte(line, 32, sum);
+		put_byte(line, static_cast<std::uint8_t>(a >> 8), sum);
+		put_byte(line, static_cast<std::uint8_t>(a), sum);
+		put_byte(line, 0, sum);
+		for (std::size_t i = 0; i < 32; i++) {
+			put_byte(line, data[a + i], sum);
+		}
+		put_byte(line, static_cast<std::uint8_t>(-sum), sum);
+		contents += line + "\n";
+	}
+	return contents + ":00000001FF\n";
+}
+
+std::string make_srec(const std::vector<std::uint8_t> &data) {
+	std::string contents, line;
+	for (std::size_t a = 0; a < data.size(); a += 32) {
+		unsigned int sum = 0;
+		line = "S3";
+		put_byte(line, 32 + 5, sum);
+		for (int shift = 24; shift >= 0; shift -= 8) {
+			put_byte(line, static_cast<std::uint8_t>(a >> shift), sum);
+		}
+		for (std::size_t i = 0; i < 32; i++) {
+			put_byte(line, data[a + i], sum);
+		}
+		put_byte(line, static_cast<std::uint8_t>(~sum), sum);
+		contents += line + "\n";
+	}
+	return contents + "S70500000000FA\n";
+}
+
+std::string make_elf(const std::vector<std::uint8_t> &data) {
+	/* ELF32, little endian, one loadable segment right after the headers. */
+	std::vector<std::uint8_t> header(52 + 32);
+	auto put = [&header](std::size_t position, std::uint32_t value, std::size_t length) {
+		for (std::size_t i = 0; i < length; i++) {
+			header[position + i] = static_cast<std::uint8_t>(value >> (8 * i));
+		}
+	};
+	header[0] = 0x7f;
+	header[1] = 'E';
+	header[2] = 'L';
+	header[3] = 'F';
+	header[4] = 1;
+	header[5] = 1;
+	header[6] = 1;
+	put(28, 52, 4);
+	put(42, 32, 2);
+	put(44, 1, 2);
+	put(52, 1, 4);
+	put(56, static_cast<std::uint32_t>(header.size()), 4);
+	put(68, static_cast<std::uint32_t>(data.size()), 4);
+	put(72, static_cast<std::uint32_t>(data.size()), 4);
+
+	std::string contents(header.begin(), header.end());
+	return contents + std::string(data.begin(), data.end());
+}
+
+void run(const std::string &name, const std::string &file_name, const std::string &contents,
+         std::size_t length,
+         const std::function<harpoon::memory::deserializer::deserializer_ptr()> &open) {
+	{
+		std::ofstream output(file_name, std::ios::binary);
+		output << contents;
+	}
+
+	auto memory = harpoon::memory::make_linear_random_access_memory(
+	    "ram", harpoon::memory::address_range(0, length - 1));
+	memory->prepare();
+
+	auto start = std::chrono::steady_clock::now();
+	auto loader = open();
+	auto parsed = std::chrono::steady_clock::now();
+	memory->deserialize(*loader);
+	auto loaded = std::chrono::steady_clock::now();
+	memory->cleanup();
+	std::remove(file_name.c_str());
+
+	std::chrono::duration<double> parse = parsed - start, load = loaded - parsed;
+	double file_mib = static_cast<double>(contents.size()) / 1048576;
+	std::cout << std::left << std::setw(8) << name << std::right << std::fixed
+	          << std::setprecision(1) << std::setw(10) << file_mib << " MiB file"
+	          << std::setw(10) << file_mib / parse.count() << " MiB/s parse" << std::setw(10)
+	          << static_cast<double>(length) / 1048576 / load.count() << " MiB/s load\n";
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+	std::size_t mib = argc > 1 ? std::strtoul(argv[1], nullptr, 0) : 64;
+	if (argc > 2 || !mib) {
+		std::cerr << "Usage: " << argv[0] << " [image size in MiB]" << std::endl;
+		return 1;
+	}
+
+	std::size_t length = mib * 1048576;
+	std::vector<std::uint8_t> data(length);
+	std::uint32_t x = 0x12345678;
+	for (auto &b : data) {
+		x = x * 1664525 + 1013904223;
+		b = static_cast<std::uint8_t>(x >> 24);
+	}
+
+	try {
+		namespace deserializer = harpoon::memory::deserializer;
+		std::string file_name = "harpoon-bench-image";
+		run("hex", file_name, make_hex(data), length, [&file_name]() {
+			return std::make_shared<deserializer::hex_file>(file_name);
+		});
+		run("srec", file_name, make_srec(data), length, [&file_name]() {
+			return std::make_shared<deserializer::srec_file>(file_name);
+		});
+		run("elf", file_name, make_elf(data), length, [&file_name]() {
+			return std::make_shared<deserializer::elf_file>(file_name);
+		});
+	} catch (std::exception &error) {
+		std::cerr << error.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
@@ -0,0 +1,147 @@
+#include "harpoon/execution/instruction_decoder.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace {
+
+/* An 8080 style instruction set with a Z80 style 0xcb page. */
+const char *const patterns[] = {
+    "00000000",
+    "00rr0001 nnnnnnnn nnnnnnnn",
+    "00rr0010",
+    "00rr0011",
+    "00ddd100",
+    "00ddd101",
+    "00ddd110 nnnnnnnn",
+    "00000111",
+    "00rr1001",
+    "00rr1010",
+    "00rr1011",
+    "00001111",
+    "00010111",
+    "00011111",
+    "00100010 nnnnnnnn nnnnnnnn",
+    "00101010 nnnnnnnn nnnnnnnn",
+    "00110010 nnnnnnnn nnnnnnnn",
+    "00111010 nnnnnnnn nnnnnnnn",
+    "01110110",
+    "01dddsss",
+    "10ooosss",
+    "11ccc000",
+    "11rr0001",
+    "11ccc010 nnnnnnnn nnnnnnnn",
+    "11000011 nnnnnnnn nnnnnnnn",
+    "11ccc100 nnnnnnnn nnnnnnnn",
+    "11rr0101",
+    "11ooo110 nnnnnnnn",
+    "11nnn111",
+    "11001001",
+    "11001101 nnnnnnnn nnnnnnnn",
+    "11001011 00ooorrr",
+    "11001011 01bbbrrr",
+    "11001011 10bbbrrr",
+    "11001011 11bbbrrr",
+    "11011101 11001011 dddddddd 00ooo110",
+    "11011101 11001011 dddddddd 01bbb110",
+};
+
+using decoder = harpoon::execution::instruction_decoder<std::uint8_t, std::uint32_t>;
+
+/* What a switch-less hand written decoder does: try every pattern in priority order. */
+class linear_decoder {
+public:
+	explicit linear_decoder(const std::vector<harpoon::execution::opcode_pattern> &patterns)
+	    : _patterns(patterns) {
+		std::stable_sort(_patterns.begin(), _patterns.end(), [](const auto &a, const auto &b) {
+			return a.get_specificity() > b.get_specificity();
+		});
+	}
+
+	std::size_t decode(const std::uint8_t *units) const {
+		for (const auto &p : _patterns) {
+			if (p.matches(units)) {
+				return p.get_length();
+			}
+		}
+		return 0;
+	}
+
+private:
+	std::vector<harpoon::execution::opcode_pattern> _patterns;
+};
+
+template<typename Decode>
+void run(const std::string &name, const std::vector<std::uint8_t> &program, Decode &&decode) {
+	auto start = std::chrono::steady_clock::now();
+	std::size_t instructions = 0, undefined = 0;
+	for (std::size_t pc = 0; pc + 4 <= program.size();) {
+		std::size_t length = decode(program.data() + pc);
+		if (!length) {
+			undefined++;
+			length = 1;
+		}
+		pc += length;
+		instructions++;
+	}
+	std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+	std::cout << std::left << std::setw(8) << name << std::right << std::fixed
+	          << std::setprecision(1) << std::setw(10)
+	          << static_cast<double>(instructions) / elapsed.count() / 1e6 << " M decodes/s"
+	          << std::setw(12) << instructions << " instructions" << std::setw(10) << undefined
+	          << " undefined\n";
+}
+
+} // namespace
+
+int main(int argc, char *argv[]) {
+	std::size_t mib = argc > 1 ? std::strtoul(argv[1], nullptr, 0) : 16;
+	if (argc > 2 || !mib) {
+		std::cerr << "Usage: " << argv[0] << " [program size in MiB]" << std::endl;
+		return 1;
+	}
+
+	std::vector<std::uint8_t> program(mib * 1048576);
+	std::uint32_t x = 0x12345678;
+	for (auto &b : program) {
+		x = x * 1664525 + 1013904223;
+		b = static_cast<std::uint8_t>(x >> 24);
+	}
+
+	try {
+		decoder d;
+		std::vector<harpoon::execution::opcode_pattern> all;
+		for (const char *p : patterns) {
+			all.emplace_back(p, 8);
+			d.add(all.back(), static_cast<std::uint32_t>(all.size()));
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		d.build();
+		std::chrono::duration<double> build = std::chrono::steady_clock::now() - start;
+		std::cout << all.size() << " patterns, " << d.get_table_count() << " tables, built in "
+		          << std::fixed << std::setprecision(2) << build.count() * 1000 << " ms\n";
+
+		std::uint8_t units[4];
+		run("tables", program, [&d, &units](const std::uint8_t *buffer) -> std::size_t {
+			auto e = d.decode_buffer(buffer, units);
+			return e ? e->pattern.get_length() : 0;
+		});
+
+		linear_decoder linear(all);
+		run("linear", program, [&linear](const std::uint8_t *buffer) {
+			return linear.decode(buffer);
+		});
+	} catch (std::exception &error) {
+		std::cerr << error.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}
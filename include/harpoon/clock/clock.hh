@@ -6,6 +6,7 @@
 #include "harpoon/clock/cycle.hh"
 #include "harpoon/hardware_component.hh"
 
+#include <deque>
 #include <functional>
 #include <map>
 
@@ -15,6 +16,7 @@ namespace clock {
 class clock : public hardware_component {
 public:
 	using step_handler = std::function<void(clock *)>;
+	using event_id = std::uint32_t;
 
 	using hardware_component::hardware_component;
 	clock(std::uint64_t frequency = 1, const std::string &name = "")
@@ -36,6 +38,13 @@ public:
 	virtual void shutdown() override;
 	virtual void step(hardware_component *trigger) override;
 
+	/*
+	 * Events scheduled by id can be saved with the machine state, closures
+	 * cannot. Ids are handed out in registration order, so a machine built the
+	 * same way gets the same ids.
+	 */
+	event_id register_event(step_handler &&fn);
+	void schedule(std::uint64_t delay, phase_t phase, event_id event);
 	void schedule(std::uint64_t delay, phase_t phase, step_handler &&fn);
 
 	virtual void log_state(log::message::Level level) const override;
@@ -45,11 +54,21 @@ public:
 protected:
 	void next_tick();
 
+	virtual void save_state(harpoon::state::writer &writer) const override;
+	virtual void restore_state(harpoon::state::reader &reader) override;
+
 private:
+	/* Event zero stands for an unregistered closure. */
+	struct scheduled_event {
+		event_id event;
+		step_handler fn;
+	};
+
 	std::uint64_t _frequency{};
 	cycle _cycle{};
 
-	std::multimap<std::pair<tick_t, phase_t>, step_handler> _handlers{};
+	std::multimap<std::pair<tick_t, phase_t>, scheduled_event> _handlers{};
+	std::deque<step_handler> _events{};
 };
 
 using clock_ptr = std::shared_ptr<clock>;
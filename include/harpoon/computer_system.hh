@@ -6,6 +6,8 @@
 #include "harpoon/execution/execution_unit.hh"
 #include "harpoon/hardware_component.hh"
 #include "harpoon/memory/memory.hh"
+#include "harpoon/state/machine_state.hh"
+#include "harpoon/state/rewind_buffer.hh"
 
 namespace harpoon {
 
@@ -27,13 +29,59 @@ public:
 
 	virtual void step(hardware_component *trigger) override;
 
+	/*
+	 * Save all component states and the main memory contents. Must be called
+	 * between steps, with no instruction in flight.
+	 */
+	harpoon::state::machine_state_ptr save_machine_state();
+	void restore_machine_state(const harpoon::state::machine_state &machine_state);
+
+	/*
+	 * Digest of the component states and the main memory contents, comparable
+	 * with machine_state::get_digest(). Like saving, it needs no instruction
+	 * in flight.
+	 */
+	std::uint64_t get_digest();
+
+	/*
+	 * Append the main memory ranges that differ from the other machine or the
+	 * saved state, and return whether the component states are equal.
+	 */
+	bool diff(computer_system &other, std::vector<memory::address_range> &ranges);
+	bool diff(const harpoon::state::machine_state &machine_state,
+	          std::vector<memory::address_range> &ranges);
+
+	/*
+	 * Capture a rewind point every interval ticks, at the first step after the
+	 * interval has passed where no instruction is in flight. History is kept
+	 * within budget bytes; the main memory provides the dirty ranges.
+	 */
+	void enable_rewind(clock::tick_t interval, std::size_t budget);
+	void disable_rewind();
+
+	const harpoon::state::rewind_buffer_ptr &get_rewind_buffer() const {
+		return _rewind_buffer;
+	}
+
+	void capture_rewind_point();
+
+	/* Go back to the newest rewind point at or before the tick. */
+	bool rewind(clock::tick_t tick);
+
 	virtual void run();
 
 	virtual ~computer_system() override;
 
 private:
+	clock::tick_t get_tick() const;
+	std::vector<std::uint8_t> save_components() const;
+
 	execution::execution_unit_ptr _main_execution_unit{};
 	memory::memory_ptr _main_memory{};
+
+	harpoon::state::rewind_buffer_ptr _rewind_buffer{};
+	clock::tick_t _rewind_interval{};
+	clock::tick_t _next_rewind_tick{};
 };
 
 using computer_system_ptr = std::shared_ptr<computer_system>;
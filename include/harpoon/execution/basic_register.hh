@@ -3,6 +3,9 @@
 
 #include "harpoon/harpoon.hh"
 
+#include "harpoon/state/reader.hh"
+#include "harpoon/state/writer.hh"
+
 #include <iomanip>
 #include <ostream>
 
@@ -65,6 +68,14 @@ public:
 		return --_value;
 	}
 
+	void save(state::writer &writer) const {
+		writer.write(_value);
+	}
+
+	void restore(state::reader &reader) {
+		reader.read(_value);
+	}
+
 private:
 	T _value{};
 };
@@ -0,0 +1,210 @@
+#ifndef HARPOON_EXECUTION_BLOCK_INTERPRETER_HH
+#define HARPOON_EXECUTION_BLOCK_INTERPRETER_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/execution/breakpoint.hh"
+#include "harpoon/execution/code_cache.hh"
+#include "harpoon/memory/main_memory.hh"
+
+#include <array>
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+namespace harpoon {
+namespace execution {
+
+class jit_compiler;
+struct jit_frame;
+class processing_unit;
+
+/* One instruction of a threaded block: its handler and the operands translated for it. */
+struct threaded_op {
+	static constexpr std::size_t operands_length = 16;
+
+	/* Or-ed into a handler result to leave the block after the instruction. */
+	static constexpr std::uint32_t exit_block = 0x80000000;
+
+	/*
+	 * Runs the whole instruction and returns the cycles it took, at least one.
+	 * Instructions with side effects other components must see first (I/O,
+	 * interrupts, faults, mode changes) or the result with exit_block.
+	 */
+	using handler = std::uint32_t (*)(processing_unit &, const threaded_op &);
+
+	template<typename T>
+	T &set_operands(const T &value) {
+		check_operands<T>();
+		return *new (operands) T(value);
+	}
+
+	template<typename T>
+	const T &get_operands() const {
+		check_operands<T>();
+		return *reinterpret_cast<const T *>(operands);
+	}
+
+	/*
+	 * Handler calling a member function of the processing unit class,
+	 * e.g. threaded_op::member_handler<cpu, &cpu::add>.
+	 */
+	template<typename Model, std::uint32_t (Model::*Method)(const threaded_op &)>
+	static std::uint32_t member_handler(processing_unit &pu, const threaded_op &op) {
+		return (static_cast<Model &>(pu).*Method)(op);
+	}
+
+	handler execute{};
+	alignas(std::uint64_t) unsigned char operands[operands_length]{};
+
+private:
+	template<typename T>
+	static constexpr void check_operands() {
+		static_assert(std::is_trivially_copyable<T>::value, "Operands must be trivially copyable");
+		static_assert(sizeof(T) <= operands_length, "Operands do not fit the operand block");
+		static_assert(alignof(T) <= alignof(std::uint64_t), "Operands are over-aligned");
+	}
+};
+
+/*
+ * Straight line code up to and including one control transfer, with links
+ * to the blocks it was last seen to continue with, and once it ran often
+ * enough with a JIT compiler set, its compiled code.
+ */
+struct threaded_block {
+	struct link {
+		memory::address address{};
+		std::uint32_t mode{};
+		threaded_block *block{};
+		std::uint64_t generation{};
+	};
+
+	std::vector<threaded_op> ops{};
+	std::array<link, 2> links{};
+	std::size_t next_link{};
+	std::uint32_t executions{};
+	std::uint32_t (*native)(jit_frame *){};
+};
+
+using block_cache = code_cache<threaded_block>;
+
+/* Implemented by processing units able to run translated blocks. */
+class block_translator {
+public:
+	/* Where and in which mode the next block starts, i.e. the program counter. */
+	virtual memory::address get_block_address() const = 0;
+
+	virtual block_cache::mode get_block_mode() const {
+		return 0;
+	}
+
+	/*
+	 * Translate the instruction at the address into op and return its length
+	 * in bytes, setting ends_block after control transfers. Returning 0 ends
+	 * the block before the instruction, which is then left to the single
+	 * instruction path.
+	 */
+	virtual std::size_t translate(memory::address address, block_cache::mode mode, threaded_op &op,
+	                              bool &ends_block) = 0;
+
+	virtual ~block_translator();
+};
+
+/*
+ * Optional execution tier: runs whole basic blocks of translated
+ * instructions, one handler call each, and goes from block to block through
+ * the links before falling back to a cache lookup. Blocks are only timed as
+ * a whole, so processing units keep to the single instruction path when they
+ * have to be cycle exact or check generic breakpoints; blocks end before
+ * address breakpoints, which are left to that path. Attached to the main
+ * memory, a write to a page a block was translated from drops the block; a
+ * block overwriting itself is left right after the writing instruction.
+ */
+class block_interpreter {
+public:
+	using native_block = std::uint32_t (*)(jit_frame *);
+
+	static constexpr std::size_t max_block_length = 64;
+
+	struct statistics {
+		std::uint64_t translated{};
+		std::uint64_t executed{};
+		std::uint64_t chained{};
+		std::uint64_t native{};
+		std::uint64_t instructions{};
+	};
+
+	void attach(const memory::main_memory_ptr &main_memory) {
+		_blocks.attach(main_memory);
+		_main_memory = main_memory;
+	}
+
+	void detach() {
+		_blocks.detach();
+		_main_memory.reset();
+	}
+
+	/*
+	 * Compile blocks run threshold times, for translators implementing
+	 * jit_translator. Compiled code needs the main memory attached. Blocks
+	 * are dropped, as they may point into the code of the previous compiler.
+	 */
+	void set_jit_compiler(const std::shared_ptr<jit_compiler> &jit_compiler,
+	                      std::uint32_t threshold = 64) {
+		_blocks.clear();
+		_jit_compiler = jit_compiler;
+		_jit_threshold = threshold ? threshold : 1;
+	}
+
+	const std::shared_ptr<jit_compiler> &get_jit_compiler() const {
+		return _jit_compiler;
+	}
+
+	/*
+	 * Run blocks until at least budget cycles are spent, a handler asks to
+	 * exit, the next instruction can not be translated or has an address
+	 * breakpoint. Returns the cycles spent, 0 when no instruction ran.
+	 */
+	std::uint64_t run(processing_unit &processing_unit, block_translator &translator,
+	                  std::uint64_t budget);
+
+	void clear() {
+		_blocks.clear();
+	}
+
+	const block_cache &get_block_cache() const {
+		return _blocks;
+	}
+
+	const statistics &get_statistics() const {
+		return _statistics;
+	}
+
+	void reset_statistics() {
+		_statistics = {};
+		_blocks.reset_statistics();
+	}
+
+private:
+	threaded_block &get_block(block_translator &translator, memory::address address,
+	                          block_cache::mode mode, const address_breakpoints &breakpoints);
+
+	block_cache _blocks{};
+	std::weak_ptr<memory::main_memory> _main_memory{};
+	std::shared_ptr<jit_compiler> _jit_compiler{};
+	std::uint32_t _jit_threshold{};
+	statistics _statistics{};
+};
+
+using block_interpreter_ptr = std::shared_ptr<block_interpreter>;
+
+template<typename... Args>
+block_interpreter_ptr make_block_interpreter(Args &&... args) {
+	return std::make_shared<block_interpreter>(std::forward<Args>(args)...);
+}
+
+} // namespace execution
+} // namespace harpoon
+
+#endif
@@ -3,13 +3,18 @@
 
 #include "harpoon/harpoon.hh"
 
+#include "harpoon/memory/address.hh"
+
 #include <functional>
+#include <map>
+#include <unordered_map>
 
 namespace harpoon {
 namespace execution {
 
 class processing_unit;
 
+/* Generic breakpoint, its condition checked before every instruction. */
 class breakpoint {
 public:
 	using condition = std::function<bool(processing_unit *)>;
@@ -33,6 +38,47 @@ private:
 	action _action{};
 };
 
+/*
+ * Breakpoints on instruction addresses, indexed by address so that checking
+ * an instruction or a block costs one hash lookup, none while empty. A
+ * condition, e.g. a breakpoint_expression, is only checked at the address.
+ */
+class address_breakpoints {
+public:
+	using breakpoint_id = unsigned int;
+
+	breakpoint_id add(memory::address address, const breakpoint::action &action,
+	                  const breakpoint::condition &condition = {});
+	void remove(breakpoint_id id);
+	void clear();
+
+	bool empty() const {
+		return _addresses.empty();
+	}
+
+	bool contains(memory::address address) const {
+		return !_addresses.empty() && _addresses.find(address) != _addresses.end();
+	}
+
+	/*
+	 * Run the actions of the breakpoints at the address whose condition
+	 * holds, in the order they were added, and before the first of them hit.
+	 */
+	void do_actions(memory::address address, processing_unit *processing_unit,
+	                const breakpoint::action &hit = {}) const;
+
+private:
+	struct entry {
+		memory::address address;
+		breakpoint::action action;
+		breakpoint::condition condition;
+	};
+
+	std::map<breakpoint_id, entry> _breakpoints{};
+	std::unordered_map<memory::address, unsigned int> _addresses{};
+	breakpoint_id _next_id{};
+};
+
 } // namespace execution
 } // namespace harpoon
 
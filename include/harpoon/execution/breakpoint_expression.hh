@@ -0,0 +1,140 @@
+#ifndef HARPOON_EXECUTION_BREAKPOINT_EXPRESSION_HH
+#define HARPOON_EXECUTION_BREAKPOINT_EXPRESSION_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/execution/basic_register.hh"
+#include "harpoon/memory/memory.hh"
+
+#include <map>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace harpoon {
+namespace execution {
+
+class processing_unit;
+
+/*
+ * Breakpoint condition written at run time, e.g.
+ *
+ *   "a == 0x10 && mem16[hl + 2] != 0 || instructions >= 100000"
+ *
+ * Values are unsigned 64 bit integers: numbers (decimal or 0x hex),
+ * registers bound through symbols, the counters "instructions" (executed
+ * so far) and "pc" (processing_unit::get_program_counter()), and little
+ * endian memory reads mem8[...] to mem64[...], [...] being mem8[...].
+ * Operators, loosest first: || &&, | ^ &, == !=, < <= > >=, << >>, + -, *
+ * and the unary ! ~ -. && and || do not evaluate their right operand when
+ * the left one decides.
+ *
+ * The expression is parsed once to stack code; evaluating it allocates
+ * nothing. It converts to a breakpoint::condition.
+ */
+class breakpoint_expression {
+public:
+	/* Names an expression may use. Registers are read through their address. */
+	class symbols {
+	public:
+		template<typename T>
+		void add_register(const std::string &name, const T &value) {
+			static_assert(std::is_integral<T>::value, "Registers must be integers");
+			_registers[name] = {&value, sizeof(T)};
+		}
+
+		/* The value is read when the expression is evaluated, so it cannot be a temporary. */
+		template<typename T>
+		void add_register(const std::string &name, const T &&value) = delete;
+
+		template<typename T>
+		void add_register(const std::string &name, const basic_register<T> &value) {
+			const T &storage = value.get();
+			add_register(name, storage);
+		}
+
+		/* Memory read by mem8[...] to mem64[...], usually the main memory. */
+		void set_memory(const memory::memory_ptr &memory) {
+			_memory = memory;
+		}
+
+	private:
+		friend class breakpoint_expression;
+
+		struct variable {
+			const void *value;
+			std::size_t size;
+		};
+
+		std::map<std::string, variable> _registers{};
+		memory::memory_ptr _memory{};
+	};
+
+	static constexpr std::size_t max_depth = 32;
+
+	/* Throws bad_breakpoint_expression on syntax errors and unknown names. */
+	breakpoint_expression(const std::string &expression, const symbols &symbols);
+
+	const std::string &get_expression() const {
+		return _expression;
+	}
+
+	std::uint64_t evaluate(processing_unit *processing_unit) const;
+
+	bool operator()(processing_unit *processing_unit) const {
+		return evaluate(processing_unit) != 0;
+	}
+
+private:
+	enum class opcode : std::uint8_t {
+		CONSTANT,
+		REGISTER8,
+		REGISTER16,
+		REGISTER32,
+		REGISTER64,
+		INSTRUCTIONS,
+		PC,
+		MEMORY8,
+		MEMORY16,
+		MEMORY32,
+		MEMORY64,
+		NOT,
+		COMPLEMENT,
+		NEGATE,
+		MULTIPLY,
+		ADD,
+		SUBTRACT,
+		SHIFT_LEFT,
+		SHIFT_RIGHT,
+		LESS,
+		LESS_EQUAL,
+		GREATER,
+		GREATER_EQUAL,
+		EQUAL,
+		NOT_EQUAL,
+		AND,
+		XOR,
+		OR,
+		/* Keep a deciding left operand of && or || as 0 or 1 and jump. */
+		AND_THEN,
+		OR_ELSE,
+		BOOLEAN,
+	};
+
+	struct op {
+		opcode code;
+		std::uint64_t operand;
+		const void *value;
+	};
+
+	class parser;
+
+	std::string _expression;
+	std::vector<op> _code{};
+	memory::memory_ptr _memory{};
+};
+
+} // namespace execution
+} // namespace harpoon
+
+#endif
@@ -0,0 +1,259 @@
+#ifndef HARPOON_EXECUTION_CODE_CACHE_HH
+#define HARPOON_EXECUTION_CODE_CACHE_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/memory/address_range.hh"
+#include "harpoon/memory/main_memory.hh"
+
+#include <limits>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace harpoon {
+namespace execution {
+
+/*
+ * Values translated from guest code, keyed by guest address and mode bits
+ * (anything besides the address which changes how bytes decode, e.g. an
+ * instruction set or operand size). When attached to a main memory, the
+ * pages a value was translated from are marked as code and a write to any
+ * of them drops every value translated from that page.
+ *
+ * Values stay where they are until dropped. The generation changes whenever
+ * values are dropped, so holders of pointers into the cache can tell when to
+ * look them up again. While the cache is held, dropped values are moved
+ * aside and kept until the last hold is released, so code running from a
+ * value may drop it.
+ */
+template<typename Value>
+class code_cache {
+public:
+	using mode = std::uint32_t;
+
+	struct statistics {
+		std::uint64_t hits{};
+		std::uint64_t misses{};
+		std::uint64_t invalidations{};
+
+		double get_hit_rate() const {
+			std::uint64_t lookups = hits + misses;
+			return lookups ? static_cast<double>(hits) / static_cast<double>(lookups) : 0;
+		}
+	};
+
+	code_cache() = default;
+	code_cache(const code_cache &) = delete;
+	code_cache &operator=(const code_cache &) = delete;
+
+	void attach(const memory::main_memory_ptr &main_memory) {
+		detach();
+		_main_memory = main_memory;
+		_handler = main_memory->add_code_write_handler(
+		    [this](const memory::address_range &range) { invalidate(range); });
+
+		/* Pages of values translated before are not marked, so start over. */
+		clear();
+	}
+
+	void detach() {
+		auto main_memory = _main_memory.lock();
+		if (main_memory) {
+			main_memory->remove_code_write_handler(_handler);
+		}
+		_main_memory.reset();
+	}
+
+	/* Cached value, or null. Counts a hit or a miss. */
+	Value *find(memory::address address, mode mode) {
+		auto i = _entries.find({address, mode});
+		if (i == _entries.end()) {
+			_statistics.misses++;
+			return nullptr;
+		}
+		_statistics.hits++;
+		return &i->second.value;
+	}
+
+	/* Cache the value translated from length bytes at the address. */
+	Value &insert(memory::address address, mode mode, std::size_t length, Value &&value) {
+		memory::address_range range{address, address + (length ? length - 1 : 0)};
+		key k{address, mode};
+		auto &e = _entries[k];
+		e.value = std::move(value);
+		e.range = range;
+
+		for (memory::address page = range.get_start() >> page_bits;
+		     page <= range.get_end() >> page_bits; page++) {
+			_pages[page].insert(k);
+			if (page == std::numeric_limits<memory::address>::max() >> page_bits) {
+				break;
+			}
+		}
+
+		auto main_memory = _main_memory.lock();
+		if (main_memory) {
+			main_memory->mark_code(range);
+		}
+		return e.value;
+	}
+
+	/*
+	 * Cached value, translating it on a miss with translate(length), which
+	 * returns the value and sets its length in bytes.
+	 */
+	template<typename Translator>
+	Value &get(memory::address address, mode mode, Translator &&translate) {
+		auto cached = find(address, mode);
+		if (cached) {
+			return *cached;
+		}
+		std::size_t length = 1;
+		Value value = translate(length);
+		return insert(address, mode, length, std::move(value));
+	}
+
+	/* Drop values translated from any page overlapping the range. */
+	void invalidate(const memory::address_range &range) {
+		if (range.is_empty()) {
+			return;
+		}
+		if (_entries.empty()) {
+			_pages.clear();
+			return;
+		}
+
+		/* Wide ranges walk the cached pages instead of the range. */
+		memory::address first = range.get_start() >> page_bits,
+		                last = range.get_end() >> page_bits;
+		if (last - first >= _pages.size()) {
+			for (auto p = _pages.begin(); p != _pages.end();) {
+				if (p->first < first || p->first > last) {
+					++p;
+					continue;
+				}
+				drop(p->second);
+				p = _pages.erase(p);
+			}
+			return;
+		}
+
+		for (memory::address page = first; page <= last; page++) {
+			auto p = _pages.find(page);
+			if (p != _pages.end()) {
+				drop(p->second);
+				_pages.erase(p);
+			}
+			if (page == last) {
+				break;
+			}
+		}
+	}
+
+	void hold() {
+		_holds++;
+	}
+
+	void release() {
+		if (!--_holds) {
+			_retired.clear();
+		}
+	}
+
+	void clear() {
+		if (!_entries.empty()) {
+			_generation++;
+		}
+		if (_holds) {
+			for (auto &e : _entries) {
+				_retired.push_back(std::move(e.second.value));
+			}
+		}
+		_statistics.invalidations += _entries.size();
+		_entries.clear();
+		_pages.clear();
+	}
+
+	std::size_t size() const {
+		return _entries.size();
+	}
+
+	std::uint64_t get_generation() const {
+		return _generation;
+	}
+
+	const statistics &get_statistics() const {
+		return _statistics;
+	}
+
+	void reset_statistics() {
+		_statistics = {};
+	}
+
+	~code_cache() {
+		detach();
+	}
+
+private:
+	struct key {
+		memory::address address;
+		code_cache::mode mode;
+
+		bool operator==(const key &k) const {
+			return address == k.address && mode == k.mode;
+		}
+	};
+
+	struct key_hash {
+		std::size_t operator()(const key &k) const {
+			return static_cast<std::size_t>((k.address * 0x9e3779b97f4a7c15ULL) ^ k.mode);
+		}
+	};
+
+	struct entry {
+		Value value;
+		memory::address_range range;
+	};
+
+	static constexpr unsigned int page_bits = memory::main_memory::page_bits;
+
+	using key_set = std::unordered_set<key, key_hash>;
+
+	void drop(const key_set &keys) {
+		std::size_t dropped = 0;
+		for (const key &k : keys) {
+			auto i = _entries.find(k);
+			if (i == _entries.end()) {
+				continue;
+			}
+			if (_holds) {
+				_retired.push_back(std::move(i->second.value));
+			}
+			_entries.erase(i);
+			dropped++;
+		}
+		if (dropped) {
+			_statistics.invalidations += dropped;
+			_generation++;
+		}
+	}
+
+	std::unordered_map<key, entry, key_hash> _entries{};
+	/* Keys by page; may name entries already dropped through another page. */
+	std::unordered_map<memory::address, key_set> _pages{};
+
+	std::weak_ptr<memory::main_memory> _main_memory{};
+	memory::main_memory::code_write_handler_id _handler{};
+
+	std::uint64_t _generation{};
+	statistics _statistics{};
+
+	unsigned int _holds{};
+	std::vector<Value> _retired{};
+};
+
+} // namespace execution
+} // namespace harpoon
+
+#endif
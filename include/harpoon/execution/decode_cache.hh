@@ -0,0 +1,28 @@
+#ifndef HARPOON_EXECUTION_DECODE_CACHE_HH
+#define HARPOON_EXECUTION_DECODE_CACHE_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/execution/code_cache.hh"
+#include "harpoon/execution/instruction.hh"
+
+namespace harpoon {
+namespace execution {
+
+/*
+ * Decoded instructions, kept as prototypes to clone. A write to a page an
+ * instruction was decoded from drops it.
+ */
+using decode_cache = code_cache<instruction>;
+
+using decode_cache_ptr = std::shared_ptr<decode_cache>;
+
+template<typename... Args>
+decode_cache_ptr make_decode_cache(Args &&... args) {
+	return std::make_shared<decode_cache>(std::forward<Args>(args)...);
+}
+
+} // namespace execution
+} // namespace harpoon
+
+#endif
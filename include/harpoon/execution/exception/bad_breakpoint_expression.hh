@@ -0,0 +1,27 @@
+#ifndef HARPOON_EXECUTION_EXCEPTION_BAD_BREAKPOINT_EXPRESSION_HH
+#define HARPOON_EXECUTION_EXCEPTION_BAD_BREAKPOINT_EXPRESSION_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/exception/harpoon_exception.hh"
+
+namespace harpoon {
+namespace execution {
+namespace exception {
+
+class bad_breakpoint_expression : public harpoon::exception::harpoon_exception {
+public:
+	bad_breakpoint_expression(const std::string &expression, const std::string &reason,
+	                          const std::string &file = {}, int line = {},
+	                          const std::string &function = {});
+	bad_breakpoint_expression(const bad_breakpoint_expression &) = default;
+	bad_breakpoint_expression &operator=(const bad_breakpoint_expression &) = default;
+
+	virtual ~bad_breakpoint_expression();
+};
+
+} // namespace exception
+} // namespace execution
+} // namespace harpoon
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef HARPOON_EXECUTION_EXCEPTION_BAD_OPCODE_PATTERN_HH
+#define HARPOON_EXECUTION_EXCEPTION_BAD_OPCODE_PATTERN_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/exception/harpoon_exception.hh"
+
+namespace harpoon {
+namespace execution {
+namespace exception {
+
+class bad_opcode_pattern : public harpoon::exception::harpoon_exception {
+public:
+	bad_opcode_pattern(const std::string &pattern, const std::string &reason,
+	                   const std::string &file = {}, int line = {},
+	                   const std::string &function = {});
+	bad_opcode_pattern(const bad_opcode_pattern &) = default;
+	bad_opcode_pattern &operator=(const bad_opcode_pattern &) = default;
+
+	virtual ~bad_opcode_pattern();
+};
+
+} // namespace exception
+} // namespace execution
+} // namespace harpoon
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef HARPOON_EXECUTION_EXCEPTION_DECODER_ERROR_HH
+#define HARPOON_EXECUTION_EXCEPTION_DECODER_ERROR_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/exception/harpoon_exception.hh"
+
+namespace harpoon {
+namespace execution {
+namespace exception {
+
+class decoder_error : public harpoon::exception::harpoon_exception {
+public:
+	decoder_error(const std::string &reason, const std::string &file = {}, int line = {},
+	              const std::string &function = {});
+	decoder_error(const decoder_error &) = default;
+	decoder_error &operator=(const decoder_error &) = default;
+
+	virtual ~decoder_error();
+};
+
+} // namespace exception
+} // namespace execution
+} // namespace harpoon
+
+#endif
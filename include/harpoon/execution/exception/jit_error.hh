@@ -0,0 +1,26 @@
+#ifndef HARPOON_EXECUTION_EXCEPTION_JIT_ERROR_HH
+#define HARPOON_EXECUTION_EXCEPTION_JIT_ERROR_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/exception/harpoon_exception.hh"
+
+namespace harpoon {
+namespace execution {
+namespace exception {
+
+class jit_error : public harpoon::exception::harpoon_exception {
+public:
+	jit_error(const std::string &reason, const std::string &file = {}, int line = {},
+	          const std::string &function = {});
+	jit_error(const jit_error &) = default;
+	jit_error &operator=(const jit_error &) = default;
+
+	virtual ~jit_error();
+};
+
+} // namespace exception
+} // namespace execution
+} // namespace harpoon
+
+#endif
@@ -3,57 +3,168 @@
 
 #include "harpoon/harpoon.hh"
 
-#include <functional>
-#include <vector>
+#include "harpoon/exception/harpoon_exception.hh"
+
+#include <array>
+#include <cstddef>
+#include <initializer_list>
+#include <new>
+#include <ostream>
+#include <type_traits>
 
 namespace harpoon {
 namespace execution {
 
 class processing_unit;
 
+/*
+ * Instruction in flight: up to max_steps micro-steps, each a pair of plain
+ * function pointers, and an operand block holding whatever the decoder (or
+ * earlier steps) stored for later ones. Everything is kept inline, so
+ * building, moving and running an instruction never allocates.
+ *
+ * Instructions are move-only to keep copies explicit; clone() copies a
+ * prototype, e.g. one kept by a decode cache.
+ */
 class instruction {
 public:
-	using step_handler = std::function<std::uint32_t(const instruction &)>;
-	using disassemble_handler = std::function<void(const instruction &, std::ostream &)>;
+	static constexpr std::size_t max_steps = 8;
+	static constexpr std::size_t operands_length = 32;
+
+	/*
+	 * The first handler of a step returns the delay before the step may
+	 * complete; once it returns 0 the second one runs, its result is the
+	 * delay and the instruction moves to the next step.
+	 */
+	using step_handler = std::uint32_t (*)(instruction &);
+	using disassemble_handler = void (*)(const instruction &, std::ostream &);
 
-	using step_handlers = std::pair<step_handler, step_handler>;
+	struct step_handlers {
+		step_handler first;
+		step_handler second;
+	};
 
 	instruction() {}
-	instruction(processing_unit *processing_unit, std::vector<step_handlers> &&steps, const disassemble_handler& d_hndl)
-	    : _processing_unit{processing_unit}, _step_handlers{steps}, _disassemble_handler(d_hndl), _step{0} {}
+
+	explicit instruction(processing_unit *processing_unit, disassemble_handler d_hndl = nullptr,
+	                     std::initializer_list<step_handlers> steps = {})
+	    : _processing_unit{processing_unit}, _disassemble_handler{d_hndl} {
+		for (const auto &s : steps) {
+			add_step(s.first, s.second);
+		}
+	}
+
+	instruction(instruction &&) = default;
+	instruction &operator=(instruction &&) = default;
+
+	instruction clone() const {
+		return instruction(*this);
+	}
+
+	/* Start over as an empty instruction of the processing unit, keeping the storage. */
+	void reset(processing_unit *processing_unit) {
+		_processing_unit = processing_unit;
+		_step_count = 0;
+		_step = 0;
+		_disassemble_handler = nullptr;
+	}
+
+	void set_disassemble_handler(disassemble_handler d_hndl) {
+		_disassemble_handler = d_hndl;
+	}
+
+	void add_step(step_handler first, step_handler second) {
+		if (_step_count == max_steps) {
+			throw HARPOON_EXCEPTION(harpoon::exception::harpoon_exception,
+			                        "Too many instruction steps");
+		}
+		_steps[_step_count++] = {first, second};
+	}
+
+	template<typename T>
+	T &set_operands(const T &operands) {
+		check_operands<T>();
+		return *new (_operands) T(operands);
+	}
+
+	template<typename T>
+	T &get_operands() {
+		check_operands<T>();
+		return *reinterpret_cast<T *>(_operands);
+	}
+
+	template<typename T>
+	const T &get_operands() const {
+		check_operands<T>();
+		return *reinterpret_cast<const T *>(_operands);
+	}
 
 	std::uint32_t step() {
-		auto delay = _step_handlers[_step].first(*this);
+		const step_handlers &handlers = _steps[_step];
+		auto delay = handlers.first(*this);
 		if (delay == 0) {
-			delay = _step_handlers[_step].second(*this);
+			delay = handlers.second(*this);
 			_step++;
 		}
 		return delay;
 	}
 
-	void disassemble(std::ostream &s) {
+	void disassemble(std::ostream &s) const {
 		if (_disassemble_handler) {
 			_disassemble_handler(*this, s);
 		}
 	}
 
 	bool done() const {
-		return _step == _step_handlers.size();
+		return _step == _step_count;
 	}
 
 	processing_unit *get_processing_unit() const {
 		return _processing_unit;
 	}
 
+	void set_processing_unit(processing_unit *processing_unit) {
+		_processing_unit = processing_unit;
+	}
+
 	std::uint32_t get_step() const {
 		return _step;
 	}
 
+	std::uint32_t get_step_count() const {
+		return _step_count;
+	}
+
+	/*
+	 * Step handler calling a member function of the processing unit class,
+	 * e.g. instruction::member_step<cpu, &cpu::load_operand>.
+	 */
+	template<typename Model, std::uint32_t (Model::*Method)(instruction &)>
+	static std::uint32_t member_step(instruction &current) {
+		return (static_cast<Model *>(current.get_processing_unit())->*Method)(current);
+	}
+
+	/* Step handler doing nothing, e.g. as the first handler of a step without delay. */
+	static std::uint32_t no_delay(instruction &) {
+		return 0;
+	}
+
 private:
+	template<typename T>
+	static constexpr void check_operands() {
+		static_assert(std::is_trivially_copyable<T>::value, "Operands must be trivially copyable");
+		static_assert(sizeof(T) <= operands_length, "Operands do not fit the operand block");
+		static_assert(alignof(T) <= alignof(std::max_align_t), "Operands are over-aligned");
+	}
+
+	instruction(const instruction &) = default;
+
 	processing_unit *_processing_unit{};
-	std::vector<step_handlers> _step_handlers{};
-	disassemble_handler _disassemble_handler{};
+	std::array<step_handlers, max_steps> _steps{};
+	std::uint32_t _step_count{};
 	std::uint32_t _step{};
+	disassemble_handler _disassemble_handler{};
+	alignas(std::max_align_t) unsigned char _operands[operands_length]{};
 };
 
 } // namespace execution
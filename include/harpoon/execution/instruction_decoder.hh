@@ -0,0 +1,283 @@
+#ifndef HARPOON_EXECUTION_INSTRUCTION_DECODER_HH
+#define HARPOON_EXECUTION_INSTRUCTION_DECODER_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/execution/exception/bad_opcode_pattern.hh"
+#include "harpoon/execution/exception/decoder_error.hh"
+#include "harpoon/execution/opcode_pattern.hh"
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace harpoon {
+namespace execution {
+
+/*
+ * Table driven decoder. A CPU model adds the opcode patterns of its
+ * instruction set, each with a value (typically a handler or an
+ * instruction_invoker), and calls build() once, e.g. from prepare().
+ *
+ * build() turns the patterns into dispatch tables indexed by the top
+ * IndexBits bits of an opcode unit. Units shared by several patterns
+ * (prefixes, escape bytes) lead to a table for the next unit, so an 8 bit
+ * instruction set decodes with one lookup per opcode unit. Entries whose
+ * remaining fixed bits are not covered by the tables fall back to a short
+ * list of candidates tried in order. Among patterns matching the same
+ * opcode the one with more fixed bits wins, then the one added first.
+ */
+template<typename Unit, typename Value,
+         unsigned int IndexBits = (8 * sizeof(Unit) < 16 ? 8 * sizeof(Unit) : 16)>
+class instruction_decoder {
+public:
+	static constexpr unsigned int unit_bits = 8 * sizeof(Unit);
+	static constexpr unsigned int index_bits = IndexBits;
+
+	static_assert(std::is_unsigned<Unit>::value, "Opcode units must be unsigned");
+	static_assert(index_bits > 0 && index_bits <= unit_bits && index_bits <= 16,
+	              "Tables are indexed by 1 to 16 bits of a unit");
+
+	struct entry {
+		opcode_pattern pattern;
+		Value value;
+	};
+
+	instruction_decoder() = default;
+	instruction_decoder(const instruction_decoder &) = delete;
+	instruction_decoder &operator=(const instruction_decoder &) = delete;
+
+	const entry &add(const std::string &pattern, const Value &value) {
+		return add(opcode_pattern(pattern, unit_bits), value);
+	}
+
+	const entry &add(const opcode_pattern &pattern, const Value &value) {
+		if (pattern.get_unit_bits() != unit_bits) {
+			throw HARPOON_EXCEPTION(exception::bad_opcode_pattern, pattern.get_pattern(),
+			                        "Unit width does not match the decoder");
+		}
+		_entries.push_back({pattern, value});
+		_max_length = std::max(_max_length, pattern.get_length());
+		_built = false;
+		return _entries.back();
+	}
+
+	void build();
+
+	bool is_built() const {
+		return _built;
+	}
+
+	std::size_t size() const {
+		return _entries.size();
+	}
+
+	/* Longest pattern, in units; buffers passed to decode() need that much room. */
+	std::size_t get_max_length() const {
+		return _max_length;
+	}
+
+	std::size_t get_table_count() const {
+		return _slots.size() >> index_bits;
+	}
+
+	/*
+	 * Decode the instruction whose units fetch(i) returns, storing them in
+	 * units. Returns null for undefined opcodes. Units past the decoded
+	 * instruction may be fetched when patterns of different lengths share
+	 * their leading units. The tables must be built for the current patterns.
+	 */
+	template<typename Fetch>
+	const entry *decode(Fetch &&fetch, Unit *units) const {
+		if (!_built) {
+			throw HARPOON_EXCEPTION(exception::decoder_error,
+			                        "Tables not built for the current patterns");
+		}
+		std::size_t depth = 0;
+		std::uint32_t node = 0;
+		units[0] = fetch(std::size_t{0});
+		for (;;) {
+			std::uint32_t slot
+			    = _slots[(static_cast<std::size_t>(node) << index_bits) | index_of(units[depth])];
+			switch (slot & kind_mask) {
+			case EMPTY: return nullptr;
+			case LEAF: {
+				const entry *e = _leaves[slot & ~kind_mask];
+				for (std::size_t i = depth + 1; i < e->pattern.get_length(); i++) {
+					units[i] = fetch(i);
+				}
+				return e;
+			}
+			case TABLE:
+				node = slot & ~kind_mask;
+				depth++;
+				units[depth] = fetch(depth);
+				break;
+			default: {
+				const std::uint32_t *list = &_lists[slot & ~kind_mask];
+				std::size_t fetched = depth + 1;
+				for (std::uint32_t i = 1; i <= list[0]; i++) {
+					const entry *e = _leaves[list[i]];
+					for (; fetched < e->pattern.get_length(); fetched++) {
+						units[fetched] = fetch(fetched);
+					}
+					if (e->pattern.matches(units)) {
+						return e;
+					}
+				}
+				return nullptr;
+			}
+			}
+		}
+	}
+
+	/* Decode from a buffer holding at least get_max_length() units. */
+	const entry *decode_buffer(const Unit *buffer, Unit *units) const {
+		return decode([buffer](std::size_t i) { return buffer[i]; }, units);
+	}
+
+private:
+	enum slot_kind : std::uint32_t {
+		EMPTY = 0,
+		LEAF = 1u << 30,
+		TABLE = 2u << 30,
+		LIST = 3u << 30,
+	};
+
+	static constexpr std::uint32_t kind_mask = 3u << 30;
+	static constexpr unsigned int index_shift = unit_bits - index_bits;
+	static constexpr std::uint64_t index_mask = ((std::uint64_t{1} << index_bits) - 1)
+	                                            << index_shift;
+
+	using node_key = std::pair<std::size_t, std::vector<std::uint32_t>>;
+
+	static std::size_t index_of(Unit unit) {
+		return static_cast<std::size_t>(unit >> index_shift);
+	}
+
+	const opcode_pattern &get_pattern(std::uint32_t index) const {
+		return _leaves[index]->pattern;
+	}
+
+	/* Whether a pattern matches any opcode reaching this unit with a matching index. */
+	bool is_unconditional(const opcode_pattern &pattern, std::size_t depth) const {
+		if (pattern.get_mask(depth) & ~index_mask) {
+			return false;
+		}
+		for (std::size_t i = depth + 1; i < pattern.get_length(); i++) {
+			if (pattern.get_mask(i)) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::uint32_t build_node(std::size_t depth, const std::vector<std::uint32_t> &candidates,
+	                         std::map<node_key, std::uint32_t> &nodes);
+	std::uint32_t build_slot(std::size_t depth, const std::vector<std::uint32_t> &matching,
+	                         std::map<node_key, std::uint32_t> &nodes);
+
+	std::deque<entry> _entries{};
+	std::size_t _max_length{};
+	bool _built{};
+
+	std::vector<const entry *> _leaves{};
+	std::vector<std::uint32_t> _slots{};
+	/* Candidate lists: a count followed by that many leaf indices. */
+	std::vector<std::uint32_t> _lists{};
+};
+
+template<typename Unit, typename Value, unsigned int IndexBits>
+void instruction_decoder<Unit, Value, IndexBits>::build() {
+	_leaves.clear();
+	_slots.clear();
+	_lists.clear();
+	for (const auto &e : _entries) {
+		_leaves.push_back(&e);
+	}
+
+	std::vector<std::uint32_t> order(_leaves.size());
+	for (std::uint32_t i = 0; i < order.size(); i++) {
+		order[i] = i;
+	}
+	std::stable_sort(order.begin(), order.end(), [this](std::uint32_t a, std::uint32_t b) {
+		return get_pattern(a).get_specificity() > get_pattern(b).get_specificity();
+	});
+
+	std::map<node_key, std::uint32_t> nodes;
+	build_node(0, order, nodes);
+	_built = true;
+}
+
+template<typename Unit, typename Value, unsigned int IndexBits>
+std::uint32_t instruction_decoder<Unit, Value, IndexBits>::build_node(
+    std::size_t depth, const std::vector<std::uint32_t> &candidates,
+    std::map<node_key, std::uint32_t> &nodes) {
+	node_key key{depth, candidates};
+	auto n = nodes.find(key);
+	if (n != nodes.end()) {
+		return n->second;
+	}
+
+	std::size_t table_length = std::size_t{1} << index_bits;
+	auto node = static_cast<std::uint32_t>(get_table_count());
+	nodes.emplace(std::move(key), node);
+	_slots.resize(_slots.size() + table_length);
+
+	std::vector<std::uint32_t> matching;
+	for (std::size_t index = 0; index < table_length; index++) {
+		std::uint64_t bits = static_cast<std::uint64_t>(index) << index_shift;
+		matching.clear();
+		for (std::uint32_t c : candidates) {
+			const opcode_pattern &p = get_pattern(c);
+			if ((bits & p.get_mask(depth) & index_mask) == (p.get_value(depth) & index_mask)) {
+				matching.push_back(c);
+				/* Anything less specific can not be reached past this one. */
+				if (is_unconditional(p, depth)) {
+					break;
+				}
+			}
+		}
+
+		std::uint32_t slot = build_slot(depth, matching, nodes);
+		_slots[(static_cast<std::size_t>(node) << index_bits) | index] = slot;
+	}
+	return node;
+}
+
+template<typename Unit, typename Value, unsigned int IndexBits>
+std::uint32_t instruction_decoder<Unit, Value, IndexBits>::build_slot(
+    std::size_t depth, const std::vector<std::uint32_t> &matching,
+    std::map<node_key, std::uint32_t> &nodes) {
+	if (matching.empty()) {
+		return EMPTY;
+	}
+	if (matching.size() == 1 && is_unconditional(get_pattern(matching[0]), depth)) {
+		return LEAF | matching[0];
+	}
+
+	bool deeper = true;
+	for (std::uint32_t c : matching) {
+		const opcode_pattern &p = get_pattern(c);
+		if (p.get_length() <= depth + 1 || (p.get_mask(depth) & ~index_mask)) {
+			deeper = false;
+			break;
+		}
+	}
+	if (deeper) {
+		return TABLE | build_node(depth + 1, matching, nodes);
+	}
+
+	auto offset = static_cast<std::uint32_t>(_lists.size());
+	_lists.push_back(static_cast<std::uint32_t>(matching.size()));
+	_lists.insert(_lists.end(), matching.begin(), matching.end());
+	return LIST | offset;
+}
+
+} // namespace execution
+} // namespace harpoon
+
+#endif
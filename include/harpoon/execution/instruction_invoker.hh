@@ -0,0 +1,101 @@
+#ifndef HARPOON_EXECUTION_INSTRUCTION_INVOKER_HH
+#define HARPOON_EXECUTION_INSTRUCTION_INVOKER_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/execution/exception/bad_opcode_pattern.hh"
+#include "harpoon/execution/opcode_pattern.hh"
+
+#include <array>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+namespace harpoon {
+namespace execution {
+
+/*
+ * Calls a member function of a CPU model with operand fields of a decoded
+ * opcode as its arguments, one field name per argument:
+ *
+ *   instruction_invoker<cpu, std::uint8_t> ld(&cpu::ld, pattern, "ds");
+ *   ld(model, units); // model.ld(d, s)
+ *
+ * All invokers of a model share one type whatever the signature of their
+ * member function, so they can be used as instruction_decoder values.
+ * Invoking does not allocate.
+ */
+template<typename Model, typename Unit, typename Result = void>
+class instruction_invoker {
+public:
+	static constexpr std::size_t max_operands = 6;
+
+	instruction_invoker() = default;
+
+	template<typename... Args>
+	instruction_invoker(Result (Model::*method)(Args...), const opcode_pattern &pattern,
+	                    const std::string &operands = {})
+	    : _call(&call<Args...>) {
+		static_assert(sizeof...(Args) <= max_operands, "Too many operands");
+		static_assert(sizeof(method) <= sizeof(_method), "Unexpected member pointer size");
+		new (&_method) handler<Args...>(method);
+		if (operands.size() != sizeof...(Args)) {
+			throw HARPOON_EXCEPTION(exception::bad_opcode_pattern, pattern.get_pattern(),
+			                        "Operand count does not match the handler");
+		}
+		for (std::size_t i = 0; i < operands.size(); i++) {
+			_operands[i] = pattern.get_field(operands[i]);
+		}
+	}
+
+	explicit operator bool() const {
+		return _call != nullptr;
+	}
+
+	Result operator()(Model &model, const Unit *units) const {
+		return _call(*this, model, units);
+	}
+
+	std::uint32_t get_operand(std::size_t index, const Unit *units) const {
+		return _operands[index].extract(units);
+	}
+
+private:
+	template<typename... Args>
+	using handler = Result (Model::*)(Args...);
+	using caller = Result (*)(const instruction_invoker &, Model &, const Unit *);
+
+	/* The member function pointer lives in _method with its own type; call<Args...> knows it. */
+	template<typename... Args>
+	const handler<Args...> &get_handler() const {
+		return *reinterpret_cast<const handler<Args...> *>(&_method);
+	}
+
+	template<typename... Args>
+	static Result call(const instruction_invoker &invoker, Model &model, const Unit *units) {
+		return invoke<Args...>(invoker, model, units, std::index_sequence_for<Args...>{});
+	}
+
+	template<typename... Args, std::size_t... I>
+	static Result invoke(const instruction_invoker &invoker, Model &model, const Unit *units,
+	                     std::index_sequence<I...>) {
+		return (model.*invoker.get_handler<Args...>())(
+		    static_cast<Args>(invoker._operands[I].extract(units))...);
+	}
+
+	template<typename... Args>
+	static Result invoke(const instruction_invoker &invoker, Model &model, const Unit *,
+	                     std::index_sequence<>) {
+		return (model.*invoker.get_handler<Args...>())();
+	}
+
+	typename std::aligned_storage<sizeof(handler<>), alignof(handler<>)>::type _method{};
+	caller _call{};
+	std::array<opcode_pattern::field, max_operands> _operands{};
+};
+
+} // namespace execution
+} // namespace harpoon
+
+#endif
@@ -0,0 +1,193 @@
+#ifndef HARPOON_EXECUTION_JIT_COMPILER_HH
+#define HARPOON_EXECUTION_JIT_COMPILER_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/execution/block_interpreter.hh"
+#include "harpoon/execution/x86_64_assembler.hh"
+#include "harpoon/memory/main_memory.hh"
+
+#include <cstddef>
+#include <exception>
+
+namespace harpoon {
+namespace execution {
+
+/*
+ * What compiled code works with, reached through jit_context::frame_register.
+ * The TLBs map guest pages to host storage, biased so that adding the guest
+ * address gives the host one.
+ */
+struct jit_frame {
+	static constexpr std::size_t tlb_entries = 64;
+
+	struct tlb_entry {
+		std::uint64_t page;
+		std::uintptr_t host;
+	};
+
+	processing_unit *unit;
+	void *state;
+	memory::main_memory *main_memory;
+	const block_cache *blocks;
+	std::exception_ptr *error;
+	std::uint32_t instructions;
+	std::uint8_t faulted;
+	std::uint8_t code_written;
+	tlb_entry read_tlb[tlb_entries];
+	tlb_entry write_tlb[tlb_entries];
+};
+
+/*
+ * Assembler handed to per-instruction emitters, with the registers compiled
+ * blocks keep: the frame, the guest state of jit_translator::get_jit_state()
+ * and the cycle count. R13 to R15 are free and kept across the emit_*
+ * helpers; RAX, RCX, RDX, RSI, RDI and R8 to R11 are not.
+ */
+class jit_context : public x86_64_assembler {
+public:
+	static constexpr reg frame_register = reg::RBX;
+	static constexpr reg state_register = reg::RBP;
+	static constexpr reg cycles_register = reg::R12;
+
+	/* Called with the processing unit; may throw, which ends the block as a fault. */
+	using helper = std::uint64_t (*)(processing_unit &, std::uint64_t);
+
+	/* Address of the instruction being emitted. */
+	memory::address get_address() const {
+		return _address;
+	}
+
+	void emit_cycles(std::uint32_t cycles);
+
+	/* Leave the block once the instruction is done, like threaded_op::exit_block. */
+	void emit_exit();
+
+	/*
+	 * Guest memory accesses of 8 to 64 bits, little endian. Pages with plain
+	 * storage are accessed inline through the frame TLBs, anything else goes
+	 * through the main memory. Faults end the block; writes to code end it
+	 * after the instruction.
+	 */
+	void emit_load(reg value, reg address, unsigned int bits);
+	void emit_store(reg address, reg value, unsigned int bits);
+
+	/* Result in RAX. Writes to code made by the helper end the block after the instruction. */
+	void emit_call(helper function, reg argument);
+
+private:
+	friend class jit_compiler;
+
+	void begin(memory::address address, std::uint32_t index);
+	void end();
+	void emit_leave(std::uint32_t instructions, label target);
+	void emit_fault_check();
+	void emit_tlb_lookup(std::int32_t offset, unsigned int bits, label miss);
+
+	memory::address _address{};
+	std::uint32_t _index{};
+	bool _stores{};
+	label _exit{};
+	label _return{};
+};
+
+/* Implemented by processing units whose instructions can be compiled. */
+class jit_translator : public block_translator {
+public:
+	/* Registers and other guest state, for jit_context::state_register. */
+	virtual void *get_jit_state() = 0;
+
+	/*
+	 * Emit the instruction translate() would return for the address and
+	 * return its length, or 0 if it can not be compiled. Emitted code updates
+	 * the guest state the way the threaded handler does, cycles included.
+	 */
+	virtual std::size_t emit(memory::address address, block_cache::mode mode,
+	                         jit_context &context) = 0;
+
+	virtual ~jit_translator() override;
+};
+
+/*
+ * Compiles hot blocks to x86-64 code, on Linux x86-64 hosts only. Code is
+ * placed in a fixed size buffer, writable only while code is added; once it
+ * is full, the block interpreter drops every block and the buffer starts
+ * over.
+ */
+class jit_compiler {
+public:
+	using native_block = block_interpreter::native_block;
+
+	struct statistics {
+		std::uint64_t compiled{};
+		std::uint64_t failed{};
+		std::uint64_t resets{};
+		std::size_t code_bytes{};
+	};
+
+	explicit jit_compiler(std::size_t capacity = 16 << 20) : _capacity(capacity) {}
+	jit_compiler(const jit_compiler &) = delete;
+	jit_compiler &operator=(const jit_compiler &) = delete;
+
+	static bool is_supported();
+
+	/* Code for the instructions of the block at the address, or null. */
+	native_block compile(jit_translator &translator, memory::address address,
+	                     block_cache::mode mode, std::size_t instructions);
+
+	bool is_full() const {
+		return _full;
+	}
+
+	void reset();
+
+	/* Bind the frame before running blocks; drops cached pages. */
+	void prepare(memory::main_memory *main_memory, const block_cache &blocks, void *state);
+	void flush_tlb();
+
+	/*
+	 * Run a block and return its cycles, or-ed with threaded_op::exit_block
+	 * when it was left early; a fault is rethrown after the instructions
+	 * before it are counted.
+	 */
+	std::uint32_t execute(native_block block, processing_unit &processing_unit,
+	                      std::uint32_t &instructions);
+
+	const statistics &get_statistics() const {
+		return _statistics;
+	}
+
+	~jit_compiler();
+
+private:
+	static std::uint64_t load(jit_frame *frame, std::uint64_t address, std::uint32_t bits);
+	static void store(jit_frame *frame, std::uint64_t address, std::uint64_t value,
+	                  std::uint32_t bits);
+	static std::uint64_t call(jit_frame *frame, jit_context::helper function,
+	                          std::uint64_t argument);
+	static void fill_tlb(jit_frame *frame, std::uint64_t address, bool write);
+
+	friend class jit_context;
+
+	std::size_t _capacity;
+	std::uint8_t *_code{};
+	std::size_t _used{};
+	bool _full{};
+
+	jit_context _context{};
+	jit_frame _frame{};
+	std::exception_ptr _error{};
+	statistics _statistics{};
+};
+
+using jit_compiler_ptr = std::shared_ptr<jit_compiler>;
+
+template<typename... Args>
+jit_compiler_ptr make_jit_compiler(Args &&... args) {
+	return std::make_shared<jit_compiler>(std::forward<Args>(args)...);
+}
+
+} // namespace execution
+} // namespace harpoon
+
+#endif
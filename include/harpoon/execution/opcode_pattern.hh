@@ -0,0 +1,131 @@
+#ifndef HARPOON_EXECUTION_OPCODE_PATTERN_HH
+#define HARPOON_EXECUTION_OPCODE_PATTERN_HH
+
+#include "harpoon/harpoon.hh"
+
+#include <string>
+#include <vector>
+
+namespace harpoon {
+namespace execution {
+
+/*
+ * Bit pattern of an opcode made of one or more units (bytes, half words,
+ * ...), written most significant bit first with units separated by spaces:
+ *
+ *   "11001011 01bbbrrr"
+ *
+ * '0' and '1' are fixed bits, '-' and '.' are ignored bits and any letter
+ * is a bit of the operand field of that name. Fields may span units and
+ * need not be contiguous; their bits are taken in pattern order. '_' and
+ * '\'' may be used as separators within a unit.
+ */
+class opcode_pattern {
+public:
+	/* Bits of a field held by one unit. */
+	struct field_part {
+		std::uint8_t unit;
+		std::uint8_t shift;
+		std::uint8_t width;
+	};
+
+	class field {
+	public:
+		field() = default;
+		explicit field(char name) : _name(name) {}
+
+		char get_name() const {
+			return _name;
+		}
+
+		unsigned int get_width() const {
+			unsigned int width = 0;
+			for (const auto &part : _parts) {
+				width += part.width;
+			}
+			return width;
+		}
+
+		template<typename Unit>
+		std::uint32_t extract(const Unit *units) const {
+			std::uint32_t value = 0;
+			for (const auto &part : _parts) {
+				std::uint64_t bits = static_cast<std::uint64_t>(units[part.unit]) >> part.shift;
+				value = static_cast<std::uint32_t>(value << part.width)
+				        | static_cast<std::uint32_t>(bits & ((std::uint64_t{1} << part.width) - 1));
+			}
+			return value;
+		}
+
+	private:
+		friend class opcode_pattern;
+
+		char _name{};
+		std::vector<field_part> _parts{};
+	};
+
+	opcode_pattern(const std::string &pattern, unsigned int unit_bits);
+
+	const std::string &get_pattern() const {
+		return _pattern;
+	}
+
+	unsigned int get_unit_bits() const {
+		return _unit_bits;
+	}
+
+	/* Number of units. */
+	std::size_t get_length() const {
+		return _mask.size();
+	}
+
+	std::uint64_t get_mask(std::size_t unit) const {
+		return _mask[unit];
+	}
+
+	std::uint64_t get_value(std::size_t unit) const {
+		return _value[unit];
+	}
+
+	/* Number of fixed bits; more specific patterns win over less specific ones. */
+	unsigned int get_specificity() const {
+		return _specificity;
+	}
+
+	template<typename Unit>
+	bool matches(const Unit *units) const {
+		for (std::size_t i = 0; i < _mask.size(); i++) {
+			if ((static_cast<std::uint64_t>(units[i]) & _mask[i]) != _value[i]) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	const std::vector<field> &get_fields() const {
+		return _fields;
+	}
+
+	bool has_field(char name) const;
+
+	/* Throws bad_opcode_pattern when there is no such field. */
+	const field &get_field(char name) const;
+
+	template<typename Unit>
+	std::uint32_t extract(char name, const Unit *units) const {
+		return get_field(name).extract(units);
+	}
+
+private:
+	std::string _pattern;
+	unsigned int _unit_bits;
+	std::vector<std::uint64_t> _mask{};
+	std::vector<std::uint64_t> _value{};
+	unsigned int _specificity{};
+	std::vector<field> _fields{};
+};
+
+} // namespace execution
+} // namespace harpoon
+
+#endif
@@ -3,7 +3,9 @@
 
 #include "harpoon/harpoon.hh"
 
+#include "harpoon/execution/block_interpreter.hh"
 #include "harpoon/execution/breakpoint.hh"
+#include "harpoon/execution/decode_cache.hh"
 #include "harpoon/execution/execution_unit.hh"
 #include "harpoon/execution/instruction.hh"
 #include "harpoon/hardware_component.hh"
@@ -25,10 +27,26 @@ public:
 	virtual void boot() override;
 	virtual void shutdown() override;
 
+	/* Generic breakpoints keep the unit on the single instruction path. */
 	void add_breakpoint(const breakpoint &breakpoint) {
 		_breakpoints.push_back(breakpoint);
 	}
 
+	/*
+	 * Breakpoint on the instruction at the address, its action run before
+	 * the instruction when the condition, if any, holds. Looked up once per
+	 * instruction through get_program_counter(), and once per block on the
+	 * block tier, whose blocks stop before it.
+	 */
+	address_breakpoints::breakpoint_id add_breakpoint(memory::address address,
+	                                                  const breakpoint::action &action,
+	                                                  const breakpoint::condition &condition = {});
+	void remove_breakpoint(address_breakpoints::breakpoint_id id);
+
+	const address_breakpoints &get_address_breakpoints() const {
+		return _address_breakpoints;
+	}
+
 	const execution_unit_ptr &get_execution_unit() const {
 		return _execution_unit;
 	}
@@ -53,8 +71,59 @@ public:
 		_stats_interval = interval;
 	}
 
-	void set_current_instruction(const instruction &instruction) {
-		_current_instruction = instruction;
+	/* Optional cache of decoded instructions; its hit rate is logged with the stats. */
+	void set_decode_cache(const decode_cache_ptr &decode_cache) {
+		_decode_cache = decode_cache;
+	}
+
+	const decode_cache_ptr &get_decode_cache() const {
+		return _decode_cache;
+	}
+
+	/*
+	 * Optional block tier. Models implementing block_translator call
+	 * run_blocks() from step() while can_run_blocks() and schedule the
+	 * returned cycles at once; on 0 they run the next instruction the usual
+	 * way.
+	 */
+	void set_block_interpreter(const block_interpreter_ptr &block_interpreter) {
+		_block_interpreter = block_interpreter;
+		if (_block_interpreter && !_address_breakpoints.empty()) {
+			_block_interpreter->clear();
+		}
+	}
+
+	const block_interpreter_ptr &get_block_interpreter() const {
+		return _block_interpreter;
+	}
+
+	/* Cycle exact units time every instruction step and never run blocks. */
+	void set_cycle_exact(bool cycle_exact) {
+		_cycle_exact = cycle_exact;
+	}
+
+	bool is_cycle_exact() const {
+		return _cycle_exact;
+	}
+
+	bool can_run_blocks() const {
+		return _block_interpreter && !_cycle_exact && !_disassemble && _breakpoints.empty()
+		       && _current_instruction.done();
+	}
+
+	std::uint64_t run_blocks(block_translator &translator, std::uint64_t budget);
+
+	/*
+	 * Build the next instruction in place: new_instruction() hands out the
+	 * emptied current instruction to fill, start_instruction() makes it the
+	 * one executed.
+	 */
+	instruction &new_instruction() {
+		_current_instruction.reset(this);
+		return _current_instruction;
+	}
+
+	void start_instruction() {
 		if (_disassemble) {
 			disassemble_instruction();
 		}
@@ -66,12 +135,32 @@ public:
 		_executed_instructions++;
 	}
 
+	void set_current_instruction(instruction &&instruction) {
+		_current_instruction = std::move(instruction);
+		start_instruction();
+	}
+
+	/* Run a copy of a prototype, e.g. one kept by the decode cache. */
+	void set_current_instruction(const instruction &prototype) {
+		_current_instruction = prototype.clone();
+		_current_instruction.set_processing_unit(this);
+		start_instruction();
+	}
+
 	const instruction &get_current_instruction() const {
 		return _current_instruction;
 	}
 
 	std::uint32_t execute_instruction();
 
+	/*
+	 * Address of the current instruction when it starts, needed by address
+	 * breakpoints; the default throws.
+	 */
+	virtual memory::address get_program_counter() const;
+
+	virtual bool can_save_state() const override;
+
 	virtual void disassemble_instruction();
 
 	virtual void log_state(log::message::Level level = log::message::Level::DEBUG) const override;
@@ -82,8 +171,22 @@ public:
 
 	virtual ~processing_unit() override;
 
+protected:
+	/*
+	 * Instructions in flight hold closures, so state is saved between
+	 * instructions only. Subclasses add their registers.
+	 */
+	virtual void save_state(harpoon::state::writer &writer) const override;
+	virtual void restore_state(harpoon::state::reader &reader) override;
+
 private:
 	void process_breakpoints() {
+		if (!_address_breakpoints.empty()) {
+			memory::address address = get_program_counter();
+			if (_address_breakpoints.contains(address)) {
+				process_address_breakpoints(address);
+			}
+		}
 		for (const auto &breakpoint : _breakpoints) {
 			if (breakpoint.check_condition(this)) {
 				log(component_debug << "EXECUTION BREAKPOINT");
@@ -93,11 +196,17 @@ private:
 		}
 	}
 
+	void process_address_breakpoints(memory::address address);
+
 	execution_unit_ptr _execution_unit{};
 	std::uint_fast64_t _executed_instructions{};
 	std::uint64_t _stats_interval{};
+	decode_cache_ptr _decode_cache{};
+	block_interpreter_ptr _block_interpreter{};
+	bool _cycle_exact{};
 	bool _disassemble{};
 	std::list<breakpoint> _breakpoints{};
+	address_breakpoints _address_breakpoints{};
 	instruction _current_instruction{};
 	std::chrono::high_resolution_clock::time_point _stats_checkpoint_start{}, _run_start{};
 	std::uint64_t _stats_checkpoint_executed_instruction{};
@@ -14,7 +14,10 @@ public:
 	using execution_unit::execution_unit;
 
 	void set_processing_unit(const processing_unit_ptr &processing_unit) {
-		replace_component(_processing_unit, processing_unit);
+		if (_processing_unit) {
+			remove_component(_processing_unit);
+		}
+		add_component(processing_unit);
 		_processing_unit = processing_unit;
 	}
 
@@ -0,0 +1,161 @@
+#ifndef HARPOON_EXECUTION_X86_64_ASSEMBLER_HH
+#define HARPOON_EXECUTION_X86_64_ASSEMBLER_HH
+
+#include "harpoon/harpoon.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+namespace harpoon {
+namespace execution {
+
+/*
+ * Minimal x86-64 assembler for the JIT: integer moves, arithmetic, shifts,
+ * compares, branches to labels and absolute calls. Jumps are always rel32
+ * and calls go through a register, so the code may be copied anywhere.
+ * Operand sizes are given in bits; 32 bit operations zero the upper half.
+ */
+class x86_64_assembler {
+public:
+	enum class reg : std::uint8_t {
+		RAX,
+		RCX,
+		RDX,
+		RBX,
+		RSP,
+		RBP,
+		RSI,
+		RDI,
+		R8,
+		R9,
+		R10,
+		R11,
+		R12,
+		R13,
+		R14,
+		R15,
+		NONE = 0xff,
+	};
+
+	enum class condition : std::uint8_t {
+		O,
+		NO,
+		B,
+		AE,
+		E,
+		NE,
+		BE,
+		A,
+		S,
+		NS,
+		P,
+		NP,
+		L,
+		GE,
+		LE,
+		G,
+	};
+
+	enum class alu : std::uint8_t {
+		ADD = 0,
+		OR = 1,
+		AND = 4,
+		SUB = 5,
+		XOR = 6,
+		CMP = 7,
+	};
+
+	enum class shift : std::uint8_t {
+		SHL = 4,
+		SHR = 5,
+		SAR = 7,
+	};
+
+	/* [base + index * scale + displacement] */
+	struct mem {
+		reg base;
+		std::int32_t displacement{};
+		reg index{reg::NONE};
+		std::uint8_t scale{1};
+	};
+
+	using label = std::size_t;
+
+	label new_label();
+	void bind(label label);
+
+	void mov(reg destination, reg source, unsigned int bits = 64);
+	void mov(reg destination, std::uint64_t immediate);
+	void mov(const mem &destination, std::int32_t immediate, unsigned int bits = 64);
+
+	/* Loads of 8 and 16 bits zero extend. */
+	void load(reg destination, const mem &source, unsigned int bits = 64);
+	void store(const mem &destination, reg source, unsigned int bits = 64);
+	void lea(reg destination, const mem &source);
+
+	void op(alu op, reg destination, reg source, unsigned int bits = 64);
+	void op(alu op, reg destination, std::int32_t immediate, unsigned int bits = 64);
+	void op(alu op, reg destination, const mem &source, unsigned int bits = 64);
+	void op(alu op, const mem &destination, reg source, unsigned int bits = 64);
+	void op(alu op, const mem &destination, std::int32_t immediate, unsigned int bits = 64);
+
+	void op(shift op, reg destination, std::uint8_t count, unsigned int bits = 64);
+	void test(reg first, reg second, unsigned int bits = 64);
+
+	/* Set the low byte of the register to the condition, zero extended. */
+	void set(condition condition, reg destination);
+
+	void jump(label target);
+	void jump(condition condition, label target);
+	/* Clobbers RAX. */
+	void call(const void *function);
+	void push(reg source);
+	void pop(reg destination);
+	void ret();
+
+	std::size_t size() const {
+		return _code.size();
+	}
+
+	/* Code with all jumps resolved; throws if a label used was never bound. */
+	const std::vector<std::uint8_t> &finish();
+
+	void clear();
+
+private:
+	static constexpr std::size_t unbound = ~std::size_t{};
+
+	struct fixup {
+		std::size_t position;
+		label target;
+	};
+
+	void byte(std::uint8_t b) {
+		_code.push_back(b);
+	}
+
+	void imm32(std::uint32_t value);
+	void imm64(std::uint64_t value);
+
+	void prefix(unsigned int bits, std::uint8_t r, std::uint8_t x, std::uint8_t b,
+	            bool force_rex = false);
+	void modrm(std::uint8_t r, reg rm);
+	void modrm(std::uint8_t r, const mem &rm);
+
+	/* Prefixes, opcode and ModRM; force_rex reaches the low byte of RSP to RDI. */
+	void encode(unsigned int bits, std::initializer_list<std::uint8_t> opcode, std::uint8_t r,
+	            reg rm, bool force_rex = false);
+	void encode(unsigned int bits, std::initializer_list<std::uint8_t> opcode, std::uint8_t r,
+	            const mem &rm, bool force_rex = false);
+
+	std::vector<std::uint8_t> _code{};
+	std::vector<std::size_t> _labels{};
+	std::vector<fixup> _fixups{};
+};
+
+} // namespace execution
+} // namespace harpoon
+
+#endif
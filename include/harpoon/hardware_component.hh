@@ -21,6 +21,11 @@ namespace clock {
 class clock;
 }
 
+namespace state {
+class reader;
+class writer;
+}
+
 /** std::shared_ptr pointing to hardware_component object */
 using hardware_component_ptr = std::shared_ptr<hardware_component>;
 
@@ -141,6 +146,26 @@ public:
 	 */
 	virtual void shutdown();
 
+	/**
+	 * @brief Save state of component and all its subcomponents.
+	 * @details Each component writes a section named after it, holding its own state
+	 * (see save_state()) followed by the sections of its subcomponents.
+	 * @param[in] writer State writer.
+	 */
+	void save(harpoon::state::writer &writer) const;
+
+	/**
+	 * @brief Check if component and all its subcomponents are at a point where state can be saved.
+	 * @return true if save() would succeed.
+	 */
+	virtual bool can_save_state() const;
+
+	/**
+	 * @brief Restore state saved by save() into the same component hierarchy.
+	 * @param[in] reader State reader.
+	 */
+	void restore(harpoon::state::reader &reader);
+
 	/**
 	 * @brief Emit message to component log.
 	 * @param[in] stream Stream with log message collected.
@@ -228,6 +253,19 @@ public:
 	 */
 	virtual void log_state(log::message::Level level) const;
 
+protected:
+	/**
+	 * @brief Write state of this component only. Components without state keep the default.
+	 * @param[in] writer State writer.
+	 */
+	virtual void save_state(harpoon::state::writer &writer) const;
+
+	/**
+	 * @brief Read back what save_state() wrote.
+	 * @param[in] reader State reader.
+	 */
+	virtual void restore_state(harpoon::state::reader &reader);
+
 private:
 	void set_parent_component(const hardware_component_weak_ptr &parent_component);
 
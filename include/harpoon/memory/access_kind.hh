@@ -0,0 +1,27 @@
+#ifndef HARPOON_MEMORY_ACCESS_KIND_HH
+#define HARPOON_MEMORY_ACCESS_KIND_HH
+
+#include "harpoon/harpoon.hh"
+
+#include <ostream>
+
+namespace harpoon {
+namespace memory {
+
+enum class access_kind : std::uint8_t { READ, WRITE, FETCH };
+
+static constexpr std::size_t access_kinds = 3;
+
+static inline std::ostream &operator<<(std::ostream &stream, access_kind kind) {
+	switch (kind) {
+	case access_kind::READ: return stream << "read";
+	case access_kind::WRITE: return stream << "write";
+	case access_kind::FETCH: return stream << "fetch";
+	}
+	return stream;
+}
+
+} // namespace memory
+} // namespace harpoon
+
+#endif
@@ -0,0 +1,128 @@
+#ifndef HARPOON_MEMORY_ACCESS_PROFILER_HH
+#define HARPOON_MEMORY_ACCESS_PROFILER_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/memory/access_kind.hh"
+#include "harpoon/memory/address.hh"
+
+#include <array>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <ostream>
+
+namespace harpoon {
+namespace memory {
+
+/*
+ * Per-page access counters. Every byte access that reaches main_memory is
+ * counted against the page containing it (and, when enabled, against the
+ * source set with set_source()), so a 4 byte read adds 4 read bytes. With a
+ * sample interval N only every N-th byte is recorded and reported counts are
+ * scaled back by N.
+ *
+ * record() is meant to be called from the emulation thread only. Counters
+ * are relaxed atomics, so dump() and reset() may run concurrently from
+ * another thread; reset() zeroes counters in place and pages without
+ * accesses are left out of dumps.
+ */
+class access_profiler {
+public:
+	using source_id = std::uint32_t;
+
+	enum class Format { CSV, JSON };
+
+	access_profiler(unsigned int page_bits = 12, std::uint32_t sample_interval = 1,
+	                bool per_source = false);
+	access_profiler(const access_profiler &) = delete;
+	access_profiler &operator=(const access_profiler &) = delete;
+
+	std::uint64_t get_page_length() const {
+		return std::uint64_t{1} << _page_bits;
+	}
+
+	std::uint32_t get_sample_interval() const {
+		return _sample_interval;
+	}
+
+	bool is_per_source() const {
+		return _per_source;
+	}
+
+	void set_source(source_id source) {
+		_source = _per_source ? source : 0;
+	}
+
+	source_id get_source() const {
+		return _source;
+	}
+
+	void record(address address, access_kind kind) {
+		if (_sample_interval > 1) {
+			if (--_sample_countdown != 0) {
+				return;
+			}
+			_sample_countdown = _sample_interval;
+		}
+
+		page_key key{_source, address >> _page_bits};
+		if (!_last_counters || key != _last_key) {
+			_last_counters = &get_page_counters(key);
+			_last_key = key;
+		}
+		(*_last_counters)[static_cast<std::size_t>(kind)].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	std::uint64_t get_count(address address, access_kind kind, source_id source = 0) const;
+
+	void reset();
+
+	void dump(std::ostream &stream, Format format) const;
+	void dump(const std::string &file_name, Format format) const;
+
+	void set_shutdown_dump(const std::string &file_name, Format format = Format::CSV) {
+		_shutdown_file_name = file_name;
+		_shutdown_format = format;
+	}
+
+	void dump_on_shutdown() const;
+
+	~access_profiler();
+
+private:
+	using page_key = std::pair<source_id, address>;
+	using page_counters = std::array<std::atomic<std::uint64_t>, access_kinds>;
+
+	page_counters &get_page_counters(const page_key &key);
+
+	void dump_csv(std::ostream &stream) const;
+	void dump_json(std::ostream &stream) const;
+
+	unsigned int _page_bits{};
+	std::uint32_t _sample_interval{};
+	std::uint32_t _sample_countdown{};
+	bool _per_source{};
+	source_id _source{};
+
+	page_key _last_key{};
+	page_counters *_last_counters{};
+
+	std::map<page_key, std::unique_ptr<page_counters>> _pages{};
+	mutable std::mutex _mutex{};
+
+	std::string _shutdown_file_name{};
+	Format _shutdown_format{Format::CSV};
+};
+
+using access_profiler_ptr = std::shared_ptr<access_profiler>;
+
+template<typename... Args>
+access_profiler_ptr make_access_profiler(Args &&... args) {
+	return std::make_shared<access_profiler>(std::forward<Args>(args)...);
+}
+
+} // namespace memory
+} // namespace harpoon
+
+#endif
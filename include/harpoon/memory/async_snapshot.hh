@@ -0,0 +1,68 @@
+#ifndef HARPOON_MEMORY_ASYNC_SNAPSHOT_HH
+#define HARPOON_MEMORY_ASYNC_SNAPSHOT_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/clock/clock.hh"
+#include "harpoon/memory/frozen_memory.hh"
+#include "harpoon/memory/serializer/serializer.hh"
+
+#include <atomic>
+#include <exception>
+#include <thread>
+
+namespace harpoon {
+namespace memory {
+
+/*
+ * Snapshot written in the background. The memory is frozen when the object is
+ * created (from the emulation thread, e.g. in a clock handler) and the
+ * emulation may continue right away; a worker thread serializes the frozen
+ * view and then releases the serializer. The snapshot keeps the memory alive
+ * until it is destroyed, as the frozen view refers to it.
+ */
+class async_snapshot {
+public:
+	async_snapshot(const memory_ptr &memory, const serializer::serializer_ptr &serializer,
+	               const clock::clock *clock = nullptr);
+	async_snapshot(const async_snapshot &) = delete;
+	async_snapshot &operator=(const async_snapshot &) = delete;
+
+	/* Tick at which the memory was frozen (0 without a clock). */
+	clock::tick_t get_tick() const {
+		return _tick;
+	}
+
+	bool is_done() const {
+		return _done.load(std::memory_order_acquire);
+	}
+
+	/* Wait for the worker; rethrows a serialization error. */
+	void wait();
+
+	~async_snapshot();
+
+private:
+	void write();
+
+	clock::tick_t _tick{};
+	memory_ptr _memory{};
+	frozen_memory_ptr _frozen{};
+	serializer::serializer_ptr _serializer{};
+
+	std::atomic<bool> _done{};
+	std::exception_ptr _error{};
+	std::thread _thread{};
+};
+
+using async_snapshot_ptr = std::shared_ptr<async_snapshot>;
+
+template<typename... Args>
+async_snapshot_ptr make_async_snapshot(Args &&... args) {
+	return std::make_shared<async_snapshot>(std::forward<Args>(args)...);
+}
+
+} // namespace memory
+} // namespace harpoon
+
+#endif
@@ -3,7 +3,9 @@
 
 #include "harpoon/harpoon.hh"
 
+#include "harpoon/memory/deserializer/deserializer.hh"
 #include "harpoon/memory/memory.hh"
+#include "harpoon/memory/shared_storage.hh"
 
 #include <vector>
 
@@ -25,18 +27,67 @@ public:
 	chunked_memory(const chunked_memory &) = delete;
 	chunked_memory &operator=(const chunked_memory &) = delete;
 
+	/*
+	 * Back the memory with a newly created shared memory object of that name,
+	 * starting with the next prepare(). Chunk n lives at offset n * chunk
+	 * length, so the object is a flat image of the memory. All chunks stay
+	 * allocated (untouched pages of the object cost nothing), freeze() copies
+	 * and lazy restore is done eagerly. cleanup() removes the object.
+	 */
+	void set_shared_memory_name(const std::string &name) {
+		_shared_memory_name = name;
+	}
+
+	const std::string &get_shared_memory_name() const {
+		return _shared_memory_name;
+	}
+
+	virtual std::shared_ptr<shared_storage> get_shared_storage() const override {
+		return _shared_storage;
+	}
+
 	virtual void prepare() override;
 	virtual void cleanup() override;
 
 	virtual void serialize(serializer::serializer &serializer) override;
 	virtual void deserialize(deserializer::deserializer &deserializer) override;
 
+	/*
+	 * Demand-paged restore: chunks fully covered by the deserializer are only
+	 * marked, and loaded from it on first access. Each marked chunk keeps a
+	 * reference to its deserializer until it is loaded or the memory is
+	 * cleaned up.
+	 */
+	void deserialize_lazily(const deserializer::deserializer_ptr &deserializer);
+
+	std::size_t get_lazy_chunks() const {
+		return _lazy_chunks;
+	}
+
+	/*
+	 * Shares all chunks with the frozen view. A shared chunk is copied before
+	 * it is written, so only chunks modified while the view is alive cost a
+	 * copy. Chunks pending lazy restore are loaded first.
+	 */
+	virtual std::shared_ptr<frozen_memory> freeze() override;
+
+	/* Tracked per chunk; every chunk starts dirty. */
+	virtual void get_dirty(std::vector<address_range> &ranges) const override;
+	virtual void clear_dirty() override;
+	virtual void get_dirty_since(std::uint64_t epoch,
+	                             std::vector<address_range> &ranges) const override;
+
+	/* One block per chunk; hashes are kept until the chunk is written. */
+	virtual void get_block_hashes(std::vector<block_hash> &hashes) override;
+
 	virtual ~chunked_memory() override;
 
 protected:
 	virtual void get_cell(address address, uint8_t &value) override;
 	virtual void set_cell(address address, uint8_t value) override;
 
+	virtual bool do_get_span(address address, bool write, span &span) override;
+
 	chunk_index get_chunk_index(address address) const {
 		return static_cast<chunk_index>(get_offset(address) / _chunk_length);
 	}
@@ -55,9 +106,50 @@ protected:
 
 	inline void allocate_chunk(chunk_ptr &chunk, address address);
 
+	/* Make a chunk shared with a frozen view private before writing to it. */
+	void unshare_chunk(chunk_ptr &chunk) {
+		if (chunk.use_count() > 1) {
+			copy_chunk(chunk);
+		}
+	}
+
+	void copy_chunk(chunk_ptr &chunk);
+
+	bool is_lazy(chunk_index index) const {
+		return _lazy_chunks && _lazy[index];
+	}
+
+	void load_chunk(chunk_index index);
+	void discard_lazy(chunk_index index);
+
+	void mark_written(chunk_index index) {
+		_flags[index] = 0;
+		_written[index] = get_dirty_epoch();
+	}
+
 private:
+	class frozen;
+
+	address_range get_chunk_range(chunk_index index) const;
+	void restore_chunk(deserializer::deserializer &deserializer, chunk_index index);
+	void serialize_chunks(serializer::serializer &serializer,
+	                      const chunk_container &chunks) const;
+
 	chunk_length _chunk_length{};
 	chunk_container _memory{};
+
+	/* Per chunk: hash cached until written, dirty epoch of the last write. */
+	static constexpr std::uint8_t chunk_hashed = 1;
+	std::vector<std::uint8_t> _flags{};
+	std::vector<std::uint64_t> _hashes{};
+	std::vector<std::uint64_t> _written{};
+	std::uint64_t _cleared{};
+
+	std::string _shared_memory_name{};
+	shared_storage_ptr _shared_storage{};
+
+	std::vector<deserializer::deserializer_ptr> _lazy{};
+	std::size_t _lazy_chunks{};
 };
 
 } // namespace memory
@@ -0,0 +1,66 @@
+#ifndef HARPOON_MEMORY_CONTAINER_HH
+#define HARPOON_MEMORY_CONTAINER_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/memory/address_range.hh"
+
+#include <vector>
+
+namespace harpoon {
+namespace memory {
+namespace container {
+
+/*
+ * Snapshot container layout (all integers little-endian):
+ *   header: magic "HRPNSNP1", u32 version, u32 block length, u64 range start,
+ *           u64 range end, u64 index offset, u64 block count, u64 index checksum
+ *   blocks: stored payloads, in index order
+ *   index:  one entry per block: u64 start address, u32 length, u32 flags,
+ *           u64 file offset, u32 stored length, u32 reserved, u64 checksum
+ *
+ * Blocks cover at most one block length of address space and never cross a
+ * block length boundary. Ranges without a block read as zero. Payloads are
+ * LZ-compressed unless that did not make them smaller (flag RAW). Checksums
+ * are util::hash::hash64 of the uncompressed data and of the encoded index.
+ */
+static constexpr char file_magic[8] = {'H', 'R', 'P', 'N', 'S', 'N', 'P', '1'};
+static constexpr std::uint32_t file_version = 1;
+static constexpr std::size_t header_length = 56;
+static constexpr std::size_t index_entry_length = 40;
+
+enum block_flag : std::uint32_t { RAW = 1 };
+
+struct header {
+	std::uint32_t version;
+	std::uint32_t block_length;
+	address_range range;
+	std::uint64_t index_offset;
+	std::uint64_t block_count;
+	std::uint64_t index_checksum;
+};
+
+struct index_entry {
+	harpoon::memory::address start;
+	std::uint32_t length;
+	std::uint32_t flags;
+	std::uint64_t offset;
+	std::uint32_t stored_length;
+	std::uint64_t checksum;
+
+	address_range get_range() const {
+		return {start, start + length - 1};
+	}
+};
+
+void encode_header(const header &header, std::uint8_t *output);
+bool decode_header(const std::uint8_t *data, header &header);
+
+void encode_index_entry(const index_entry &entry, std::uint8_t *output);
+void decode_index_entry(const std::uint8_t *data, index_entry &entry);
+
+} // namespace container
+} // namespace memory
+} // namespace harpoon
+
+#endif
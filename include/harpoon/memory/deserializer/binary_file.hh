@@ -4,23 +4,42 @@
 #include "harpoon/harpoon.hh"
 
 #include "harpoon/memory/deserializer/deserializer.hh"
-
-#include <fstream>
+#include "harpoon/util/file.hh"
 
 namespace harpoon {
 namespace memory {
 namespace deserializer {
 
+/*
+ * Raw image starting at the base address. Holes in the file are located with
+ * SEEK_DATA/SEEK_HOLE where the platform has them: they are reported by
+ * has_data() and zero-filled without being read.
+ */
 class binary_file : public deserializer {
 public:
 	binary_file(address base, const std::string &file_name);
+	binary_file(const binary_file &) = delete;
+	binary_file &operator=(const binary_file &) = delete;
+
+	virtual bool has_data(const address_range &range) override;
+
+	virtual bool is_concurrent() const override {
+		return true;
+	}
+
+	virtual ~binary_file() override;
 
 protected:
-	virtual std::size_t do_read(const memory *memory, uint8_t *data, const address_range &range);
+	virtual std::size_t do_read(const memory *memory, uint8_t *data,
+	                            const address_range &range) override;
 
 private:
+	bool find_data(std::size_t &start, std::size_t &end, std::size_t limit);
+	void read_data(uint8_t *data, std::size_t position, std::size_t length);
+
 	std::string _file_name{};
-	std::ifstream _input{};
+	util::file _file{};
+	std::size_t _file_length{};
 };
 
 } // namespace deserializer
@@ -0,0 +1,65 @@
+#ifndef HARPOON_MEMORY_DESERIALIZER_CONTAINER_FILE_HH
+#define HARPOON_MEMORY_DESERIALIZER_CONTAINER_FILE_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/memory/container.hh"
+#include "harpoon/memory/deserializer/deserializer.hh"
+#include "harpoon/util/file.hh"
+#include "harpoon/util/thread_pool.hh"
+
+#include <vector>
+
+namespace harpoon {
+namespace memory {
+namespace deserializer {
+
+/*
+ * Reader for serializer::container_file snapshots. Only the index is loaded
+ * up front; reads locate the blocks overlapping the requested range and
+ * decompress just those, in parallel when several are needed.
+ */
+class container_file : public deserializer {
+public:
+	container_file(const std::string &file_name,
+	               const util::thread_pool_ptr &thread_pool = util::get_thread_pool());
+	container_file(const container_file &) = delete;
+	container_file &operator=(const container_file &) = delete;
+
+	const container::header &get_header() const {
+		return _header;
+	}
+
+	const std::vector<container::index_entry> &get_index() const {
+		return _index;
+	}
+
+	virtual bool has_data(const address_range &range) override;
+
+	virtual bool is_concurrent() const override {
+		return true;
+	}
+
+	virtual ~container_file() override;
+
+protected:
+	virtual std::size_t do_read(const memory *memory, uint8_t *data,
+	                            const address_range &range) override;
+
+private:
+	std::vector<container::index_entry>::const_iterator find_block(address address) const;
+	void read_at(void *data, std::size_t length, std::uint64_t offset);
+	void load_block(const container::index_entry &entry, uint8_t *output);
+
+	std::string _file_name{};
+	util::file _file{};
+	util::thread_pool_ptr _thread_pool{};
+	container::header _header{};
+	std::vector<container::index_entry> _index{};
+};
+
+} // namespace deserializer
+} // namespace memory
+} // namespace harpoon
+
+#endif
@@ -19,8 +19,15 @@ public:
 	}
 
 	virtual address_range has_range(const address_range &range);
+
+	/* False when the input is known to hold only zeros within the range. */
+	virtual bool has_data(const address_range &range);
+
 	virtual std::size_t read(const memory *memory, uint8_t *data, const address_range &range);
 
+	/* True when has_data() and read() may be called from several threads at once. */
+	virtual bool is_concurrent() const;
+
 	virtual ~deserializer();
 
 protected:
@@ -34,6 +41,8 @@ private:
 	address_range _range{};
 };
 
+using deserializer_ptr = std::shared_ptr<deserializer>;
+
 } // namespace deserializer
 } // namespace memory
 } // namespace harpoon
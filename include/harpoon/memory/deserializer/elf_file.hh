@@ -0,0 +1,32 @@
+#ifndef HARPOON_MEMORY_DESERIALIZER_ELF_FILE_HH
+#define HARPOON_MEMORY_DESERIALIZER_ELF_FILE_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/memory/deserializer/image_file.hh"
+
+namespace harpoon {
+namespace memory {
+namespace deserializer {
+
+/*
+ * Loadable segments of a 32 or 64-bit ELF file of either byte order. Segments
+ * are placed at their physical (load) address unless virtual addresses are
+ * requested, and read in file order; the part of a segment beyond its file
+ * size reads as zero. The entry point is taken from the header.
+ */
+class elf_file : public image_file {
+public:
+	elf_file(const std::string &file_name, bool virtual_addresses = false);
+
+	virtual ~elf_file() override;
+
+private:
+	void parse(bool virtual_addresses);
+};
+
+} // namespace deserializer
+} // namespace memory
+} // namespace harpoon
+
+#endif
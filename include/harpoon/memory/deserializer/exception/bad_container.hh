@@ -0,0 +1,28 @@
+#ifndef HARPOON_MEMORY_DESERIALIZER_EXCEPTION_BAD_CONTAINER_HH
+#define HARPOON_MEMORY_DESERIALIZER_EXCEPTION_BAD_CONTAINER_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/exception/harpoon_exception.hh"
+
+namespace harpoon {
+namespace memory {
+namespace deserializer {
+namespace exception {
+
+class bad_container : public harpoon::exception::harpoon_exception {
+public:
+	bad_container(const std::string &container_file, const std::string &reason,
+	              const std::string &file = {}, int line = {}, const std::string &function = {});
+	bad_container(const bad_container &) = default;
+	bad_container &operator=(const bad_container &) = default;
+
+	virtual ~bad_container();
+};
+
+} // namespace exception
+} // namespace deserializer
+} // namespace memory
+} // namespace harpoon
+
+#endif
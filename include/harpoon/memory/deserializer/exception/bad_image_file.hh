@@ -0,0 +1,28 @@
+#ifndef HARPOON_MEMORY_DESERIALIZER_EXCEPTION_BAD_IMAGE_FILE_HH
+#define HARPOON_MEMORY_DESERIALIZER_EXCEPTION_BAD_IMAGE_FILE_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/exception/harpoon_exception.hh"
+
+namespace harpoon {
+namespace memory {
+namespace deserializer {
+namespace exception {
+
+class bad_image_file : public harpoon::exception::harpoon_exception {
+public:
+	bad_image_file(const std::string &image_file, const std::string &reason,
+	               const std::string &file = {}, int line = {}, const std::string &function = {});
+	bad_image_file(const bad_image_file &) = default;
+	bad_image_file &operator=(const bad_image_file &) = default;
+
+	virtual ~bad_image_file();
+};
+
+} // namespace exception
+} // namespace deserializer
+} // namespace memory
+} // namespace harpoon
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef HARPOON_MEMORY_DESERIALIZER_EXCEPTION_BAD_STREAM_HH
+#define HARPOON_MEMORY_DESERIALIZER_EXCEPTION_BAD_STREAM_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/exception/harpoon_exception.hh"
+
+namespace harpoon {
+namespace memory {
+namespace deserializer {
+namespace exception {
+
+class bad_stream : public harpoon::exception::harpoon_exception {
+public:
+	bad_stream(const std::string &reason, const std::string &file = {}, int line = {},
+	           const std::string &function = {});
+	bad_stream(const bad_stream &) = default;
+	bad_stream &operator=(const bad_stream &) = default;
+
+	virtual ~bad_stream();
+};
+
+} // namespace exception
+} // namespace deserializer
+} // namespace memory
+} // namespace harpoon
+
+#endif
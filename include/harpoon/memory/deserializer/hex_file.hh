@@ -0,0 +1,31 @@
+#ifndef HARPOON_MEMORY_DESERIALIZER_HEX_FILE_HH
+#define HARPOON_MEMORY_DESERIALIZER_HEX_FILE_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/memory/deserializer/image_file.hh"
+
+namespace harpoon {
+namespace memory {
+namespace deserializer {
+
+/*
+ * Intel HEX image. Data records are placed at the extended linear (04) or
+ * extended segment (02) base; start address records (03, 05) set the entry
+ * point. The end of file record (01) is required.
+ */
+class hex_file : public image_file {
+public:
+	hex_file(const std::string &file_name);
+
+	virtual ~hex_file() override;
+
+private:
+	void parse();
+};
+
+} // namespace deserializer
+} // namespace memory
+} // namespace harpoon
+
+#endif
@@ -0,0 +1,107 @@
+#ifndef HARPOON_MEMORY_DESERIALIZER_IMAGE_FILE_HH
+#define HARPOON_MEMORY_DESERIALIZER_IMAGE_FILE_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/memory/deserializer/memory_buffer.hh"
+#include "harpoon/util/file.hh"
+
+#include <vector>
+
+namespace harpoon {
+namespace memory {
+namespace deserializer {
+
+/*
+ * Base of the firmware image loaders. The file is parsed once, front to back,
+ * when the loader is constructed; contiguous records are coalesced into
+ * extents of the image, so restoring copies large blocks. The range of the
+ * deserializer is the hull of the segments and everything between them reads
+ * as zero.
+ */
+class image_file : public memory_buffer {
+public:
+	image_file(const image_file &) = delete;
+	image_file &operator=(const image_file &) = delete;
+
+	const std::string &get_file_name() const {
+		return _file_name;
+	}
+
+	/* Coalesced address ranges holding data, sorted. */
+	const std::vector<address_range> &get_segments() const {
+		return _segments;
+	}
+
+	/* Entry point recorded in the file, if any. */
+	bool has_entry() const {
+		return _has_entry;
+	}
+
+	address get_entry() const {
+		return _entry;
+	}
+
+	virtual ~image_file() override;
+
+protected:
+	static constexpr std::size_t input_length = 65536;
+	static constexpr std::size_t block_length = 1048576;
+
+	image_file(const std::string &file_name, const address_range &address_space);
+
+	/* Reads up to length bytes from the current position; 0 at the end of the file. */
+	std::size_t read_input(uint8_t *data, std::size_t length);
+
+	/* Reads exactly length bytes at the position. */
+	void read_input_at(uint8_t *data, std::size_t position, std::size_t length);
+
+	/* Next line without its terminator; false at the end of the file. */
+	bool next_line(const char *&line, std::size_t &length);
+
+	std::size_t get_line_number() const {
+		return _line_number;
+	}
+
+	/* Decodes length bytes from pairs of hex digits; false on a bad digit. */
+	static bool decode_hex(const char *text, uint8_t *data, std::size_t length);
+
+	void add(address start, const uint8_t *data, std::size_t length);
+	void add_zero(address start, std::size_t length);
+
+	void set_entry(address entry) {
+		_entry = entry;
+		_has_entry = true;
+	}
+
+	/* Called by the loaders once parsing is done. */
+	void finish();
+
+	[[noreturn]] void fail(const std::string &reason) const;
+
+private:
+	void flush();
+	void insert(address start, const uint8_t *data, std::size_t length);
+
+	std::string _file_name{};
+	util::file _file{};
+
+	std::vector<char> _input{};
+	std::size_t _input_start{};
+	std::size_t _input_end{};
+	bool _input_ended{};
+	std::size_t _line_number{};
+
+	std::vector<uint8_t> _pending{};
+	address _pending_start{};
+	std::vector<address_range> _segments{};
+
+	address _entry{};
+	bool _has_entry{};
+};
+
+} // namespace deserializer
+} // namespace memory
+} // namespace harpoon
+
+#endif
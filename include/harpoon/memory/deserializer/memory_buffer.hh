@@ -0,0 +1,47 @@
+#ifndef HARPOON_MEMORY_DESERIALIZER_MEMORY_BUFFER_HH
+#define HARPOON_MEMORY_DESERIALIZER_MEMORY_BUFFER_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/memory/deserializer/deserializer.hh"
+#include "harpoon/memory/memory_image.hh"
+
+namespace harpoon {
+namespace memory {
+namespace deserializer {
+
+/*
+ * Restores from a memory_image. Restoring into the layout the image was taken
+ * from costs one memcpy per chunk; sparse extents and gaps read as zero and
+ * are reported by has_data().
+ */
+class memory_buffer : public deserializer {
+public:
+	memory_buffer(const memory_image_ptr &image)
+	    : deserializer(image->get_range()), _image(image) {}
+
+	const memory_image_ptr &get_image() const {
+		return _image;
+	}
+
+	virtual bool has_data(const address_range &range) override;
+
+	virtual bool is_concurrent() const override {
+		return true;
+	}
+
+	virtual ~memory_buffer() override;
+
+protected:
+	virtual std::size_t do_read(const memory *memory, uint8_t *data,
+	                            const address_range &range) override;
+
+private:
+	memory_image_ptr _image{};
+};
+
+} // namespace deserializer
+} // namespace memory
+} // namespace harpoon
+
+#endif
@@ -0,0 +1,69 @@
+#ifndef HARPOON_MEMORY_DESERIALIZER_RECORD_STREAM_HH
+#define HARPOON_MEMORY_DESERIALIZER_RECORD_STREAM_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/memory/deserializer/deserializer.hh"
+#include "harpoon/memory/record_stream.hh"
+
+#include <istream>
+#include <vector>
+
+namespace harpoon {
+namespace memory {
+namespace deserializer {
+
+/*
+ * Reads a record stream in one pass. Memories have to be restored in the
+ * order they were serialized, though any of them may be left out: blocks that
+ * do not contain a read are skipped, a read never moves past the end of the
+ * block containing it, and data that has already been passed reads as zero.
+ * Only a small fixed buffer is used for skipping.
+ */
+class record_stream : public deserializer {
+public:
+	record_stream(std::istream &input, std::size_t skip_length = 65536);
+	record_stream(const record_stream &) = delete;
+	record_stream &operator=(const record_stream &) = delete;
+
+	virtual bool has_data(const address_range &range) override;
+
+	virtual ~record_stream() override;
+
+protected:
+	virtual std::size_t do_read(const memory *memory, uint8_t *data,
+	                            const address_range &range) override;
+
+private:
+	bool advance(address address);
+	void next_record();
+	void read_payload(uint8_t *data, std::size_t length);
+	void skip_payload(std::size_t length);
+
+	address get_position() const {
+		return _record.address + _consumed;
+	}
+
+	address get_record_end() const {
+		return _record.address + _record.length - 1;
+	}
+
+	bool in_block(address address) const {
+		return _block && _block.has_address(address);
+	}
+
+	std::istream &_input;
+	std::vector<uint8_t> _skip{};
+
+	harpoon::memory::record_stream::record _record{};
+	address_range _block{};
+	std::uint64_t _consumed{};
+	bool _have_record{};
+	bool _ended{};
+};
+
+} // namespace deserializer
+} // namespace memory
+} // namespace harpoon
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef HARPOON_MEMORY_DESERIALIZER_SREC_FILE_HH
+#define HARPOON_MEMORY_DESERIALIZER_SREC_FILE_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/memory/deserializer/image_file.hh"
+
+namespace harpoon {
+namespace memory {
+namespace deserializer {
+
+/*
+ * Motorola S-record image. S1, S2 and S3 records hold data, S7, S8 and S9
+ * set the entry point and end the image; header (S0) and count (S5, S6)
+ * records are ignored.
+ */
+class srec_file : public image_file {
+public:
+	srec_file(const std::string &file_name);
+
+	virtual ~srec_file() override;
+
+private:
+	void parse();
+};
+
+} // namespace deserializer
+} // namespace memory
+} // namespace harpoon
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef HARPOON_MEMORY_EXCEPTION_SHARED_MEMORY_ERROR_HH
+#define HARPOON_MEMORY_EXCEPTION_SHARED_MEMORY_ERROR_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/exception/harpoon_exception.hh"
+
+namespace harpoon {
+namespace memory {
+namespace exception {
+
+class shared_memory_error : public harpoon::exception::harpoon_exception {
+public:
+	shared_memory_error(const std::string &object, const std::string &reason,
+	                    const std::string &file = {}, int line = {},
+	                    const std::string &function = {});
+	shared_memory_error(const shared_memory_error &) = default;
+	shared_memory_error &operator=(const shared_memory_error &) = default;
+
+	virtual ~shared_memory_error();
+};
+
+} // namespace exception
+} // namespace memory
+} // namespace harpoon
+
+#endif
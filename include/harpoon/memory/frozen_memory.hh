@@ -0,0 +1,37 @@
+#ifndef HARPOON_MEMORY_FROZEN_MEMORY_HH
+#define HARPOON_MEMORY_FROZEN_MEMORY_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/memory/memory.hh"
+
+namespace harpoon {
+namespace memory {
+
+namespace serializer {
+class serializer;
+}
+
+/*
+ * Contents of a memory captured by memory::freeze(). Serializing it produces
+ * the same output the memory would have produced at the time it was frozen,
+ * and may run concurrently with further accesses to the memory. The memory
+ * itself must outlive the frozen view.
+ */
+class frozen_memory {
+public:
+	frozen_memory() = default;
+	frozen_memory(const frozen_memory &) = delete;
+	frozen_memory &operator=(const frozen_memory &) = delete;
+
+	virtual void serialize(serializer::serializer &serializer) = 0;
+
+	virtual ~frozen_memory();
+};
+
+using frozen_memory_ptr = std::shared_ptr<frozen_memory>;
+
+} // namespace memory
+} // namespace harpoon
+
+#endif
@@ -94,6 +94,11 @@ protected:
 		}
 	}
 
+	/* Ports have side effects, so there is no direct access to the storage. */
+	virtual bool do_get_span(address, bool, memory::span &) override {
+		return false;
+	}
+
 
 private:
 	std::map<address, port> _ports{};
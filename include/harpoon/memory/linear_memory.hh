@@ -4,6 +4,7 @@
 #include "harpoon/harpoon.hh"
 
 #include "harpoon/memory/memory.hh"
+#include "harpoon/memory/shared_storage.hh"
 
 namespace harpoon {
 namespace memory {
@@ -15,20 +16,48 @@ public:
 	linear_memory(const linear_memory &) = delete;
 	linear_memory &operator=(const linear_memory &) = delete;
 
+	/*
+	 * Back the memory with a newly created shared memory object of that name
+	 * instead of the heap, starting with the next prepare(). The object is
+	 * removed again by cleanup().
+	 */
+	void set_shared_memory_name(const std::string &name) {
+		_shared_memory_name = name;
+	}
+
+	const std::string &get_shared_memory_name() const {
+		return _shared_memory_name;
+	}
+
+	virtual std::shared_ptr<shared_storage> get_shared_storage() const override {
+		return _shared_storage;
+	}
+
 	virtual void prepare() override;
 	virtual void cleanup() override;
 
 	virtual void serialize(serializer::serializer &serializer) override;
 	virtual void deserialize(deserializer::deserializer &deserializer) override;
 
+	/* Same blocks as the default, hashed in parallel. */
+	virtual void get_block_hashes(std::vector<block_hash> &hashes) override;
+
 	virtual ~linear_memory() override;
 
 protected:
 	virtual void get_cell(address address, uint8_t &value) override;
 	virtual void set_cell(address address, uint8_t value) override;
 
+	virtual bool do_get_span(address address, bool write, span &span) override;
+
 private:
+	/* Granularity at which zero runs are passed to serializers as sparse. */
+	static constexpr std::size_t zero_granularity = 65536;
+
 	std::unique_ptr<std::uint8_t[]> _memory{};
+	std::string _shared_memory_name{};
+	shared_storage_ptr _shared_storage{};
+	std::uint8_t *_data{};
 };
 
 } // namespace memory
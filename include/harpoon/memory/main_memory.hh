@@ -3,15 +3,28 @@
 
 #include "harpoon/harpoon.hh"
 
+#include "harpoon/memory/access_profiler.hh"
 #include "harpoon/memory/memory.hh"
+#include "harpoon/memory/shared_memory_descriptor.hh"
+#include "harpoon/memory/watchpoint.hh"
 
+#include <array>
+#include <functional>
 #include <list>
+#include <map>
+#include <unordered_map>
 
 namespace harpoon {
 namespace memory {
 
 class main_memory : public memory {
 public:
+	using watchpoint_id = unsigned int;
+	using code_write_handler = std::function<void(const address_range &)>;
+	using code_write_handler_id = unsigned int;
+
+	static constexpr unsigned int page_bits = 12;
+
 	main_memory(const std::string &name = {},
 	            const address_range &address_range = {0, address_range::max()})
 	    : memory(name, address_range) {}
@@ -23,21 +36,130 @@ public:
 	virtual void replace_memory(const memory_ptr &old_memory, const memory_ptr &new_memory,
 	                            bool owner = true);
 
+	/* Sets the pool of the added memories too, and of memories added later without one. */
+	virtual void set_thread_pool(const util::thread_pool_ptr &thread_pool) override;
+
+	/* Smallest range covering all added memories; empty when there are none. */
+	address_range get_mapped_range() const;
+
+	/* Layout of the added memories exported through shared storage, once prepared. */
+	shared_memory_descriptor get_shared_memory_descriptor() const;
+
+	void set_access_profiler(const access_profiler_ptr &access_profiler) {
+		_access_profiler = access_profiler;
+	}
+
+	const access_profiler_ptr &get_access_profiler() const {
+		return _access_profiler;
+	}
+
+	/* Read watchpoints see instruction fetches too, as access_kind::FETCH. */
+	watchpoint_id add_watchpoint(const watchpoint &watchpoint);
+	void remove_watchpoint(watchpoint_id id);
+	void clear_watchpoints();
+
+	/*
+	 * Pages holding decoded instructions are marked as code. The first write
+	 * to a code page through this memory clears the mark and passes the page
+	 * range to the handlers, so decoded copies can be dropped. Restoring the
+	 * memory or removing a memory from it reports every code page.
+	 */
+	code_write_handler_id add_code_write_handler(const code_write_handler &handler);
+	void remove_code_write_handler(code_write_handler_id id);
+	void mark_code(const address_range &range);
+	void invalidate_code();
+
+	virtual void shutdown() override;
+
 	virtual void serialize(serializer::serializer &serializer) override;
 	virtual void deserialize(deserializer::deserializer &deserializer) override;
 
+	virtual std::shared_ptr<frozen_memory> freeze() override;
+
+	virtual void get_dirty(std::vector<address_range> &ranges) const override;
+	virtual void clear_dirty() override;
+	virtual void get_dirty_since(std::uint64_t epoch,
+	                             std::vector<address_range> &ranges) const override;
+	virtual void get_mapped(std::vector<address_range> &ranges) const override;
+
+	/* Blocks of all mapped memories, in address order. */
+	virtual void get_block_hashes(std::vector<block_hash> &hashes) override;
+
 	virtual ~main_memory() override;
 
 protected:
 	virtual void get_cell(address address, uint8_t &value) override;
 	virtual void set_cell(address address, uint8_t value) override;
+	virtual void fetch_cell(address address, uint8_t &value) override;
+
+	virtual bool do_get_span(address address, bool write, span &span) override;
 
 private:
-	const memory_ptr &get_memory(address address);
+	/*
+	 * Pages with any of these flags take the slow path on the matching
+	 * access. Flags are cached in the TLB together with the page's memory, so
+	 * accesses to ordinary pages cost a single flag test. Code pages are kept
+	 * in _page_flags; watch flags are looked up in the watch segments when a
+	 * page enters the TLB, so only pages actually accessed pay for them.
+	 */
+	enum page_flag : std::uint32_t {
+		WATCH_READ = 1,
+		WATCH_WRITE = 2,
+		CODE = 4,
+	};
+
+	struct tlb_entry {
+		address page{};
+		harpoon::memory::memory *memory{};
+		std::uint32_t flags{};
+	};
+
+	/* Watchpoints covering the addresses from the key up to the next key. */
+	struct watch_counts {
+		unsigned int reads{};
+		unsigned int writes{};
+
+		bool operator==(const watch_counts &counts) const {
+			return reads == counts.reads && writes == counts.writes;
+		}
+	};
+
+	static constexpr std::size_t tlb_entries = 256;
+
+	memory *find_memory(address address, std::uint32_t &flags) {
+		auto page = address >> page_bits;
+		const tlb_entry &entry = _tlb[page & (tlb_entries - 1)];
+		if (entry.memory && entry.page == page) {
+			flags = entry.flags;
+			return entry.memory;
+		}
+		return fill_tlb(address, flags);
+	}
+
+	memory *fill_tlb(address address, std::uint32_t &flags);
+	void flush_tlb();
+	void set_tlb_code(address page, bool code);
+
+	void update_watch_segments(const watchpoint &watchpoint, int delta);
+	void split_watch_segment(address address);
+	void merge_watch_segment(address address);
+	std::uint32_t get_watch_flags(address page) const;
+	void check_watchpoints(address address, std::uint8_t value, access_kind kind);
+	void invalidate_code_page(address page);
 
 	std::list<memory_ptr> _memory;
-	memory_ptr _last_used_memory;
-	address_range _last_used_range;
+	std::array<tlb_entry, tlb_entries> _tlb{};
+	std::unordered_map<address, std::uint32_t> _page_flags{};
+
+	std::map<watchpoint_id, watchpoint> _watchpoints{};
+	std::map<address, watch_counts> _watch_segments{};
+	watchpoint_id _next_watchpoint_id{};
+
+	std::map<code_write_handler_id, code_write_handler> _code_write_handlers{};
+	code_write_handler_id _next_code_write_handler_id{};
+	std::size_t _code_pages{};
+
+	access_profiler_ptr _access_profiler{};
 };
 
 using main_memory_ptr = std::shared_ptr<main_memory>;
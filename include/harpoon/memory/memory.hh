@@ -5,8 +5,12 @@
 
 #include "harpoon/hardware_component.hh"
 #include "harpoon/memory/address_range.hh"
+#include "harpoon/util/thread_pool.hh"
 
+#include <atomic>
+#include <functional>
 #include <list>
+#include <vector>
 
 namespace harpoon {
 namespace memory {
@@ -19,13 +23,36 @@ namespace deserializer {
 class deserializer;
 }
 
+namespace trace {
+class recorder;
+}
+
 class memory;
+class memory_image;
+class shared_storage;
+class write_journal;
+class frozen_memory;
 
 using memory_ptr = std::shared_ptr<memory>;
 using memory_weak_ptr = std::weak_ptr<memory>;
 
 class memory : public hardware_component {
 public:
+	/*
+	 * Contiguous piece of backing storage containing a requested address.
+	 * A null data pointer marks an unallocated range which reads as zeros.
+	 */
+	struct span {
+		address_range range;
+		std::uint8_t *data;
+	};
+
+	/* Content hash of a block of the memory; unallocated storage hashes as zeros. */
+	struct block_hash {
+		address_range range;
+		std::uint64_t hash;
+	};
+
 	memory(const std::string &name = {}, const address_range &address_range = {})
 	    : hardware_component(name), _address_range(address_range) {}
 
@@ -61,17 +88,165 @@ public:
 	void get(address address, std::uint64_t &value);
 	void set(address address, std::uint64_t value);
 
+	void fetch(address address, std::uint8_t &value);
+	void fetch(address address, std::uint16_t &value);
+	void fetch(address address, std::uint32_t &value);
+	void fetch(address address, std::uint64_t &value);
+
+	/*
+	 * Returns false when the address has no directly accessible storage (or
+	 * when access hooks are attached), in which case byte accessors have to
+	 * be used. With write set, unallocated storage is allocated.
+	 */
+	bool get_span(address address, bool write, span &span);
+
+	/* Bulk copies through get_span(), falling back to byte accessors. */
+	void read(const address_range &range, std::uint8_t *data);
+	void write(const address_range &range, const std::uint8_t *data);
+
+	/* Searches the mapped parts of the range; a match does not span an unmapped gap. */
+	bool find(const address_range &range, const std::uint8_t *pattern, const std::uint8_t *mask,
+	          std::size_t length, address &found);
+	void fill(const address_range &range, std::uint8_t value);
+	/* Compares the addresses mapped in both memories and skips the others. */
+	bool compare(const address_range &range, memory &other, address other_start,
+	             address &difference);
+
+	void set_access_recorder(const std::shared_ptr<trace::recorder> &access_recorder) {
+		_access_recorder = access_recorder;
+	}
+
+	const std::shared_ptr<trace::recorder> &get_access_recorder() const {
+		return _access_recorder;
+	}
+
+	void set_write_journal(const std::shared_ptr<write_journal> &write_journal) {
+		_write_journal = write_journal;
+	}
+
+	const std::shared_ptr<write_journal> &get_write_journal() const {
+		return _write_journal;
+	}
+
+	/*
+	 * Pool used to scan and restore the memory in parallel batches, e.g.
+	 * util::get_thread_pool(). There is none by default and everything runs on
+	 * the calling thread.
+	 */
+	virtual void set_thread_pool(const util::thread_pool_ptr &thread_pool) {
+		_thread_pool = thread_pool;
+	}
+
+	const util::thread_pool_ptr &get_thread_pool() const {
+		return _thread_pool;
+	}
+
 	virtual void serialize(serializer::serializer &serializer);
 	virtual void deserialize(deserializer::deserializer &deserializer);
 
+	/*
+	 * Ranges possibly written since the last clear_dirty(). Memories that do
+	 * not track writes report their whole range.
+	 */
+	virtual void get_dirty(std::vector<address_range> &ranges) const;
+	virtual void clear_dirty();
+
+	/*
+	 * Dirty tracking for users other than the owner of clear_dirty():
+	 * get_dirty_since() reports the ranges possibly written since
+	 * start_dirty_epoch() returned the epoch, without affecting anyone else.
+	 */
+	static std::uint64_t start_dirty_epoch();
+	virtual void get_dirty_since(std::uint64_t epoch, std::vector<address_range> &ranges) const;
+
+	/* Ranges backed by a memory, in the order get_dirty() reports them. */
+	virtual void get_mapped(std::vector<address_range> &ranges) const;
+
+	/*
+	 * Append hashes of consecutive blocks covering the memory, in address
+	 * order. The default hashes 64 KiB blocks on every call; memories that
+	 * track writes use their own granularity and cache the hashes.
+	 */
+	virtual void get_block_hashes(std::vector<block_hash> &hashes);
+
+	std::uint64_t get_digest();
+	static std::uint64_t get_digest(const std::vector<block_hash> &hashes);
+
+	/*
+	 * Append the ranges where the contents differ from the same addresses of
+	 * the other memory, or of the image (where unstored addresses read as
+	 * zero). Blocks with equal ranges and hashes on both sides are skipped
+	 * without reading them; only the remaining ones are compared.
+	 */
+	void diff(memory &other, std::vector<address_range> &ranges);
+	void diff(const memory_image &image, const std::vector<block_hash> &image_hashes,
+	          std::vector<address_range> &ranges);
+
+	/* Shared memory object holding the contents, if the memory is exported. */
+	virtual std::shared_ptr<shared_storage> get_shared_storage() const;
+
+	/*
+	 * Capture the current contents for serialization at a later time, possibly
+	 * on another thread. The default copies everything; memories able to
+	 * share their storage copy-on-write override it.
+	 */
+	virtual std::shared_ptr<frozen_memory> freeze();
+
 	virtual ~memory();
 
 protected:
 	virtual void get_cell(address address, std::uint8_t &value) = 0;
 	virtual void set_cell(address address, std::uint8_t value) = 0;
 
+	/*
+	 * Instruction fetch. Behaves like get_cell() unless a memory needs to tell
+	 * fetches apart from data reads.
+	 */
+	virtual void fetch_cell(address address, std::uint8_t &value);
+
+	virtual bool do_get_span(address address, bool write, span &span);
+
+	static constexpr std::size_t hash_block_length = 65536;
+
+	/* Epoch to record for a write made now. */
+	static std::uint64_t get_dirty_epoch() {
+		return _dirty_epoch.load(std::memory_order_relaxed);
+	}
+
+	/* Amount of storage handled by one parallel serialization task. */
+	static constexpr std::size_t batch_length = 1048576;
+
+	/* Run task(first, last) over [0, count) in pieces of at most batch items. */
+	void run_batches(std::size_t count, std::size_t batch,
+	                 const std::function<void(std::size_t, std::size_t)> &task) const;
+
 private:
+	template<typename T>
+	void read_cells(address address, T &value);
+	template<typename T>
+	void write_cells(address address, T value);
+	template<typename T>
+	void fetch_cells(address address, T &value);
+
+	bool matches_at(address address, const std::uint8_t *pattern, const std::uint8_t *mask,
+	                std::size_t length);
+	bool find_mapped(const address_range &range, const std::uint8_t *pattern,
+	                 const std::uint8_t *mask, std::size_t length, address &found);
+	bool compare_mapped(const address_range &range, memory &other, address other_start,
+	                    address &difference);
+
+	void diff_range(const address_range &range, memory &other, std::vector<address_range> &ranges);
+	void diff_data(const address_range &range, const std::uint8_t *data,
+	               std::vector<address_range> &ranges);
+	void diff_image(const address_range &range, const memory_image &image,
+	                std::vector<address_range> &ranges);
+
+	static std::atomic<std::uint64_t> _dirty_epoch;
+
 	address_range _address_range{};
+	std::shared_ptr<trace::recorder> _access_recorder{};
+	std::shared_ptr<write_journal> _write_journal{};
+	util::thread_pool_ptr _thread_pool{};
 };
 
 } // namespace memory
@@ -0,0 +1,77 @@
+#ifndef HARPOON_MEMORY_MEMORY_IMAGE_HH
+#define HARPOON_MEMORY_MEMORY_IMAGE_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/memory/address_range.hh"
+#include "harpoon/util/buffer_pool.hh"
+
+#include <vector>
+
+namespace harpoon {
+namespace memory {
+
+/*
+ * In-memory snapshot: a sorted list of non-overlapping extents. Data is
+ * copied into buffers taken from a pool and given back when the image is
+ * destroyed; sparse extents only record their range and read as zero.
+ */
+class memory_image {
+public:
+	struct extent {
+		address_range range;
+		const std::uint8_t *data;
+	};
+
+	memory_image(const address_range &range,
+	             const util::buffer_pool_ptr &buffer_pool = util::get_buffer_pool())
+	    : _range(range), _buffer_pool(buffer_pool) {}
+	memory_image(const memory_image &) = delete;
+	memory_image &operator=(const memory_image &) = delete;
+
+	const address_range &get_range() const {
+		return _range;
+	}
+
+	const std::vector<extent> &get_extents() const {
+		return _extents;
+	}
+
+	/* Bytes of non-sparse data held by the image. */
+	std::size_t get_stored() const {
+		return _stored;
+	}
+
+	void add(address start, const std::uint8_t *data, std::size_t length);
+	void add_sparse(address start, std::size_t length);
+
+	/* First extent that ends at or after the address. */
+	std::vector<extent>::const_iterator find(address address) const;
+
+	~memory_image();
+
+private:
+	void insert(const extent &extent);
+	std::uint8_t *allocate(std::size_t &length);
+
+	address_range _range{};
+	util::buffer_pool_ptr _buffer_pool{};
+
+	std::vector<extent> _extents{};
+	std::size_t _stored{};
+
+	std::vector<util::buffer_pool::buffer> _buffers{};
+	std::size_t _buffer_used{};
+};
+
+using memory_image_ptr = std::shared_ptr<memory_image>;
+
+template<typename... Args>
+memory_image_ptr make_memory_image(Args &&... args) {
+	return std::make_shared<memory_image>(std::forward<Args>(args)...);
+}
+
+} // namespace memory
+} // namespace harpoon
+
+#endif
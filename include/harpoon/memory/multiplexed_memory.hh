@@ -32,6 +32,8 @@ protected:
 	virtual void get_cell(address address, uint8_t &value) override;
 	virtual void set_cell(address address, uint8_t value) override;
 
+	virtual bool do_get_span(address address, bool write, span &span) override;
+
 private:
 	std::map<memory_id, memory_ptr> _memory{};
 	memory_ptr _active_memory{};
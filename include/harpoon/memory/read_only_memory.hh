@@ -14,6 +14,10 @@ class read_only_memory : public MemoryImplementation {
 public:
 	using MemoryImplementation::MemoryImplementation;
 
+	/* Contents only change by loading an image, which is not tracked. */
+	virtual void get_dirty(std::vector<address_range> &) const override {}
+	virtual void get_dirty_since(std::uint64_t, std::vector<address_range> &) const override {}
+
 	virtual ~read_only_memory() override {}
 
 protected:
@@ -21,6 +25,10 @@ protected:
 		(void)value;
 		throw COMPONENT_EXCEPTION(exception::write_access_violation, address);
 	}
+
+	virtual bool do_get_span(address address, bool write, memory::span &span) override {
+		return !write && MemoryImplementation::do_get_span(address, write, span);
+	}
 };
 
 template<typename MemoryImplementation>
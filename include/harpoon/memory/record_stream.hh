@@ -0,0 +1,45 @@
+#ifndef HARPOON_MEMORY_RECORD_STREAM_HH
+#define HARPOON_MEMORY_RECORD_STREAM_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/memory/address_range.hh"
+
+namespace harpoon {
+namespace memory {
+namespace record_stream {
+
+/*
+ * Sequential snapshot layout, written and read without seeking (all integers
+ * little-endian):
+ *   header:  magic "HRPNSTR1", u32 version, u64 range start, u64 range end
+ *   records: u8 type, u64 address, u64 length, then length bytes for DATA
+ *
+ * Each memory block starts with a BLOCK record holding its range, followed by
+ * its DATA and SPARSE records in ascending address order. SPARSE records
+ * carry no payload and read as zero. The stream ends with an END record.
+ */
+static constexpr char file_magic[8] = {'H', 'R', 'P', 'N', 'S', 'T', 'R', '1'};
+static constexpr std::uint32_t file_version = 1;
+static constexpr std::size_t header_length = 28;
+static constexpr std::size_t record_header_length = 17;
+
+enum class record_type : std::uint8_t { END = 0, BLOCK = 1, DATA = 2, SPARSE = 3 };
+
+struct record {
+	record_type type;
+	harpoon::memory::address address;
+	std::uint64_t length;
+};
+
+void encode_header(const address_range &range, std::uint8_t *output);
+bool decode_header(const std::uint8_t *data, address_range &range);
+
+void encode_record(const record &record, std::uint8_t *output);
+bool decode_record(const std::uint8_t *data, record &record);
+
+} // namespace record_stream
+} // namespace memory
+} // namespace harpoon
+
+#endif
@@ -4,25 +4,51 @@
 #include "harpoon/harpoon.hh"
 
 #include "harpoon/memory/serializer/serializer.hh"
+#include "harpoon/util/file.hh"
 
-#include <fstream>
+#include <vector>
 
 namespace harpoon {
 namespace memory {
 namespace serializer {
 
+/*
+ * Raw image of the serializer range. Contiguous data is collected and written
+ * in one gathering write (pwritev) when the memory block is finalized. Sparse
+ * and all-zero regions become holes where the platform has them.
+ */
 class binary_file : public serializer {
 public:
+	static constexpr std::size_t hole_granularity = 4096;
+
 	binary_file(const address_range &range, const std::string &file_name);
+	binary_file(const binary_file &) = delete;
+	binary_file &operator=(const binary_file &) = delete;
+
+	virtual ~binary_file() override;
 
 protected:
 	virtual void do_start_memory_block() override;
 	virtual std::size_t do_write(uint8_t *data, std::size_t offset, std::size_t length,
 	                             bool sparse) override;
+	virtual void do_finalize_memory_block() override;
 
 private:
+	void append(uint8_t *data, std::size_t position, std::size_t length);
+	void flush();
+	void punch_hole(std::size_t position, std::size_t length);
+
 	std::string _file_name{};
-	std::ofstream _output{};
+	util::file _file{};
+	std::size_t _file_length{};
+	std::size_t _extent{};
+
+	std::vector<util::file::piece> _pending{};
+	std::size_t _pending_position{};
+	std::size_t _pending_length{};
+
+	std::size_t _written{};
+	std::size_t _sparse{};
 };
 
 } // namespace serializer
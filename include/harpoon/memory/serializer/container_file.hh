@@ -0,0 +1,78 @@
+#ifndef HARPOON_MEMORY_SERIALIZER_CONTAINER_FILE_HH
+#define HARPOON_MEMORY_SERIALIZER_CONTAINER_FILE_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/memory/container.hh"
+#include "harpoon/memory/serializer/serializer.hh"
+#include "harpoon/util/file.hh"
+#include "harpoon/util/thread_pool.hh"
+
+#include <vector>
+
+namespace harpoon {
+namespace memory {
+namespace serializer {
+
+/*
+ * Compressed, indexed snapshot container (see container.hh). Written data is
+ * split into blocks which are checksummed and compressed in parallel; sparse
+ * and all-zero blocks are not stored. Buffers passed to write() must stay
+ * valid until the memory block is finalized, and every address may only be
+ * written once. The index is written by close() (or the destructor).
+ */
+class container_file : public serializer {
+public:
+	static constexpr std::size_t default_block_length = 65536;
+
+	container_file(const address_range &range, const std::string &file_name,
+	               std::size_t block_length = default_block_length,
+	               const util::thread_pool_ptr &thread_pool = util::get_thread_pool());
+	container_file(const container_file &) = delete;
+	container_file &operator=(const container_file &) = delete;
+
+	void close();
+
+	virtual ~container_file() override;
+
+protected:
+	virtual void do_start_memory_block() override;
+	virtual std::size_t do_write(uint8_t *data, std::size_t offset, std::size_t length,
+	                             bool sparse) override;
+	virtual void do_finalize_memory_block() override;
+
+private:
+	struct segment {
+		const uint8_t *data;
+		std::size_t length;
+	};
+
+	struct pending_block {
+		harpoon::memory::address start;
+		std::size_t length;
+		std::vector<segment> segments;
+	};
+
+	void queue(harpoon::memory::address start, const uint8_t *data, std::size_t length);
+	void flush();
+	void compress(std::size_t index);
+	void write_at(const void *data, std::size_t length, std::uint64_t offset);
+
+	std::string _file_name{};
+	util::file _file{};
+	std::size_t _block_length{};
+	util::thread_pool_ptr _thread_pool{};
+	std::size_t _batch_length{};
+
+	std::vector<pending_block> _pending{};
+	std::vector<std::vector<uint8_t>> _payloads{};
+	std::vector<container::index_entry> _results{};
+	std::vector<container::index_entry> _index{};
+	std::uint64_t _offset{container::header_length};
+};
+
+} // namespace serializer
+} // namespace memory
+} // namespace harpoon
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef HARPOON_MEMORY_SERIALIZER_EXCEPTION_IO_HH
+#define HARPOON_MEMORY_SERIALIZER_EXCEPTION_IO_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/exception/harpoon_exception.hh"
+
+namespace harpoon {
+namespace memory {
+namespace serializer {
+namespace exception {
+
+class io : public harpoon::exception::harpoon_exception {
+public:
+	io(const std::string &outfile, const std::string &file = {}, int line = {},
+	   const std::string &function = {});
+	io(const io &) = default;
+	io &operator=(const io &) = default;
+
+	virtual ~io();
+};
+
+} // namespace exception
+} // namespace serializer
+} // namespace memory
+} // namespace harpoon
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef HARPOON_MEMORY_SERIALIZER_MEMORY_BUFFER_HH
+#define HARPOON_MEMORY_SERIALIZER_MEMORY_BUFFER_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/memory/memory_image.hh"
+#include "harpoon/memory/serializer/serializer.hh"
+
+namespace harpoon {
+namespace memory {
+namespace serializer {
+
+/*
+ * Serializes into a memory_image. Written data is copied into pooled
+ * buffers; sparse writes are kept as sparse extents.
+ */
+class memory_buffer : public serializer {
+public:
+	memory_buffer(const address_range &range,
+	              const util::buffer_pool_ptr &buffer_pool = util::get_buffer_pool())
+	    : serializer(range), _image(make_memory_image(range, buffer_pool)) {}
+
+	const memory_image_ptr &get_image() const {
+		return _image;
+	}
+
+	virtual ~memory_buffer() override;
+
+protected:
+	virtual void do_start_memory_block() override;
+	virtual std::size_t do_write(uint8_t *data, std::size_t offset, std::size_t length,
+	                             bool sparse) override;
+
+private:
+	memory_image_ptr _image{};
+};
+
+} // namespace serializer
+} // namespace memory
+} // namespace harpoon
+
+#endif
@@ -0,0 +1,50 @@
+#ifndef HARPOON_MEMORY_SERIALIZER_RECORD_STREAM_HH
+#define HARPOON_MEMORY_SERIALIZER_RECORD_STREAM_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/memory/record_stream.hh"
+#include "harpoon/memory/serializer/serializer.hh"
+
+#include <ostream>
+
+namespace harpoon {
+namespace memory {
+namespace serializer {
+
+/*
+ * Writes a sequential record stream (see record_stream.hh) to any ostream,
+ * including pipes. Sparse and all-zero writes become SPARSE records. The END
+ * record is written by close() (or the destructor).
+ */
+class record_stream : public serializer {
+public:
+	static constexpr std::size_t zero_granularity = 4096;
+
+	record_stream(const address_range &range, std::ostream &output);
+	record_stream(const record_stream &) = delete;
+	record_stream &operator=(const record_stream &) = delete;
+
+	void close();
+
+	virtual ~record_stream() override;
+
+protected:
+	virtual void do_start_memory_block() override;
+	virtual std::size_t do_write(uint8_t *data, std::size_t offset, std::size_t length,
+	                             bool sparse) override;
+
+private:
+	void write_record(harpoon::memory::record_stream::record_type type, address address,
+	                  std::size_t length);
+	void check();
+
+	std::ostream &_output;
+	bool _closed{};
+};
+
+} // namespace serializer
+} // namespace memory
+} // namespace harpoon
+
+#endif
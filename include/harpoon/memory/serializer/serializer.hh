@@ -10,6 +10,12 @@ namespace harpoon {
 namespace memory {
 namespace serializer {
 
+/*
+ * Receives the contents of memory blocks. Implementations may defer their I/O,
+ * so data passed to write() must stay valid and unchanged until
+ * finalize_memory_block() returns; after that the serializer keeps no
+ * reference to it.
+ */
 class serializer {
 public:
 	serializer(const address_range &range) : _range(range) {}
@@ -49,6 +55,8 @@ private:
 	address_range _block_range{};
 };
 
+using serializer_ptr = std::shared_ptr<serializer>;
+
 } // namespace serializer
 } // namespace memory
 } // namespace harpoon
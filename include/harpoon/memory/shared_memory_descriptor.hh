@@ -0,0 +1,52 @@
+#ifndef HARPOON_MEMORY_SHARED_MEMORY_DESCRIPTOR_HH
+#define HARPOON_MEMORY_SHARED_MEMORY_DESCRIPTOR_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/memory/address_range.hh"
+
+#include <string>
+#include <vector>
+
+namespace harpoon {
+namespace memory {
+
+/*
+ * Layout of the memories exported through shared storage, so other local
+ * processes can find and map them. The file is text, one region per line:
+ *
+ *   region <first address> <last address> <object name> <memory name>
+ *
+ * with hexadecimal addresses. Each object holds the contents of its region
+ * from the first address on. Empty lines and lines starting with '#' are
+ * ignored.
+ */
+class shared_memory_descriptor {
+public:
+	struct region {
+		address_range range;
+		std::string object;
+		std::string name;
+	};
+
+	void add(const region &region) {
+		_regions.push_back(region);
+	}
+
+	const std::vector<region> &get_regions() const {
+		return _regions;
+	}
+
+	/* Written to a temporary file first, then renamed over the target. */
+	void write(const std::string &file_name) const;
+
+	static shared_memory_descriptor read(const std::string &file_name);
+
+private:
+	std::vector<region> _regions{};
+};
+
+} // namespace memory
+} // namespace harpoon
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef HARPOON_MEMORY_SHARED_STORAGE_HH
+#define HARPOON_MEMORY_SHARED_STORAGE_HH
+
+#include "harpoon/harpoon.hh"
+
+#include <string>
+
+namespace harpoon {
+namespace memory {
+
+/*
+ * Named POSIX shared memory object mapped into the process. The owner
+ * creates the object exclusively, maps it read-write and unlinks it when
+ * destroyed. Observers map an existing object read-only; their mapping stays
+ * valid after the owner is gone. Names get a leading '/' if they lack one.
+ * Without POSIX shared memory is_supported() is false and the constructors
+ * throw shared_memory_error.
+ */
+class shared_storage {
+public:
+	/* Create and map an object of the given length; its contents start zeroed. */
+	shared_storage(const std::string &name, std::size_t length, unsigned int mode = 0600);
+
+	/* Map an existing object read-only. */
+	explicit shared_storage(const std::string &name);
+
+	shared_storage(const shared_storage &) = delete;
+	shared_storage &operator=(const shared_storage &) = delete;
+
+	static bool is_supported();
+
+	const std::string &get_name() const {
+		return _name;
+	}
+
+	std::size_t get_length() const {
+		return _length;
+	}
+
+	std::uint8_t *get_data() {
+		return _data;
+	}
+
+	const std::uint8_t *get_data() const {
+		return _data;
+	}
+
+	bool is_owner() const {
+		return _owner;
+	}
+
+	~shared_storage();
+
+private:
+	void map(int fd, int protection);
+	[[noreturn]] void fail(const std::string &operation) const;
+
+	std::string _name{};
+	std::size_t _length{};
+	std::uint8_t *_data{};
+	bool _owner{};
+};
+
+using shared_storage_ptr = std::shared_ptr<shared_storage>;
+
+template<typename... Args>
+shared_storage_ptr make_shared_storage(Args &&... args) {
+	return std::make_shared<shared_storage>(std::forward<Args>(args)...);
+}
+
+} // namespace memory
+} // namespace harpoon
+
+#endif
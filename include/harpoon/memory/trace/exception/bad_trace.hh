@@ -0,0 +1,28 @@
+#ifndef HARPOON_MEMORY_TRACE_EXCEPTION_BAD_TRACE_HH
+#define HARPOON_MEMORY_TRACE_EXCEPTION_BAD_TRACE_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/exception/harpoon_exception.hh"
+
+namespace harpoon {
+namespace memory {
+namespace trace {
+namespace exception {
+
+class bad_trace : public harpoon::exception::harpoon_exception {
+public:
+	bad_trace(const std::string &trace_file, const std::string &reason,
+	          const std::string &file = {}, int line = {}, const std::string &function = {});
+	bad_trace(const bad_trace &) = default;
+	bad_trace &operator=(const bad_trace &) = default;
+
+	virtual ~bad_trace();
+};
+
+} // namespace exception
+} // namespace trace
+} // namespace memory
+} // namespace harpoon
+
+#endif
@@ -0,0 +1,42 @@
+#ifndef HARPOON_MEMORY_TRACE_READER_HH
+#define HARPOON_MEMORY_TRACE_READER_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/memory/trace/record.hh"
+
+#include <fstream>
+#include <vector>
+
+namespace harpoon {
+namespace memory {
+namespace trace {
+
+class reader {
+public:
+	reader(const std::string &file_name);
+	reader(const reader &) = delete;
+	reader &operator=(const reader &) = delete;
+
+	bool next(record &record);
+
+	~reader();
+
+private:
+	bool read_block();
+
+	std::string _file_name{};
+	std::ifstream _input{};
+
+	std::vector<record> _block{};
+	std::size_t _position{};
+
+	std::vector<std::uint8_t> _stored{};
+	std::vector<std::uint8_t> _encoded{};
+};
+
+} // namespace trace
+} // namespace memory
+} // namespace harpoon
+
+#endif
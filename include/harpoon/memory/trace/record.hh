@@ -0,0 +1,52 @@
+#ifndef HARPOON_MEMORY_TRACE_RECORD_HH
+#define HARPOON_MEMORY_TRACE_RECORD_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/clock/cycle.hh"
+#include "harpoon/memory/access_kind.hh"
+#include "harpoon/memory/address.hh"
+
+#include <vector>
+
+namespace harpoon {
+namespace memory {
+namespace trace {
+
+struct record {
+	clock::tick_t tick;
+	harpoon::memory::address address;
+	std::uint64_t value;
+	std::uint16_t unit;
+	std::uint8_t width;
+	access_kind kind;
+};
+
+static inline bool operator==(const record &a, const record &b) {
+	return a.tick == b.tick && a.address == b.address && a.value == b.value && a.unit == b.unit
+	       && a.width == b.width && a.kind == b.kind;
+}
+
+/*
+ * Trace file layout:
+ *   header: magic "HRPNTRC1", u32 version
+ *   blocks: u32 record count, u32 encoded length, u32 stored length, payload
+ *
+ * Payload is the LZ-compressed (stored length < encoded length) or raw
+ * delta encoding of the block records. Tick and address are zigzag varint
+ * deltas against the previous record of the same block, unit is only
+ * present when it changes, and value is a plain varint. Delta state is reset
+ * at every block so blocks can be decoded independently.
+ */
+static constexpr char file_magic[8] = {'H', 'R', 'P', 'N', 'T', 'R', 'C', '1'};
+static constexpr std::uint32_t file_version = 1;
+
+void encode_block(const record *records, std::size_t count, std::vector<std::uint8_t> &output);
+bool decode_block(const std::uint8_t *data, std::size_t length, std::size_t count,
+                  std::vector<record> &records);
+
+} // namespace trace
+} // namespace memory
+} // namespace harpoon
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef HARPOON_MEMORY_TRACE_RECORDER_HH
+#define HARPOON_MEMORY_TRACE_RECORDER_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/clock/clock.hh"
+#include "harpoon/memory/trace/record.hh"
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace harpoon {
+namespace memory {
+namespace trace {
+
+/*
+ * Memory access recorder. Accesses are stored in a single-producer ring
+ * buffer by the emulation thread and drained by a background thread, which
+ * delta-encodes and compresses them into a trace file (see record.hh).
+ * When the ring is full the producer waits for the writer, so no access is
+ * ever dropped.
+ */
+class recorder {
+public:
+	recorder(const std::string &file_name, std::size_t ring_length = 65536,
+	         std::size_t block_length = 4096);
+	recorder(const recorder &) = delete;
+	recorder &operator=(const recorder &) = delete;
+
+	void set_clock(const clock::clock_ptr &clock) {
+		_clock = clock.get();
+	}
+
+	void set_unit(std::uint16_t unit) {
+		_unit = unit;
+	}
+
+	std::uint16_t get_unit() const {
+		return _unit;
+	}
+
+	void record(address address, std::uint8_t width, std::uint64_t value, access_kind kind) {
+		std::uint64_t head = _head.load(std::memory_order_relaxed);
+		if (head - _cached_tail >= _ring.size()) {
+			wait_for_space(head);
+		}
+
+		trace::record &r = _ring[head & _ring_mask];
+		r.tick = _clock ? _clock->get_cycle().tick : 0;
+		r.address = address;
+		r.value = value;
+		r.unit = _unit;
+		r.width = width;
+		r.kind = kind;
+		_head.store(head + 1, std::memory_order_release);
+
+		if (head - _cached_tail == _ring.size() / 2) {
+			_wakeup.notify_one();
+		}
+	}
+
+	std::uint64_t get_recorded() const {
+		return _head.load(std::memory_order_relaxed);
+	}
+
+	void flush();
+	void close();
+
+	~recorder();
+
+private:
+	void wait_for_space(std::uint64_t head);
+	void writer();
+	void write_block(std::size_t count);
+
+	std::string _file_name{};
+	std::ofstream _output{};
+
+	std::vector<trace::record> _ring{};
+	std::uint64_t _ring_mask{};
+	std::size_t _block_length{};
+
+	alignas(64) std::atomic<std::uint64_t> _head{};
+	std::uint64_t _cached_tail{};
+	alignas(64) std::atomic<std::uint64_t> _tail{};
+
+	const clock::clock *_clock{};
+	std::uint16_t _unit{};
+
+	std::vector<trace::record> _block{};
+	std::vector<std::uint8_t> _encoded{};
+	std::vector<std::uint8_t> _compressed{};
+
+	std::mutex _mutex{};
+	std::condition_variable _wakeup{};
+	std::condition_variable _drained{};
+	std::uint64_t _synced{};
+	bool _closing{};
+	std::exception_ptr _error{};
+	std::thread _thread{};
+};
+
+using recorder_ptr = std::shared_ptr<recorder>;
+
+template<typename... Args>
+recorder_ptr make_recorder(Args &&... args) {
+	return std::make_shared<recorder>(std::forward<Args>(args)...);
+}
+
+} // namespace trace
+} // namespace memory
+} // namespace harpoon
+
+#endif
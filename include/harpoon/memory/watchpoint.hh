@@ -0,0 +1,77 @@
+#ifndef HARPOON_MEMORY_WATCHPOINT_HH
+#define HARPOON_MEMORY_WATCHPOINT_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/memory/access_kind.hh"
+#include "harpoon/memory/address_range.hh"
+
+#include <functional>
+
+namespace harpoon {
+namespace memory {
+
+class memory;
+
+class watchpoint {
+public:
+	enum class Type { READ, WRITE, ACCESS };
+
+	struct access {
+		harpoon::memory::memory *memory;
+		harpoon::memory::address address;
+		std::uint8_t value;
+		access_kind kind;
+	};
+
+	using action = std::function<void(const watchpoint &, const access &)>;
+
+	watchpoint(const address_range &range, Type type, const action &action)
+	    : _range(range), _type(type), _action(action) {}
+	watchpoint(const address_range &range, Type type, std::uint8_t value, const action &action)
+	    : _range(range), _type(type), _match_value(true), _value(value), _action(action) {}
+	watchpoint(const watchpoint &) = default;
+	watchpoint &operator=(const watchpoint &) = default;
+
+	const address_range &get_range() const {
+		return _range;
+	}
+
+	Type get_type() const {
+		return _type;
+	}
+
+	bool watches_reads() const {
+		return _type != Type::WRITE;
+	}
+
+	bool watches_writes() const {
+		return _type != Type::READ;
+	}
+
+	bool check_condition(const access &access) const {
+		if (!_range.has_address(access.address)) {
+			return false;
+		}
+		if (access.kind == access_kind::WRITE ? !watches_writes() : !watches_reads()) {
+			return false;
+		}
+		return !_match_value || access.value == _value;
+	}
+
+	void do_action(const access &access) const {
+		_action(*this, access);
+	}
+
+private:
+	address_range _range{};
+	Type _type{};
+	bool _match_value{};
+	std::uint8_t _value{};
+	action _action{};
+};
+
+} // namespace memory
+} // namespace harpoon
+
+#endif
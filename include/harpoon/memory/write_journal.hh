@@ -0,0 +1,101 @@
+#ifndef HARPOON_MEMORY_WRITE_JOURNAL_HH
+#define HARPOON_MEMORY_WRITE_JOURNAL_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/memory/address.hh"
+
+#include <vector>
+
+namespace harpoon {
+
+namespace execution {
+class processing_unit;
+}
+
+namespace memory {
+
+class memory;
+
+/*
+ * Bounded undo log of memory writes. Every byte written through a memory the
+ * journal is attached to is recorded with its previous value and tagged with
+ * the processing unit's executed instruction count, so the last N
+ * instructions can be undone without restoring a full snapshot. Once the
+ * ring is full the oldest entries are dropped.
+ *
+ * Old values are obtained with a plain cell read, so journals should only be
+ * attached to memories without read side effects (i.e. not to I/O ports).
+ */
+class write_journal {
+public:
+	struct entry {
+		std::uint64_t instruction;
+		harpoon::memory::address address;
+		std::uint8_t value;
+	};
+
+	write_journal(std::size_t capacity = 1048576);
+	write_journal(const write_journal &) = delete;
+	write_journal &operator=(const write_journal &) = delete;
+
+	void set_processing_unit(const std::shared_ptr<execution::processing_unit> &processing_unit);
+
+	std::size_t get_capacity() const {
+		return _entries.size();
+	}
+
+	std::size_t get_size() const {
+		return _size;
+	}
+
+	/* Oldest instruction count undo_to() can still restore. */
+	std::uint64_t get_oldest_instruction() const {
+		return _oldest_instruction;
+	}
+
+	std::uint64_t get_current_instruction() const;
+
+	void record(address address, std::uint8_t old_value) {
+		if (_suspended) {
+			return;
+		}
+		if (_size == _entries.size()) {
+			drop_oldest();
+		}
+		entry &e = _entries[(_first + _size) % _entries.size()];
+		e.instruction = get_current_instruction();
+		e.address = address;
+		e.value = old_value;
+		_size++;
+	}
+
+	bool undo(memory &memory, std::uint64_t instructions);
+	bool undo_to(memory &memory, std::uint64_t instruction);
+
+	void clear();
+
+	~write_journal();
+
+private:
+	void drop_oldest();
+
+	std::vector<entry> _entries{};
+	std::size_t _first{};
+	std::size_t _size{};
+	std::uint64_t _oldest_instruction{};
+	std::weak_ptr<const execution::processing_unit> _processing_unit{};
+	bool _suspended{};
+};
+
+using write_journal_ptr = std::shared_ptr<write_journal>;
+
+template<typename... Args>
+write_journal_ptr make_write_journal(Args &&... args) {
+	return std::make_shared<write_journal>(std::forward<Args>(args)...);
+}
+
+} // namespace memory
+} // namespace harpoon
+
+#endif
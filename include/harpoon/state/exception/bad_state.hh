@@ -0,0 +1,26 @@
+#ifndef HARPOON_STATE_EXCEPTION_BAD_STATE_HH
+#define HARPOON_STATE_EXCEPTION_BAD_STATE_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/exception/harpoon_exception.hh"
+
+namespace harpoon {
+namespace state {
+namespace exception {
+
+class bad_state : public harpoon::exception::harpoon_exception {
+public:
+	bad_state(const std::string &reason, const std::string &file = {}, int line = {},
+	          const std::string &function = {});
+	bad_state(const bad_state &) = default;
+	bad_state &operator=(const bad_state &) = default;
+
+	virtual ~bad_state();
+};
+
+} // namespace exception
+} // namespace state
+} // namespace harpoon
+
+#endif
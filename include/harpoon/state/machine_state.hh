@@ -0,0 +1,74 @@
+#ifndef HARPOON_STATE_MACHINE_STATE_HH
+#define HARPOON_STATE_MACHINE_STATE_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/memory/memory.hh"
+#include "harpoon/memory/memory_image.hh"
+
+#include <vector>
+
+namespace harpoon {
+namespace state {
+
+/*
+ * Saved machine: component states (see hardware_component::save()) and an
+ * image of the main memory contents.
+ */
+class machine_state {
+public:
+	std::vector<std::uint8_t> &get_components() {
+		return _components;
+	}
+
+	const std::vector<std::uint8_t> &get_components() const {
+		return _components;
+	}
+
+	const memory::memory_image_ptr &get_memory() const {
+		return _memory;
+	}
+
+	void set_memory(const memory::memory_image_ptr &memory) {
+		_memory = memory;
+	}
+
+	/* Block hashes of the main memory at the time the state was saved. */
+	std::vector<memory::memory::block_hash> &get_memory_hashes() {
+		return _memory_hashes;
+	}
+
+	const std::vector<memory::memory::block_hash> &get_memory_hashes() const {
+		return _memory_hashes;
+	}
+
+	/* Same as computer_system::get_digest() of the saved machine. */
+	std::uint64_t get_digest() const {
+		return get_digest(_components, _memory_hashes);
+	}
+
+	static std::uint64_t get_digest(const std::vector<std::uint8_t> &components,
+	                                const std::vector<memory::memory::block_hash> &memory_hashes);
+
+	/* Bytes held by the state. */
+	std::size_t get_length() const {
+		return _components.size() + (_memory ? _memory->get_stored() : 0);
+	}
+
+private:
+	std::vector<std::uint8_t> _components{};
+	memory::memory_image_ptr _memory{};
+	std::vector<memory::memory::block_hash> _memory_hashes{};
+};
+
+using machine_state_ptr = std::shared_ptr<machine_state>;
+
+template<typename... Args>
+machine_state_ptr make_machine_state(Args &&... args) {
+	return std::make_shared<machine_state>(std::forward<Args>(args)...);
+}
+
+} // namespace state
+} // namespace harpoon
+
+#endif
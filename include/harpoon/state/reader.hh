@@ -0,0 +1,59 @@
+#ifndef HARPOON_STATE_READER_HH
+#define HARPOON_STATE_READER_HH
+
+#include "harpoon/harpoon.hh"
+
+#include <type_traits>
+
+namespace harpoon {
+namespace state {
+
+/* Reads state written by state::writer; malformed input throws bad_state. */
+class reader {
+public:
+	reader(const std::uint8_t *data, std::size_t length) : _data(data), _length(length) {}
+	reader(const reader &) = delete;
+	reader &operator=(const reader &) = delete;
+
+	template<typename T>
+	void read(T &value) {
+		static_assert(std::is_integral<T>::value || std::is_enum<T>::value,
+		              "Only integers and enums are read by value");
+		const std::uint8_t *p = take(sizeof(T));
+		std::uint64_t v = 0;
+		for (std::size_t i = 0; i < sizeof(T); i++) {
+			v |= static_cast<std::uint64_t>(p[i]) << (8 * i);
+		}
+		value = static_cast<T>(v);
+	}
+
+	template<typename T>
+	T read() {
+		T value;
+		read(value);
+		return value;
+	}
+
+	void read(void *data, std::size_t length);
+	void read(std::string &value);
+
+	/* Checks the section name and returns a mark to be passed to end_section(). */
+	std::size_t begin_section(const std::string &name);
+	void end_section(std::size_t mark);
+
+	bool at_end() const {
+		return _position == _length;
+	}
+
+private:
+	const std::uint8_t *take(std::size_t length);
+
+	const std::uint8_t *_data{};
+	std::size_t _length{};
+	std::size_t _position{};
+};
+
+} // namespace state
+} // namespace harpoon
+
+#endif
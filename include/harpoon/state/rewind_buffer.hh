@@ -0,0 +1,117 @@
+#ifndef HARPOON_STATE_REWIND_BUFFER_HH
+#define HARPOON_STATE_REWIND_BUFFER_HH
+
+#include "harpoon/harpoon.hh"
+
+#include "harpoon/clock/cycle.hh"
+#include "harpoon/memory/memory.hh"
+
+#include <deque>
+#include <map>
+#include <vector>
+
+namespace harpoon {
+namespace state {
+
+/*
+ * Bounded history of machine states. The memory contents of the newest entry
+ * are kept in a shadow copy; every entry stores the XOR between its memory
+ * and the one of the entry before it, compressed, for the ranges the memory
+ * reported dirty since the previous entry, through a dirty epoch of its own;
+ * the first entry reads all mapped memory into the shadow. Going back n
+ * entries replays n deltas against the shadow and restores the memory the way
+ * a deserializer does, so no watchpoints, profilers or journals see it.
+ * The oldest entries are dropped to keep the stored deltas within budget.
+ */
+class rewind_buffer {
+public:
+	/* Shadow pages; dirty ranges are split at page boundaries. */
+	static constexpr std::size_t page_length = 65536;
+
+	rewind_buffer(std::size_t budget) : _budget(budget) {}
+	rewind_buffer(const rewind_buffer &) = delete;
+	rewind_buffer &operator=(const rewind_buffer &) = delete;
+
+	void capture(clock::tick_t tick, std::vector<std::uint8_t> &&components,
+	             memory::memory &memory);
+
+	/*
+	 * Bring the memory back to the newest entry at or before the tick and
+	 * return that entry's component state. Newer entries are dropped. Returns
+	 * false when no such entry is retained; throws state::exception::bad_state,
+	 * with the buffer unchanged, when a delta is corrupt.
+	 */
+	bool restore(clock::tick_t tick, memory::memory &memory,
+	             std::vector<std::uint8_t> &components);
+
+	void clear();
+
+	std::size_t get_entries() const {
+		return _entries.size();
+	}
+
+	clock::tick_t get_oldest_tick() const {
+		return _entries.empty() ? 0 : _entries.front().tick;
+	}
+
+	clock::tick_t get_newest_tick() const {
+		return _entries.empty() ? 0 : _entries.back().tick;
+	}
+
+	/* Bytes of component states and compressed deltas held. */
+	std::size_t get_used() const {
+		return _used;
+	}
+
+	std::size_t get_budget() const {
+		return _budget;
+	}
+
+	/* Bytes held by the shadow copy of the newest memory contents. */
+	std::size_t get_shadow_length() const {
+		return _shadow.size() * page_length;
+	}
+
+private:
+	struct delta {
+		memory::address start;
+		std::size_t length;
+		bool raw;
+		std::vector<std::uint8_t> data;
+	};
+
+	struct entry {
+		clock::tick_t tick;
+		std::vector<std::uint8_t> components;
+		std::vector<delta> deltas;
+		std::size_t length;
+	};
+
+	std::uint8_t *get_shadow(memory::address start, bool allocate);
+	void split(const std::vector<memory::address_range> &ranges,
+	           std::vector<memory::address_range> &pieces) const;
+	void apply(const delta &delta);
+	void write(memory::memory &memory, std::vector<memory::address_range> &pieces);
+	void drop_deltas(entry &entry);
+
+	std::size_t _budget{};
+	std::size_t _used{};
+	std::deque<entry> _entries{};
+	std::uint64_t _epoch{};
+
+	std::map<memory::address, std::unique_ptr<std::uint8_t[]>> _shadow{};
+	std::vector<std::uint8_t> _current{};
+	std::vector<std::uint8_t> _xor{};
+};
+
+using rewind_buffer_ptr = std::shared_ptr<rewind_buffer>;
+
+template<typename... Args>
+rewind_buffer_ptr make_rewind_buffer(Args &&... args) {
+	return std::make_shared<rewind_buffer>(std::forward<Args>(args)...);
+}
+
+} // namespace state
+} // namespace harpoon
+
+#endif
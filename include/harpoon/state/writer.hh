@@ -0,0 +1,51 @@
+#ifndef HARPOON_STATE_WRITER_HH
+#define HARPOON_STATE_WRITER_HH
+
+#include "harpoon/harpoon.hh"
+
+#include <type_traits>
+#include <vector>
+
+namespace harpoon {
+namespace state {
+
+/*
+ * Appends component state to a byte buffer. Integers are stored
+ * little-endian in their own width; sections are named and carry their
+ * length, so a reader can check it restores into the same component tree.
+ */
+class writer {
+public:
+	writer(std::vector<std::uint8_t> &output) : _output(output) {}
+	writer(const writer &) = delete;
+	writer &operator=(const writer &) = delete;
+
+	template<typename T>
+	void write(T value) {
+		static_assert(std::is_integral<T>::value || std::is_enum<T>::value,
+		              "Only integers and enums are written by value");
+		auto v = static_cast<std::uint64_t>(value);
+		for (std::size_t i = 0; i < sizeof(T); i++) {
+			_output.push_back(static_cast<std::uint8_t>(v >> (8 * i)));
+		}
+	}
+
+	void write(const void *data, std::size_t length);
+	void write(const std::string &value);
+
+	/* Returns a mark to be passed to end_section(). */
+	std::size_t begin_section(const std::string &name);
+	void end_section(std::size_t mark);
+
+	std::size_t get_length() const {
+		return _output.size();
+	}
+
+private:
+	std::vector<std::uint8_t> &_output;
+};
+
+} // namespace state
+} // namespace harpoon
+
+#endif
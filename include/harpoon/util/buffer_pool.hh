@@ -0,0 +1,59 @@
+#ifndef HARPOON_UTIL_BUFFER_POOL_HH
+#define HARPOON_UTIL_BUFFER_POOL_HH
+
+#include "harpoon/harpoon.hh"
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace harpoon {
+namespace util {
+
+/*
+ * Pool of fixed-size byte buffers. Released buffers are kept, up to
+ * max_free_bytes in total, and handed out again, so steady-state users do not
+ * allocate; buffers beyond the budget are freed on release.
+ */
+class buffer_pool {
+public:
+	using buffer = std::unique_ptr<std::uint8_t[]>;
+
+	buffer_pool(std::size_t buffer_length = 1048576, std::size_t max_free_bytes = 16777216)
+	    : _buffer_length(buffer_length), _max_free_bytes(max_free_bytes) {}
+	buffer_pool(const buffer_pool &) = delete;
+	buffer_pool &operator=(const buffer_pool &) = delete;
+
+	std::size_t get_buffer_length() const {
+		return _buffer_length;
+	}
+
+	buffer acquire();
+	void release(buffer &&buffer);
+
+	std::size_t get_free() const;
+
+	~buffer_pool();
+
+private:
+	std::size_t _buffer_length{};
+	std::size_t _max_free_bytes{};
+
+	mutable std::mutex _mutex{};
+	std::vector<buffer> _free{};
+};
+
+using buffer_pool_ptr = std::shared_ptr<buffer_pool>;
+
+template<typename... Args>
+buffer_pool_ptr make_buffer_pool(Args &&... args) {
+	return std::make_shared<buffer_pool>(std::forward<Args>(args)...);
+}
+
+/* Process-wide pool with the default buffer length, created on first use. */
+const buffer_pool_ptr &get_buffer_pool();
+
+} // namespace util
+} // namespace harpoon
+
+#endif
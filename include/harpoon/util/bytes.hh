@@ -0,0 +1,40 @@
+#ifndef HARPOON_UTIL_BYTES_HH
+#define HARPOON_UTIL_BYTES_HH
+
+#include "harpoon/harpoon.hh"
+
+namespace harpoon {
+namespace util {
+namespace bytes {
+
+/*
+ * Byte buffer kernels. On x86 they use AVX2 or SSE2 depending on the host
+ * CPU (selected once at runtime), elsewhere a portable word-at-a-time
+ * implementation is used. All of them return the buffer length when
+ * nothing is found.
+ */
+
+std::size_t find_first_nonzero(const std::uint8_t *data, std::size_t length);
+
+std::size_t find_first_difference(const std::uint8_t *a, const std::uint8_t *b,
+                                  std::size_t length);
+
+/*
+ * Find the first offset where (data[i + k] & mask[k]) == (pattern[k] & mask[k])
+ * holds for every k < pattern_length. mask may be nullptr (all bits
+ * significant).
+ */
+std::size_t find_pattern(const std::uint8_t *data, std::size_t length, const std::uint8_t *pattern,
+                         const std::uint8_t *mask, std::size_t pattern_length);
+
+void fill(std::uint8_t *data, std::size_t length, std::uint8_t value);
+
+inline bool is_zero(const std::uint8_t *data, std::size_t length) {
+	return find_first_nonzero(data, length) == length;
+}
+
+} // namespace bytes
+} // namespace util
+} // namespace harpoon
+
+#endif
@@ -0,0 +1,82 @@
+#ifndef HARPOON_UTIL_FILE_HH
+#define HARPOON_UTIL_FILE_HH
+
+#include "harpoon/harpoon.hh"
+
+#include <atomic>
+#include <fstream>
+#include <mutex>
+#include <string>
+
+namespace harpoon {
+namespace util {
+
+/*
+ * File with positional I/O that several threads may use at once. POSIX
+ * systems use a descriptor, with pread/pwritev and holes; elsewhere a locked
+ * std::fstream stands in and holes are written as zeros. Calls return false
+ * on errors and callers raise their own exceptions.
+ */
+class file {
+public:
+	enum class Mode { READ, WRITE };
+
+	struct piece {
+		const void *data;
+		std::size_t length;
+	};
+
+	file() {}
+	file(const file &) = delete;
+	file &operator=(const file &) = delete;
+
+	/* WRITE creates the file or truncates it. */
+	bool open(const std::string &name, Mode mode);
+	void close();
+
+	bool is_open() const;
+
+	bool get_length(std::uint64_t &length);
+
+	/* Up to length bytes from the current position; done is 0 at the end of the file. */
+	bool read(void *data, std::size_t length, std::size_t &done);
+
+	/* Length bytes at the offset; done is less only at the end of the file. */
+	bool read_at(void *data, std::size_t length, std::uint64_t offset, std::size_t &done);
+
+	bool write_at(const void *data, std::size_t length, std::uint64_t offset);
+
+	/* The pieces back to back, starting at the offset. */
+	bool write_at(const piece *pieces, std::size_t count, std::uint64_t offset);
+
+	/* Extend the file to the length; the new space reads as zero. */
+	bool extend(std::uint64_t length);
+
+	/* Zero a range within the file, turning it into a hole where supported. */
+	bool zero(std::uint64_t offset, std::uint64_t length);
+
+	/*
+	 * Narrow [start, limit) to the first data extent, returning false when only
+	 * holes remain. Without hole support everything is data.
+	 */
+	bool find_data(std::uint64_t &start, std::uint64_t &end, std::uint64_t limit);
+
+	~file();
+
+private:
+	bool write_zeros(std::uint64_t offset, std::uint64_t length);
+
+	/* POSIX descriptor; SEEK_DATA is dropped for good once the filesystem rejects it. */
+	int _fd{-1};
+	std::atomic<bool> _seek_data{true};
+
+	/* Stream used elsewhere, and its read() position. */
+	std::fstream _stream{};
+	std::mutex _mutex{};
+	std::uint64_t _position{};
+};
+
+} // namespace util
+} // namespace harpoon
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef HARPOON_UTIL_HASH_HH
+#define HARPOON_UTIL_HASH_HH
+
+#include "harpoon/harpoon.hh"
+
+namespace harpoon {
+namespace util {
+namespace hash {
+
+/*
+ * Fast non-cryptographic 64-bit hash (XXH64). Used for block checksums and
+ * content digests; stable across hosts and builds.
+ */
+std::uint64_t hash64(const void *data, std::size_t length, std::uint64_t seed = 0);
+
+} // namespace hash
+} // namespace util
+} // namespace harpoon
+
+#endif
@@ -0,0 +1,29 @@
+#ifndef HARPOON_UTIL_LZ_HH
+#define HARPOON_UTIL_LZ_HH
+
+#include "harpoon/harpoon.hh"
+
+#include <vector>
+
+namespace harpoon {
+namespace util {
+namespace lz {
+
+/*
+ * Fast LZ77 block compression (LZ4 block layout: token, literals, 16-bit
+ * offset, match length). Blocks are self-contained; the decompressor has to
+ * be told the original length.
+ */
+
+std::size_t compress_bound(std::size_t length);
+
+std::size_t compress(const std::uint8_t *data, std::size_t length, std::vector<std::uint8_t> &output);
+
+bool decompress(const std::uint8_t *data, std::size_t length, std::uint8_t *output,
+                std::size_t output_length);
+
+} // namespace lz
+} // namespace util
+} // namespace harpoon
+
+#endif
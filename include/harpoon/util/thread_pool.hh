@@ -0,0 +1,71 @@
+#ifndef HARPOON_UTIL_THREAD_POOL_HH
+#define HARPOON_UTIL_THREAD_POOL_HH
+
+#include "harpoon/harpoon.hh"
+
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace harpoon {
+namespace util {
+
+/*
+ * Fixed set of worker threads running index-parallel jobs. The calling
+ * thread takes part in every job. run() called from inside a job executes
+ * serially, so tasks may use the pool themselves.
+ */
+class thread_pool {
+public:
+	using task = std::function<void(std::size_t)>;
+
+	thread_pool(std::size_t threads = 0);
+	thread_pool(const thread_pool &) = delete;
+	thread_pool &operator=(const thread_pool &) = delete;
+
+	/* Run task(0) ... task(count - 1); the first exception thrown is rethrown. */
+	void run(std::size_t count, const task &task);
+
+	std::size_t get_threads() const {
+		return _workers.size() + 1;
+	}
+
+	~thread_pool();
+
+private:
+	void worker();
+	void execute();
+
+	std::vector<std::thread> _workers{};
+
+	std::mutex _run_mutex{};
+	std::mutex _mutex{};
+	std::condition_variable _start{};
+	std::condition_variable _done{};
+	std::uint64_t _generation{};
+	bool _stopping{};
+
+	const task *_task{};
+	std::size_t _count{};
+	std::size_t _next{};
+	std::size_t _active{};
+	std::exception_ptr _error{};
+};
+
+using thread_pool_ptr = std::shared_ptr<thread_pool>;
+
+template<typename... Args>
+thread_pool_ptr make_thread_pool(Args &&... args) {
+	return std::make_shared<thread_pool>(std::forward<Args>(args)...);
+}
+
+/* Process-wide pool sized to the host, created on first use. */
+const thread_pool_ptr &get_thread_pool();
+
+} // namespace util
+} // namespace harpoon
+
+#endif
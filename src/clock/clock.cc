@@ -1,6 +1,9 @@
 #include "harpoon/clock/clock.hh"
 
+#include "harpoon/clock/exception/clock_exception.hh"
 #include "harpoon/clock/exception/dead_clock.hh"
+#include "harpoon/state/reader.hh"
+#include "harpoon/state/writer.hh"
 
 #include <chrono>
 #include <thread>
@@ -26,8 +29,53 @@ void clock::log_state(log::message::Level level) const {
 	hardware_component::log_state(level);
 }
 
+clock::event_id clock::register_event(step_handler &&fn) {
+	_events.push_back(std::move(fn));
+	return static_cast<event_id>(_events.size());
+}
+
+void clock::schedule(uint64_t delay, phase_t phase, event_id event) {
+	if (event == 0 || event > _events.size()) {
+		throw COMPONENT_EXCEPTION(exception::clock_exception, "Unknown clock event");
+	}
+	_handlers.insert({{_cycle.tick + delay, phase}, {event, {}}});
+}
+
 void clock::schedule(uint64_t delay, phase_t phase, step_handler &&fn) {
-	_handlers.insert({{_cycle.tick + delay, phase}, fn});
+	_handlers.insert({{_cycle.tick + delay, phase}, {0, std::move(fn)}});
+}
+
+void clock::save_state(harpoon::state::writer &writer) const {
+	writer.write(_cycle.tick);
+	writer.write(_cycle.phase);
+	writer.write(static_cast<std::uint64_t>(_handlers.size()));
+	for (const auto &h : _handlers) {
+		if (!h.second.event) {
+			throw COMPONENT_EXCEPTION(exception::clock_exception,
+			                          "Pending unregistered clock event can not be saved");
+		}
+		writer.write(h.first.first);
+		writer.write(h.first.second);
+		writer.write(h.second.event);
+	}
+}
+
+/* Pending events are replaced, including closures scheduled after the save. */
+void clock::restore_state(harpoon::state::reader &reader) {
+	reader.read(_cycle.tick);
+	reader.read(_cycle.phase);
+
+	_handlers.clear();
+	auto count = reader.read<std::uint64_t>();
+	for (std::uint64_t i = 0; i < count; i++) {
+		auto tick = reader.read<tick_t>();
+		auto phase = reader.read<phase_t>();
+		auto event = reader.read<event_id>();
+		if (event == 0 || event > _events.size()) {
+			throw COMPONENT_EXCEPTION(exception::clock_exception, "Unknown clock event");
+		}
+		_handlers.insert({{tick, phase}, {event, {}}});
+	}
 }
 
 void clock::step(hardware_component *) {
@@ -39,7 +87,11 @@ void clock::step(hardware_component *) {
 	auto i = std::begin(_handlers);
 	while (i != std::end(_handlers) && i->first.first == _cycle.tick) {
 		_cycle.phase = i->first.second;
-		i->second(this);
+		if (i->second.event) {
+			_events[i->second.event - 1](this);
+		} else {
+			i->second.fn(this);
+		}
 		i = _handlers.erase(i);
 	}
 
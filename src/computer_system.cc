@@ -1,6 +1,11 @@
 #include "harpoon/computer_system.hh"
 
 #include "harpoon/exception/hardware_component_exception.hh"
+#include "harpoon/memory/deserializer/memory_buffer.hh"
+#include "harpoon/memory/main_memory.hh"
+#include "harpoon/memory/serializer/memory_buffer.hh"
+#include "harpoon/state/reader.hh"
+#include "harpoon/state/writer.hh"
 
 namespace harpoon {
 
@@ -27,6 +32,117 @@ void computer_system::set_main_memory(const memory::memory_ptr &main_memory) {
 
 void computer_system::step(hardware_component *) {
 	_main_execution_unit->step(this);
+
+	if (_rewind_buffer && get_tick() >= _next_rewind_tick && can_save_state()) {
+		capture_rewind_point();
+	}
+}
+
+clock::tick_t computer_system::get_tick() const {
+	if (!_main_execution_unit || !_main_execution_unit->get_clock()) {
+		return 0;
+	}
+	return _main_execution_unit->get_clock()->get_cycle().tick;
+}
+
+void computer_system::enable_rewind(clock::tick_t interval, std::size_t budget) {
+	if (!_main_memory) {
+		throw COMPONENT_EXCEPTION(exception::hardware_component_exception,
+		                          "Rewind needs a main memory");
+	}
+	_rewind_buffer = harpoon::state::make_rewind_buffer(budget);
+	_rewind_interval = interval;
+	_next_rewind_tick = get_tick();
+}
+
+void computer_system::disable_rewind() {
+	_rewind_buffer.reset();
+}
+
+std::vector<std::uint8_t> computer_system::save_components() const {
+	std::vector<std::uint8_t> components;
+	harpoon::state::writer writer(components);
+	save(writer);
+	return components;
+}
+
+void computer_system::capture_rewind_point() {
+	auto components = save_components();
+	auto tick = get_tick();
+	_rewind_buffer->capture(tick, std::move(components), *_main_memory);
+	_next_rewind_tick = tick + _rewind_interval;
+}
+
+bool computer_system::rewind(clock::tick_t tick) {
+	std::vector<std::uint8_t> components;
+	if (!_rewind_buffer || !_rewind_buffer->restore(tick, *_main_memory, components)) {
+		return false;
+	}
+
+	harpoon::state::reader reader(components.data(), components.size());
+	restore(reader);
+	_next_rewind_tick = get_tick() + _rewind_interval;
+
+	log(component_debug << "Rewound to tick " << get_tick());
+	return true;
+}
+
+harpoon::state::machine_state_ptr computer_system::save_machine_state() {
+	auto machine_state = harpoon::state::make_machine_state();
+
+	machine_state->get_components() = save_components();
+
+	if (_main_memory) {
+		/* The default main memory range spans the whole address space and reads as empty. */
+		memory::address_range range = _main_memory->get_address_range();
+		auto main_memory = std::dynamic_pointer_cast<memory::main_memory>(_main_memory);
+		if (main_memory) {
+			range = main_memory->get_mapped_range();
+		}
+		if (!range.is_empty()) {
+			memory::serializer::memory_buffer serializer(range);
+			_main_memory->serialize(serializer);
+			machine_state->set_memory(serializer.get_image());
+		}
+		_main_memory->get_block_hashes(machine_state->get_memory_hashes());
+	}
+
+	log(component_debug << "Saved machine state of " << machine_state->get_length() << " bytes");
+	return machine_state;
+}
+
+void computer_system::restore_machine_state(const harpoon::state::machine_state &machine_state) {
+	const auto &components = machine_state.get_components();
+	harpoon::state::reader reader(components.data(), components.size());
+	restore(reader);
+
+	if (_main_memory && machine_state.get_memory()) {
+		memory::deserializer::memory_buffer deserializer(machine_state.get_memory());
+		_main_memory->deserialize(deserializer);
+	}
+}
+
+std::uint64_t computer_system::get_digest() {
+	std::vector<memory::memory::block_hash> hashes;
+	if (_main_memory) {
+		_main_memory->get_block_hashes(hashes);
+	}
+	return harpoon::state::machine_state::get_digest(save_components(), hashes);
+}
+
+bool computer_system::diff(computer_system &other, std::vector<memory::address_range> &ranges) {
+	if (_main_memory && other._main_memory) {
+		_main_memory->diff(*other._main_memory, ranges);
+	}
+	return save_components() == other.save_components();
+}
+
+bool computer_system::diff(const harpoon::state::machine_state &machine_state,
+                           std::vector<memory::address_range> &ranges) {
+	if (_main_memory && machine_state.get_memory()) {
+		_main_memory->diff(*machine_state.get_memory(), machine_state.get_memory_hashes(), ranges);
+	}
+	return save_components() == machine_state.get_components();
 }
 
 void computer_system::run() {
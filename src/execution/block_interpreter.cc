@@ -0,0 +1,173 @@
+#include "harpoon/execution/block_interpreter.hh"
+
+#include "harpoon/execution/jit_compiler.hh"
+#include "harpoon/execution/processing_unit.hh"
+
+namespace harpoon {
+namespace execution {
+
+namespace {
+
+/* Keeps dropped blocks until the run ends, as handlers may drop the block they run from. */
+class block_cache_hold {
+public:
+	explicit block_cache_hold(block_cache &blocks) : _blocks(blocks) {
+		_blocks.hold();
+	}
+	block_cache_hold(const block_cache_hold &) = delete;
+	block_cache_hold &operator=(const block_cache_hold &) = delete;
+
+	~block_cache_hold() {
+		_blocks.release();
+	}
+
+private:
+	block_cache &_blocks;
+};
+
+} // namespace
+
+block_translator::~block_translator() {}
+
+threaded_block &block_interpreter::get_block(block_translator &translator,
+                                             memory::address address, block_cache::mode mode,
+                                             const address_breakpoints &breakpoints) {
+	return _blocks.get(address, mode, [&](std::size_t &length) {
+		threaded_block block;
+		memory::address next = address;
+		length = 0;
+		while (block.ops.size() < max_block_length) {
+			if (length && breakpoints.contains(next)) {
+				break;
+			}
+			threaded_op op;
+			bool ends_block = false;
+			std::size_t l = translator.translate(next, mode, op, ends_block);
+			if (!l) {
+				break;
+			}
+			block.ops.push_back(op);
+			length += l;
+			next += l;
+			if (ends_block) {
+				break;
+			}
+		}
+		if (!length) {
+			/* Remember the instruction can not be translated until it changes. */
+			length = 1;
+		}
+		_statistics.translated++;
+		return block;
+	});
+}
+
+std::uint64_t block_interpreter::run(processing_unit &processing_unit,
+                                     block_translator &translator, std::uint64_t budget) {
+	std::uint64_t cycles = 0;
+	threaded_block *previous = nullptr;
+	const address_breakpoints &breakpoints = processing_unit.get_address_breakpoints();
+	block_cache_hold hold(_blocks);
+
+	/* Compiled code uses the main memory directly, so hold it meanwhile. */
+	memory::main_memory_ptr main_memory;
+	jit_translator *jit = nullptr;
+	if (_jit_compiler) {
+		main_memory = _main_memory.lock();
+		jit = main_memory ? dynamic_cast<jit_translator *>(&translator) : nullptr;
+		if (jit) {
+			_jit_compiler->prepare(main_memory.get(), _blocks, jit->get_jit_state());
+		}
+	}
+
+	do {
+		memory::address address = translator.get_block_address();
+		if (breakpoints.contains(address)) {
+			/* Left to the single instruction path, which runs the breakpoint. */
+			break;
+		}
+		block_cache::mode mode = translator.get_block_mode();
+		std::uint64_t generation = _blocks.get_generation();
+
+		threaded_block *block = nullptr;
+		if (previous) {
+			for (const auto &l : previous->links) {
+				if (l.block && l.address == address && l.mode == mode
+				    && l.generation == generation) {
+					block = l.block;
+					_statistics.chained++;
+					break;
+				}
+			}
+		}
+		if (!block) {
+			std::uint64_t translated = _statistics.translated;
+			block = &get_block(translator, address, mode, breakpoints);
+			if (jit && _statistics.translated != translated) {
+				/* New code pages must not be written through cached pages. */
+				_jit_compiler->flush_tlb();
+			}
+			if (previous) {
+				previous->links[previous->next_link] = {address, mode, block, generation};
+				previous->next_link = (previous->next_link + 1) % previous->links.size();
+			}
+		}
+		if (block->ops.empty()) {
+			break;
+		}
+
+		if (jit && !block->native && ++block->executions == _jit_threshold) {
+			block->native = _jit_compiler->compile(*jit, address, mode, block->ops.size());
+			if (!block->native && _jit_compiler->is_full()) {
+				/* Blocks point into the code buffer, so they go with it. */
+				_jit_compiler->reset();
+				_blocks.clear();
+				previous = nullptr;
+				continue;
+			}
+		}
+
+		_statistics.executed++;
+		bool exit = false;
+		if (block->native) {
+			std::uint32_t instructions = 0, result;
+			try {
+				result = _jit_compiler->execute(block->native, processing_unit, instructions);
+			} catch (...) {
+				_statistics.instructions += instructions;
+				throw;
+			}
+			_statistics.native++;
+			_statistics.instructions += instructions;
+			cycles += result & ~threaded_op::exit_block;
+			exit = result & threaded_op::exit_block;
+			if (_blocks.get_generation() != generation) {
+				block = nullptr;
+			}
+		} else {
+			for (const threaded_op &op : block->ops) {
+				std::uint32_t result = op.execute(processing_unit, op);
+				cycles += result & ~threaded_op::exit_block;
+				_statistics.instructions++;
+				if (result & threaded_op::exit_block) {
+					exit = true;
+					break;
+				}
+				/* The instruction wrote code, maybe this very block. */
+				if (_blocks.get_generation() != generation) {
+					block = nullptr;
+					break;
+				}
+			}
+		}
+		if (exit) {
+			break;
+		}
+		previous = block;
+	} while (cycles < budget);
+
+	return cycles;
+}
+
+} // namespace execution
+} // namespace harpoon
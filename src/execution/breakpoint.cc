@@ -0,0 +1,57 @@
+#include "harpoon/execution/breakpoint.hh"
+
+#include <vector>
+
+namespace harpoon {
+namespace execution {
+
+address_breakpoints::breakpoint_id address_breakpoints::add(
+    memory::address address, const breakpoint::action &action,
+    const breakpoint::condition &condition) {
+	breakpoint_id id = _next_id++;
+	_breakpoints.insert({id, {address, action, condition}});
+	_addresses[address]++;
+	return id;
+}
+
+void address_breakpoints::remove(breakpoint_id id) {
+	auto i = _breakpoints.find(id);
+	if (i == _breakpoints.end()) {
+		return;
+	}
+	auto a = _addresses.find(i->second.address);
+	if (!--a->second) {
+		_addresses.erase(a);
+	}
+	_breakpoints.erase(i);
+}
+
+void address_breakpoints::clear() {
+	_breakpoints.clear();
+	_addresses.clear();
+}
+
+void address_breakpoints::do_actions(memory::address address, processing_unit *processing_unit,
+                                     const breakpoint::action &hit) const {
+	/* Actions may add or remove breakpoints, one-shot ones themselves. */
+	std::vector<entry> matching;
+	for (const auto &b : _breakpoints) {
+		if (b.second.address == address) {
+			matching.push_back(b.second);
+		}
+	}
+
+	bool first = true;
+	for (const auto &b : matching) {
+		if (!b.condition || b.condition(processing_unit)) {
+			if (first && hit) {
+				hit(processing_unit);
+			}
+			first = false;
+			b.action(processing_unit);
+		}
+	}
+}
+
+} // namespace execution
+} // namespace harpoon
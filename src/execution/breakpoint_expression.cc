@@ -0,0 +1,356 @@
+#include "harpoon/execution/breakpoint_expression.hh"
+
+#include "harpoon/execution/exception/bad_breakpoint_expression.hh"
+#include "harpoon/execution/processing_unit.hh"
+
+#include <cctype>
+#include <cstring>
+
+namespace harpoon {
+namespace execution {
+
+class breakpoint_expression::parser {
+public:
+	parser(breakpoint_expression &expression, const symbols &symbols)
+	    : _expression(expression), _symbols(symbols), _text(expression._expression) {}
+
+	void parse() {
+		parse_binary(1);
+		skip_space();
+		if (_position < _text.size()) {
+			fail(std::string("Unexpected '") + _text[_position] + "'");
+		}
+	}
+
+private:
+	static constexpr std::size_t max_nesting = 256;
+
+	struct binary {
+		const char *token;
+		unsigned int precedence;
+		opcode code;
+	};
+
+	/* Two character tokens first, so that "<<" is not taken for "<". */
+	static constexpr binary binaries[] = {
+	    {"||", 1, opcode::OR_ELSE},      {"&&", 2, opcode::AND_THEN},
+	    {"==", 6, opcode::EQUAL},        {"!=", 6, opcode::NOT_EQUAL},
+	    {"<=", 7, opcode::LESS_EQUAL},   {">=", 7, opcode::GREATER_EQUAL},
+	    {"<<", 8, opcode::SHIFT_LEFT},   {">>", 8, opcode::SHIFT_RIGHT},
+	    {"|", 3, opcode::OR},            {"^", 4, opcode::XOR},
+	    {"&", 5, opcode::AND},           {"<", 7, opcode::LESS},
+	    {">", 7, opcode::GREATER},       {"+", 9, opcode::ADD},
+	    {"-", 9, opcode::SUBTRACT},      {"*", 10, opcode::MULTIPLY},
+	};
+
+	[[noreturn]] void fail(const std::string &reason) const {
+		throw HARPOON_EXCEPTION(exception::bad_breakpoint_expression, _text,
+		                        reason + " at " + std::to_string(_position));
+	}
+
+	static bool is_name(char c, bool first) {
+		return std::isalpha(static_cast<unsigned char>(c)) || c == '_'
+		       || (!first && std::isdigit(static_cast<unsigned char>(c)));
+	}
+
+	void skip_space() {
+		while (_position < _text.size()
+		       && std::isspace(static_cast<unsigned char>(_text[_position]))) {
+			_position++;
+		}
+	}
+
+	bool accept(const char *token) {
+		skip_space();
+		std::size_t length = std::strlen(token);
+		if (_text.compare(_position, length, token) != 0) {
+			return false;
+		}
+		_position += length;
+		return true;
+	}
+
+	void expect(const char *token) {
+		if (!accept(token)) {
+			fail(std::string("Expected '") + token + "'");
+		}
+	}
+
+	std::size_t emit(opcode code, int depth, std::uint64_t operand = 0,
+	                 const void *value = nullptr) {
+		_depth = static_cast<std::size_t>(static_cast<int>(_depth) + depth);
+		if (_depth > max_depth) {
+			fail("Expression nested too deep");
+		}
+		_expression._code.push_back({code, operand, value});
+		return _expression._code.size() - 1;
+	}
+
+	const binary *next_binary(unsigned int precedence) {
+		skip_space();
+		for (const auto &b : binaries) {
+			if (_text.compare(_position, std::strlen(b.token), b.token) == 0) {
+				return b.precedence >= precedence ? &b : nullptr;
+			}
+		}
+		return nullptr;
+	}
+
+	void parse_binary(unsigned int precedence) {
+		parse_unary();
+		while (const binary *b = next_binary(precedence)) {
+			_position += std::strlen(b->token);
+			if (b->code == opcode::AND_THEN || b->code == opcode::OR_ELSE) {
+				std::size_t jump = emit(b->code, -1);
+				parse_binary(b->precedence + 1);
+				emit(opcode::BOOLEAN, 0);
+				_expression._code[jump].operand = _expression._code.size();
+			} else {
+				parse_binary(b->precedence + 1);
+				emit(b->code, -1);
+			}
+		}
+	}
+
+	/* Every nesting level of the grammar passes here: bound the native stack. */
+	void parse_unary() {
+		if (++_nesting > max_nesting) {
+			fail("Expression nested too deep");
+		}
+		if (accept("!")) {
+			parse_unary();
+			emit(opcode::NOT, 0);
+		} else if (accept("~")) {
+			parse_unary();
+			emit(opcode::COMPLEMENT, 0);
+		} else if (accept("-")) {
+			parse_unary();
+			emit(opcode::NEGATE, 0);
+		} else {
+			parse_primary();
+		}
+		_nesting--;
+	}
+
+	void parse_memory(opcode code) {
+		if (!_symbols._memory) {
+			fail("No memory to read");
+		}
+		_expression._memory = _symbols._memory;
+		parse_binary(1);
+		expect("]");
+		emit(code, 0);
+	}
+
+	void parse_number() {
+		unsigned int base = 10;
+		if (_text.compare(_position, 2, "0x") == 0 || _text.compare(_position, 2, "0X") == 0) {
+			base = 16;
+			_position += 2;
+		}
+		std::uint64_t value = 0;
+		std::size_t start = _position;
+		for (; _position < _text.size(); _position++) {
+			char c = _text[_position];
+			unsigned int digit;
+			if (std::isdigit(static_cast<unsigned char>(c))) {
+				digit = static_cast<unsigned int>(c - '0');
+			} else if (base == 16 && std::isxdigit(static_cast<unsigned char>(c))) {
+				digit = static_cast<unsigned int>(std::tolower(c) - 'a' + 10);
+			} else {
+				break;
+			}
+			if (value > (~std::uint64_t{} - digit) / base) {
+				fail("Number too large");
+			}
+			value = value * base + digit;
+		}
+		if (_position == start || (_position < _text.size() && is_name(_text[_position], false))) {
+			fail("Bad number");
+		}
+		emit(opcode::CONSTANT, 1, value);
+	}
+
+	void parse_name() {
+		std::size_t start = _position;
+		while (_position < _text.size() && is_name(_text[_position], _position == start)) {
+			_position++;
+		}
+		std::string name = _text.substr(start, _position - start);
+
+		auto r = _symbols._registers.find(name);
+		if (r != _symbols._registers.end()) {
+			std::size_t size = r->second.size;
+			emit(size == 1   ? opcode::REGISTER8
+			     : size == 2 ? opcode::REGISTER16
+			     : size == 4 ? opcode::REGISTER32
+			                 : opcode::REGISTER64,
+			     1, 0, r->second.value);
+		} else if (name == "instructions") {
+			emit(opcode::INSTRUCTIONS, 1);
+		} else if (name == "pc") {
+			emit(opcode::PC, 1);
+		} else if (name == "mem8" && accept("[")) {
+			parse_memory(opcode::MEMORY8);
+		} else if (name == "mem16" && accept("[")) {
+			parse_memory(opcode::MEMORY16);
+		} else if (name == "mem32" && accept("[")) {
+			parse_memory(opcode::MEMORY32);
+		} else if (name == "mem64" && accept("[")) {
+			parse_memory(opcode::MEMORY64);
+		} else {
+			_position = start;
+			fail("Unknown name '" + name + "'");
+		}
+	}
+
+	void parse_primary() {
+		if (accept("(")) {
+			parse_binary(1);
+			expect(")");
+		} else if (accept("[")) {
+			parse_memory(opcode::MEMORY8);
+		} else if (_position == _text.size()) {
+			fail("Unexpected end");
+		} else if (std::isdigit(static_cast<unsigned char>(_text[_position]))) {
+			parse_number();
+		} else if (is_name(_text[_position], true)) {
+			parse_name();
+		} else {
+			fail(std::string("Unexpected '") + _text[_position] + "'");
+		}
+	}
+
+	breakpoint_expression &_expression;
+	const symbols &_symbols;
+	const std::string &_text;
+	std::size_t _position{};
+	std::size_t _depth{};
+	std::size_t _nesting{};
+};
+
+constexpr breakpoint_expression::parser::binary breakpoint_expression::parser::binaries[];
+
+breakpoint_expression::breakpoint_expression(const std::string &expression,
+                                             const symbols &symbols)
+    : _expression(expression) {
+	parser(*this, symbols).parse();
+}
+
+std::uint64_t breakpoint_expression::evaluate(processing_unit *processing_unit) const {
+	/* Values start at stack[1], top pointing at the last one. */
+	std::uint64_t stack[max_depth + 1];
+	std::uint64_t *top = stack;
+	const op *code = _code.data(), *end = code + _code.size();
+
+	for (const op *i = code; i != end; i++) {
+		switch (i->code) {
+		case opcode::CONSTANT: *++top = i->operand; break;
+		case opcode::REGISTER8: *++top = *static_cast<const std::uint8_t *>(i->value); break;
+		case opcode::REGISTER16: *++top = *static_cast<const std::uint16_t *>(i->value); break;
+		case opcode::REGISTER32: *++top = *static_cast<const std::uint32_t *>(i->value); break;
+		case opcode::REGISTER64: *++top = *static_cast<const std::uint64_t *>(i->value); break;
+		case opcode::INSTRUCTIONS: *++top = processing_unit->get_executed_instructions(); break;
+		case opcode::PC: *++top = processing_unit->get_program_counter(); break;
+		case opcode::MEMORY8: {
+			std::uint8_t value;
+			_memory->get(*top, value);
+			*top = value;
+			break;
+		}
+		case opcode::MEMORY16: {
+			std::uint16_t value;
+			_memory->get(*top, value);
+			*top = value;
+			break;
+		}
+		case opcode::MEMORY32: {
+			std::uint32_t value;
+			_memory->get(*top, value);
+			*top = value;
+			break;
+		}
+		case opcode::MEMORY64: _memory->get(*top, *top); break;
+		case opcode::NOT: *top = !*top; break;
+		case opcode::COMPLEMENT: *top = ~*top; break;
+		case opcode::NEGATE: *top = ~*top + 1; break;
+		case opcode::MULTIPLY:
+			top--;
+			top[0] *= top[1];
+			break;
+		case opcode::ADD:
+			top--;
+			top[0] += top[1];
+			break;
+		case opcode::SUBTRACT:
+			top--;
+			top[0] -= top[1];
+			break;
+		case opcode::SHIFT_LEFT:
+			top--;
+			top[0] = top[1] < 64 ? top[0] << top[1] : 0;
+			break;
+		case opcode::SHIFT_RIGHT:
+			top--;
+			top[0] = top[1] < 64 ? top[0] >> top[1] : 0;
+			break;
+		case opcode::LESS:
+			top--;
+			top[0] = top[0] < top[1];
+			break;
+		case opcode::LESS_EQUAL:
+			top--;
+			top[0] = top[0] <= top[1];
+			break;
+		case opcode::GREATER:
+			top--;
+			top[0] = top[0] > top[1];
+			break;
+		case opcode::GREATER_EQUAL:
+			top--;
+			top[0] = top[0] >= top[1];
+			break;
+		case opcode::EQUAL:
+			top--;
+			top[0] = top[0] == top[1];
+			break;
+		case opcode::NOT_EQUAL:
+			top--;
+			top[0] = top[0] != top[1];
+			break;
+		case opcode::AND:
+			top--;
+			top[0] &= top[1];
+			break;
+		case opcode::XOR:
+			top--;
+			top[0] ^= top[1];
+			break;
+		case opcode::OR:
+			top--;
+			top[0] |= top[1];
+			break;
+		case opcode::AND_THEN:
+			if (*top) {
+				top--;
+			} else {
+				i = code + i->operand - 1;
+			}
+			break;
+		case opcode::OR_ELSE:
+			if (*top) {
+				*top = 1;
+				i = code + i->operand - 1;
+			} else {
+				top--;
+			}
+			break;
+		case opcode::BOOLEAN: *top = *top != 0; break;
+		}
+	}
+
+	return *top;
+}
+
+} // namespace execution
+} // namespace harpoon
@@ -0,0 +1,24 @@
+#include "harpoon/execution/exception/bad_breakpoint_expression.hh"
+
+#include <sstream>
+
+namespace harpoon {
+namespace execution {
+namespace exception {
+
+bad_breakpoint_expression::bad_breakpoint_expression(const std::string &expression,
+                                                     const std::string &reason,
+                                                     const std::string &file, int line,
+                                                     const std::string &function)
+    : harpoon::exception::harpoon_exception("", file, line, function) {
+	std::stringstream stream;
+	stream << "Bad breakpoint expression '" << expression << "': " << reason;
+
+	set_what(stream.str());
+}
+
+bad_breakpoint_expression::~bad_breakpoint_expression() {}
+
+} // namespace exception
+} // namespace execution
+} // namespace harpoon
@@ -0,0 +1,23 @@
+#include "harpoon/execution/exception/bad_opcode_pattern.hh"
+
+#include <sstream>
+
+namespace harpoon {
+namespace execution {
+namespace exception {
+
+bad_opcode_pattern::bad_opcode_pattern(const std::string &pattern, const std::string &reason,
+                                       const std::string &file, int line,
+                                       const std::string &function)
+    : harpoon::exception::harpoon_exception("", file, line, function) {
+	std::stringstream stream;
+	stream << "Bad opcode pattern '" << pattern << "': " << reason;
+
+	set_what(stream.str());
+}
+
+bad_opcode_pattern::~bad_opcode_pattern() {}
+
+} // namespace exception
+} // namespace execution
+} // namespace harpoon
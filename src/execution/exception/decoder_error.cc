@@ -0,0 +1,22 @@
+#include "harpoon/execution/exception/decoder_error.hh"
+
+#include <sstream>
+
+namespace harpoon {
+namespace execution {
+namespace exception {
+
+decoder_error::decoder_error(const std::string &reason, const std::string &file, int line,
+                             const std::string &function)
+    : harpoon::exception::harpoon_exception("", file, line, function) {
+	std::stringstream stream;
+	stream << "Decoder: " << reason;
+
+	set_what(stream.str());
+}
+
+decoder_error::~decoder_error() {}
+
+} // namespace exception
+} // namespace execution
+} // namespace harpoon
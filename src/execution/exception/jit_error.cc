@@ -0,0 +1,22 @@
+#include "harpoon/execution/exception/jit_error.hh"
+
+#include <sstream>
+
+namespace harpoon {
+namespace execution {
+namespace exception {
+
+jit_error::jit_error(const std::string &reason, const std::string &file, int line,
+                     const std::string &function)
+    : harpoon::exception::harpoon_exception("", file, line, function) {
+	std::stringstream stream;
+	stream << "JIT: " << reason;
+
+	set_what(stream.str());
+}
+
+jit_error::~jit_error() {}
+
+} // namespace exception
+} // namespace execution
+} // namespace harpoon
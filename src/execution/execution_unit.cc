@@ -6,7 +6,10 @@ namespace execution {
 execution_unit::~execution_unit() {}
 
 void execution_unit::set_clock(const harpoon::clock::clock_ptr &clock) {
-	replace_component(_clock, clock);
+	if (_clock) {
+		remove_component(_clock);
+	}
+	add_component(clock);
 	_clock = clock;
 }
 
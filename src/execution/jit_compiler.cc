@@ -0,0 +1,416 @@
+#include "harpoon/execution/jit_compiler.hh"
+
+#include "harpoon/execution/exception/jit_error.hh"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+
+#if defined(__x86_64__) && defined(__linux__)
+#define HARPOON_EXECUTION_JIT
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace harpoon {
+namespace execution {
+
+namespace {
+
+using reg = x86_64_assembler::reg;
+using mem = x86_64_assembler::mem;
+using alu = x86_64_assembler::alu;
+
+constexpr unsigned int page_bits = memory::main_memory::page_bits;
+constexpr std::int32_t page_size = 1 << page_bits;
+
+constexpr std::int32_t state_offset = offsetof(jit_frame, state);
+constexpr std::int32_t instructions_offset = offsetof(jit_frame, instructions);
+constexpr std::int32_t faulted_offset = offsetof(jit_frame, faulted);
+constexpr std::int32_t code_written_offset = offsetof(jit_frame, code_written);
+constexpr std::int32_t read_tlb_offset = offsetof(jit_frame, read_tlb);
+constexpr std::int32_t write_tlb_offset = offsetof(jit_frame, write_tlb);
+
+template<typename Function>
+const void *function_address(Function function) {
+	return reinterpret_cast<const void *>(function);
+}
+
+} // namespace
+
+void jit_context::begin(memory::address address, std::uint32_t index) {
+	_address = address;
+	_index = index;
+	_stores = false;
+}
+
+/* After writes to code the block ends, but the run goes on with what was written. */
+void jit_context::end() {
+	if (_stores) {
+		label next = new_label();
+		op(alu::CMP, mem{frame_register, code_written_offset}, 0, 8);
+		jump(condition::E, next);
+		emit_leave(_index + 1, _return);
+		bind(next);
+	}
+}
+
+void jit_context::emit_leave(std::uint32_t instructions, label target) {
+	mov(mem{frame_register, instructions_offset}, static_cast<std::int32_t>(instructions), 32);
+	jump(target);
+}
+
+void jit_context::emit_fault_check() {
+	label next = new_label();
+	op(alu::CMP, mem{frame_register, faulted_offset}, 0, 8);
+	jump(condition::E, next);
+	emit_leave(_index, _exit);
+	bind(next);
+}
+
+void jit_context::emit_cycles(std::uint32_t cycles) {
+	op(alu::ADD, cycles_register, static_cast<std::int32_t>(cycles), 32);
+}
+
+void jit_context::emit_exit() {
+	emit_leave(_index + 1, _exit);
+}
+
+/* Guest address in RSI; on a hit RAX holds the biased host page. */
+void jit_context::emit_tlb_lookup(std::int32_t offset, unsigned int bits, label miss) {
+	mov(reg::RAX, reg::RSI);
+	op(shift::SHR, reg::RAX, page_bits);
+	mov(reg::RCX, reg::RAX, 32);
+	op(alu::AND, reg::RCX, static_cast<std::int32_t>(jit_frame::tlb_entries - 1), 32);
+	op(shift::SHL, reg::RCX, 4, 32);
+	op(alu::CMP, reg::RAX, mem{frame_register, offset, reg::RCX});
+	jump(condition::NE, miss);
+	if (bits > 8) {
+		/* Accesses crossing into the next page take the slow path. */
+		mov(reg::RDI, reg::RSI, 32);
+		op(alu::AND, reg::RDI, page_size - 1, 32);
+		op(alu::CMP, reg::RDI, page_size - static_cast<std::int32_t>(bits / 8), 32);
+		jump(condition::A, miss);
+	}
+	load(reg::RAX, mem{frame_register, offset + 8, reg::RCX});
+}
+
+void jit_context::emit_load(reg value, reg address, unsigned int bits) {
+	if (address != reg::RSI) {
+		mov(reg::RSI, address);
+	}
+	label miss = new_label(), done = new_label();
+	emit_tlb_lookup(read_tlb_offset, bits, miss);
+	load(value, mem{reg::RAX, 0, reg::RSI}, bits);
+	jump(done);
+
+	bind(miss);
+	mov(reg::RDI, frame_register);
+	mov(reg::RDX, bits);
+	call(function_address(&jit_compiler::load));
+	emit_fault_check();
+	if (value != reg::RAX) {
+		mov(value, reg::RAX);
+	}
+	bind(done);
+}
+
+void jit_context::emit_store(reg address, reg value, unsigned int bits) {
+	if (value != reg::RSI) {
+		mov(reg::RSI, address);
+		mov(reg::RDX, value);
+	} else if (address != reg::RDX) {
+		mov(reg::RDX, value);
+		mov(reg::RSI, address);
+	} else {
+		mov(reg::RAX, reg::RSI);
+		mov(reg::RSI, reg::RDX);
+		mov(reg::RDX, reg::RAX);
+	}
+	label miss = new_label(), done = new_label();
+	emit_tlb_lookup(write_tlb_offset, bits, miss);
+	store(mem{reg::RAX, 0, reg::RSI}, reg::RDX, bits);
+	jump(done);
+
+	bind(miss);
+	mov(reg::RDI, frame_register);
+	mov(reg::RCX, bits);
+	call(function_address(&jit_compiler::store));
+	emit_fault_check();
+	bind(done);
+	_stores = true;
+}
+
+void jit_context::emit_call(helper function, reg argument) {
+	if (argument != reg::RDX) {
+		mov(reg::RDX, argument);
+	}
+	mov(reg::RDI, frame_register);
+	mov(reg::RSI, reinterpret_cast<std::uint64_t>(function));
+	call(function_address(&jit_compiler::call));
+	emit_fault_check();
+	_stores = true;
+}
+
+jit_translator::~jit_translator() {}
+
+jit_compiler::~jit_compiler() {
+#ifdef HARPOON_EXECUTION_JIT
+	if (_code) {
+		munmap(_code, _capacity);
+	}
+#endif
+}
+
+bool jit_compiler::is_supported() {
+#ifdef HARPOON_EXECUTION_JIT
+	return true;
+#else
+	return false;
+#endif
+}
+
+jit_compiler::native_block jit_compiler::compile(jit_translator &translator,
+                                                 memory::address address,
+                                                 block_cache::mode mode,
+                                                 std::size_t instructions) {
+#ifdef HARPOON_EXECUTION_JIT
+	jit_context &c = _context;
+	c.clear();
+	c._exit = c.new_label();
+	c._return = c.new_label();
+	x86_64_assembler::label done = c.new_label();
+
+	/* Six pushes and the return address keep the stack aligned for calls after the sub. */
+	for (reg r : {reg::RBX, reg::RBP, reg::R12, reg::R13, reg::R14, reg::R15}) {
+		c.push(r);
+	}
+	c.op(alu::SUB, reg::RSP, 8);
+	c.mov(jit_context::frame_register, reg::RDI);
+	c.load(jit_context::state_register,
+	       mem{jit_context::frame_register, state_offset});
+	c.op(alu::XOR, jit_context::cycles_register, jit_context::cycles_register, 32);
+
+	for (std::size_t i = 0; i < instructions; i++) {
+		c.begin(address, static_cast<std::uint32_t>(i));
+		std::size_t length = translator.emit(address, mode, c);
+		if (!length) {
+			_statistics.failed++;
+			return nullptr;
+		}
+		c.end();
+		address += length;
+	}
+
+	c.mov(mem{jit_context::frame_register, instructions_offset},
+	      static_cast<std::int32_t>(instructions), 32);
+	c.bind(c._return);
+	c.mov(reg::RAX, jit_context::cycles_register, 32);
+	c.bind(done);
+	c.op(alu::ADD, reg::RSP, 8);
+	for (reg r : {reg::R15, reg::R14, reg::R13, reg::R12, reg::RBP, reg::RBX}) {
+		c.pop(r);
+	}
+	c.ret();
+
+	c.bind(c._exit);
+	c.mov(reg::RAX, jit_context::cycles_register, 32);
+	c.op(alu::OR, reg::RAX, static_cast<std::int32_t>(threaded_op::exit_block), 32);
+	c.jump(done);
+
+	const auto &code = c.finish();
+
+	if (!_code) {
+		void *mapping = mmap(nullptr, _capacity, PROT_READ | PROT_EXEC,
+		                     MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (mapping == MAP_FAILED) {
+			throw HARPOON_EXCEPTION(exception::jit_error,
+			                        std::string("Cannot map code buffer: ") + std::strerror(errno));
+		}
+		_code = static_cast<std::uint8_t *>(mapping);
+	}
+
+	std::size_t start = (_used + 15) & ~std::size_t{15};
+	if (code.size() > _capacity) {
+		/* Would not fit even after a reset; the block stays threaded. */
+		_statistics.failed++;
+		return nullptr;
+	}
+	if (start + code.size() > _capacity) {
+		_full = true;
+		return nullptr;
+	}
+
+	/* Only the pages taking the code are writable, and only while it is copied. */
+	auto host_page = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+	std::size_t first = start & ~(host_page - 1);
+	std::size_t length = start + code.size() - first;
+	if (mprotect(_code + first, length, PROT_READ | PROT_WRITE)) {
+		throw HARPOON_EXCEPTION(exception::jit_error,
+		                        std::string("Cannot unprotect code: ") + std::strerror(errno));
+	}
+	std::memcpy(_code + start, code.data(), code.size());
+	if (mprotect(_code + first, length, PROT_READ | PROT_EXEC)) {
+		throw HARPOON_EXCEPTION(exception::jit_error,
+		                        std::string("Cannot protect code: ") + std::strerror(errno));
+	}
+
+	_used = start + code.size();
+	_statistics.compiled++;
+	_statistics.code_bytes = _used;
+	return reinterpret_cast<native_block>(_code + start);
+#else
+	(void)translator;
+	(void)address;
+	(void)mode;
+	(void)instructions;
+	_statistics.failed++;
+	return nullptr;
+#endif
+}
+
+void jit_compiler::reset() {
+	_used = 0;
+	_full = false;
+	_statistics.resets++;
+	_statistics.code_bytes = 0;
+}
+
+void jit_compiler::prepare(memory::main_memory *main_memory, const block_cache &blocks,
+                           void *state) {
+	_frame.main_memory = main_memory;
+	_frame.blocks = &blocks;
+	_frame.state = state;
+	_frame.error = &_error;
+	flush_tlb();
+}
+
+void jit_compiler::flush_tlb() {
+	for (std::size_t i = 0; i < jit_frame::tlb_entries; i++) {
+		_frame.read_tlb[i] = {~std::uint64_t{}, 0};
+		_frame.write_tlb[i] = {~std::uint64_t{}, 0};
+	}
+}
+
+std::uint32_t jit_compiler::execute(native_block block, processing_unit &processing_unit,
+                                    std::uint32_t &instructions) {
+	_frame.unit = &processing_unit;
+	_frame.instructions = 0;
+	_frame.faulted = 0;
+	_frame.code_written = 0;
+
+	std::uint32_t result = block(&_frame);
+	instructions = _frame.instructions;
+	if (_frame.faulted) {
+		std::exception_ptr error = _error;
+		_error = nullptr;
+		std::rethrow_exception(error);
+	}
+	return result;
+}
+
+void jit_compiler::fill_tlb(jit_frame *frame, std::uint64_t address, bool write) {
+	memory::address page = address >> page_bits, start = page << page_bits;
+	memory::address end = start + page_size - 1;
+	memory::memory::span span{};
+	if (!frame->main_memory->get_span(start, write, span) || !span.data
+	    || span.range.get_start() > start || span.range.get_end() < end) {
+		return;
+	}
+
+	auto &entry = (write ? frame->write_tlb : frame->read_tlb)[page & (jit_frame::tlb_entries - 1)];
+	entry.page = page;
+	entry.host = reinterpret_cast<std::uintptr_t>(span.data) + (start - span.range.get_start())
+	             - start;
+}
+
+std::uint64_t jit_compiler::load(jit_frame *frame, std::uint64_t address, std::uint32_t bits) {
+	try {
+		std::uint64_t value = 0;
+		switch (bits) {
+		case 8: {
+			std::uint8_t v;
+			frame->main_memory->get(address, v);
+			value = v;
+			break;
+		}
+		case 16: {
+			std::uint16_t v;
+			frame->main_memory->get(address, v);
+			value = v;
+			break;
+		}
+		case 32: {
+			std::uint32_t v;
+			frame->main_memory->get(address, v);
+			value = v;
+			break;
+		}
+		default:
+			frame->main_memory->get(address, value);
+			break;
+		}
+		fill_tlb(frame, address, false);
+		return value;
+	} catch (...) {
+		*frame->error = std::current_exception();
+		frame->faulted = 1;
+		return 0;
+	}
+}
+
+void jit_compiler::store(jit_frame *frame, std::uint64_t address, std::uint64_t value,
+                         std::uint32_t bits) {
+	try {
+		std::uint64_t generation = frame->blocks->get_generation();
+		switch (bits) {
+		case 8:
+			frame->main_memory->set(address, static_cast<std::uint8_t>(value));
+			break;
+		case 16:
+			frame->main_memory->set(address, static_cast<std::uint16_t>(value));
+			break;
+		case 32:
+			frame->main_memory->set(address, static_cast<std::uint32_t>(value));
+			break;
+		default:
+			frame->main_memory->set(address, value);
+			break;
+		}
+		if (frame->blocks->get_generation() != generation) {
+			frame->code_written = 1;
+		}
+
+		/* The write may have replaced the storage, e.g. copied a chunk shared with a snapshot. */
+		for (std::uint64_t page = address >> page_bits;
+		     page <= (address + bits / 8 - 1) >> page_bits; page++) {
+			auto &entry = frame->read_tlb[page & (jit_frame::tlb_entries - 1)];
+			if (entry.page == page) {
+				entry = {~std::uint64_t{}, 0};
+			}
+		}
+		fill_tlb(frame, address, true);
+	} catch (...) {
+		*frame->error = std::current_exception();
+		frame->faulted = 1;
+	}
+}
+
+std::uint64_t jit_compiler::call(jit_frame *frame, jit_context::helper function,
+                                 std::uint64_t argument) {
+	try {
+		std::uint64_t generation = frame->blocks->get_generation();
+		std::uint64_t result = function(*frame->unit, argument);
+		if (frame->blocks->get_generation() != generation) {
+			frame->code_written = 1;
+		}
+		return result;
+	} catch (...) {
+		*frame->error = std::current_exception();
+		frame->faulted = 1;
+		return 0;
+	}
+}
+
+} // namespace execution
+} // namespace harpoon
@@ -0,0 +1,103 @@
+#include "harpoon/execution/opcode_pattern.hh"
+
+#include "harpoon/execution/exception/bad_opcode_pattern.hh"
+
+#include <cctype>
+
+namespace harpoon {
+namespace execution {
+
+opcode_pattern::opcode_pattern(const std::string &pattern, unsigned int unit_bits)
+    : _pattern(pattern), _unit_bits(unit_bits) {
+	if (unit_bits == 0 || unit_bits > 64) {
+		throw HARPOON_EXCEPTION(exception::bad_opcode_pattern, pattern, "Bad unit width");
+	}
+
+	unsigned int bit = 0;
+	char previous = 0;
+	for (std::size_t i = 0; i <= pattern.size(); i++) {
+		char c = i < pattern.size() ? pattern[i] : ' ';
+		if (c == '_' || c == '\'') {
+			continue;
+		}
+		if (std::isspace(static_cast<unsigned char>(c))) {
+			if (bit != 0 && bit != unit_bits) {
+				throw HARPOON_EXCEPTION(exception::bad_opcode_pattern, pattern,
+				                        "Unit " + std::to_string(_mask.size() - 1) + " has "
+				                            + std::to_string(bit) + " bits instead of "
+				                            + std::to_string(unit_bits));
+			}
+			bit = 0;
+			previous = 0;
+			continue;
+		}
+
+		if (bit == 0) {
+			_mask.push_back(0);
+			_value.push_back(0);
+		} else if (bit == unit_bits) {
+			throw HARPOON_EXCEPTION(exception::bad_opcode_pattern, pattern,
+			                        "Unit " + std::to_string(_mask.size() - 1) + " has more than "
+			                            + std::to_string(unit_bits) + " bits");
+		}
+		std::uint8_t shift = static_cast<std::uint8_t>(unit_bits - 1 - bit);
+		bit++;
+
+		if (c == '0' || c == '1') {
+			_mask.back() |= std::uint64_t{1} << shift;
+			_value.back() |= static_cast<std::uint64_t>(c - '0') << shift;
+			_specificity++;
+		} else if (std::isalpha(static_cast<unsigned char>(c))) {
+			std::size_t f = 0;
+			while (f < _fields.size() && _fields[f]._name != c) {
+				f++;
+			}
+			if (f == _fields.size()) {
+				_fields.emplace_back(c);
+			}
+
+			/* Adjacent bits of the same field extend the current part. */
+			auto &parts = _fields[f]._parts;
+			if (previous == c) {
+				parts.back().shift = shift;
+				parts.back().width++;
+			} else {
+				parts.push_back({static_cast<std::uint8_t>(_mask.size() - 1), shift, 1});
+			}
+			if (_fields[f].get_width() > 32) {
+				throw HARPOON_EXCEPTION(exception::bad_opcode_pattern, pattern,
+				                        std::string("Field '") + c + "' is wider than 32 bits");
+			}
+		} else if (c != '-' && c != '.') {
+			throw HARPOON_EXCEPTION(exception::bad_opcode_pattern, pattern,
+			                        std::string("Unexpected character '") + c + "'");
+		}
+		previous = c;
+	}
+
+	if (_mask.empty()) {
+		throw HARPOON_EXCEPTION(exception::bad_opcode_pattern, pattern, "Empty pattern");
+	}
+}
+
+bool opcode_pattern::has_field(char name) const {
+	for (const auto &f : _fields) {
+		if (f._name == name) {
+			return true;
+		}
+	}
+	return false;
+}
+
+const opcode_pattern::field &opcode_pattern::get_field(char name) const {
+	for (const auto &f : _fields) {
+		if (f._name == name) {
+			return f;
+		}
+	}
+	throw HARPOON_EXCEPTION(exception::bad_opcode_pattern, _pattern,
+	                        std::string("No field '") + name + "'");
+}
+
+} // namespace execution
+} // namespace harpoon
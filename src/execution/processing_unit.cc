@@ -1,6 +1,8 @@
 #include "harpoon/execution/processing_unit.hh"
 
 #include "harpoon/execution/exception/execution_exception.hh"
+#include "harpoon/state/reader.hh"
+#include "harpoon/state/writer.hh"
 
 #include <iomanip>
 
@@ -36,6 +38,69 @@ std::uint32_t processing_unit::execute_instruction() {
 	return _current_instruction.step();
 }
 
+address_breakpoints::breakpoint_id processing_unit::add_breakpoint(
+    memory::address address, const breakpoint::action &action,
+    const breakpoint::condition &condition) {
+	auto id = _address_breakpoints.add(address, action, condition);
+	/* Blocks running past the address have to be translated again. */
+	if (_block_interpreter) {
+		_block_interpreter->clear();
+	}
+	return id;
+}
+
+void processing_unit::remove_breakpoint(address_breakpoints::breakpoint_id id) {
+	_address_breakpoints.remove(id);
+	if (_block_interpreter) {
+		_block_interpreter->clear();
+	}
+}
+
+void processing_unit::process_address_breakpoints(memory::address address) {
+	_address_breakpoints.do_actions(address, this, [this, address](processing_unit *) {
+		log(component_debug << "EXECUTION BREAKPOINT at 0x" << std::hex << address);
+		disassemble_instruction();
+	});
+}
+
+memory::address processing_unit::get_program_counter() const {
+	throw COMPONENT_EXCEPTION(exception::execution_exception,
+	                          "Address breakpoints need the program counter.");
+}
+
+std::uint64_t processing_unit::run_blocks(block_translator &translator, std::uint64_t budget) {
+	std::uint64_t instructions = _block_interpreter->get_statistics().instructions;
+	std::uint64_t cycles = _block_interpreter->run(*this, translator, budget);
+	std::uint_fast64_t executed = _executed_instructions;
+	_executed_instructions += _block_interpreter->get_statistics().instructions - instructions;
+
+	if (_stats_interval > 0
+	    && executed / _stats_interval != _executed_instructions / _stats_interval) {
+		log_stats();
+		new_stats_checkpoint();
+	}
+	return cycles;
+}
+
+bool processing_unit::can_save_state() const {
+	return _current_instruction.done() && hardware_component::can_save_state();
+}
+
+void processing_unit::save_state(harpoon::state::writer &writer) const {
+	if (!_current_instruction.done()) {
+		throw COMPONENT_EXCEPTION(exception::execution_exception,
+		                          "Can not save state in the middle of an instruction.");
+	}
+	writer.write(static_cast<std::uint64_t>(_executed_instructions));
+	writer.write(_stats_checkpoint_executed_instruction);
+}
+
+void processing_unit::restore_state(harpoon::state::reader &reader) {
+	_executed_instructions = reader.read<std::uint64_t>();
+	reader.read(_stats_checkpoint_executed_instruction);
+	_current_instruction = instruction{};
+}
+
 void processing_unit::disassemble_instruction() {
 	std::stringstream stream;
 	_current_instruction.disassemble(stream);
@@ -75,6 +140,20 @@ void processing_unit::log_stats(harpoon::log::message::Level level) {
 		                         << " / "
 		                         << static_cast<double>(_executed_instructions) / ms_t * 1000);
 	}
+	if (_decode_cache) {
+		const auto &statistics = _decode_cache->get_statistics();
+		log(component_log(level) << "Decode cache hits / misses / invalidations: "
+		                         << statistics.hits << " / " << statistics.misses << " / "
+		                         << statistics.invalidations << " (hit rate "
+		                         << statistics.get_hit_rate() * 100 << "%)");
+	}
+	if (_block_interpreter) {
+		const auto &statistics = _block_interpreter->get_statistics();
+		log(component_log(level) << "Blocks translated / executed / chained / native: "
+		                         << statistics.translated << " / " << statistics.executed << " / "
+		                         << statistics.chained << " / " << statistics.native << ", "
+		                         << statistics.instructions << " instructions");
+	}
 }
 
 } // namespace execution
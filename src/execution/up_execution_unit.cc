@@ -8,8 +8,9 @@ up_execution_unit::~up_execution_unit() {}
 void up_execution_unit::prepare() {
 	execution_unit::prepare();
 
-	get_clock()->schedule(
-	    0, 0, [this](hardware_component *trigger) { get_processing_unit()->step(trigger); });
+	auto event = get_clock()->register_event(
+	    [this](hardware_component *trigger) { get_processing_unit()->step(trigger); });
+	get_clock()->schedule(0, 0, event);
 }
 
 void up_execution_unit::enable_disassemble() {
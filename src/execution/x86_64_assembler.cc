@@ -0,0 +1,296 @@
+#include "harpoon/execution/x86_64_assembler.hh"
+
+#include "harpoon/execution/exception/jit_error.hh"
+
+namespace harpoon {
+namespace execution {
+
+namespace {
+
+std::uint8_t code(x86_64_assembler::reg r) {
+	return static_cast<std::uint8_t>(r);
+}
+
+bool is_rex_byte(x86_64_assembler::reg r) {
+	return code(r) >= 4 && code(r) < 8;
+}
+
+/* Byte operations on SPL, BPL, SIL or DIL, which need a REX prefix. */
+bool needs_rex(unsigned int bits, x86_64_assembler::reg first,
+               x86_64_assembler::reg second = x86_64_assembler::reg::RAX) {
+	return bits == 8 && (is_rex_byte(first) || is_rex_byte(second));
+}
+
+std::uint8_t alu_opcode(x86_64_assembler::alu op, unsigned int bits, std::uint8_t direction) {
+	return static_cast<std::uint8_t>(static_cast<std::uint8_t>(op) << 3 | direction
+	                                 | (bits == 8 ? 0 : 1));
+}
+
+bool fits_int8(std::int32_t value) {
+	return value >= -128 && value <= 127;
+}
+
+} // namespace
+
+constexpr std::size_t x86_64_assembler::unbound;
+
+x86_64_assembler::label x86_64_assembler::new_label() {
+	_labels.push_back(unbound);
+	return _labels.size() - 1;
+}
+
+void x86_64_assembler::bind(label label) {
+	_labels[label] = _code.size();
+}
+
+void x86_64_assembler::imm32(std::uint32_t value) {
+	for (unsigned int i = 0; i < 4; i++) {
+		byte(static_cast<std::uint8_t>(value >> (8 * i)));
+	}
+}
+
+void x86_64_assembler::imm64(std::uint64_t value) {
+	imm32(static_cast<std::uint32_t>(value));
+	imm32(static_cast<std::uint32_t>(value >> 32));
+}
+
+void x86_64_assembler::prefix(unsigned int bits, std::uint8_t r, std::uint8_t x, std::uint8_t b,
+                              bool force_rex) {
+	if (bits == 16) {
+		byte(0x66);
+	}
+	std::uint8_t rex = static_cast<std::uint8_t>(0x40 | (bits == 64 ? 8 : 0) | ((r >> 3) & 1) << 2
+	                                             | ((x >> 3) & 1) << 1 | ((b >> 3) & 1));
+	if (rex != 0x40 || force_rex) {
+		byte(rex);
+	}
+}
+
+void x86_64_assembler::modrm(std::uint8_t r, reg rm) {
+	byte(static_cast<std::uint8_t>(0xc0 | (r & 7) << 3 | (code(rm) & 7)));
+}
+
+void x86_64_assembler::modrm(std::uint8_t r, const mem &rm) {
+	if (rm.base == reg::NONE || rm.index == reg::RSP) {
+		throw HARPOON_EXCEPTION(exception::jit_error, "Unsupported memory operand");
+	}
+
+	std::uint8_t base = code(rm.base) & 7;
+	std::uint8_t mod = 0x80;
+	if (rm.displacement == 0 && base != 5) {
+		mod = 0x00;
+	} else if (fits_int8(rm.displacement)) {
+		mod = 0x40;
+	}
+
+	if (rm.index == reg::NONE && base != 4) {
+		byte(static_cast<std::uint8_t>(mod | (r & 7) << 3 | base));
+	} else {
+		std::uint8_t scale = rm.scale == 8 ? 3 : rm.scale == 4 ? 2 : rm.scale == 2 ? 1 : 0;
+		std::uint8_t index = rm.index == reg::NONE ? 4 : code(rm.index) & 7;
+		byte(static_cast<std::uint8_t>(mod | (r & 7) << 3 | 4));
+		byte(static_cast<std::uint8_t>(scale << 6 | index << 3 | base));
+	}
+
+	if (mod == 0x40) {
+		byte(static_cast<std::uint8_t>(rm.displacement));
+	} else if (mod == 0x80) {
+		imm32(static_cast<std::uint32_t>(rm.displacement));
+	}
+}
+
+void x86_64_assembler::encode(unsigned int bits, std::initializer_list<std::uint8_t> opcode,
+                              std::uint8_t r, reg rm, bool force_rex) {
+	prefix(bits, r, 0, code(rm), force_rex);
+	for (auto b : opcode) {
+		byte(b);
+	}
+	modrm(r, rm);
+}
+
+void x86_64_assembler::encode(unsigned int bits, std::initializer_list<std::uint8_t> opcode,
+                              std::uint8_t r, const mem &rm, bool force_rex) {
+	prefix(bits, r, rm.index == reg::NONE ? 0 : code(rm.index), code(rm.base), force_rex);
+	for (auto b : opcode) {
+		byte(b);
+	}
+	modrm(r, rm);
+}
+
+void x86_64_assembler::mov(reg destination, reg source, unsigned int bits) {
+	encode(bits, {static_cast<std::uint8_t>(bits == 8 ? 0x88 : 0x89)}, code(source), destination,
+	       needs_rex(bits, destination, source));
+}
+
+void x86_64_assembler::mov(reg destination, std::uint64_t immediate) {
+	if (immediate <= 0xffffffffu) {
+		prefix(32, 0, 0, code(destination));
+		byte(static_cast<std::uint8_t>(0xb8 + (code(destination) & 7)));
+		imm32(static_cast<std::uint32_t>(immediate));
+	} else {
+		prefix(64, 0, 0, code(destination));
+		byte(static_cast<std::uint8_t>(0xb8 + (code(destination) & 7)));
+		imm64(immediate);
+	}
+}
+
+void x86_64_assembler::mov(const mem &destination, std::int32_t immediate, unsigned int bits) {
+	encode(bits, {static_cast<std::uint8_t>(bits == 8 ? 0xc6 : 0xc7)}, 0, destination);
+	if (bits == 8) {
+		byte(static_cast<std::uint8_t>(immediate));
+	} else if (bits == 16) {
+		byte(static_cast<std::uint8_t>(immediate));
+		byte(static_cast<std::uint8_t>(immediate >> 8));
+	} else {
+		imm32(static_cast<std::uint32_t>(immediate));
+	}
+}
+
+void x86_64_assembler::load(reg destination, const mem &source, unsigned int bits) {
+	switch (bits) {
+	case 8:
+		encode(32, {0x0f, 0xb6}, code(destination), source);
+		break;
+	case 16:
+		encode(32, {0x0f, 0xb7}, code(destination), source);
+		break;
+	default:
+		encode(bits, {0x8b}, code(destination), source);
+		break;
+	}
+}
+
+void x86_64_assembler::store(const mem &destination, reg source, unsigned int bits) {
+	encode(bits, {static_cast<std::uint8_t>(bits == 8 ? 0x88 : 0x89)}, code(source), destination,
+	       needs_rex(bits, source));
+}
+
+void x86_64_assembler::lea(reg destination, const mem &source) {
+	encode(64, {0x8d}, code(destination), source);
+}
+
+void x86_64_assembler::op(alu op, reg destination, reg source, unsigned int bits) {
+	encode(bits, {alu_opcode(op, bits, 0)}, code(source), destination,
+	       needs_rex(bits, destination, source));
+}
+
+void x86_64_assembler::op(alu op, reg destination, std::int32_t immediate, unsigned int bits) {
+	if (bits == 8) {
+		encode(bits, {0x80}, static_cast<std::uint8_t>(op), destination,
+		       needs_rex(bits, destination));
+		byte(static_cast<std::uint8_t>(immediate));
+	} else if (fits_int8(immediate)) {
+		encode(bits, {0x83}, static_cast<std::uint8_t>(op), destination);
+		byte(static_cast<std::uint8_t>(immediate));
+	} else {
+		encode(bits, {0x81}, static_cast<std::uint8_t>(op), destination);
+		if (bits == 16) {
+			byte(static_cast<std::uint8_t>(immediate));
+			byte(static_cast<std::uint8_t>(immediate >> 8));
+		} else {
+			imm32(static_cast<std::uint32_t>(immediate));
+		}
+	}
+}
+
+void x86_64_assembler::op(alu op, reg destination, const mem &source, unsigned int bits) {
+	encode(bits, {alu_opcode(op, bits, 2)}, code(destination), source,
+	       needs_rex(bits, destination));
+}
+
+void x86_64_assembler::op(alu op, const mem &destination, reg source, unsigned int bits) {
+	encode(bits, {alu_opcode(op, bits, 0)}, code(source), destination, needs_rex(bits, source));
+}
+
+void x86_64_assembler::op(alu op, const mem &destination, std::int32_t immediate,
+                          unsigned int bits) {
+	if (bits == 8) {
+		encode(bits, {0x80}, static_cast<std::uint8_t>(op), destination);
+		byte(static_cast<std::uint8_t>(immediate));
+	} else if (fits_int8(immediate)) {
+		encode(bits, {0x83}, static_cast<std::uint8_t>(op), destination);
+		byte(static_cast<std::uint8_t>(immediate));
+	} else {
+		encode(bits, {0x81}, static_cast<std::uint8_t>(op), destination);
+		if (bits == 16) {
+			byte(static_cast<std::uint8_t>(immediate));
+			byte(static_cast<std::uint8_t>(immediate >> 8));
+		} else {
+			imm32(static_cast<std::uint32_t>(immediate));
+		}
+	}
+}
+
+void x86_64_assembler::op(shift op, reg destination, std::uint8_t count, unsigned int bits) {
+	encode(bits, {static_cast<std::uint8_t>(bits == 8 ? 0xc0 : 0xc1)},
+	       static_cast<std::uint8_t>(op), destination, needs_rex(bits, destination));
+	byte(count);
+}
+
+void x86_64_assembler::test(reg first, reg second, unsigned int bits) {
+	encode(bits, {static_cast<std::uint8_t>(bits == 8 ? 0x84 : 0x85)}, code(second), first,
+	       needs_rex(bits, first, second));
+}
+
+void x86_64_assembler::set(condition condition, reg destination) {
+	bool rex = is_rex_byte(destination);
+	encode(32, {0x0f, static_cast<std::uint8_t>(0x90 + static_cast<std::uint8_t>(condition))}, 0,
+	       destination, rex);
+	encode(32, {0x0f, 0xb6}, code(destination), destination, rex);
+}
+
+void x86_64_assembler::jump(label target) {
+	byte(0xe9);
+	_fixups.push_back({_code.size(), target});
+	imm32(0);
+}
+
+void x86_64_assembler::jump(condition condition, label target) {
+	byte(0x0f);
+	byte(static_cast<std::uint8_t>(0x80 + static_cast<std::uint8_t>(condition)));
+	_fixups.push_back({_code.size(), target});
+	imm32(0);
+}
+
+void x86_64_assembler::call(const void *function) {
+	mov(reg::RAX, reinterpret_cast<std::uint64_t>(function));
+	encode(32, {0xff}, 2, reg::RAX);
+}
+
+void x86_64_assembler::push(reg source) {
+	prefix(32, 0, 0, code(source));
+	byte(static_cast<std::uint8_t>(0x50 + (code(source) & 7)));
+}
+
+void x86_64_assembler::pop(reg destination) {
+	prefix(32, 0, 0, code(destination));
+	byte(static_cast<std::uint8_t>(0x58 + (code(destination) & 7)));
+}
+
+void x86_64_assembler::ret() {
+	byte(0xc3);
+}
+
+const std::vector<std::uint8_t> &x86_64_assembler::finish() {
+	for (const auto &f : _fixups) {
+		if (_labels[f.target] == unbound) {
+			throw HARPOON_EXCEPTION(exception::jit_error, "Jump to an unbound label");
+		}
+		auto relative = static_cast<std::uint32_t>(static_cast<std::int64_t>(_labels[f.target])
+		                                           - static_cast<std::int64_t>(f.position + 4));
+		for (unsigned int i = 0; i < 4; i++) {
+			_code[f.position + i] = static_cast<std::uint8_t>(relative >> (8 * i));
+		}
+	}
+	_fixups.clear();
+	return _code;
+}
+
+void x86_64_assembler::clear() {
+	_code.clear();
+	_labels.clear();
+	_fixups.clear();
+}
+
+} // namespace execution
+} // namespace harpoon
@@ -5,6 +5,8 @@
 #include "harpoon/exception/subcomponent_owned.hh"
 #include "harpoon/exception/wrong_state.hh"
 #include "harpoon/log/message.hh"
+#include "harpoon/state/reader.hh"
+#include "harpoon/state/writer.hh"
 
 #include <algorithm>
 
@@ -151,6 +153,37 @@ void hardware_component::shutdown() {
 	}
 }
 
+void hardware_component::save(harpoon::state::writer &writer) const {
+	auto mark = writer.begin_section(_name);
+	save_state(writer);
+	for (const auto &component : _components) {
+		component->save(writer);
+	}
+	writer.end_section(mark);
+}
+
+bool hardware_component::can_save_state() const {
+	for (const auto &component : _components) {
+		if (!component->can_save_state()) {
+			return false;
+		}
+	}
+	return true;
+}
+
+void hardware_component::restore(harpoon::state::reader &reader) {
+	auto mark = reader.begin_section(_name);
+	restore_state(reader);
+	for (const auto &component : _components) {
+		component->restore(reader);
+	}
+	reader.end_section(mark);
+}
+
+void hardware_component::save_state(harpoon::state::writer &) const {}
+
+void hardware_component::restore_state(harpoon::state::reader &) {}
+
 void hardware_component::log_state(bool subcomponents, log::message::Level level) const {
 	std::lock_guard<std::mutex> _lk(_mutex);
 	log_state(level);
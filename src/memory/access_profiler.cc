@@ -0,0 +1,142 @@
+#include "harpoon/memory/access_profiler.hh"
+
+#include <fstream>
+#include <iomanip>
+
+namespace harpoon {
+namespace memory {
+
+namespace {
+
+class hex_address {
+public:
+	hex_address(address address) : _address(address) {}
+
+	friend std::ostream &operator<<(std::ostream &stream, const hex_address &a) {
+		std::ostream out(stream.rdbuf());
+		out << "0x" << std::hex << std::setw(sizeof(address) * 2) << std::uppercase
+		    << std::setfill('0') << a._address;
+		return stream;
+	}
+
+private:
+	address _address;
+};
+
+template<typename Counters>
+bool is_unused(const Counters &counters) {
+	for (const auto &counter : counters) {
+		if (counter.load(std::memory_order_relaxed)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+} // namespace
+
+access_profiler::access_profiler(unsigned int page_bits, std::uint32_t sample_interval,
+                                 bool per_source)
+    : _page_bits(page_bits), _sample_interval(sample_interval ? sample_interval : 1),
+      _sample_countdown(_sample_interval), _per_source(per_source) {}
+
+access_profiler::~access_profiler() {}
+
+access_profiler::page_counters &access_profiler::get_page_counters(const page_key &key) {
+	std::lock_guard<std::mutex> lk(_mutex);
+	auto &counters = _pages[key];
+	if (!counters) {
+		counters.reset(new page_counters{});
+	}
+	return *counters;
+}
+
+std::uint64_t access_profiler::get_count(address address, access_kind kind,
+                                         source_id source) const {
+	std::lock_guard<std::mutex> lk(_mutex);
+	auto i = _pages.find({_per_source ? source : 0, address >> _page_bits});
+	if (i == _pages.end()) {
+		return 0;
+	}
+	return (*i->second)[static_cast<std::size_t>(kind)].load(std::memory_order_relaxed)
+	       * _sample_interval;
+}
+
+void access_profiler::reset() {
+	std::lock_guard<std::mutex> lk(_mutex);
+	for (auto &page : _pages) {
+		for (auto &counter : *page.second) {
+			counter.store(0, std::memory_order_relaxed);
+		}
+	}
+}
+
+void access_profiler::dump(std::ostream &stream, Format format) const {
+	std::lock_guard<std::mutex> lk(_mutex);
+	switch (format) {
+	case Format::CSV: dump_csv(stream); break;
+	case Format::JSON: dump_json(stream); break;
+	}
+}
+
+void access_profiler::dump(const std::string &file_name, Format format) const {
+	std::ofstream output;
+	output.exceptions(std::ofstream::badbit);
+	output.open(file_name, std::ios::trunc);
+	dump(output, format);
+}
+
+void access_profiler::dump_on_shutdown() const {
+	if (!_shutdown_file_name.empty()) {
+		dump(_shutdown_file_name, _shutdown_format);
+	}
+}
+
+void access_profiler::dump_csv(std::ostream &stream) const {
+	stream << "source,page_start,page_end,read_bytes,write_bytes,fetch_bytes\n";
+	for (const auto &page : _pages) {
+		if (is_unused(*page.second)) {
+			continue;
+		}
+		address start = page.first.second << _page_bits;
+		stream << page.first.first << "," << hex_address(start) << ","
+		       << hex_address(start + get_page_length() - 1);
+		for (const auto &counter : *page.second) {
+			stream << "," << counter.load(std::memory_order_relaxed) * _sample_interval;
+		}
+		stream << "\n";
+	}
+}
+
+void access_profiler::dump_json(std::ostream &stream) const {
+	stream << "{\n\t\"page_length\": " << get_page_length()
+	       << ",\n\t\"sample_interval\": " << _sample_interval << ",\n\t\"pages\": [";
+	bool first = true;
+	for (const auto &page : _pages) {
+		const auto &counters = *page.second;
+		if (is_unused(counters)) {
+			continue;
+		}
+		address start = page.first.second << _page_bits;
+		stream << (first ? "\n" : ",\n") << "\t\t{\"source\": " << page.first.first
+		       << ", \"page_start\": \"" << hex_address(start) << "\""
+		       << ", \"read_bytes\": "
+		       << counters[static_cast<std::size_t>(access_kind::READ)].load(
+		              std::memory_order_relaxed)
+		              * _sample_interval
+		       << ", \"write_bytes\": "
+		       << counters[static_cast<std::size_t>(access_kind::WRITE)].load(
+		              std::memory_order_relaxed)
+		              * _sample_interval
+		       << ", \"fetch_bytes\": "
+		       << counters[static_cast<std::size_t>(access_kind::FETCH)].load(
+		              std::memory_order_relaxed)
+		              * _sample_interval
+		       << "}";
+		first = false;
+	}
+	stream << "\n\t]\n}\n";
+}
+
+} // namespace memory
+} // namespace harpoon
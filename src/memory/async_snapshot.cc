@@ -0,0 +1,42 @@
+#include "harpoon/memory/async_snapshot.hh"
+
+namespace harpoon {
+namespace memory {
+
+async_snapshot::async_snapshot(const memory_ptr &memory,
+                               const serializer::serializer_ptr &serializer,
+                               const clock::clock *clock)
+    : _tick(clock ? clock->get_cycle().tick : 0), _memory(memory), _frozen(memory->freeze()),
+      _serializer(serializer) {
+	memory->log(log_debug_c(memory->get_name()) << "Snapshot frozen at tick " << _tick);
+	_thread = std::thread(&async_snapshot::write, this);
+}
+
+async_snapshot::~async_snapshot() {
+	if (_thread.joinable()) {
+		_thread.join();
+	}
+}
+
+void async_snapshot::write() {
+	try {
+		_frozen->serialize(*_serializer);
+		_frozen.reset();
+		_serializer.reset();
+	} catch (...) {
+		_error = std::current_exception();
+	}
+	_done.store(true, std::memory_order_release);
+}
+
+void async_snapshot::wait() {
+	if (_thread.joinable()) {
+		_thread.join();
+	}
+	if (_error) {
+		std::rethrow_exception(_error);
+	}
+}
+
+} // namespace memory
+} // namespace harpoon
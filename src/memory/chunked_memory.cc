@@ -4,11 +4,18 @@
 #include "harpoon/memory/exception/memory_exception.hh"
 #include "harpoon/memory/exception/read_access_violation.hh"
 #include "harpoon/memory/exception/write_access_violation.hh"
+#include "harpoon/memory/frozen_memory.hh"
 #include "harpoon/memory/serializer/serializer.hh"
+#include "harpoon/util/bytes.hh"
+#include "harpoon/util/hash.hh"
+
+#include <algorithm>
+#include <cstring>
 
 namespace harpoon {
 namespace memory {
 
+
 chunked_memory::~chunked_memory() {}
 
 void chunked_memory::prepare() {
@@ -30,6 +37,21 @@ void chunked_memory::prepare() {
 	log(component_notice << "Chunking " << len << " bytes of memory into " << chunks
 	                     << " chunks of " << _chunk_length << " bytes each");
 	_memory.resize(chunks);
+	_flags.assign(chunks, 0);
+	_hashes.assign(chunks, 0);
+	_written.assign(chunks, get_dirty_epoch());
+	_cleared = 0;
+	_lazy.assign(chunks, nullptr);
+	_lazy_chunks = 0;
+
+	if (!_shared_memory_name.empty()) {
+		log(component_notice << "Sharing memory as " << _shared_memory_name);
+		_shared_storage = make_shared_storage(_shared_memory_name, chunks * _chunk_length);
+		for (chunk_index index = 0; index < chunks; index++) {
+			_memory[index] = chunk_ptr(_shared_storage->get_data() + index * _chunk_length,
+			                           [](chunk_item *) {});
+		}
+	}
 
 	memory::prepare();
 }
@@ -38,6 +60,12 @@ void chunked_memory::cleanup() {
 	memory::cleanup();
 	log(component_notice << "Freeing memory");
 	_memory.clear();
+	_flags.clear();
+	_hashes.clear();
+	_written.clear();
+	_lazy.clear();
+	_lazy_chunks = 0;
+	_shared_storage.reset();
 }
 
 void chunked_memory::get_cell(address address, uint8_t &value) {
@@ -45,11 +73,17 @@ void chunked_memory::get_cell(address address, uint8_t &value) {
 		throw COMPONENT_EXCEPTION(exception::read_access_violation, address);
 	}
 
-	const chunk_ptr &chunk = get_chunk(address);
-	if (chunk) {
-		chunk_offset offset = get_chunk_offset(address);
-		value = chunk.get()[offset];
+	chunk_ptr &chunk = get_chunk(address);
+	if (!chunk) {
+		if (!is_lazy(get_chunk_index(address))) {
+			value = 0;
+			return;
+		}
+		load_chunk(get_chunk_index(address));
 	}
+
+	chunk_offset offset = get_chunk_offset(address);
+	value = chunk.get()[offset];
 }
 
 void chunked_memory::set_cell(address address, uint8_t value) {
@@ -59,8 +93,15 @@ void chunked_memory::set_cell(address address, uint8_t value) {
 
 	chunk_ptr &chunk = get_chunk(address);
 	if (!chunk) {
-		allocate_chunk(chunk, address);
+		if (is_lazy(get_chunk_index(address))) {
+			load_chunk(get_chunk_index(address));
+		} else {
+			allocate_chunk(chunk, address);
+		}
+	} else {
+		unshare_chunk(chunk);
 	}
+	mark_written(get_chunk_index(address));
 
 	chunk_offset offset = get_chunk_offset(address);
 	chunk.get()[offset] = value;
@@ -68,38 +109,294 @@ void chunked_memory::set_cell(address address, uint8_t value) {
 
 inline void chunked_memory::allocate_chunk(chunk_ptr &chunk, address address) {
 	log(component_debug << "Allocating chunk #" << get_chunk_index(address));
-	chunk.reset(new uint8_t[_chunk_length], std::default_delete<chunk_item[]>());
+	chunk.reset(new uint8_t[_chunk_length](), std::default_delete<chunk_item[]>());
+}
+
+void chunked_memory::copy_chunk(chunk_ptr &chunk) {
+	chunk_ptr copy(new uint8_t[_chunk_length], std::default_delete<chunk_item[]>());
+	std::memcpy(copy.get(), chunk.get(), _chunk_length);
+	chunk = std::move(copy);
+}
+
+bool chunked_memory::do_get_span(address address, bool write, span &span) {
+	if (_memory.empty() || !has_address(address)) {
+		return false;
+	}
+
+	chunk_ptr &chunk = get_chunk(address);
+	if (!chunk && is_lazy(get_chunk_index(address))) {
+		load_chunk(get_chunk_index(address));
+	} else if (!chunk && write) {
+		allocate_chunk(chunk, address);
+	} else if (write) {
+		unshare_chunk(chunk);
+	}
+	if (write) {
+		mark_written(get_chunk_index(address));
+	}
+
+	auto start = address - get_chunk_offset(address);
+	span.range = address_range(start, start + _chunk_length - 1);
+	span.range.intersect(get_address_range());
+	span.data = chunk.get();
+	return true;
 }
 
 void chunked_memory::serialize(serializer::serializer &serializer) {
+	for (chunk_index index = 0; _lazy_chunks && index < _memory.size(); index++) {
+		if (is_lazy(index)) {
+			load_chunk(index);
+		}
+	}
+	serialize_chunks(serializer, _memory);
+}
+
+void chunked_memory::serialize_chunks(serializer::serializer &serializer,
+                                      const chunk_container &chunks) const {
+	std::size_t length = static_cast<std::size_t>(get_address_range().get_length());
+
+	/* Zero chunks are found in parallel; the writes stay in chunk order. */
+	std::vector<std::uint8_t> zero(chunks.size());
+	auto scan = [this, length, &chunks, &zero](chunk_index first, chunk_index last) {
+		for (chunk_index index = first; index < last; index++) {
+			std::size_t offset = index * _chunk_length;
+			const chunk_ptr &chunk = chunks[index];
+			zero[index] = !chunk
+			              || util::bytes::is_zero(chunk.get(),
+			                                      std::min(_chunk_length, length - offset));
+		}
+	};
+	run_batches(chunks.size(), batch_length / _chunk_length, scan);
+
 	serializer.start_memory_block(this);
-	for (address address = get_address_range().get_start(); address < get_address_range().get_end();
-	     address += _chunk_length) {
-		chunk_ptr &chunk = get_chunk(address);
-		serializer.write(chunk.get(), address - get_address_range().get_start(), _chunk_length,
-		                 !chunk);
+	for (chunk_index index = 0; index < chunks.size(); index++) {
+		std::size_t offset = index * _chunk_length;
+		serializer.write(chunks[index].get(), offset, std::min(_chunk_length, length - offset),
+		                 zero[index]);
 	}
 	serializer.finalize_memory_block();
 }
 
+class chunked_memory::frozen : public frozen_memory {
+public:
+	frozen(const chunked_memory *memory) : _memory(memory), _chunks(memory->_memory) {}
+
+	virtual void serialize(serializer::serializer &serializer) override {
+		_memory->serialize_chunks(serializer, _chunks);
+	}
+
+private:
+	const chunked_memory *_memory;
+	chunk_container _chunks;
+};
+
+frozen_memory_ptr chunked_memory::freeze() {
+	/* Shared chunks cannot be swapped for private copies without leaving the export stale. */
+	if (_shared_storage) {
+		return memory::freeze();
+	}
+
+	for (chunk_index index = 0; _lazy_chunks && index < _memory.size(); index++) {
+		if (is_lazy(index)) {
+			load_chunk(index);
+		}
+	}
+
+	return std::make_shared<frozen>(this);
+}
+
+void chunked_memory::get_dirty(std::vector<address_range> &ranges) const {
+	get_dirty_since(_cleared, ranges);
+}
+
+void chunked_memory::clear_dirty() {
+	_cleared = start_dirty_epoch();
+}
+
+void chunked_memory::get_dirty_since(std::uint64_t epoch,
+                                     std::vector<address_range> &ranges) const {
+	for (chunk_index index = 0; index < _written.size(); index++) {
+		if (_written[index] < epoch) {
+			continue;
+		}
+		address_range range = get_chunk_range(index);
+		if (!ranges.empty() && ranges.back().get_end() + 1 == range.get_start()) {
+			ranges.back().set_end(range.get_end());
+		} else {
+			ranges.push_back(range);
+		}
+	}
+}
+
+void chunked_memory::get_block_hashes(std::vector<block_hash> &hashes) {
+	for (chunk_index index = 0; _lazy_chunks && index < _memory.size(); index++) {
+		if (is_lazy(index)) {
+			load_chunk(index);
+		}
+	}
+
+	std::size_t first = hashes.size();
+	hashes.resize(first + _memory.size());
+	auto hash = [this, &hashes, first](std::size_t begin, std::size_t end) {
+		std::vector<std::uint8_t> zero;
+		for (chunk_index index = begin; index < end; index++) {
+			address_range range = get_chunk_range(index);
+			if (!(_flags[index] & chunk_hashed)) {
+				std::size_t length = static_cast<std::size_t>(range.get_length());
+				const chunk_ptr &chunk = _memory[index];
+				if (!chunk) {
+					zero.resize(length);
+				}
+				_hashes[index] = util::hash::hash64(chunk ? chunk.get() : zero.data(), length);
+				_flags[index] |= chunk_hashed;
+			}
+			hashes[first + index] = {range, _hashes[index]};
+		}
+	};
+	run_batches(_memory.size(), std::max<std::size_t>(batch_length / _chunk_length, 1), hash);
+}
+
+address_range chunked_memory::get_chunk_range(chunk_index index) const {
+	auto start = get_address_range().get_start() + index * _chunk_length;
+	address_range range{start, start + _chunk_length - 1};
+	range.intersect(get_address_range());
+	return range;
+}
+
 void chunked_memory::deserialize(deserializer::deserializer &deserializer) {
-	for (address address = get_address_range().get_start(); address < get_address_range().get_end();
-	     address += _chunk_length) {
+	if (!deserializer.is_concurrent()) {
+		for (chunk_index index = 0; index < _memory.size(); index++) {
+			restore_chunk(deserializer, index);
+		}
+		return;
+	}
+
+	/*
+	 * Sources of lazy chunks need not be thread-safe, so partly covered ones are
+	 * loaded up front; fully covered ones are about to be overwritten.
+	 */
+	for (chunk_index index = 0; _lazy_chunks && index < _memory.size(); index++) {
+		if (!is_lazy(index)) {
+			continue;
+		}
+		address_range cr = get_chunk_range(index);
+		if (deserializer.get_range().get_intersection(cr) == cr) {
+			discard_lazy(index);
+		} else if (cr.overlaps(deserializer.get_range())) {
+			load_chunk(index);
+		}
+	}
+
+	auto restore = [this, &deserializer](chunk_index first, chunk_index last) {
+		for (chunk_index index = first; index < last; index++) {
+			restore_chunk(deserializer, index);
+		}
+	};
+	run_batches(_memory.size(), batch_length / _chunk_length, restore);
+}
+
+void chunked_memory::restore_chunk(deserializer::deserializer &deserializer, chunk_index index) {
+	address_range cr = get_chunk_range(index);
+	cr.intersect(deserializer.get_range());
+	if (cr.is_empty()) {
+		return;
+	}
+
+	chunk_ptr &chunk = _memory[index];
+	if (is_lazy(index)) {
+		if (cr == get_chunk_range(index)) {
+			discard_lazy(index);
+		} else {
+			load_chunk(index);
+		}
+	}
+	mark_written(index);
+
+	chunk_offset offset = get_chunk_offset(cr.get_start());
+	std::size_t length = static_cast<std::size_t>(cr.get_length());
+	if (!deserializer.has_data(cr)) {
+		if (cr == get_chunk_range(index) && !_shared_storage) {
+			chunk.reset();
+		} else if (chunk) {
+			unshare_chunk(chunk);
+			util::bytes::fill(chunk.get() + offset, length, 0);
+		}
+		return;
+	}
+
+	bool allocated = !chunk;
+	if (allocated) {
+		allocate_chunk(chunk, cr.get_start());
+	} else {
+		unshare_chunk(chunk);
+	}
+
+	uint8_t *data = chunk.get() + offset;
+	deserializer.read(this, data, cr);
+
+	/* Chunks allocated just to hold zeros are released again. */
+	if (allocated && util::bytes::is_zero(data, length)) {
+		chunk.reset();
+	}
+}
+
+void chunked_memory::deserialize_lazily(const deserializer::deserializer_ptr &deserializer) {
+	if (_shared_storage) {
+		deserialize(*deserializer);
+		return;
+	}
 
-		address_range cr{address, address + _chunk_length - 1};
-		cr.intersect(get_address_range());
-		cr.intersect(deserializer.get_range());
+	for (chunk_index index = 0; index < _memory.size(); index++) {
+		address_range cr = get_chunk_range(index);
+		cr.intersect(deserializer->get_range());
 		if (cr.is_empty()) {
 			continue;
 		}
 
-		chunk_ptr &chunk = get_chunk(address);
-		if (!chunk) {
-			allocate_chunk(chunk, address);
+		chunk_ptr &chunk = _memory[index];
+		mark_written(index);
+		if (cr != get_chunk_range(index)) {
+			/* Partially covered chunks are restored right away. */
+			if (is_lazy(index)) {
+				load_chunk(index);
+			} else if (!chunk) {
+				allocate_chunk(chunk, cr.get_start());
+			} else {
+				unshare_chunk(chunk);
+			}
+			deserializer->read(this, chunk.get() + get_chunk_offset(cr.get_start()), cr);
+			continue;
 		}
 
-		deserializer.read(this, chunk.get() + get_chunk_offset(cr.get_start()), cr);
+		chunk.reset();
+		if (_lazy[index]) {
+			_lazy_chunks--;
+		}
+		_lazy[index] = deserializer->has_data(cr) ? deserializer : nullptr;
+		if (_lazy[index]) {
+			_lazy_chunks++;
+		}
 	}
+
+	log(component_debug << _lazy_chunks << " chunks pending lazy restore");
+}
+
+void chunked_memory::load_chunk(chunk_index index) {
+	address_range cr = get_chunk_range(index);
+	chunk_ptr &chunk = _memory[index];
+
+	log(component_debug << "Loading chunk #" << index << " on demand");
+	allocate_chunk(chunk, cr.get_start());
+
+	deserializer::deserializer_ptr deserializer = std::move(_lazy[index]);
+	_lazy[index] = nullptr;
+	_lazy_chunks--;
+	deserializer->read(this, chunk.get(), cr);
+}
+
+void chunked_memory::discard_lazy(chunk_index index) {
+	_lazy[index] = nullptr;
+	_lazy_chunks--;
 }
 
 } // namespace memory
@@ -0,0 +1,77 @@
+#include "harpoon/memory/container.hh"
+
+#include <cstring>
+
+namespace harpoon {
+namespace memory {
+namespace container {
+
+namespace {
+
+void put(std::uint8_t *&output, std::uint64_t v, std::size_t bytes) {
+	for (std::size_t i = 0; i < bytes; i++) {
+		*output++ = static_cast<std::uint8_t>(v >> (i * 8));
+	}
+}
+
+std::uint64_t get(const std::uint8_t *&data, std::size_t bytes) {
+	std::uint64_t v = 0;
+	for (std::size_t i = 0; i < bytes; i++) {
+		v |= static_cast<std::uint64_t>(*data++) << (i * 8);
+	}
+	return v;
+}
+
+} // namespace
+
+void encode_header(const header &header, std::uint8_t *output) {
+	std::memcpy(output, file_magic, sizeof(file_magic));
+	output += sizeof(file_magic);
+	put(output, header.version, 4);
+	put(output, header.block_length, 4);
+	put(output, header.range.get_start(), 8);
+	put(output, header.range.get_end(), 8);
+	put(output, header.index_offset, 8);
+	put(output, header.block_count, 8);
+	put(output, header.index_checksum, 8);
+}
+
+bool decode_header(const std::uint8_t *data, header &header) {
+	if (std::memcmp(data, file_magic, sizeof(file_magic)) != 0) {
+		return false;
+	}
+	data += sizeof(file_magic);
+	header.version = static_cast<std::uint32_t>(get(data, 4));
+	header.block_length = static_cast<std::uint32_t>(get(data, 4));
+	auto start = static_cast<address>(get(data, 8));
+	auto end = static_cast<address>(get(data, 8));
+	header.range = address_range(start, end);
+	header.index_offset = get(data, 8);
+	header.block_count = get(data, 8);
+	header.index_checksum = get(data, 8);
+	return true;
+}
+
+void encode_index_entry(const index_entry &entry, std::uint8_t *output) {
+	put(output, entry.start, 8);
+	put(output, entry.length, 4);
+	put(output, entry.flags, 4);
+	put(output, entry.offset, 8);
+	put(output, entry.stored_length, 4);
+	put(output, 0, 4);
+	put(output, entry.checksum, 8);
+}
+
+void decode_index_entry(const std::uint8_t *data, index_entry &entry) {
+	entry.start = static_cast<address>(get(data, 8));
+	entry.length = static_cast<std::uint32_t>(get(data, 4));
+	entry.flags = static_cast<std::uint32_t>(get(data, 4));
+	entry.offset = get(data, 8);
+	entry.stored_length = static_cast<std::uint32_t>(get(data, 4));
+	get(data, 4);
+	entry.checksum = get(data, 8);
+}
+
+} // namespace container
+} // namespace memory
+} // namespace harpoon
@@ -3,22 +3,51 @@
 #include "harpoon/memory/deserializer/exception/io.hh"
 #include "harpoon/memory/memory.hh"
 
+#include <cstring>
+
 namespace harpoon {
 namespace memory {
 namespace deserializer {
 
 binary_file::binary_file(address base, const std::string &file_name)
     : deserializer({base, base}), _file_name(file_name) {
-	_input.exceptions(std::ifstream::badbit);
-	_input.open(_file_name, std::ios::binary);
-
-	if (!_input.good()) {
+	std::uint64_t length;
+	if (!_file.open(_file_name, util::file::Mode::READ) || !_file.get_length(length)) {
 		throw HARPOON_EXCEPTION(exception::io, file_name);
 	}
+	_file_length = static_cast<std::size_t>(length);
+	set_range({base, base + static_cast<address>(_file_length) - 1});
+}
 
-	_input.seekg(0, _input.end);
-	set_range({base, base + static_cast<address>(_input.tellg()) - 1});
-	_input.seekg(0, _input.beg);
+binary_file::~binary_file() {}
+
+/* Narrow [start, limit) to the first data extent, returning false when only holes remain. */
+bool binary_file::find_data(std::size_t &start, std::size_t &end, std::size_t limit) {
+	std::uint64_t data_start = start, data_end;
+	if (!_file.find_data(data_start, data_end, limit)) {
+		return false;
+	}
+	start = static_cast<std::size_t>(data_start);
+	end = static_cast<std::size_t>(data_end);
+	return true;
+}
+
+bool binary_file::has_data(const address_range &range) {
+	address_range r = has_range(range);
+	if (!r) {
+		return false;
+	}
+
+	std::size_t start = static_cast<std::size_t>(r.get_start() - get_range().get_start());
+	std::size_t end;
+	return find_data(start, end, start + static_cast<std::size_t>(r.get_length()));
+}
+
+void binary_file::read_data(uint8_t *data, std::size_t position, std::size_t length) {
+	std::size_t done;
+	if (!_file.read_at(data, length, position, done) || done != length) {
+		throw HARPOON_EXCEPTION(exception::io, _file_name);
+	}
 }
 
 std::size_t binary_file::do_read(const memory *memory, std::uint8_t *data,
@@ -28,13 +57,25 @@ std::size_t binary_file::do_read(const memory *memory, std::uint8_t *data,
 		return 0;
 	}
 
-	_input.seekg(static_cast<std::ifstream::off_type>(range.get_start() - get_range().get_start()),
-	             _input.beg);
 	memory->log(log_debug_c(_file_name + " => " + memory->get_name())
 	            << "Reading " << r.get_length() << " bytes into " << r);
-	_input.read(reinterpret_cast<char *>(data + r.get_start() - range.get_start()),
-	            static_cast<std::streamsize>(r.get_length()));
-	return static_cast<std::size_t>(_input.gcount());
+
+	uint8_t *output = data + (r.get_start() - range.get_start());
+	std::size_t first = static_cast<std::size_t>(r.get_start() - get_range().get_start());
+	std::size_t limit = first + static_cast<std::size_t>(r.get_length());
+
+	std::size_t position = first;
+	while (position < limit) {
+		std::size_t start = position;
+		std::size_t end;
+		if (!find_data(start, end, limit)) {
+			start = end = limit;
+		}
+		std::memset(output + (position - first), 0, start - position);
+		read_data(output + (start - first), start, end - start);
+		position = end;
+	}
+	return limit - first;
 }
 
 } // namespace deserializer
@@ -0,0 +1,155 @@
+#include "harpoon/memory/deserializer/container_file.hh"
+
+#include "harpoon/memory/deserializer/exception/bad_container.hh"
+#include "harpoon/memory/deserializer/exception/io.hh"
+#include "harpoon/memory/memory.hh"
+#include "harpoon/util/hash.hh"
+#include "harpoon/util/lz.hh"
+
+#include <algorithm>
+#include <cstring>
+
+namespace harpoon {
+namespace memory {
+namespace deserializer {
+
+container_file::container_file(const std::string &file_name,
+                               const util::thread_pool_ptr &thread_pool)
+    : deserializer({}), _file_name(file_name), _thread_pool(thread_pool) {
+	if (!_file.open(_file_name, util::file::Mode::READ)) {
+		throw HARPOON_EXCEPTION(exception::io, _file_name);
+	}
+
+	try {
+		uint8_t encoded[container::header_length];
+		read_at(encoded, sizeof(encoded), 0);
+		if (!container::decode_header(encoded, _header)) {
+			throw HARPOON_EXCEPTION(exception::bad_container, _file_name, "Bad magic");
+		}
+		if (_header.version != container::file_version) {
+			throw HARPOON_EXCEPTION(exception::bad_container, _file_name, "Unsupported version");
+		}
+
+		std::vector<uint8_t> index(static_cast<std::size_t>(_header.block_count)
+		                           * container::index_entry_length);
+		read_at(index.data(), index.size(), _header.index_offset);
+		if (util::hash::hash64(index.data(), index.size()) != _header.index_checksum) {
+			throw HARPOON_EXCEPTION(exception::bad_container, _file_name,
+			                        "Index checksum mismatch");
+		}
+
+		_index.resize(static_cast<std::size_t>(_header.block_count));
+		for (std::size_t i = 0; i < _index.size(); i++) {
+			container::decode_index_entry(index.data() + i * container::index_entry_length,
+			                              _index[i]);
+		}
+	} catch (...) {
+		_file.close();
+		throw;
+	}
+
+	set_range(_header.range);
+}
+
+container_file::~container_file() {}
+
+std::vector<container::index_entry>::const_iterator
+container_file::find_block(address address) const {
+	auto i = std::upper_bound(
+	    _index.begin(), _index.end(), address,
+	    [](harpoon::memory::address a, const container::index_entry &e) { return a < e.start; });
+	if (i != _index.begin() && std::prev(i)->get_range().has_address(address)) {
+		--i;
+	}
+	return i;
+}
+
+bool container_file::has_data(const address_range &range) {
+	address_range r = has_range(range);
+	if (!r) {
+		return false;
+	}
+
+	auto i = find_block(r.get_start());
+	return i != _index.end() && i->start <= r.get_end();
+}
+
+void container_file::read_at(void *data, std::size_t length, std::uint64_t offset) {
+	std::size_t done;
+	if (!_file.read_at(data, length, offset, done)) {
+		throw HARPOON_EXCEPTION(exception::io, _file_name);
+	}
+	if (done != length) {
+		throw HARPOON_EXCEPTION(exception::bad_container, _file_name, "Truncated file");
+	}
+}
+
+void container_file::load_block(const container::index_entry &entry, uint8_t *output) {
+	static thread_local std::vector<uint8_t> payload;
+
+	if (entry.flags & container::RAW) {
+		read_at(output, entry.length, entry.offset);
+	} else {
+		payload.resize(entry.stored_length);
+		read_at(payload.data(), payload.size(), entry.offset);
+		if (!util::lz::decompress(payload.data(), payload.size(), output, entry.length)) {
+			throw HARPOON_EXCEPTION(exception::bad_container, _file_name, "Corrupted block");
+		}
+	}
+
+	if (util::hash::hash64(output, entry.length) != entry.checksum) {
+		throw HARPOON_EXCEPTION(exception::bad_container, _file_name, "Block checksum mismatch");
+	}
+}
+
+std::size_t container_file::do_read(const memory *memory, std::uint8_t *data,
+                                    const address_range &range) {
+	address_range r = has_range(range);
+	if (!r) {
+		return 0;
+	}
+
+	memory->log(log_debug_c(_file_name + " => " + memory->get_name())
+	            << "Reading " << r.get_length() << " bytes into " << r);
+
+	uint8_t *output = data + (r.get_start() - range.get_start());
+	std::memset(output, 0, static_cast<std::size_t>(r.get_length()));
+
+	auto first = find_block(r.get_start());
+	auto last = first;
+	while (last != _index.end() && last->start <= r.get_end()) {
+		++last;
+	}
+
+	auto task = [this, first, &r, output](std::size_t index) {
+		static thread_local std::vector<uint8_t> block;
+
+		const container::index_entry &entry = *(first + static_cast<std::ptrdiff_t>(index));
+		address_range br = entry.get_range();
+		if (br.get_start() >= r.get_start() && br.get_end() <= r.get_end()) {
+			load_block(entry, output + (br.get_start() - r.get_start()));
+			return;
+		}
+
+		block.resize(entry.length);
+		load_block(entry, block.data());
+		br.intersect(r);
+		std::memcpy(output + (br.get_start() - r.get_start()),
+		            block.data() + (br.get_start() - entry.start),
+		            static_cast<std::size_t>(br.get_length()));
+	};
+
+	std::size_t count = static_cast<std::size_t>(last - first);
+	if (_thread_pool) {
+		_thread_pool->run(count, task);
+	} else {
+		for (std::size_t i = 0; i < count; i++) {
+			task(i);
+		}
+	}
+	return static_cast<std::size_t>(r.get_length());
+}
+
+} // namespace deserializer
+} // namespace memory
+} // namespace harpoon
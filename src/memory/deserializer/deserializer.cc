@@ -12,6 +12,14 @@ address_range deserializer::has_range(const address_range &range) {
 	return _range.get_intersection(range);
 }
 
+bool deserializer::has_data(const address_range &range) {
+	return !has_range(range).is_empty();
+}
+
+bool deserializer::is_concurrent() const {
+	return false;
+}
+
 std::size_t deserializer::read(const memory *memory, uint8_t *data, const address_range &range) {
 	return do_read(memory, data, range);
 }
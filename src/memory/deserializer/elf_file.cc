@@ -0,0 +1,130 @@
+#include "harpoon/memory/deserializer/elf_file.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+namespace harpoon {
+namespace memory {
+namespace deserializer {
+
+namespace {
+
+constexpr std::uint8_t magic[] = {0x7f, 'E', 'L', 'F'};
+constexpr std::uint8_t ELFCLASS32 = 1;
+constexpr std::uint8_t ELFCLASS64 = 2;
+constexpr std::uint8_t ELFDATA2LSB = 1;
+constexpr std::uint8_t ELFDATA2MSB = 2;
+constexpr std::uint32_t PT_LOAD = 1;
+
+struct segment {
+	std::uint64_t offset;
+	std::uint64_t address;
+	std::uint64_t file_size;
+	std::uint64_t memory_size;
+};
+
+class fields {
+public:
+	fields(bool big_endian) : _big_endian(big_endian) {}
+
+	std::uint64_t get(const std::uint8_t *data, std::size_t length) const {
+		std::uint64_t value = 0;
+		for (std::size_t i = 0; i < length; i++) {
+			std::size_t b = _big_endian ? i : length - 1 - i;
+			value = value << 8 | data[b];
+		}
+		return value;
+	}
+
+private:
+	bool _big_endian;
+};
+
+} // namespace
+
+elf_file::elf_file(const std::string &file_name, bool virtual_addresses)
+    : image_file(file_name, {0, std::numeric_limits<address>::max() - 1}) {
+	parse(virtual_addresses);
+	finish();
+}
+
+elf_file::~elf_file() {}
+
+void elf_file::parse(bool virtual_addresses) {
+	uint8_t header[64];
+	read_input_at(header, 0, 16);
+	if (std::memcmp(header, magic, sizeof(magic)) != 0) {
+		fail("Not an ELF file");
+	}
+	if (header[4] != ELFCLASS32 && header[4] != ELFCLASS64) {
+		fail("Unknown ELF class");
+	}
+	if (header[5] != ELFDATA2LSB && header[5] != ELFDATA2MSB) {
+		fail("Unknown ELF byte order");
+	}
+
+	bool wide = header[4] == ELFCLASS64;
+	fields f(header[5] == ELFDATA2MSB);
+	/* Width of addresses and offsets. */
+	std::size_t w = wide ? 8 : 4;
+
+	read_input_at(header + 16, 16, wide ? 48 : 36);
+	set_entry(f.get(header + 24, w));
+	std::uint64_t table = f.get(header + 24 + w, w);
+	std::size_t entry_length = static_cast<std::size_t>(f.get(header + 30 + 3 * w, 2));
+	std::size_t entries = static_cast<std::size_t>(f.get(header + 32 + 3 * w, 2));
+	if (!entries) {
+		return;
+	}
+	if (entry_length < (wide ? 56u : 32u)) {
+		fail("Bad program header size");
+	}
+
+	std::vector<uint8_t> headers(entries * entry_length);
+	read_input_at(headers.data(), static_cast<std::size_t>(table), headers.size());
+
+	std::vector<segment> segments;
+	for (std::size_t i = 0; i < entries; i++) {
+		const uint8_t *p = headers.data() + i * entry_length;
+		if (f.get(p, 4) != PT_LOAD) {
+			continue;
+		}
+
+		/* The ELF64 layout moves p_flags in front of p_offset. */
+		const uint8_t *q = p + (wide ? 8 : 4);
+		segment s{f.get(q, w), f.get(q + (virtual_addresses ? w : 2 * w), w),
+		          f.get(q + 3 * w, w), f.get(q + 4 * w, w)};
+		if (s.file_size > s.memory_size) {
+			fail("Segment file size exceeds its memory size");
+		}
+		if (s.memory_size) {
+			segments.push_back(s);
+		}
+	}
+
+	/* One forward pass over the file. */
+	std::sort(segments.begin(), segments.end(),
+	          [](const segment &a, const segment &b) { return a.offset < b.offset; });
+
+	std::vector<uint8_t> block;
+	for (const auto &s : segments) {
+		std::uint64_t done = 0;
+		while (done < s.file_size) {
+			std::size_t length = block_length;
+			if (s.file_size - done < length) {
+				length = static_cast<std::size_t>(s.file_size - done);
+			}
+			block.resize(std::max(block.size(), length));
+			read_input_at(block.data(), static_cast<std::size_t>(s.offset + done), length);
+			add(s.address + done, block.data(), length);
+			done += length;
+		}
+		add_zero(s.address + s.file_size, static_cast<std::size_t>(s.memory_size - s.file_size));
+	}
+}
+
+} // namespace deserializer
+} // namespace memory
+} // namespace harpoon
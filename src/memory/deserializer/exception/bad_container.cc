@@ -0,0 +1,24 @@
+#include "harpoon/memory/deserializer/exception/bad_container.hh"
+
+#include <sstream>
+
+namespace harpoon {
+namespace memory {
+namespace deserializer {
+namespace exception {
+
+bad_container::bad_container(const std::string &container_file, const std::string &reason,
+                             const std::string &file, int line, const std::string &function)
+    : harpoon::exception::harpoon_exception("", file, line, function) {
+	std::stringstream stream;
+	stream << "Bad snapshot container: " << container_file << ": " << reason;
+
+	set_what(stream.str());
+}
+
+bad_container::~bad_container() {}
+
+} // namespace exception
+} // namespace deserializer
+} // namespace memory
+} // namespace harpoon
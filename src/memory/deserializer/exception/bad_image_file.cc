@@ -0,0 +1,24 @@
+#include "harpoon/memory/deserializer/exception/bad_image_file.hh"
+
+#include <sstream>
+
+namespace harpoon {
+namespace memory {
+namespace deserializer {
+namespace exception {
+
+bad_image_file::bad_image_file(const std::string &image_file, const std::string &reason,
+                               const std::string &file, int line, const std::string &function)
+    : harpoon::exception::harpoon_exception("", file, line, function) {
+	std::stringstream stream;
+	stream << "Bad image file: " << image_file << ": " << reason;
+
+	set_what(stream.str());
+}
+
+bad_image_file::~bad_image_file() {}
+
+} // namespace exception
+} // namespace deserializer
+} // namespace memory
+} // namespace harpoon
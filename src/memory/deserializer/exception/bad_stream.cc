@@ -0,0 +1,24 @@
+#include "harpoon/memory/deserializer/exception/bad_stream.hh"
+
+#include <sstream>
+
+namespace harpoon {
+namespace memory {
+namespace deserializer {
+namespace exception {
+
+bad_stream::bad_stream(const std::string &reason, const std::string &file, int line,
+                       const std::string &function)
+    : harpoon::exception::harpoon_exception("", file, line, function) {
+	std::stringstream stream;
+	stream << "Bad snapshot record stream: " << reason;
+
+	set_what(stream.str());
+}
+
+bad_stream::~bad_stream() {}
+
+} // namespace exception
+} // namespace deserializer
+} // namespace memory
+} // namespace harpoon
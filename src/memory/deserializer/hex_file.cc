@@ -0,0 +1,113 @@
+#include "harpoon/memory/deserializer/hex_file.hh"
+
+#include <numeric>
+
+namespace harpoon {
+namespace memory {
+namespace deserializer {
+
+namespace {
+
+enum record_type : std::uint8_t {
+	DATA = 0x00,
+	END_OF_FILE = 0x01,
+	EXTENDED_SEGMENT_ADDRESS = 0x02,
+	START_SEGMENT_ADDRESS = 0x03,
+	EXTENDED_LINEAR_ADDRESS = 0x04,
+	START_LINEAR_ADDRESS = 0x05,
+};
+
+std::uint32_t get_u16(const std::uint8_t *data) {
+	return static_cast<std::uint32_t>(data[0]) << 8 | data[1];
+}
+
+} // namespace
+
+hex_file::hex_file(const std::string &file_name)
+    : image_file(file_name, {0x00000000, 0xffffffff}) {
+	parse();
+	finish();
+}
+
+hex_file::~hex_file() {}
+
+void hex_file::parse() {
+	/* Byte count, address, type, up to 255 data bytes and the checksum. */
+	uint8_t record[260];
+	address base = 0;
+	bool segmented = false;
+
+	const char *line;
+	std::size_t length;
+	while (next_line(line, length)) {
+		if (!length) {
+			continue;
+		}
+		if (line[0] != ':') {
+			fail("Missing record mark");
+		}
+
+		std::size_t n = (length - 1) / 2;
+		if (length % 2 == 0 || n < 5 || n > sizeof(record)) {
+			fail("Bad record length");
+		}
+		if (!decode_hex(line + 1, record, n)) {
+			fail("Bad hex digit");
+		}
+		if (n != record[0] + 5u) {
+			fail("Bad record length");
+		}
+		if (std::accumulate(record, record + n, 0u) & 0xff) {
+			fail("Bad checksum");
+		}
+
+		std::uint32_t offset = get_u16(record + 1);
+		const uint8_t *data = record + 4;
+		std::size_t count = record[0];
+		switch (record[3]) {
+		case DATA:
+			/* Segment offsets wrap around within the 64 KiB segment. */
+			if (segmented && offset + count > 0x10000) {
+				std::size_t first = 0x10000 - offset;
+				add(base + offset, data, first);
+				add(base, data + first, count - first);
+			} else {
+				add(base + offset, data, count);
+			}
+			break;
+		case END_OF_FILE: return;
+		case EXTENDED_SEGMENT_ADDRESS:
+			if (count != 2) {
+				fail("Bad extended segment address record");
+			}
+			base = get_u16(data) << 4;
+			segmented = true;
+			break;
+		case START_SEGMENT_ADDRESS:
+			if (count != 4) {
+				fail("Bad start segment address record");
+			}
+			set_entry((get_u16(data) << 4) + get_u16(data + 2));
+			break;
+		case EXTENDED_LINEAR_ADDRESS:
+			if (count != 2) {
+				fail("Bad extended linear address record");
+			}
+			base = get_u16(data) << 16;
+			segmented = false;
+			break;
+		case START_LINEAR_ADDRESS:
+			if (count != 4) {
+				fail("Bad start linear address record");
+			}
+			set_entry(get_u16(data) << 16 | get_u16(data + 2));
+			break;
+		default: fail("Unknown record type");
+		}
+	}
+	fail("Missing end of file record");
+}
+
+} // namespace deserializer
+} // namespace memory
+} // namespace harpoon
@@ -0,0 +1,208 @@
+#include "harpoon/memory/deserializer/image_file.hh"
+
+#include "harpoon/memory/deserializer/exception/bad_image_file.hh"
+#include "harpoon/memory/deserializer/exception/io.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+
+namespace harpoon {
+namespace memory {
+namespace deserializer {
+
+namespace {
+
+struct hex_table {
+	std::int8_t values[256];
+
+	constexpr hex_table() : values() {
+		for (int c = 0; c < 256; c++) {
+			values[c] = -1;
+		}
+		for (int c = 0; c < 10; c++) {
+			values['0' + c] = static_cast<std::int8_t>(c);
+		}
+		for (int c = 0; c < 6; c++) {
+			values['a' + c] = values['A' + c] = static_cast<std::int8_t>(10 + c);
+		}
+	}
+};
+
+constexpr hex_table hex_digits;
+
+} // namespace
+
+image_file::image_file(const std::string &file_name, const address_range &address_space)
+    : memory_buffer(make_memory_image(address_space)), _file_name(file_name) {
+	if (!_file.open(_file_name, util::file::Mode::READ)) {
+		throw HARPOON_EXCEPTION(exception::io, file_name);
+	}
+}
+
+image_file::~image_file() {}
+
+void image_file::fail(const std::string &reason) const {
+	if (!_line_number) {
+		throw HARPOON_EXCEPTION(exception::bad_image_file, _file_name, reason);
+	}
+
+	std::stringstream stream;
+	stream << reason << " at line " << _line_number;
+	throw HARPOON_EXCEPTION(exception::bad_image_file, _file_name, stream.str());
+}
+
+bool image_file::decode_hex(const char *text, uint8_t *data, std::size_t length) {
+	int invalid = 0;
+	for (std::size_t i = 0; i < length; i++) {
+		int high = hex_digits.values[static_cast<unsigned char>(text[2 * i])];
+		int low = hex_digits.values[static_cast<unsigned char>(text[2 * i + 1])];
+		invalid |= high | low;
+		data[i] = static_cast<uint8_t>(high * 16 + low);
+	}
+	return invalid >= 0;
+}
+
+std::size_t image_file::read_input(uint8_t *data, std::size_t length) {
+	std::size_t total = 0;
+	while (total < length) {
+		std::size_t n;
+		if (!_file.read(data + total, length - total, n)) {
+			throw HARPOON_EXCEPTION(exception::io, _file_name);
+		}
+		if (n == 0) {
+			break;
+		}
+		total += n;
+	}
+	return total;
+}
+
+void image_file::read_input_at(uint8_t *data, std::size_t position, std::size_t length) {
+	std::size_t done;
+	if (!_file.read_at(data, length, position, done)) {
+		throw HARPOON_EXCEPTION(exception::io, _file_name);
+	}
+	if (done != length) {
+		fail("Unexpected end of file");
+	}
+}
+
+bool image_file::next_line(const char *&line, std::size_t &length) {
+	if (_input.empty()) {
+		_input.resize(input_length);
+	}
+
+	for (;;) {
+		const char *start = _input.data() + _input_start;
+		const void *newline = std::memchr(start, '\n', _input_end - _input_start);
+		if (newline || (_input_ended && _input_start < _input_end)) {
+			const char *end = newline ? static_cast<const char *>(newline)
+			                          : _input.data() + _input_end;
+			line = start;
+			length = static_cast<std::size_t>(end - start);
+			if (length && line[length - 1] == '\r') {
+				length--;
+			}
+			_input_start = newline ? static_cast<std::size_t>(end - _input.data()) + 1
+			                       : _input_end;
+			_line_number++;
+			return true;
+		}
+		if (_input_ended) {
+			return false;
+		}
+
+		/* Keep the partial line and refill; grow only for very long lines. */
+		std::memmove(_input.data(), start, _input_end - _input_start);
+		_input_end -= _input_start;
+		_input_start = 0;
+		if (_input_end == _input.size()) {
+			_input.resize(_input.size() * 2);
+		}
+		std::size_t n = read_input(reinterpret_cast<uint8_t *>(_input.data()) + _input_end,
+		                           _input.size() - _input_end);
+		_input_end += n;
+		_input_ended = n == 0;
+	}
+}
+
+void image_file::add(address start, const uint8_t *data, std::size_t length) {
+	if (!length) {
+		return;
+	}
+
+	if (_pending.empty() || start != _pending_start + _pending.size()
+	    || _pending.size() >= block_length) {
+		flush();
+		/* Large blocks go to the image without being staged. */
+		if (length >= block_length) {
+			insert(start, data, length);
+			return;
+		}
+		_pending_start = start;
+	}
+	_pending.insert(_pending.end(), data, data + length);
+}
+
+void image_file::add_zero(address start, std::size_t length) {
+	if (!length) {
+		return;
+	}
+
+	flush();
+	insert(start, nullptr, length);
+}
+
+void image_file::flush() {
+	if (!_pending.empty()) {
+		insert(_pending_start, _pending.data(), _pending.size());
+		_pending.clear();
+	}
+}
+
+void image_file::insert(address start, const uint8_t *data, std::size_t length) {
+	const auto &image = get_image();
+	address end = start + (length - 1);
+	if (end < start || !image->get_range().has_address(start)
+	    || !image->get_range().has_address(end)) {
+		fail("Data outside of the address space");
+	}
+
+	auto i = image->find(start);
+	if (i != image->get_extents().end() && i->range.get_start() <= end) {
+		fail("Overlapping data");
+	}
+
+	if (data) {
+		image->add(start, data, length);
+	} else {
+		image->add_sparse(start, length);
+	}
+}
+
+void image_file::finish() {
+	flush();
+	_pending.shrink_to_fit();
+	_input.clear();
+	_input.shrink_to_fit();
+	_file.close();
+
+	for (const auto &e : get_image()->get_extents()) {
+		if (!_segments.empty() && _segments.back().get_end() + 1 == e.range.get_start()) {
+			_segments.back().set_end(e.range.get_end());
+		} else {
+			_segments.push_back(e.range);
+		}
+	}
+
+	if (_segments.empty()) {
+		set_range({});
+	} else {
+		set_range({_segments.front().get_start(), _segments.back().get_end()});
+	}
+}
+
+} // namespace deserializer
+} // namespace memory
+} // namespace harpoon
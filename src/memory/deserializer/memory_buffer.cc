@@ -0,0 +1,58 @@
+#include "harpoon/memory/deserializer/memory_buffer.hh"
+
+#include <cstring>
+
+namespace harpoon {
+namespace memory {
+namespace deserializer {
+
+memory_buffer::~memory_buffer() {}
+
+bool memory_buffer::has_data(const address_range &range) {
+	address_range r = has_range(range);
+	if (!r) {
+		return false;
+	}
+
+	const auto &extents = _image->get_extents();
+	for (auto i = _image->find(r.get_start());
+	     i != extents.end() && i->range.get_start() <= r.get_end(); ++i) {
+		if (i->data) {
+			return true;
+		}
+	}
+	return false;
+}
+
+std::size_t memory_buffer::do_read(const memory *, std::uint8_t *data,
+                                   const address_range &range) {
+	address_range r = has_range(range);
+	if (!r) {
+		return 0;
+	}
+
+	const auto &extents = _image->get_extents();
+	auto position = r.get_start();
+	for (auto i = _image->find(r.get_start());
+	     i != extents.end() && i->range.get_start() <= r.get_end(); ++i) {
+		address_range er = i->range.get_intersection(r);
+		std::uint8_t *output = data + (er.get_start() - range.get_start());
+		std::size_t length = static_cast<std::size_t>(er.get_length());
+
+		std::memset(data + (position - range.get_start()), 0,
+		            static_cast<std::size_t>(er.get_start() - position));
+		if (i->data) {
+			std::memcpy(output, i->data + (er.get_start() - i->range.get_start()), length);
+		} else {
+			std::memset(output, 0, length);
+		}
+		position = er.get_end() + 1;
+	}
+	std::memset(data + (position - range.get_start()), 0,
+	            static_cast<std::size_t>(r.get_end() + 1 - position));
+	return static_cast<std::size_t>(r.get_length());
+}
+
+} // namespace deserializer
+} // namespace memory
+} // namespace harpoon
@@ -0,0 +1,139 @@
+#include "harpoon/memory/deserializer/record_stream.hh"
+
+#include "harpoon/memory/deserializer/exception/bad_stream.hh"
+
+#include <algorithm>
+#include <cstring>
+
+namespace harpoon {
+namespace memory {
+namespace deserializer {
+
+namespace format = harpoon::memory::record_stream;
+
+record_stream::record_stream(std::istream &input, std::size_t skip_length)
+    : deserializer({}), _input(input), _skip(std::max<std::size_t>(skip_length, 1)) {
+	uint8_t header[format::header_length];
+	address_range range;
+	read_payload(header, sizeof(header));
+	if (!format::decode_header(header, range)) {
+		throw HARPOON_EXCEPTION(exception::bad_stream, "Bad header");
+	}
+	set_range(range);
+}
+
+record_stream::~record_stream() {}
+
+void record_stream::read_payload(uint8_t *data, std::size_t length) {
+	_input.read(reinterpret_cast<char *>(data), static_cast<std::streamsize>(length));
+	if (static_cast<std::size_t>(_input.gcount()) != length) {
+		throw HARPOON_EXCEPTION(exception::bad_stream, "Unexpected end of stream");
+	}
+}
+
+void record_stream::skip_payload(std::size_t length) {
+	while (length) {
+		std::size_t n = std::min(length, _skip.size());
+		read_payload(_skip.data(), n);
+		length -= n;
+	}
+}
+
+void record_stream::next_record() {
+	uint8_t encoded[format::record_header_length];
+	read_payload(encoded, sizeof(encoded));
+	if (!format::decode_record(encoded, _record)) {
+		throw HARPOON_EXCEPTION(exception::bad_stream, "Bad record");
+	}
+	_consumed = 0;
+	_have_record = true;
+	_ended = _record.type == format::record_type::END;
+}
+
+/*
+ * Move to the first data record that ends at or after the address, within the
+ * memory block containing it. Blocks that do not contain the address are
+ * skipped, but once the block containing it ends the stream stays there.
+ * Sparse records are dropped on the way since unread ranges are zero anyway.
+ */
+bool record_stream::advance(address address) {
+	while (!_ended) {
+		if (!_have_record) {
+			next_record();
+			continue;
+		}
+
+		switch (_record.type) {
+		case format::record_type::BLOCK:
+			if (in_block(address)) {
+				return false;
+			}
+			_block = address_range(_record.address, get_record_end());
+			break;
+		case format::record_type::DATA:
+			if (in_block(address) && _record.length && get_record_end() >= address) {
+				return true;
+			}
+			skip_payload(static_cast<std::size_t>(_record.length - _consumed));
+			break;
+		default: break;
+		}
+		_have_record = false;
+	}
+	return false;
+}
+
+bool record_stream::has_data(const address_range &range) {
+	address_range r = has_range(range);
+	if (!r) {
+		return false;
+	}
+
+	return advance(r.get_start()) && get_position() <= r.get_end();
+}
+
+std::size_t record_stream::do_read(const memory *memory, std::uint8_t *data,
+                                   const address_range &range) {
+	address_range r = has_range(range);
+	if (!r) {
+		return 0;
+	}
+
+	memory->log(log_debug_c("record stream => " + memory->get_name())
+	            << "Reading " << r.get_length() << " bytes into " << r);
+
+	uint8_t *output = data + (r.get_start() - range.get_start());
+	std::memset(output, 0, static_cast<std::size_t>(r.get_length()));
+
+	auto position = r.get_start();
+	for (;;) {
+		if (!advance(position) || get_position() > r.get_end()) {
+			break;
+		}
+
+		if (get_position() < position) {
+			std::size_t skip = static_cast<std::size_t>(position - get_position());
+			skip_payload(skip);
+			_consumed += skip;
+		}
+
+		auto start = get_position();
+		auto end = std::min(get_record_end(), r.get_end());
+		std::size_t length = static_cast<std::size_t>(end - start + 1);
+		read_payload(output + (start - r.get_start()), length);
+		_consumed += length;
+		if (_consumed == _record.length) {
+			_have_record = false;
+		}
+
+		if (end == r.get_end()) {
+			break;
+		}
+		position = end + 1;
+	}
+	return static_cast<std::size_t>(r.get_length());
+}
+
+} // namespace deserializer
+} // namespace memory
+} // namespace harpoon
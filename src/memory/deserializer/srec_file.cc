@@ -0,0 +1,79 @@
+#include "harpoon/memory/deserializer/srec_file.hh"
+
+#include <numeric>
+
+namespace harpoon {
+namespace memory {
+namespace deserializer {
+
+namespace {
+
+/* Address bytes by record type; S4 is reserved. */
+constexpr int address_bytes[10] = {2, 2, 3, 4, -1, 2, 3, 4, 3, 2};
+
+} // namespace
+
+srec_file::srec_file(const std::string &file_name)
+    : image_file(file_name, {0x00000000, 0xffffffff}) {
+	parse();
+	finish();
+}
+
+srec_file::~srec_file() {}
+
+void srec_file::parse() {
+	/* Byte count, then up to 255 bytes of address, data and checksum. */
+	uint8_t record[256];
+
+	const char *line;
+	std::size_t length;
+	while (next_line(line, length)) {
+		if (!length) {
+			continue;
+		}
+		if (line[0] != 'S' || length < 2 || line[1] < '0' || line[1] > '9') {
+			fail("Missing record mark");
+		}
+
+		int type = line[1] - '0';
+		int bytes = address_bytes[type];
+		if (bytes < 0) {
+			fail("Unknown record type");
+		}
+
+		std::size_t n = (length - 2) / 2;
+		if (length % 2 || n < 1u + bytes + 1u || n > sizeof(record)) {
+			fail("Bad record length");
+		}
+		if (!decode_hex(line + 2, record, n)) {
+			fail("Bad hex digit");
+		}
+		if (n != record[0] + 1u) {
+			fail("Bad record length");
+		}
+		if ((std::accumulate(record, record + n, 0u) & 0xff) != 0xff) {
+			fail("Bad checksum");
+		}
+
+		address a = 0;
+		for (int i = 0; i < bytes; i++) {
+			a = a << 8 | record[1 + i];
+		}
+		const uint8_t *data = record + 1 + bytes;
+		std::size_t count = n - 2 - static_cast<std::size_t>(bytes);
+
+		switch (type) {
+		case 1:
+		case 2:
+		case 3: add(a, data, count); break;
+		case 7:
+		case 8:
+		case 9: set_entry(a); return;
+		default: break;
+		}
+	}
+}
+
+} // namespace deserializer
+} // namespace memory
+} // namespace harpoon
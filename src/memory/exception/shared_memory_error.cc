@@ -0,0 +1,23 @@
+#include "harpoon/memory/exception/shared_memory_error.hh"
+
+#include <sstream>
+
+namespace harpoon {
+namespace memory {
+namespace exception {
+
+shared_memory_error::shared_memory_error(const std::string &object, const std::string &reason,
+                                         const std::string &file, int line,
+                                         const std::string &function)
+    : harpoon::exception::harpoon_exception("", file, line, function) {
+	std::stringstream stream;
+	stream << "Shared memory " << object << ": " << reason;
+
+	set_what(stream.str());
+}
+
+shared_memory_error::~shared_memory_error() {}
+
+} // namespace exception
+} // namespace memory
+} // namespace harpoon
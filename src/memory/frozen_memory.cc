@@ -0,0 +1,9 @@
+#include "harpoon/memory/frozen_memory.hh"
+
+namespace harpoon {
+namespace memory {
+
+frozen_memory::~frozen_memory() {}
+
+} // namespace memory
+} // namespace harpoon
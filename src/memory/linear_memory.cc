@@ -5,12 +5,18 @@
 #include "harpoon/memory/exception/read_access_violation.hh"
 #include "harpoon/memory/exception/write_access_violation.hh"
 #include "harpoon/memory/serializer/serializer.hh"
+#include "harpoon/util/bytes.hh"
+#include "harpoon/util/hash.hh"
 
+#include <algorithm>
 #include <limits>
+#include <vector>
 
 namespace harpoon {
 namespace memory {
 
+constexpr std::size_t linear_memory::zero_granularity;
+
 linear_memory::~linear_memory() {}
 
 void linear_memory::prepare() {
@@ -20,8 +26,16 @@ void linear_memory::prepare() {
 		throw COMPONENT_EXCEPTION(exception::memory_exception, "Zero-length memory block.");
 	}
 
-	log(component_notice << "Allocating " << len << " bytes memory block");
-	_memory.reset(new uint8_t[static_cast<size_t>(len)]);
+	if (_shared_memory_name.empty()) {
+		log(component_notice << "Allocating " << len << " bytes memory block");
+		_memory.reset(new uint8_t[static_cast<size_t>(len)]);
+		_data = _memory.get();
+	} else {
+		log(component_notice << "Mapping " << len << " bytes memory block shared as "
+		                     << _shared_memory_name);
+		_shared_storage = make_shared_storage(_shared_memory_name, static_cast<size_t>(len));
+		_data = _shared_storage->get_data();
+	}
 
 	memory::prepare();
 }
@@ -29,7 +43,9 @@ void linear_memory::prepare() {
 void linear_memory::cleanup() {
 	memory::cleanup();
 	log(component_notice << "Freeing memory");
+	_data = nullptr;
 	_memory.reset();
+	_shared_storage.reset();
 }
 
 void linear_memory::get_cell(address address, uint8_t &value) {
@@ -42,7 +58,7 @@ void linear_memory::get_cell(address address, uint8_t &value) {
 	 * otherwise prepare() will fail.
 	 */
 	size_t offset = static_cast<size_t>(address - get_address_range().get_start());
-	value = _memory[offset];
+	value = _data[offset];
 }
 
 void linear_memory::set_cell(address address, uint8_t value) {
@@ -55,17 +71,84 @@ void linear_memory::set_cell(address address, uint8_t value) {
 	 * otherwise prepare() will fail.
 	 */
 	size_t offset = static_cast<size_t>(address - get_address_range().get_start());
-	_memory[offset] = value;
+	_data[offset] = value;
+}
+
+bool linear_memory::do_get_span(address address, bool, span &span) {
+	if (!_data || !has_address(address)) {
+		return false;
+	}
+
+	span.range = get_address_range();
+	span.data = _data;
+	return true;
 }
 
 void linear_memory::serialize(serializer::serializer &serializer) {
+	std::size_t length = static_cast<std::size_t>(get_address_range().get_length());
+	std::size_t pieces = (length + zero_granularity - 1) / zero_granularity;
+
+	/* Zero pieces are found in parallel, then runs of alike pieces are written in order. */
+	std::vector<std::uint8_t> zero(pieces);
+	auto scan = [this, length, &zero](std::size_t first, std::size_t last) {
+		for (std::size_t piece = first; piece < last; piece++) {
+			std::size_t offset = piece * zero_granularity;
+			zero[piece] =
+			    util::bytes::is_zero(_data + offset, std::min(zero_granularity, length - offset));
+		}
+	};
+	run_batches(pieces, batch_length / zero_granularity, scan);
+
 	serializer.start_memory_block(this);
-	serializer.write(_memory.get(), static_cast<std::size_t>(get_address_range().get_length()));
+	for (std::size_t piece = 0; piece < pieces;) {
+		std::size_t end = piece + 1;
+		while (end < pieces && zero[end] == zero[piece]) {
+			end++;
+		}
+		std::size_t offset = piece * zero_granularity;
+		serializer.write(_data, offset, std::min(end * zero_granularity, length) - offset,
+		                 zero[piece]);
+		piece = end;
+	}
 	serializer.finalize_memory_block();
 }
 
 void linear_memory::deserialize(deserializer::deserializer &deserializer) {
-	deserializer.read(this, _memory.get(), get_address_range());
+	if (!deserializer.is_concurrent()) {
+		deserializer.read(this, _data, get_address_range());
+		return;
+	}
+
+	std::size_t length = static_cast<std::size_t>(get_address_range().get_length());
+	auto read = [this, &deserializer](std::size_t first, std::size_t last) {
+		address start = get_address_range().get_start() + first;
+		deserializer.read(this, _data + first, {start, start + (last - first) - 1});
+	};
+	run_batches(length, batch_length, read);
+}
+
+void linear_memory::get_block_hashes(std::vector<block_hash> &hashes) {
+	if (!_data) {
+		memory::get_block_hashes(hashes);
+		return;
+	}
+
+	const address_range &range = get_address_range();
+	std::size_t length = static_cast<std::size_t>(range.get_length());
+	std::size_t blocks = (length + hash_block_length - 1) / hash_block_length;
+	std::size_t first = hashes.size();
+	hashes.resize(first + blocks);
+
+	auto hash = [this, &hashes, &range, length, first](std::size_t begin, std::size_t end) {
+		for (std::size_t block = begin; block < end; block++) {
+			std::size_t offset = block * hash_block_length;
+			std::size_t n = std::min(hash_block_length, length - offset);
+			address start = range.get_start() + offset;
+			hashes[first + block] = {{start, start + (n - 1)},
+			                         util::hash::hash64(_data + offset, n)};
+		}
+	};
+	run_batches(blocks, batch_length / hash_block_length, hash);
 }
 
 } // namespace memory
@@ -2,19 +2,96 @@
 
 #include "harpoon/memory/exception/read_access_violation.hh"
 #include "harpoon/memory/exception/write_access_violation.hh"
+#include "harpoon/memory/deserializer/deserializer.hh"
+#include "harpoon/memory/frozen_memory.hh"
+#include "harpoon/memory/serializer/serializer.hh"
+#include "harpoon/memory/shared_storage.hh"
 
+#include <algorithm>
 #include <limits>
+#include <vector>
 
 namespace harpoon {
 namespace memory {
 
+namespace {
+
+class frozen_memories : public frozen_memory {
+public:
+	void add(const frozen_memory_ptr &memory) {
+		_memories.push_back(memory);
+	}
+
+	virtual void serialize(serializer::serializer &serializer) override {
+		for (const auto &memory : _memories) {
+			memory->serialize(serializer);
+		}
+	}
+
+private:
+	std::vector<frozen_memory_ptr> _memories{};
+};
+
+/*
+ * Keeps the writes of one region without copying any data, so regions can
+ * be prepared in parallel and then replayed into the real serializer in a
+ * fixed order.
+ */
+class recorded_region : public serializer::serializer {
+public:
+	recorded_region() : serializer({0, std::numeric_limits<address>::max()}) {}
+
+	void replay(harpoon::memory::serializer::serializer &target) const {
+		for (const auto &b : _blocks) {
+			target.start_memory_block(b.block_memory, b.range);
+			for (const auto &p : b.pieces) {
+				target.write(p.data, p.offset, p.length, p.sparse);
+			}
+			target.finalize_memory_block();
+		}
+	}
+
+protected:
+	virtual void do_start_memory_block() override {
+		_blocks.push_back({get_block_memory(), get_block_range(), {}});
+	}
+
+	virtual std::size_t do_write(uint8_t *data, std::size_t offset, std::size_t length,
+	                             bool sparse) override {
+		_blocks.back().pieces.push_back({data, offset, length, sparse});
+		return length;
+	}
+
+private:
+	struct piece {
+		uint8_t *data;
+		std::size_t offset;
+		std::size_t length;
+		bool sparse;
+	};
+
+	struct block {
+		const harpoon::memory::memory *block_memory;
+		address_range range;
+		std::vector<piece> pieces;
+	};
+
+	std::vector<block> _blocks{};
+};
+
+} // namespace
+
 main_memory::~main_memory() {}
 
 void main_memory::add_memory(const memory_ptr &memory, bool owner) {
 	if (owner) {
 		add_component(memory);
 	}
+	if (get_thread_pool() && !memory->get_thread_pool()) {
+		memory->set_thread_pool(get_thread_pool());
+	}
 	_memory.push_back(memory);
+	flush_tlb();
 }
 
 void main_memory::remove_memory(const memory_ptr &memory, bool owner) {
@@ -22,6 +99,8 @@ void main_memory::remove_memory(const memory_ptr &memory, bool owner) {
 		remove_component(memory);
 	}
 	_memory.remove_if([&memory](const memory_ptr &ptr) { return ptr == memory; });
+	flush_tlb();
+	invalidate_code();
 }
 
 void main_memory::replace_memory(const memory_ptr &old_memory, const memory_ptr &new_memory,
@@ -30,31 +109,367 @@ void main_memory::replace_memory(const memory_ptr &old_memory, const memory_ptr
 	add_memory(new_memory, owner);
 }
 
-void main_memory::serialize(serializer::serializer &serializer) {
+void main_memory::set_thread_pool(const util::thread_pool_ptr &thread_pool) {
+	memory::set_thread_pool(thread_pool);
 	for (const auto &memory : _memory) {
-		memory->serialize(serializer);
+		memory->set_thread_pool(thread_pool);
 	}
 }
 
-void main_memory::deserialize(deserializer::deserializer &deserializer) {
+address_range main_memory::get_mapped_range() const {
+	address_range mapped{};
 	for (const auto &memory : _memory) {
-		memory->deserialize(deserializer);
+		const address_range &range = memory->get_address_range();
+		if (range.is_empty()) {
+			continue;
+		}
+		if (mapped.is_empty()) {
+			mapped = range;
+		} else {
+			mapped = {std::min(mapped.get_start(), range.get_start()),
+			          std::max(mapped.get_end(), range.get_end())};
+		}
+	}
+	return mapped;
+}
+
+main_memory::watchpoint_id main_memory::add_watchpoint(const watchpoint &watchpoint) {
+	watchpoint_id id = _next_watchpoint_id++;
+	_watchpoints.insert({id, watchpoint});
+	update_watch_segments(watchpoint, 1);
+	return id;
+}
+
+void main_memory::remove_watchpoint(watchpoint_id id) {
+	auto i = _watchpoints.find(id);
+	if (i == _watchpoints.end()) {
+		return;
+	}
+	update_watch_segments(i->second, -1);
+	_watchpoints.erase(i);
+}
+
+void main_memory::clear_watchpoints() {
+	_watchpoints.clear();
+	_watch_segments.clear();
+	flush_tlb();
+}
+
+main_memory::code_write_handler_id main_memory::add_code_write_handler(
+    const code_write_handler &handler) {
+	code_write_handler_id id = _next_code_write_handler_id++;
+	_code_write_handlers.insert({id, handler});
+	return id;
+}
+
+void main_memory::remove_code_write_handler(code_write_handler_id id) {
+	_code_write_handlers.erase(id);
+}
+
+void main_memory::mark_code(const address_range &range) {
+	if (range.is_empty()) {
+		return;
+	}
+
+	for (address page = range.get_start() >> page_bits; page <= range.get_end() >> page_bits;
+	     page++) {
+		std::uint32_t &flags = _page_flags[page];
+		if (!(flags & CODE)) {
+			flags |= CODE;
+			_code_pages++;
+			set_tlb_code(page, true);
+		}
+
+		if (page == std::numeric_limits<address>::max() >> page_bits) {
+			break;
+		}
+	}
+}
+
+void main_memory::invalidate_code() {
+	if (!_code_pages) {
+		return;
+	}
+
+	std::vector<address> pages;
+	for (const auto &f : _page_flags) {
+		if (f.second & CODE) {
+			pages.push_back(f.first);
+		}
+	}
+	std::sort(pages.begin(), pages.end());
+	for (address page : pages) {
+		invalidate_code_page(page);
+	}
+}
+
+void main_memory::invalidate_code_page(address page) {
+	auto f = _page_flags.find(page);
+	if (f == _page_flags.end() || !(f->second & CODE)) {
+		return;
+	}
+
+	_page_flags.erase(f);
+	_code_pages--;
+	set_tlb_code(page, false);
+
+	address_range page_range{page << page_bits, ((page + 1) << page_bits) - 1};
+	for (const auto &h : _code_write_handlers) {
+		h.second(page_range);
+	}
+}
+
+/*
+ * Watch ranges are kept as segments with the number of read and write
+ * watchpoints covering them, so adding or removing one touches only the
+ * segments within its range, however large.
+ */
+void main_memory::update_watch_segments(const watchpoint &watchpoint, int delta) {
+	/* Ranges are taken as check_condition() does, so one reaching the last address covers it. */
+	const address_range &range = watchpoint.get_range();
+	bool to_end = range.get_end() == std::numeric_limits<address>::max();
+	split_watch_segment(range.get_start());
+	if (!to_end) {
+		split_watch_segment(range.get_end() + 1);
+	}
+
+	for (auto i = _watch_segments.find(range.get_start());
+	     i != _watch_segments.end() && i->first <= range.get_end(); ++i) {
+		if (watchpoint.watches_reads()) {
+			i->second.reads += static_cast<unsigned int>(delta);
+		}
+		if (watchpoint.watches_writes()) {
+			i->second.writes += static_cast<unsigned int>(delta);
+		}
+	}
+
+	/* Inner bounds still separate different counts, the outer two may not. */
+	merge_watch_segment(range.get_start());
+	if (!to_end) {
+		merge_watch_segment(range.get_end() + 1);
+	}
+	flush_tlb();
+}
+
+void main_memory::split_watch_segment(address address) {
+	auto i = _watch_segments.upper_bound(address);
+	if (i != _watch_segments.begin() && std::prev(i)->first == address) {
+		return;
+	}
+	_watch_segments.insert(
+	    i, {address, i == _watch_segments.begin() ? watch_counts{} : std::prev(i)->second});
+}
+
+void main_memory::merge_watch_segment(address address) {
+	auto i = _watch_segments.find(address);
+	if (i == _watch_segments.end()) {
+		return;
+	}
+	if (i == _watch_segments.begin() ? i->second == watch_counts{}
+	                                 : std::prev(i)->second == i->second) {
+		_watch_segments.erase(i);
+	}
+}
+
+std::uint32_t main_memory::get_watch_flags(address page) const {
+	address start = page << page_bits, end = start + ((1ULL << page_bits) - 1);
+	auto i = _watch_segments.upper_bound(start);
+	if (i != _watch_segments.begin()) {
+		--i;
+	}
+
+	std::uint32_t flags = 0;
+	for (; i != _watch_segments.end() && i->first <= end; ++i) {
+		if (i->second.reads) {
+			flags |= WATCH_READ;
+		}
+		if (i->second.writes) {
+			flags |= WATCH_WRITE;
+		}
+	}
+	return flags;
+}
+
+void main_memory::check_watchpoints(address address, std::uint8_t value, access_kind kind) {
+	watchpoint::access access{this, address, value, kind};
+	/* Actions may add or remove watchpoints, so the matching ones are copied first. */
+	std::vector<watchpoint> matching;
+	for (const auto &w : _watchpoints) {
+		if (w.second.check_condition(access)) {
+			matching.push_back(w.second);
+		}
+	}
+	for (const auto &w : matching) {
+		log(component_debug << "WATCHPOINT: " << kind << " at 0x" << std::hex << address);
+		w.do_action(access);
 	}
 }
 
-const memory_ptr &main_memory::get_memory(address address) {
-	if (_last_used_memory && _last_used_range.has_address(address)) {
-		return _last_used_memory;
+void main_memory::flush_tlb() {
+	_tlb.fill(tlb_entry{});
+}
+
+void main_memory::set_tlb_code(address page, bool code) {
+	tlb_entry &entry = _tlb[page & (tlb_entries - 1)];
+	if (entry.memory && entry.page == page) {
+		entry.flags = code ? entry.flags | CODE : entry.flags & ~static_cast<std::uint32_t>(CODE);
+	}
+}
+
+memory *main_memory::fill_tlb(address address, std::uint32_t &flags) {
+	auto page = address >> page_bits;
+
+	auto f = _page_flags.find(page);
+	flags = f == _page_flags.end() ? 0 : f->second;
+	if (!_watch_segments.empty()) {
+		flags |= get_watch_flags(page);
 	}
 
 	for (const auto &memory : _memory) {
 		if (memory->has_address(address)) {
-			_last_used_memory = memory;
-			_last_used_range = memory->get_address_range();
-			return memory;
+			/*
+			 * Only pages backed entirely by one memory are cached. Pages shared by
+			 * several memories are resolved on every access.
+			 */
+			const address_range &range = memory->get_address_range();
+			if (range.get_start() <= (page << page_bits)
+			    && range.get_end() >= (page << page_bits) + ((1ULL << page_bits) - 1)) {
+				tlb_entry &entry = _tlb[page & (tlb_entries - 1)];
+				entry.page = page;
+				entry.memory = memory.get();
+				entry.flags = flags;
+			}
+			return memory.get();
+		}
+	}
+	return nullptr;
+}
+
+void main_memory::shutdown() {
+	memory::shutdown();
+	if (_access_profiler) {
+		_access_profiler->dump_on_shutdown();
+	}
+}
+
+/*
+ * Regions are handled in parallel when a pool is set. A region run this way
+ * scans its own batches serially, so one huge region gains nothing over the
+ * sequential path, but many regions scale with the pool.
+ */
+void main_memory::serialize(serializer::serializer &serializer) {
+	if (_memory.size() < 2 || !get_thread_pool()) {
+		for (const auto &memory : _memory) {
+			memory->serialize(serializer);
+		}
+		return;
+	}
+
+	std::vector<memory_ptr> regions(_memory.begin(), _memory.end());
+	std::vector<recorded_region> recorded(regions.size());
+	get_thread_pool()->run(regions.size(), [&regions, &recorded](std::size_t index) {
+		regions[index]->serialize(recorded[index]);
+	});
+
+	/* Replaying in region order keeps the output identical to a sequential run. */
+	for (const auto &r : recorded) {
+		r.replay(serializer);
+	}
+}
+
+void main_memory::deserialize(deserializer::deserializer &deserializer) {
+	if (_memory.size() < 2 || !get_thread_pool() || !deserializer.is_concurrent()) {
+		for (const auto &memory : _memory) {
+			memory->deserialize(deserializer);
+		}
+	} else {
+		std::vector<memory_ptr> regions(_memory.begin(), _memory.end());
+		get_thread_pool()->run(regions.size(), [&regions, &deserializer](std::size_t index) {
+			regions[index]->deserialize(deserializer);
+		});
+	}
+	invalidate_code();
+}
+
+frozen_memory_ptr main_memory::freeze() {
+	auto frozen = std::make_shared<frozen_memories>();
+	for (const auto &memory : _memory) {
+		frozen->add(memory->freeze());
+	}
+	return frozen;
+}
+
+void main_memory::get_dirty(std::vector<address_range> &ranges) const {
+	for (const auto &memory : _memory) {
+		memory->get_dirty(ranges);
+	}
+}
+
+void main_memory::clear_dirty() {
+	for (const auto &memory : _memory) {
+		memory->clear_dirty();
+	}
+}
+
+void main_memory::get_dirty_since(std::uint64_t epoch,
+                                  std::vector<address_range> &ranges) const {
+	for (const auto &memory : _memory) {
+		memory->get_dirty_since(epoch, ranges);
+	}
+}
+
+void main_memory::get_mapped(std::vector<address_range> &ranges) const {
+	for (const auto &memory : _memory) {
+		memory->get_mapped(ranges);
+	}
+}
+
+void main_memory::get_block_hashes(std::vector<block_hash> &hashes) {
+	std::size_t first = hashes.size();
+	for (const auto &memory : _memory) {
+		memory->get_block_hashes(hashes);
+	}
+	std::sort(hashes.begin() + static_cast<std::ptrdiff_t>(first), hashes.end(),
+	          [](const block_hash &a, const block_hash &b) {
+		          return a.range.get_start() < b.range.get_start();
+	          });
+}
+
+shared_memory_descriptor main_memory::get_shared_memory_descriptor() const {
+	shared_memory_descriptor descriptor;
+	for (const auto &memory : _memory) {
+		auto storage = memory->get_shared_storage();
+		if (storage) {
+			descriptor.add({memory->get_address_range(), storage->get_name(), memory->get_name()});
+		}
+	}
+	return descriptor;
+}
+
+bool main_memory::do_get_span(address address, bool write, span &span) {
+	if (_access_profiler || !_watchpoints.empty() || !has_address(address)) {
+		return false;
+	}
+
+	std::uint32_t flags;
+	auto memory = find_memory(address, flags);
+	if (!memory || !memory->get_span(address, write, span)) {
+		return false;
+	}
+
+	/* Spans written through may not reach past the page while code pages are marked. */
+	if (write && _code_pages) {
+		harpoon::memory::address page = address >> page_bits;
+		address_range page_range{page << page_bits, ((page + 1) << page_bits) - 1};
+		if (span.data && page_range.get_start() > span.range.get_start()) {
+			span.data += page_range.get_start() - span.range.get_start();
+		}
+		span.range.intersect(page_range);
+		if (flags & CODE) {
+			invalidate_code_page(page);
 		}
 	}
-	throw COMPONENT_EXCEPTION(exception::access_violation, address);
+	return true;
 }
 
 void main_memory::get_cell(address address, uint8_t &value) {
@@ -62,12 +477,20 @@ void main_memory::get_cell(address address, uint8_t &value) {
 		throw COMPONENT_EXCEPTION(exception::read_access_violation, address);
 	}
 
-	auto memory = get_memory(address);
+	std::uint32_t flags;
+	auto memory = find_memory(address, flags);
 	if (!memory) {
 		throw COMPONENT_EXCEPTION(exception::read_access_violation, address);
 	}
 
+	if (_access_profiler) {
+		_access_profiler->record(address, access_kind::READ);
+	}
 	memory->get(address, value);
+
+	if (flags & WATCH_READ) {
+		check_watchpoints(address, value, access_kind::READ);
+	}
 }
 
 void main_memory::set_cell(address address, uint8_t value) {
@@ -75,12 +498,44 @@ void main_memory::set_cell(address address, uint8_t value) {
 		throw COMPONENT_EXCEPTION(exception::write_access_violation, address);
 	}
 
-	auto memory = get_memory(address);
+	std::uint32_t flags;
+	auto memory = find_memory(address, flags);
 	if (!memory) {
 		throw COMPONENT_EXCEPTION(exception::write_access_violation, address);
 	}
 
+	if (_access_profiler) {
+		_access_profiler->record(address, access_kind::WRITE);
+	}
 	memory->set(address, value);
+
+	if (flags & CODE) {
+		invalidate_code_page(address >> page_bits);
+	}
+	if (flags & WATCH_WRITE) {
+		check_watchpoints(address, value, access_kind::WRITE);
+	}
+}
+
+void main_memory::fetch_cell(address address, uint8_t &value) {
+	if (!has_address(address)) {
+		throw COMPONENT_EXCEPTION(exception::read_access_violation, address);
+	}
+
+	std::uint32_t flags;
+	auto memory = find_memory(address, flags);
+	if (!memory) {
+		throw COMPONENT_EXCEPTION(exception::read_access_violation, address);
+	}
+
+	if (_access_profiler) {
+		_access_profiler->record(address, access_kind::FETCH);
+	}
+	memory->fetch(address, value);
+
+	if (flags & WATCH_READ) {
+		check_watchpoints(address, value, access_kind::FETCH);
+	}
 }
 
 } // namespace memory
@@ -1,60 +1,671 @@
 #include "harpoon/memory/memory.hh"
 
 #include "harpoon/memory/deserializer/deserializer.hh"
+#include "harpoon/memory/frozen_memory.hh"
+#include "harpoon/memory/memory_image.hh"
+#include "harpoon/memory/serializer/memory_buffer.hh"
 #include "harpoon/memory/serializer/serializer.hh"
+#include "harpoon/memory/trace/recorder.hh"
+#include "harpoon/memory/write_journal.hh"
+#include "harpoon/util/bytes.hh"
+#include "harpoon/util/hash.hh"
+
+#include <algorithm>
+#include <cstring>
 
 namespace harpoon {
 namespace memory {
 
+namespace {
+
+/* Frozen view holding a full copy of the memory contents. */
+class frozen_image : public frozen_memory {
+public:
+	frozen_image(const memory *memory, const memory_image_ptr &image)
+	    : _memory(memory), _image(image) {}
+
+	virtual void serialize(serializer::serializer &serializer) override {
+		if (_image->get_extents().empty()) {
+			return;
+		}
+
+		auto start = _memory->get_address_range().get_start();
+		serializer.start_memory_block(_memory);
+		for (const auto &e : _image->get_extents()) {
+			serializer.write(const_cast<std::uint8_t *>(e.data),
+			                 static_cast<std::size_t>(e.range.get_start() - start),
+			                 static_cast<std::size_t>(e.range.get_length()), !e.data);
+		}
+		serializer.finalize_memory_block();
+	}
+
+private:
+	const memory *_memory;
+	memory_image_ptr _image;
+};
+
+void append_range(std::vector<address_range> &ranges, address start, address end) {
+	if (!ranges.empty() && ranges.back().get_end() + 1 == start) {
+		ranges.back().set_end(end);
+	} else {
+		ranges.emplace_back(start, end);
+	}
+}
+
+/* Ranges where two buffers differ; a null buffer reads as zeros. */
+void diff_bytes(address start, const std::uint8_t *p1, const std::uint8_t *p2, std::size_t length,
+                std::vector<address_range> &ranges) {
+	auto byte = [](const std::uint8_t *p, std::size_t i) { return p ? p[i] : std::uint8_t{0}; };
+
+	std::size_t offset = 0;
+	while (offset < length) {
+		std::size_t left = length - offset;
+		std::size_t found = left;
+		if (p1 && p2) {
+			found = util::bytes::find_first_difference(p1 + offset, p2 + offset, left);
+		} else if (p1 || p2) {
+			found = util::bytes::find_first_nonzero((p1 ? p1 : p2) + offset, left);
+		}
+		if (found == left) {
+			return;
+		}
+
+		std::size_t first = offset + found;
+		std::size_t end = first + 1;
+		while (end < length && byte(p1, end) != byte(p2, end)) {
+			end++;
+		}
+		append_range(ranges, start + first, start + (end - 1));
+		offset = end;
+	}
+}
+
+/*
+ * Call mismatch() for every part covered by blocks on both sides, except
+ * where both blocks have the same range and hash.
+ */
+template<typename F>
+void for_each_mismatch(const std::vector<memory::block_hash> &first,
+                       const std::vector<memory::block_hash> &second, bool compare_hashes,
+                       F mismatch) {
+	std::size_t i = 0, j = 0;
+	while (i < first.size() && j < second.size()) {
+		const auto &a = first[i];
+		const auto &b = second[j];
+		address_range part = a.range.get_intersection(b.range);
+		if (part && !(compare_hashes && a.range == b.range && a.hash == b.hash)) {
+			mismatch(part);
+		}
+
+		address a_end = a.range.get_end(), b_end = b.range.get_end();
+		if (a_end <= b_end) {
+			i++;
+		}
+		if (b_end <= a_end) {
+			j++;
+		}
+	}
+}
+
+/* Mapped parts of the range in address order, those of adjacent memories joined. */
+std::vector<address_range> get_mapped_within(const memory &memory, const address_range &range) {
+	std::vector<address_range> mapped, pieces;
+	memory.get_mapped(mapped);
+	std::sort(mapped.begin(), mapped.end(), [](const address_range &a, const address_range &b) {
+		return a.get_start() < b.get_start();
+	});
+	for (auto r : mapped) {
+		r.intersect(range);
+		if (!r.is_empty()) {
+			append_range(pieces, r.get_start(), r.get_end());
+		}
+	}
+	return pieces;
+}
+
+} // namespace
+
+constexpr std::size_t memory::hash_block_length;
+std::atomic<std::uint64_t> memory::_dirty_epoch{};
+
 memory::~memory() {}
 
+/*
+ * Multi-byte accesses are little-endian sequences of cell accesses. Tracing
+ * is done once per access (not per cell), so the recorded width and value
+ * match what the caller asked for.
+ */
+template<typename T>
+void memory::read_cells(address address, T &value) {
+	value = 0;
+	for (std::size_t i = 0; i < sizeof(T); i++) {
+		std::uint8_t cell{};
+		get_cell(address + i, cell);
+		value = static_cast<T>(value | (static_cast<T>(cell) << (8 * i)));
+	}
+	if (_access_recorder) {
+		_access_recorder->record(address, sizeof(T), value, access_kind::READ);
+	}
+}
+
+template<typename T>
+void memory::write_cells(address address, T value) {
+	for (std::size_t i = 0; i < sizeof(T); i++) {
+		if (_write_journal) {
+			std::uint8_t old_value{};
+			get_cell(address + i, old_value);
+			_write_journal->record(address + i, old_value);
+		}
+		set_cell(address + i, static_cast<std::uint8_t>((value >> (8 * i)) & 0xff));
+	}
+	if (_access_recorder) {
+		_access_recorder->record(address, sizeof(T), value, access_kind::WRITE);
+	}
+}
+
+template<typename T>
+void memory::fetch_cells(address address, T &value) {
+	value = 0;
+	for (std::size_t i = 0; i < sizeof(T); i++) {
+		std::uint8_t cell{};
+		fetch_cell(address + i, cell);
+		value = static_cast<T>(value | (static_cast<T>(cell) << (8 * i)));
+	}
+	if (_access_recorder) {
+		_access_recorder->record(address, sizeof(T), value, access_kind::FETCH);
+	}
+}
+
 void memory::get(address address, std::uint8_t &value) {
-	get_cell(address, value);
+	read_cells(address, value);
 }
 
 void memory::set(address address, std::uint8_t value) {
-	set_cell(address, value);
+	write_cells(address, value);
 }
 
 void memory::get(address address, std::uint16_t &value) {
-	std::uint8_t lo, hi;
-	get(address, lo);
-	get(address + 1, hi);
-	value = ((static_cast<std::uint16_t>(hi << 8)) | lo);
+	read_cells(address, value);
 }
 
 void memory::set(address address, std::uint16_t value) {
-	set(address, static_cast<std::uint8_t>(value & 0xff));
-	set(address + 1, static_cast<std::uint8_t>((value >> 8) & 0xff));
+	write_cells(address, value);
 }
 
 void memory::get(address address, std::uint32_t &value) {
-	std::uint16_t lo, hi;
-	get(address, lo);
-	get(address + 2, hi);
-	value = ((static_cast<std::uint32_t>(hi) << 16) | lo);
+	read_cells(address, value);
 }
 
 void memory::set(address address, std::uint32_t value) {
-	set(address, static_cast<std::uint16_t>(value & 0xffff));
-	set(address + 2, static_cast<std::uint16_t>((value >> 16) & 0xffff));
+	write_cells(address, value);
 }
 
 void memory::get(address address, std::uint64_t &value) {
-	std::uint32_t lo, hi;
-	get(address, lo);
-	get(address + 4, hi);
-	value = ((static_cast<std::uint64_t>(hi) << 32) | lo);
+	read_cells(address, value);
 }
 
 void memory::set(address address, std::uint64_t value) {
-	set(address, static_cast<std::uint32_t>(value & 0xffffffff));
-	set(address + 4, static_cast<std::uint32_t>((value >> 32) & 0xffffffff));
+	write_cells(address, value);
+}
+
+void memory::fetch(address address, std::uint8_t &value) {
+	fetch_cells(address, value);
+}
+
+void memory::fetch(address address, std::uint16_t &value) {
+	fetch_cells(address, value);
+}
+
+void memory::fetch(address address, std::uint32_t &value) {
+	fetch_cells(address, value);
+}
+
+void memory::fetch(address address, std::uint64_t &value) {
+	fetch_cells(address, value);
+}
+
+void memory::fetch_cell(address address, std::uint8_t &value) {
+	get_cell(address, value);
+}
+
+bool memory::do_get_span(address, bool, span &) {
+	return false;
+}
+
+bool memory::get_span(address address, bool write, span &span) {
+	if (_access_recorder || _write_journal) {
+		return false;
+	}
+	return do_get_span(address, write, span);
+}
+
+bool memory::matches_at(address address, const std::uint8_t *pattern, const std::uint8_t *mask,
+                        std::size_t length) {
+	for (std::size_t k = 0; k < length; k++) {
+		std::uint8_t m = mask ? mask[k] : 0xff;
+		std::uint8_t value;
+		get(address + k, value);
+		if ((value & m) != (pattern[k] & m)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool memory::find(const address_range &range, const std::uint8_t *pattern, const std::uint8_t *mask,
+                  std::size_t length, address &found) {
+	for (const auto &piece : get_mapped_within(*this, range)) {
+		if (find_mapped(piece, pattern, mask, length, found)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+bool memory::find_mapped(const address_range &range, const std::uint8_t *pattern,
+                         const std::uint8_t *mask, std::size_t length, address &found) {
+	if (range.is_empty() || length == 0 || range.get_end() - range.get_start() < length - 1) {
+		return false;
+	}
+
+	bool zero_pattern = true;
+	for (std::size_t k = 0; k < length; k++) {
+		zero_pattern = zero_pattern && (pattern[k] & (mask ? mask[k] : 0xff)) == 0;
+	}
+
+	const address last = range.get_end() - (length - 1);
+	address a = range.get_start();
+	for (;;) {
+		span s;
+		if (!get_span(a, false, s)) {
+			if (matches_at(a, pattern, mask, length)) {
+				found = a;
+				return true;
+			}
+			if (a == last) {
+				return false;
+			}
+			a++;
+			continue;
+		}
+
+		/* Starts whose whole pattern lies in the span are handled in bulk. */
+		address span_end = std::min(s.range.get_end(), range.get_end());
+		address next = a;
+		if (span_end - a >= length - 1) {
+			std::size_t n = static_cast<std::size_t>(span_end - a + 1);
+			if (s.data) {
+				std::size_t offset = util::bytes::find_pattern(
+				    s.data + (a - s.range.get_start()), n, pattern, mask, length);
+				if (offset != n) {
+					found = a + offset;
+					return true;
+				}
+			} else if (zero_pattern) {
+				found = a;
+				return true;
+			}
+			next = span_end - (length - 1) + 1;
+		}
+
+		/* Starts crossing into the following storage are checked bytewise. */
+		address straddle_end = std::min(span_end, last);
+		for (address b = next; b <= straddle_end; b++) {
+			if (matches_at(b, pattern, mask, length)) {
+				found = b;
+				return true;
+			}
+		}
+
+		if (span_end >= last) {
+			return false;
+		}
+		a = span_end + 1;
+	}
+}
+
+void memory::fill(const address_range &range, std::uint8_t value) {
+	if (range.is_empty()) {
+		return;
+	}
+
+	address a = range.get_start();
+	for (;;) {
+		span s;
+		if (value == 0 && get_span(a, false, s) && !s.data) {
+			/* Unallocated storage already reads as zeros. */
+		} else if (get_span(a, true, s)) {
+			address end = std::min(s.range.get_end(), range.get_end());
+			util::bytes::fill(s.data + (a - s.range.get_start()),
+			                  static_cast<std::size_t>(end - a + 1), value);
+		} else {
+			set(a, value);
+			s.range = {a, a};
+		}
+
+		address end = std::min(s.range.get_end(), range.get_end());
+		if (end == range.get_end()) {
+			return;
+		}
+		a = end + 1;
+	}
+}
+
+bool memory::compare(const address_range &range, memory &other, address other_start,
+                     address &difference) {
+	for (const auto &piece : get_mapped_within(*this, range)) {
+		address_range other_range(other_start + (piece.get_start() - range.get_start()),
+		                          other_start + (piece.get_end() - range.get_start()));
+		for (const auto &other_piece : get_mapped_within(other, other_range)) {
+			address start = piece.get_start() + (other_piece.get_start() - other_range.get_start());
+			address_range both(start, start + (other_piece.get_end() - other_piece.get_start()));
+			if (!compare_mapped(both, other, other_piece.get_start(), difference)) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+bool memory::compare_mapped(const address_range &range, memory &other, address other_start,
+                            address &difference) {
+	if (range.is_empty()) {
+		return true;
+	}
+
+	address a = range.get_start();
+	for (;;) {
+		address b = other_start + (a - range.get_start());
+		address remaining = range.get_end() - a;
+
+		span s1, s2;
+		if (get_span(a, false, s1) && other.get_span(b, false, s2)) {
+			remaining = std::min({remaining, s1.range.get_end() - a, s2.range.get_end() - b});
+			std::size_t n = static_cast<std::size_t>(remaining + 1);
+
+			const std::uint8_t *p1 = s1.data ? s1.data + (a - s1.range.get_start()) : nullptr;
+			const std::uint8_t *p2 = s2.data ? s2.data + (b - s2.range.get_start()) : nullptr;
+			std::size_t offset = n;
+			if (p1 && p2) {
+				offset = util::bytes::find_first_difference(p1, p2, n);
+			} else if (p1 || p2) {
+				offset = util::bytes::find_first_nonzero(p1 ? p1 : p2, n);
+			}
+			if (offset != n) {
+				difference = a + offset;
+				return false;
+			}
+		} else {
+			std::uint8_t v1, v2;
+			get(a, v1);
+			other.get(b, v2);
+			if (v1 != v2) {
+				difference = a;
+				return false;
+			}
+			remaining = 0;
+		}
+
+		if (a + remaining == range.get_end()) {
+			return true;
+		}
+		a += remaining + 1;
+	}
+}
+
+void memory::read(const address_range &range, std::uint8_t *data) {
+	if (range.is_empty()) {
+		return;
+	}
+
+	address a = range.get_start();
+	for (;;) {
+		span s;
+		address end = a;
+		std::uint8_t *output = data + (a - range.get_start());
+		if (get_span(a, false, s)) {
+			end = std::min(s.range.get_end(), range.get_end());
+			std::size_t length = static_cast<std::size_t>(end - a + 1);
+			if (s.data) {
+				std::memcpy(output, s.data + (a - s.range.get_start()), length);
+			} else {
+				std::memset(output, 0, length);
+			}
+		} else {
+			get(a, *output);
+		}
+
+		if (end == range.get_end()) {
+			return;
+		}
+		a = end + 1;
+	}
+}
+
+void memory::write(const address_range &range, const std::uint8_t *data) {
+	if (range.is_empty()) {
+		return;
+	}
+
+	address a = range.get_start();
+	for (;;) {
+		span s;
+		address end = a;
+		const std::uint8_t *input = data + (a - range.get_start());
+		if (get_span(a, true, s)) {
+			end = std::min(s.range.get_end(), range.get_end());
+			std::memcpy(s.data + (a - s.range.get_start()), input,
+			            static_cast<std::size_t>(end - a + 1));
+		} else {
+			set(a, *input);
+		}
+
+		if (end == range.get_end()) {
+			return;
+		}
+		a = end + 1;
+	}
+}
+
+void memory::get_block_hashes(std::vector<block_hash> &hashes) {
+	const address_range &range = get_address_range();
+	if (range.is_empty()) {
+		return;
+	}
+
+	std::vector<std::uint8_t> buffer(hash_block_length);
+	address start = range.get_start();
+	for (;;) {
+		address end = start + (hash_block_length - 1);
+		if (end < start || end > range.get_end()) {
+			end = range.get_end();
+		}
+		address_range block(start, end);
+		std::size_t length = static_cast<std::size_t>(block.get_length());
+
+		span s;
+		const std::uint8_t *data = buffer.data();
+		if (get_span(start, false, s) && s.data && s.range.get_end() >= end) {
+			data = s.data + (start - s.range.get_start());
+		} else {
+			read(block, buffer.data());
+		}
+		hashes.push_back({block, util::hash::hash64(data, length)});
+
+		if (end == range.get_end()) {
+			return;
+		}
+		start = end + 1;
+	}
+}
+
+std::uint64_t memory::get_digest() {
+	std::vector<block_hash> hashes;
+	get_block_hashes(hashes);
+	return get_digest(hashes);
+}
+
+std::uint64_t memory::get_digest(const std::vector<block_hash> &hashes) {
+	std::vector<std::uint64_t> values;
+	values.reserve(hashes.size() * 3);
+	for (const auto &h : hashes) {
+		values.push_back(h.range.get_start());
+		values.push_back(h.range.get_end());
+		values.push_back(h.hash);
+	}
+	return util::hash::hash64(values.data(), values.size() * sizeof(std::uint64_t));
+}
+
+void memory::diff(memory &other, std::vector<address_range> &ranges) {
+	std::vector<block_hash> mine, theirs;
+	get_block_hashes(mine);
+	other.get_block_hashes(theirs);
+
+	for_each_mismatch(mine, theirs, true,
+	                  [this, &other, &ranges](const address_range &range) {
+		                  diff_range(range, other, ranges);
+	                  });
+}
+
+void memory::diff(const memory_image &image, const std::vector<block_hash> &image_hashes,
+                  std::vector<address_range> &ranges) {
+	std::vector<block_hash> mine;
+	get_block_hashes(mine);
+
+	/* Without hashes the whole image is compared. */
+	bool compare_hashes = !image_hashes.empty();
+	std::vector<block_hash> whole{{image.get_range(), 0}};
+	for_each_mismatch(mine, compare_hashes ? image_hashes : whole, compare_hashes,
+	                  [this, &image, &ranges](const address_range &range) {
+		                  diff_image(range, image, ranges);
+	                  });
+}
+
+void memory::diff_range(const address_range &range, memory &other,
+                        std::vector<address_range> &ranges) {
+	address a = range.get_start();
+	for (;;) {
+		span s;
+		address end = a;
+		if (other.get_span(a, false, s)) {
+			end = std::min(s.range.get_end(), range.get_end());
+			diff_data({a, end}, s.data ? s.data + (a - s.range.get_start()) : nullptr, ranges);
+		} else {
+			std::uint8_t value;
+			other.get(a, value);
+			diff_data({a, a}, &value, ranges);
+		}
+
+		if (end == range.get_end()) {
+			return;
+		}
+		a = end + 1;
+	}
+}
+
+void memory::diff_data(const address_range &range, const std::uint8_t *data,
+                       std::vector<address_range> &ranges) {
+	address a = range.get_start();
+	for (;;) {
+		span s;
+		address end = a;
+		const std::uint8_t *input = data ? data + (a - range.get_start()) : nullptr;
+		if (get_span(a, false, s)) {
+			end = std::min(s.range.get_end(), range.get_end());
+			diff_bytes(a, s.data ? s.data + (a - s.range.get_start()) : nullptr, input,
+			           static_cast<std::size_t>(end - a + 1), ranges);
+		} else {
+			std::uint8_t value;
+			get(a, value);
+			diff_bytes(a, &value, input, 1, ranges);
+		}
+
+		if (end == range.get_end()) {
+			return;
+		}
+		a = end + 1;
+	}
+}
+
+void memory::diff_image(const address_range &range, const memory_image &image,
+                        std::vector<address_range> &ranges) {
+	const auto &extents = image.get_extents();
+	address a = range.get_start();
+	for (auto i = image.find(a); i != extents.end() && i->range.get_start() <= range.get_end();
+	     ++i) {
+		address_range part = i->range.get_intersection(range);
+		if (part.get_start() > a) {
+			diff_data({a, part.get_start() - 1}, nullptr, ranges);
+		}
+		diff_data(part, i->data ? i->data + (part.get_start() - i->range.get_start()) : nullptr,
+		          ranges);
+		if (part.get_end() == range.get_end()) {
+			return;
+		}
+		a = part.get_end() + 1;
+	}
+	diff_data({a, range.get_end()}, nullptr, ranges);
+}
+
+void memory::run_batches(std::size_t count, std::size_t batch,
+                         const std::function<void(std::size_t, std::size_t)> &task) const {
+	if (!count) {
+		return;
+	}
+	if (!batch) {
+		batch = 1;
+	}
+
+	std::size_t batches = (count + batch - 1) / batch;
+	auto run = [count, batch, &task](std::size_t index) {
+		std::size_t first = index * batch;
+		task(first, std::min(first + batch, count));
+	};
+
+	if (_thread_pool) {
+		_thread_pool->run(batches, run);
+	} else {
+		for (std::size_t i = 0; i < batches; i++) {
+			run(i);
+		}
+	}
+}
+
+void memory::get_dirty(std::vector<address_range> &ranges) const {
+	if (!get_address_range().is_empty()) {
+		ranges.push_back(get_address_range());
+	}
+}
+
+void memory::clear_dirty() {}
+
+std::uint64_t memory::start_dirty_epoch() {
+	return _dirty_epoch.fetch_add(1, std::memory_order_relaxed) + 1;
+}
+
+void memory::get_dirty_since(std::uint64_t, std::vector<address_range> &ranges) const {
+	get_dirty(ranges);
+}
+
+void memory::get_mapped(std::vector<address_range> &ranges) const {
+	if (!get_address_range().is_empty()) {
+		ranges.push_back(get_address_range());
+	}
 }
 
 void memory::serialize(serializer::serializer &) {}
 
 void memory::deserialize(deserializer::deserializer &) {}
 
+std::shared_ptr<shared_storage> memory::get_shared_storage() const {
+	return nullptr;
+}
+
+frozen_memory_ptr memory::freeze() {
+	serializer::memory_buffer buffer(get_address_range());
+	serialize(buffer);
+	return std::make_shared<frozen_image>(this, buffer.get_image());
+}
+
 } // namespace memory
 } // namespace harpoon
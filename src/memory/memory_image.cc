@@ -0,0 +1,68 @@
+#include "harpoon/memory/memory_image.hh"
+
+#include <algorithm>
+#include <cstring>
+
+namespace harpoon {
+namespace memory {
+
+memory_image::~memory_image() {
+	for (auto &b : _buffers) {
+		_buffer_pool->release(std::move(b));
+	}
+}
+
+void memory_image::add(address start, const std::uint8_t *data, std::size_t length) {
+	/* Data larger than a pooled buffer is split into several extents. */
+	while (length) {
+		std::size_t piece = length;
+		std::uint8_t *copy = allocate(piece);
+		std::memcpy(copy, data, piece);
+		insert({address_range(start, start + piece - 1), copy});
+
+		_stored += piece;
+		start += piece;
+		data += piece;
+		length -= piece;
+	}
+}
+
+void memory_image::add_sparse(address start, std::size_t length) {
+	if (length) {
+		insert({address_range(start, start + length - 1), nullptr});
+	}
+}
+
+std::vector<memory_image::extent>::const_iterator memory_image::find(address address) const {
+	return std::lower_bound(_extents.begin(), _extents.end(), address,
+	                        [](const extent &e, harpoon::memory::address a) {
+		                        return e.range.get_end() < a;
+	                        });
+}
+
+void memory_image::insert(const extent &extent) {
+	/* Writes normally arrive in address order, so this is an append. */
+	if (_extents.empty() || _extents.back().range.get_end() < extent.range.get_start()) {
+		_extents.push_back(extent);
+		return;
+	}
+	_extents.insert(find(extent.range.get_start()), extent);
+}
+
+/* Pieces that fit in one buffer are kept whole; longer ones may be shortened. */
+std::uint8_t *memory_image::allocate(std::size_t &length) {
+	std::size_t buffer_length = _buffer_pool->get_buffer_length();
+	if (_buffers.empty() || _buffer_used == buffer_length
+	    || (buffer_length - _buffer_used < length && length <= buffer_length)) {
+		_buffers.push_back(_buffer_pool->acquire());
+		_buffer_used = 0;
+	}
+	length = std::min(length, buffer_length - _buffer_used);
+
+	std::uint8_t *p = _buffers.back().get() + _buffer_used;
+	_buffer_used += length;
+	return p;
+}
+
+} // namespace memory
+} // namespace harpoon
@@ -63,5 +63,9 @@ void multiplexed_memory::set_cell(address address, uint8_t value) {
 	_active_memory->get(address, value);
 }
 
+bool multiplexed_memory::do_get_span(address address, bool write, span &span) {
+	return _active_memory && _active_memory->get_span(address, write, span);
+}
+
 } // namespace memory
 } // namespace harpoon
@@ -0,0 +1,68 @@
+#include "harpoon/memory/record_stream.hh"
+
+#include <cstring>
+
+namespace harpoon {
+namespace memory {
+namespace record_stream {
+
+namespace {
+
+void put(std::uint8_t *&output, std::uint64_t v, std::size_t bytes) {
+	for (std::size_t i = 0; i < bytes; i++) {
+		*output++ = static_cast<std::uint8_t>(v >> (i * 8));
+	}
+}
+
+std::uint64_t get(const std::uint8_t *&data, std::size_t bytes) {
+	std::uint64_t v = 0;
+	for (std::size_t i = 0; i < bytes; i++) {
+		v |= static_cast<std::uint64_t>(*data++) << (i * 8);
+	}
+	return v;
+}
+
+} // namespace
+
+void encode_header(const address_range &range, std::uint8_t *output) {
+	std::memcpy(output, file_magic, sizeof(file_magic));
+	output += sizeof(file_magic);
+	put(output, file_version, 4);
+	put(output, range.get_start(), 8);
+	put(output, range.get_end(), 8);
+}
+
+bool decode_header(const std::uint8_t *data, address_range &range) {
+	if (std::memcmp(data, file_magic, sizeof(file_magic)) != 0) {
+		return false;
+	}
+	data += sizeof(file_magic);
+	if (get(data, 4) != file_version) {
+		return false;
+	}
+	auto start = static_cast<address>(get(data, 8));
+	auto end = static_cast<address>(get(data, 8));
+	range = address_range(start, end);
+	return true;
+}
+
+void encode_record(const record &record, std::uint8_t *output) {
+	put(output, static_cast<std::uint8_t>(record.type), 1);
+	put(output, record.address, 8);
+	put(output, record.length, 8);
+}
+
+bool decode_record(const std::uint8_t *data, record &record) {
+	auto type = static_cast<std::uint8_t>(get(data, 1));
+	if (type > static_cast<std::uint8_t>(record_type::SPARSE)) {
+		return false;
+	}
+	record.type = static_cast<record_type>(type);
+	record.address = static_cast<address>(get(data, 8));
+	record.length = get(data, 8);
+	return true;
+}
+
+} // namespace record_stream
+} // namespace memory
+} // namespace harpoon
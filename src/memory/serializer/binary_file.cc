@@ -1,37 +1,127 @@
 #include "harpoon/memory/serializer/binary_file.hh"
 
 #include "harpoon/memory/memory.hh"
+#include "harpoon/memory/serializer/exception/io.hh"
+#include "harpoon/util/bytes.hh"
+
+#include <algorithm>
 
 namespace harpoon {
 namespace memory {
 namespace serializer {
 
+namespace {
+
+constexpr std::size_t max_pending = 1024;
+
+} // namespace
+
+constexpr std::size_t binary_file::hole_granularity;
+
 binary_file::binary_file(const address_range &range, const std::string &file_name)
     : serializer(range), _file_name(file_name) {
-	_output.exceptions(std::ofstream::badbit);
-	_output.open(_file_name, std::ios::binary | std::ios::trunc);
+	if (!_file.open(_file_name, util::file::Mode::WRITE)) {
+		throw HARPOON_EXCEPTION(exception::io, _file_name);
+	}
 }
 
+binary_file::~binary_file() {}
+
 void binary_file::do_start_memory_block() {}
 
 std::size_t binary_file::do_write(uint8_t *data, std::size_t offset, std::size_t length,
                                   bool sparse) {
-	_output.seekp(static_cast<std::ifstream::off_type>(get_block_range().get_start()
-	                                                   - get_range().get_start() + offset),
-	              _output.beg);
+	std::size_t position = static_cast<std::size_t>(get_block_range().get_start()
+	                                                - get_range().get_start() + offset);
+	_extent = std::max(_extent, position + length);
+
 	if (sparse) {
-		get_block_memory()->log(log_debug_c(get_block_memory()->get_name() + " => binary_file")
-		                        << "Writing " << length << " bytes of sparse buffer to "
-		                        << _file_name);
-		_output.seekp(static_cast<std::ifstream::off_type>(length), _output.cur);
-	} else {
-		get_block_memory()->log(log_debug_c(get_block_memory()->get_name() + " => binary_file")
-		                        << "Writing " << length << " bytes to " << _file_name);
-		_output.write(reinterpret_cast<const char *>(data), static_cast<std::streamsize>(length));
+		punch_hole(position, length);
+		return length;
+	}
+
+	/* Zero detection works on file-block aligned pieces so holes line up with the filesystem. */
+	std::size_t done = 0;
+	while (done < length) {
+		std::size_t p = position + done;
+		std::size_t piece = std::min(length - done, hole_granularity - p % hole_granularity);
+		if (util::bytes::is_zero(data + done, piece)) {
+			punch_hole(p, piece);
+		} else {
+			append(data + done, p, piece);
+		}
+		done += piece;
 	}
 	return length;
 }
 
+void binary_file::do_finalize_memory_block() {
+	flush();
+	if (_file_length < _extent) {
+		if (!_file.extend(_extent)) {
+			throw HARPOON_EXCEPTION(exception::io, _file_name);
+		}
+		_file_length = _extent;
+	}
+
+	get_block_memory()->log(log_debug_c(get_block_memory()->get_name() + " => binary_file")
+	                        << "Wrote " << _written << " bytes (" << _sparse << " sparse) to "
+	                        << _file_name);
+	_written = 0;
+	_sparse = 0;
+}
+
+void binary_file::append(uint8_t *data, std::size_t position, std::size_t length) {
+	if (!_pending.empty() && _pending_position + _pending_length == position) {
+		util::file::piece &last = _pending.back();
+		if (static_cast<const uint8_t *>(last.data) + last.length == data) {
+			last.length += length;
+			_pending_length += length;
+			return;
+		}
+		if (_pending.size() < max_pending) {
+			_pending.push_back({data, length});
+			_pending_length += length;
+			return;
+		}
+	}
+
+	flush();
+	_pending.push_back({data, length});
+	_pending_position = position;
+	_pending_length = length;
+}
+
+void binary_file::flush() {
+	if (!_pending.empty() && !_file.write_at(_pending.data(), _pending.size(), _pending_position)) {
+		throw HARPOON_EXCEPTION(exception::io, _file_name);
+	}
+
+	_written += _pending_length;
+	_file_length = std::max(_file_length, _pending_position + _pending_length);
+	_pending.clear();
+	_pending_length = 0;
+}
+
+void binary_file::punch_hole(std::size_t position, std::size_t length) {
+	_sparse += length;
+
+	if (!_pending.empty() && position < _pending_position + _pending_length
+	    && position + length > _pending_position) {
+		flush();
+	}
+
+	/* Anything past the current end of file is a hole once the file is extended. */
+	if (position >= _file_length || length == 0) {
+		return;
+	}
+	length = std::min(length, _file_length - position);
+
+	if (!_file.zero(position, length)) {
+		throw HARPOON_EXCEPTION(exception::io, _file_name);
+	}
+}
+
 } // namespace serializer
 } // namespace memory
 } // namespace harpoon
@@ -0,0 +1,187 @@
+#include "harpoon/memory/serializer/container_file.hh"
+
+#include "harpoon/memory/serializer/exception/io.hh"
+#include "harpoon/util/bytes.hh"
+#include "harpoon/util/hash.hh"
+#include "harpoon/util/lz.hh"
+
+#include <algorithm>
+#include <cstring>
+
+namespace harpoon {
+namespace memory {
+namespace serializer {
+
+constexpr std::size_t container_file::default_block_length;
+
+container_file::container_file(const address_range &range, const std::string &file_name,
+                               std::size_t block_length, const util::thread_pool_ptr &thread_pool)
+    : serializer(range), _file_name(file_name),
+      _block_length(std::max<std::size_t>(block_length, 1)), _thread_pool(thread_pool) {
+	_batch_length = 16 * (_thread_pool ? _thread_pool->get_threads() : 1);
+
+	if (!_file.open(_file_name, util::file::Mode::WRITE)) {
+		throw HARPOON_EXCEPTION(exception::io, _file_name);
+	}
+}
+
+container_file::~container_file() {
+	try {
+		close();
+	} catch (...) {
+	}
+}
+
+void container_file::close() {
+	if (!_file.is_open()) {
+		return;
+	}
+
+	try {
+		flush();
+
+		std::sort(_index.begin(), _index.end(),
+		          [](const container::index_entry &a, const container::index_entry &b) {
+			          return a.start < b.start;
+		          });
+
+		std::vector<uint8_t> index(_index.size() * container::index_entry_length);
+		for (std::size_t i = 0; i < _index.size(); i++) {
+			container::encode_index_entry(_index[i],
+			                              index.data() + i * container::index_entry_length);
+		}
+		write_at(index.data(), index.size(), _offset);
+
+		container::header header{container::file_version,
+		                         static_cast<std::uint32_t>(_block_length),
+		                         get_range(),
+		                         _offset,
+		                         _index.size(),
+		                         util::hash::hash64(index.data(), index.size())};
+		uint8_t encoded[container::header_length];
+		container::encode_header(header, encoded);
+		write_at(encoded, sizeof(encoded), 0);
+	} catch (...) {
+		_file.close();
+		throw;
+	}
+
+	_file.close();
+}
+
+void container_file::do_start_memory_block() {}
+
+std::size_t container_file::do_write(uint8_t *data, std::size_t offset, std::size_t length,
+                                     bool sparse) {
+	if (sparse) {
+		return length;
+	}
+
+	auto start = get_block_range().get_start() + offset;
+	std::size_t done = 0;
+	while (done < length) {
+		auto a = start + done;
+		std::size_t piece = std::min<std::size_t>(length - done,
+		                                          _block_length - a % _block_length);
+		queue(a, data + done, piece);
+		done += piece;
+	}
+	return length;
+}
+
+void container_file::do_finalize_memory_block() {
+	flush();
+}
+
+void container_file::queue(harpoon::memory::address start, const uint8_t *data,
+                           std::size_t length) {
+	if (!_pending.empty()) {
+		pending_block &last = _pending.back();
+		if (last.start + last.length == start && start % _block_length != 0) {
+			last.segments.push_back({data, length});
+			last.length += length;
+			return;
+		}
+	}
+
+	if (_pending.size() >= _batch_length) {
+		flush();
+	}
+	_pending.push_back({start, length, {{data, length}}});
+}
+
+void container_file::compress(std::size_t index) {
+	static thread_local std::vector<uint8_t> gathered;
+
+	const pending_block &block = _pending[index];
+	const uint8_t *data = block.segments.front().data;
+	if (block.segments.size() > 1) {
+		gathered.resize(block.length);
+		std::size_t position = 0;
+		for (const auto &s : block.segments) {
+			std::memcpy(gathered.data() + position, s.data, s.length);
+			position += s.length;
+		}
+		data = gathered.data();
+	}
+
+	container::index_entry &entry = _results[index];
+	entry = {block.start, static_cast<std::uint32_t>(block.length), 0, 0, 0, 0};
+	if (util::bytes::is_zero(data, block.length)) {
+		entry.length = 0;
+		return;
+	}
+	entry.checksum = util::hash::hash64(data, block.length);
+
+	std::vector<uint8_t> &payload = _payloads[index];
+	payload.clear();
+	util::lz::compress(data, block.length, payload);
+	if (payload.size() >= block.length) {
+		payload.assign(data, data + block.length);
+		entry.flags |= container::RAW;
+	}
+	entry.stored_length = static_cast<std::uint32_t>(payload.size());
+}
+
+void container_file::flush() {
+	if (_pending.empty()) {
+		return;
+	}
+
+	if (_payloads.size() < _pending.size()) {
+		_payloads.resize(_pending.size());
+	}
+	_results.resize(_pending.size());
+
+	auto task = [this](std::size_t index) { compress(index); };
+	if (_thread_pool) {
+		_thread_pool->run(_pending.size(), task);
+	} else {
+		for (std::size_t i = 0; i < _pending.size(); i++) {
+			task(i);
+		}
+	}
+
+	/* Payloads are appended in queue order, so the layout does not depend on scheduling. */
+	for (std::size_t i = 0; i < _pending.size(); i++) {
+		container::index_entry &entry = _results[i];
+		if (!entry.length) {
+			continue;
+		}
+		entry.offset = _offset;
+		write_at(_payloads[i].data(), _payloads[i].size(), _offset);
+		_offset += _payloads[i].size();
+		_index.push_back(entry);
+	}
+	_pending.clear();
+}
+
+void container_file::write_at(const void *data, std::size_t length, std::uint64_t offset) {
+	if (!_file.write_at(data, length, offset)) {
+		throw HARPOON_EXCEPTION(exception::io, _file_name);
+	}
+}
+
+} // namespace serializer
+} // namespace memory
+} // namespace harpoon
@@ -0,0 +1,24 @@
+#include "harpoon/memory/serializer/exception/io.hh"
+
+#include <iomanip>
+#include <sstream>
+
+namespace harpoon {
+namespace memory {
+namespace serializer {
+namespace exception {
+
+io::io(const std::string &outfile, const std::string &file, int line, const std::string &function)
+    : harpoon::exception::harpoon_exception("", file, line, function) {
+	std::stringstream stream;
+	stream << "I/O error. Output file: " << outfile;
+
+	set_what(stream.str());
+}
+
+io::~io() {}
+
+} // namespace exception
+} // namespace serializer
+} // namespace memory
+} // namespace harpoon
@@ -0,0 +1,24 @@
+#include "harpoon/memory/serializer/memory_buffer.hh"
+
+namespace harpoon {
+namespace memory {
+namespace serializer {
+
+memory_buffer::~memory_buffer() {}
+
+void memory_buffer::do_start_memory_block() {}
+
+std::size_t memory_buffer::do_write(uint8_t *data, std::size_t offset, std::size_t length,
+                                   bool sparse) {
+	auto start = get_block_range().get_start() + offset;
+	if (sparse) {
+		_image->add_sparse(start, length);
+	} else {
+		_image->add(start, data, length);
+	}
+	return length;
+}
+
+} // namespace serializer
+} // namespace memory
+} // namespace harpoon
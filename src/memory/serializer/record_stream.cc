@@ -0,0 +1,97 @@
+#include "harpoon/memory/serializer/record_stream.hh"
+
+#include "harpoon/memory/serializer/exception/io.hh"
+#include "harpoon/util/bytes.hh"
+
+#include <algorithm>
+
+namespace harpoon {
+namespace memory {
+namespace serializer {
+
+namespace format = harpoon::memory::record_stream;
+
+constexpr std::size_t record_stream::zero_granularity;
+
+record_stream::record_stream(const address_range &range, std::ostream &output)
+    : serializer(range), _output(output) {
+	uint8_t header[format::header_length];
+	format::encode_header(range, header);
+	_output.write(reinterpret_cast<const char *>(header), sizeof(header));
+	check();
+}
+
+record_stream::~record_stream() {
+	try {
+		close();
+	} catch (...) {
+	}
+}
+
+void record_stream::close() {
+	if (_closed) {
+		return;
+	}
+	_closed = true;
+	write_record(format::record_type::END, 0, 0);
+	_output.flush();
+	check();
+}
+
+void record_stream::do_start_memory_block() {
+	write_record(format::record_type::BLOCK, get_block_range().get_start(),
+	             static_cast<std::size_t>(get_block_range().get_length()));
+	check();
+}
+
+std::size_t record_stream::do_write(uint8_t *data, std::size_t offset, std::size_t length,
+                                    bool sparse) {
+	auto start = get_block_range().get_start() + offset;
+	if (sparse) {
+		write_record(format::record_type::SPARSE, start, length);
+		check();
+		return length;
+	}
+
+	/* Runs of all-zero pages become sparse records, the rest is written as is. */
+	std::size_t done = 0;
+	while (done < length) {
+		bool zero = util::bytes::is_zero(data + done, std::min(length - done, zero_granularity));
+		std::size_t run = 0;
+		while (done + run < length) {
+			std::size_t piece = std::min(length - done - run, zero_granularity);
+			if (run && util::bytes::is_zero(data + done + run, piece) != zero) {
+				break;
+			}
+			run += piece;
+		}
+
+		if (zero) {
+			write_record(format::record_type::SPARSE, start + done, run);
+		} else {
+			write_record(format::record_type::DATA, start + done, run);
+			_output.write(reinterpret_cast<const char *>(data + done),
+			              static_cast<std::streamsize>(run));
+		}
+		check();
+		done += run;
+	}
+	return length;
+}
+
+void record_stream::write_record(format::record_type type, address address,
+                                 std::size_t length) {
+	uint8_t encoded[format::record_header_length];
+	format::encode_record({type, address, length}, encoded);
+	_output.write(reinterpret_cast<const char *>(encoded), sizeof(encoded));
+}
+
+void record_stream::check() {
+	if (!_output) {
+		throw HARPOON_EXCEPTION(exception::io, "record stream");
+	}
+}
+
+} // namespace serializer
+} // namespace memory
+} // namespace harpoon
@@ -19,6 +19,7 @@ void serializer::start_memory_block(const memory *block_memory, const address_ra
 
 	_block_memory = block_memory;
 	_block_range = block_range;
+	do_start_memory_block();
 }
 
 std::size_t serializer::write(uint8_t *data, std::size_t length, bool sparse) {
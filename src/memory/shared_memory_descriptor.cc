@@ -0,0 +1,66 @@
+#include "harpoon/memory/shared_memory_descriptor.hh"
+
+#include "harpoon/memory/exception/shared_memory_error.hh"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace harpoon {
+namespace memory {
+
+void shared_memory_descriptor::write(const std::string &file_name) const {
+	std::string temporary = file_name + ".tmp";
+	{
+		std::ofstream output(temporary, std::ios::trunc);
+		output << "# harpoon shared memory layout\n" << std::hex;
+		for (const auto &r : _regions) {
+			output << "region 0x" << r.range.get_start() << " 0x" << r.range.get_end() << " "
+			       << r.object << " " << r.name << "\n";
+		}
+		output.close();
+		if (!output) {
+			throw HARPOON_EXCEPTION(exception::shared_memory_error, file_name, "Cannot write");
+		}
+	}
+
+	if (std::rename(temporary.c_str(), file_name.c_str()) != 0) {
+		std::remove(temporary.c_str());
+		throw HARPOON_EXCEPTION(exception::shared_memory_error, file_name, "Cannot write");
+	}
+}
+
+shared_memory_descriptor shared_memory_descriptor::read(const std::string &file_name) {
+	std::ifstream input(file_name);
+	if (!input) {
+		throw HARPOON_EXCEPTION(exception::shared_memory_error, file_name, "Cannot read");
+	}
+
+	shared_memory_descriptor descriptor;
+	std::string line;
+	for (std::size_t number = 1; std::getline(input, line); number++) {
+		if (line.empty() || line[0] == '#') {
+			continue;
+		}
+
+		std::istringstream fields(line);
+		std::string keyword;
+		address first, last;
+		region r;
+		fields >> keyword >> std::hex >> first >> last >> r.object;
+		if (!fields || keyword != "region" || last < first) {
+			throw HARPOON_EXCEPTION(exception::shared_memory_error, file_name,
+			                        "Bad region at line " + std::to_string(number));
+		}
+
+		/* The memory name is the rest of the line and may be empty. */
+		std::getline(fields, r.name);
+		r.name.erase(0, r.name.find_first_not_of(' '));
+		r.range = {first, last};
+		descriptor.add(r);
+	}
+	return descriptor;
+}
+
+} // namespace memory
+} // namespace harpoon
@@ -0,0 +1,122 @@
+#include "harpoon/memory/shared_storage.hh"
+
+#include "harpoon/memory/exception/shared_memory_error.hh"
+
+#include <cerrno>
+#include <cstring>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define HARPOON_MEMORY_SHARED_STORAGE_POSIX
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace harpoon {
+namespace memory {
+
+namespace {
+
+std::string object_name(const std::string &name) {
+	return !name.empty() && name[0] == '/' ? name : "/" + name;
+}
+
+} // namespace
+
+bool shared_storage::is_supported() {
+#ifdef HARPOON_MEMORY_SHARED_STORAGE_POSIX
+	return true;
+#else
+	return false;
+#endif
+}
+
+#ifdef HARPOON_MEMORY_SHARED_STORAGE_POSIX
+
+shared_storage::shared_storage(const std::string &name, std::size_t length, unsigned int mode)
+    : _name(object_name(name)), _length(length), _owner(true) {
+	int fd = ::shm_open(_name.c_str(), O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC,
+	                    static_cast<mode_t>(mode));
+	if (fd < 0) {
+		fail("shm_open");
+	}
+
+	if (::ftruncate(fd, static_cast<off_t>(_length)) != 0) {
+		int error = errno;
+		::close(fd);
+		::shm_unlink(_name.c_str());
+		errno = error;
+		fail("ftruncate");
+	}
+
+	try {
+		map(fd, PROT_READ | PROT_WRITE);
+	} catch (...) {
+		::shm_unlink(_name.c_str());
+		throw;
+	}
+}
+
+shared_storage::shared_storage(const std::string &name) : _name(object_name(name)) {
+	int fd = ::shm_open(_name.c_str(), O_RDONLY | O_CLOEXEC, 0);
+	if (fd < 0) {
+		fail("shm_open");
+	}
+
+	struct stat st;
+	if (::fstat(fd, &st) != 0) {
+		int error = errno;
+		::close(fd);
+		errno = error;
+		fail("fstat");
+	}
+	_length = static_cast<std::size_t>(st.st_size);
+	map(fd, PROT_READ);
+}
+
+shared_storage::~shared_storage() {
+	if (_data) {
+		::munmap(_data, _length);
+	}
+	if (_owner) {
+		::shm_unlink(_name.c_str());
+	}
+}
+
+/* The descriptor is not needed once the object is mapped. */
+void shared_storage::map(int fd, int protection) {
+	void *data = ::mmap(nullptr, _length, protection, MAP_SHARED, fd, 0);
+	int error = errno;
+	::close(fd);
+	if (data == MAP_FAILED) {
+		errno = error;
+		fail("mmap");
+	}
+	_data = static_cast<std::uint8_t *>(data);
+}
+
+#else
+
+shared_storage::shared_storage(const std::string &name, std::size_t length, unsigned int)
+    : _name(object_name(name)), _length(length) {
+	throw HARPOON_EXCEPTION(exception::shared_memory_error, _name, "Not supported");
+}
+
+shared_storage::shared_storage(const std::string &name) : _name(object_name(name)) {
+	throw HARPOON_EXCEPTION(exception::shared_memory_error, _name, "Not supported");
+}
+
+shared_storage::~shared_storage() {}
+
+void shared_storage::map(int, int) {}
+
+#endif
+
+void shared_storage::fail(const std::string &operation) const {
+	throw HARPOON_EXCEPTION(exception::shared_memory_error, _name,
+	                        operation + ": " + std::strerror(errno));
+}
+
+} // namespace memory
+} // namespace harpoon
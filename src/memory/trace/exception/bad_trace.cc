@@ -0,0 +1,24 @@
+#include "harpoon/memory/trace/exception/bad_trace.hh"
+
+#include <sstream>
+
+namespace harpoon {
+namespace memory {
+namespace trace {
+namespace exception {
+
+bad_trace::bad_trace(const std::string &trace_file, const std::string &reason,
+                     const std::string &file, int line, const std::string &function)
+    : harpoon::exception::harpoon_exception("", file, line, function) {
+	std::stringstream stream;
+	stream << "Bad memory trace: " << trace_file << ": " << reason;
+
+	set_what(stream.str());
+}
+
+bad_trace::~bad_trace() {}
+
+} // namespace exception
+} // namespace trace
+} // namespace memory
+} // namespace harpoon
@@ -0,0 +1,90 @@
+#include "harpoon/memory/trace/reader.hh"
+
+#include "harpoon/memory/trace/exception/bad_trace.hh"
+#include "harpoon/util/lz.hh"
+
+#include <cstring>
+
+namespace harpoon {
+namespace memory {
+namespace trace {
+
+namespace {
+
+bool read_u32(std::ifstream &input, std::uint32_t &v) {
+	unsigned char b[4];
+	if (!input.read(reinterpret_cast<char *>(b), sizeof(b))) {
+		return false;
+	}
+	v = static_cast<std::uint32_t>(b[0]) | (static_cast<std::uint32_t>(b[1]) << 8)
+	    | (static_cast<std::uint32_t>(b[2]) << 16) | (static_cast<std::uint32_t>(b[3]) << 24);
+	return true;
+}
+
+} // namespace
+
+reader::reader(const std::string &file_name) : _file_name(file_name) {
+	_input.open(_file_name, std::ios::binary);
+	if (!_input.good()) {
+		throw HARPOON_EXCEPTION(exception::bad_trace, _file_name, "Unable to open file");
+	}
+
+	char magic[sizeof(file_magic)];
+	std::uint32_t version;
+	if (!_input.read(magic, sizeof(magic)) || std::memcmp(magic, file_magic, sizeof(magic)) != 0
+	    || !read_u32(_input, version)) {
+		throw HARPOON_EXCEPTION(exception::bad_trace, _file_name, "Not a memory trace");
+	}
+	if (version != file_version) {
+		throw HARPOON_EXCEPTION(exception::bad_trace, _file_name, "Unsupported version");
+	}
+}
+
+reader::~reader() {}
+
+bool reader::next(record &record) {
+	while (_position == _block.size()) {
+		if (!read_block()) {
+			return false;
+		}
+	}
+	record = _block[_position++];
+	return true;
+}
+
+bool reader::read_block() {
+	std::uint32_t count, encoded_length, stored_length;
+	if (!read_u32(_input, count)) {
+		return false;
+	}
+	if (!read_u32(_input, encoded_length) || !read_u32(_input, stored_length)
+	    || stored_length > encoded_length) {
+		throw HARPOON_EXCEPTION(exception::bad_trace, _file_name, "Truncated block header");
+	}
+
+	_stored.resize(stored_length);
+	if (!_input.read(reinterpret_cast<char *>(_stored.data()), stored_length)) {
+		throw HARPOON_EXCEPTION(exception::bad_trace, _file_name, "Truncated block");
+	}
+
+	const std::uint8_t *encoded = _stored.data();
+	if (stored_length < encoded_length) {
+		_encoded.resize(encoded_length);
+		if (!util::lz::decompress(_stored.data(), stored_length, _encoded.data(),
+		                          encoded_length)) {
+			throw HARPOON_EXCEPTION(exception::bad_trace, _file_name, "Corrupted block");
+		}
+		encoded = _encoded.data();
+	}
+
+	_block.clear();
+	_position = 0;
+	if (!decode_block(encoded, encoded_length, count, _block)) {
+		throw HARPOON_EXCEPTION(exception::bad_trace, _file_name, "Corrupted block");
+	}
+	return true;
+}
+
+} // namespace trace
+} // namespace memory
+} // namespace harpoon
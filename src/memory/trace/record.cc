@@ -0,0 +1,115 @@
+#include "harpoon/memory/trace/record.hh"
+
+namespace harpoon {
+namespace memory {
+namespace trace {
+
+namespace {
+
+enum : std::uint8_t { UNIT_CHANGED = 0x10 };
+
+void put_varint(std::vector<std::uint8_t> &output, std::uint64_t v) {
+	while (v >= 0x80) {
+		output.push_back(static_cast<std::uint8_t>(v | 0x80));
+		v >>= 7;
+	}
+	output.push_back(static_cast<std::uint8_t>(v));
+}
+
+bool get_varint(const std::uint8_t *data, std::size_t length, std::size_t &ip, std::uint64_t &v) {
+	v = 0;
+	for (unsigned int shift = 0; shift < 64; shift += 7) {
+		if (ip >= length) {
+			return false;
+		}
+		std::uint8_t b = data[ip++];
+		v |= static_cast<std::uint64_t>(b & 0x7f) << shift;
+		if (!(b & 0x80)) {
+			return true;
+		}
+	}
+	return false;
+}
+
+std::uint64_t zigzag(std::uint64_t delta) {
+	return (delta << 1) ^ (0 - (delta >> 63));
+}
+
+std::uint64_t unzigzag(std::uint64_t v) {
+	return (v >> 1) ^ (0 - (v & 1));
+}
+
+std::uint8_t width_code(std::uint8_t width) {
+	switch (width) {
+	case 2: return 1;
+	case 4: return 2;
+	case 8: return 3;
+	default: return 0;
+	}
+}
+
+} // namespace
+
+void encode_block(const record *records, std::size_t count, std::vector<std::uint8_t> &output) {
+	record previous{};
+	for (std::size_t i = 0; i < count; i++) {
+		const record &r = records[i];
+		std::uint8_t header = static_cast<std::uint8_t>(static_cast<std::uint8_t>(r.kind) & 0x3);
+		header |= static_cast<std::uint8_t>(width_code(r.width) << 2);
+		if (r.unit != previous.unit) {
+			header |= UNIT_CHANGED;
+		}
+		output.push_back(header);
+		put_varint(output, zigzag(r.tick - previous.tick));
+		put_varint(output, zigzag(r.address - previous.address));
+		if (header & UNIT_CHANGED) {
+			put_varint(output, r.unit);
+		}
+		put_varint(output, r.value);
+		previous = r;
+	}
+}
+
+bool decode_block(const std::uint8_t *data, std::size_t length, std::size_t count,
+                  std::vector<record> &records) {
+	record previous{};
+	std::size_t ip = 0;
+	for (std::size_t i = 0; i < count; i++) {
+		if (ip >= length) {
+			return false;
+		}
+		std::uint8_t header = data[ip++];
+		if ((header & 0x3) > static_cast<std::uint8_t>(access_kind::FETCH)) {
+			return false;
+		}
+
+		record r = previous;
+		std::uint64_t v;
+		r.kind = static_cast<access_kind>(header & 0x3);
+		r.width = static_cast<std::uint8_t>(1 << ((header >> 2) & 0x3));
+		if (!get_varint(data, length, ip, v)) {
+			return false;
+		}
+		r.tick = previous.tick + unzigzag(v);
+		if (!get_varint(data, length, ip, v)) {
+			return false;
+		}
+		r.address = previous.address + unzigzag(v);
+		if (header & UNIT_CHANGED) {
+			if (!get_varint(data, length, ip, v)) {
+				return false;
+			}
+			r.unit = static_cast<std::uint16_t>(v);
+		}
+		if (!get_varint(data, length, ip, r.value)) {
+			return false;
+		}
+		records.push_back(r);
+		previous = r;
+	}
+	return ip == length;
+}
+
+} // namespace trace
+} // namespace memory
+} // namespace harpoon
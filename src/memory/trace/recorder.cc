@@ -0,0 +1,154 @@
+#include "harpoon/memory/trace/recorder.hh"
+
+#include "harpoon/memory/trace/exception/bad_trace.hh"
+#include "harpoon/util/lz.hh"
+
+#include <chrono>
+
+namespace harpoon {
+namespace memory {
+namespace trace {
+
+namespace {
+
+void write_u32(std::ofstream &output, std::uint32_t v) {
+	char b[4] = {static_cast<char>(v & 0xff), static_cast<char>((v >> 8) & 0xff),
+	             static_cast<char>((v >> 16) & 0xff), static_cast<char>((v >> 24) & 0xff)};
+	output.write(b, sizeof(b));
+}
+
+} // namespace
+
+recorder::recorder(const std::string &file_name, std::size_t ring_length,
+                   std::size_t block_length)
+    : _file_name(file_name), _block_length(block_length ? block_length : 1) {
+	std::size_t length = 2;
+	while (length < ring_length) {
+		length <<= 1;
+	}
+	_ring.resize(length);
+	_ring_mask = length - 1;
+	_block.resize(_block_length);
+
+	_output.exceptions(std::ofstream::badbit);
+	_output.open(_file_name, std::ios::binary | std::ios::trunc);
+	if (!_output.good()) {
+		throw HARPOON_EXCEPTION(exception::bad_trace, _file_name, "Unable to create file");
+	}
+	_output.write(file_magic, sizeof(file_magic));
+	write_u32(_output, file_version);
+
+	_thread = std::thread(&recorder::writer, this);
+}
+
+recorder::~recorder() {
+	try {
+		close();
+	} catch (...) {
+	}
+}
+
+void recorder::wait_for_space(std::uint64_t head) {
+	_cached_tail = _tail.load(std::memory_order_acquire);
+	while (head - _cached_tail >= _ring.size()) {
+		_wakeup.notify_one();
+		std::this_thread::yield();
+		_cached_tail = _tail.load(std::memory_order_acquire);
+	}
+}
+
+void recorder::flush() {
+	std::unique_lock<std::mutex> lk(_mutex);
+	std::uint64_t target = _head.load(std::memory_order_acquire);
+	_wakeup.notify_one();
+	_drained.wait(lk, [this, target] { return _synced >= target || !_thread.joinable(); });
+	if (_error) {
+		std::rethrow_exception(_error);
+	}
+}
+
+void recorder::close() {
+	{
+		std::lock_guard<std::mutex> lk(_mutex);
+		if (!_thread.joinable()) {
+			return;
+		}
+		_closing = true;
+	}
+	_wakeup.notify_one();
+	_thread.join();
+	_output.close();
+	if (_error) {
+		std::rethrow_exception(_error);
+	}
+}
+
+void recorder::writer() {
+	std::unique_lock<std::mutex> lk(_mutex);
+	for (;;) {
+		std::uint64_t tail = _tail.load(std::memory_order_relaxed);
+		std::uint64_t head = _head.load(std::memory_order_acquire);
+
+		if (head == tail) {
+			if (_synced != head) {
+				try {
+					if (!_error) {
+						_output.flush();
+					}
+				} catch (...) {
+					_error = std::current_exception();
+				}
+				_synced = head;
+				_drained.notify_all();
+			}
+			if (_closing) {
+				break;
+			}
+			_wakeup.wait_for(lk, std::chrono::milliseconds(10));
+			continue;
+		}
+		lk.unlock();
+
+		std::size_t count = static_cast<std::size_t>(
+		    std::min<std::uint64_t>(head - tail, static_cast<std::uint64_t>(_block_length)));
+		for (std::size_t i = 0; i < count; i++) {
+			_block[i] = _ring[(tail + i) & _ring_mask];
+		}
+		_tail.store(tail + count, std::memory_order_release);
+
+		std::exception_ptr error;
+		try {
+			write_block(count);
+		} catch (...) {
+			error = std::current_exception();
+		}
+
+		lk.lock();
+		if (error && !_error) {
+			_error = error;
+		}
+	}
+}
+
+void recorder::write_block(std::size_t count) {
+	if (_error) {
+		return;
+	}
+
+	_encoded.clear();
+	encode_block(_block.data(), count, _encoded);
+
+	_compressed.clear();
+	util::lz::compress(_encoded.data(), _encoded.size(), _compressed);
+	const auto &payload = _compressed.size() < _encoded.size() ? _compressed : _encoded;
+
+	write_u32(_output, static_cast<std::uint32_t>(count));
+	write_u32(_output, static_cast<std::uint32_t>(_encoded.size()));
+	write_u32(_output, static_cast<std::uint32_t>(payload.size()));
+	_output.write(reinterpret_cast<const char *>(payload.data()),
+	              static_cast<std::streamsize>(payload.size()));
+}
+
+} // namespace trace
+} // namespace memory
+} // namespace harpoon
@@ -0,0 +1,67 @@
+#include "harpoon/memory/write_journal.hh"
+
+#include "harpoon/execution/processing_unit.hh"
+#include "harpoon/memory/memory.hh"
+
+namespace harpoon {
+namespace memory {
+
+write_journal::write_journal(std::size_t capacity) : _entries(capacity ? capacity : 1) {}
+
+write_journal::~write_journal() {}
+
+void write_journal::set_processing_unit(
+    const std::shared_ptr<execution::processing_unit> &processing_unit) {
+	_processing_unit = processing_unit;
+}
+
+std::uint64_t write_journal::get_current_instruction() const {
+	auto processing_unit = _processing_unit.lock();
+	return processing_unit ? processing_unit->get_executed_instructions() : 0;
+}
+
+void write_journal::drop_oldest() {
+	_oldest_instruction = _entries[_first].instruction;
+	_first = (_first + 1) % _entries.size();
+	_size--;
+}
+
+bool write_journal::undo(memory &memory, std::uint64_t instructions) {
+	std::uint64_t current = get_current_instruction();
+	if (instructions > current) {
+		return false;
+	}
+	return undo_to(memory, current - instructions);
+}
+
+bool write_journal::undo_to(memory &memory, std::uint64_t instruction) {
+	if (instruction < _oldest_instruction) {
+		return false;
+	}
+
+	_suspended = true;
+	try {
+		while (_size > 0) {
+			const entry &e = _entries[(_first + _size - 1) % _entries.size()];
+			if (e.instruction <= instruction) {
+				break;
+			}
+			memory.set(e.address, e.value);
+			_size--;
+		}
+	} catch (...) {
+		_suspended = false;
+		throw;
+	}
+	_suspended = false;
+	return true;
+}
+
+void write_journal::clear() {
+	_first = 0;
+	_size = 0;
+	_oldest_instruction = get_current_instruction();
+}
+
+} // namespace memory
+} // namespace harpoon
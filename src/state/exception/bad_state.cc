@@ -0,0 +1,22 @@
+#include "harpoon/state/exception/bad_state.hh"
+
+#include <sstream>
+
+namespace harpoon {
+namespace state {
+namespace exception {
+
+bad_state::bad_state(const std::string &reason, const std::string &file, int line,
+                     const std::string &function)
+    : harpoon::exception::harpoon_exception("", file, line, function) {
+	std::stringstream stream;
+	stream << "Bad machine state: " << reason;
+
+	set_what(stream.str());
+}
+
+bad_state::~bad_state() {}
+
+} // namespace exception
+} // namespace state
+} // namespace harpoon
@@ -0,0 +1,17 @@
+#include "harpoon/state/machine_state.hh"
+
+#include "harpoon/util/hash.hh"
+
+namespace harpoon {
+namespace state {
+
+std::uint64_t machine_state::get_digest(
+    const std::vector<std::uint8_t> &components,
+    const std::vector<memory::memory::block_hash> &memory_hashes) {
+	std::uint64_t digests[] = {util::hash::hash64(components.data(), components.size()),
+	                           memory::memory::get_digest(memory_hashes)};
+	return util::hash::hash64(digests, sizeof(digests));
+}
+
+} // namespace state
+} // namespace harpoon
@@ -0,0 +1,51 @@
+#include "harpoon/state/reader.hh"
+
+#include "harpoon/state/exception/bad_state.hh"
+
+#include <cstring>
+
+namespace harpoon {
+namespace state {
+
+const std::uint8_t *reader::take(std::size_t length) {
+	if (length > _length - _position) {
+		throw HARPOON_EXCEPTION(exception::bad_state, "Truncated state");
+	}
+	const std::uint8_t *p = _data + _position;
+	_position += length;
+	return p;
+}
+
+void reader::read(void *data, std::size_t length) {
+	std::memcpy(data, take(length), length);
+}
+
+void reader::read(std::string &value) {
+	auto length = read<std::uint32_t>();
+	const std::uint8_t *p = take(length);
+	value.assign(reinterpret_cast<const char *>(p), length);
+}
+
+std::size_t reader::begin_section(const std::string &name) {
+	std::string found;
+	read(found);
+	if (found != name) {
+		throw HARPOON_EXCEPTION(exception::bad_state,
+		                        "Expected state of '" + name + "', found '" + found + "'");
+	}
+
+	auto length = read<std::uint32_t>();
+	if (length > _length - _position) {
+		throw HARPOON_EXCEPTION(exception::bad_state, "Truncated state of '" + name + "'");
+	}
+	return _position + length;
+}
+
+void reader::end_section(std::size_t mark) {
+	if (_position != mark) {
+		throw HARPOON_EXCEPTION(exception::bad_state, "Section length mismatch");
+	}
+}
+
+} // namespace state
+} // namespace harpoon
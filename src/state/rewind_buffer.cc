@@ -0,0 +1,263 @@
+#include "harpoon/state/rewind_buffer.hh"
+
+#include "harpoon/memory/deserializer/deserializer.hh"
+#include "harpoon/state/exception/bad_state.hh"
+#include "harpoon/util/bytes.hh"
+#include "harpoon/util/lz.hh"
+
+#include <algorithm>
+#include <cstring>
+
+namespace harpoon {
+namespace state {
+
+namespace {
+
+/* Longest run of shadow pages restored in one go. */
+constexpr std::size_t max_run_length = 16 * rewind_buffer::page_length;
+
+/* Serves a run of restored contents; zeros are reported so chunks can be released. */
+class run_reader : public memory::deserializer::deserializer {
+public:
+	run_reader(const memory::address_range &range, const std::uint8_t *data)
+	    : deserializer(range), _data(data) {}
+
+	virtual bool has_data(const memory::address_range &range) override {
+		memory::address_range r = has_range(range);
+		return r
+		       && !util::bytes::is_zero(_data + (r.get_start() - get_range().get_start()),
+		                                static_cast<std::size_t>(r.get_length()));
+	}
+
+	virtual bool is_concurrent() const override {
+		return true;
+	}
+
+protected:
+	virtual std::size_t do_read(const memory::memory *, std::uint8_t *data,
+	                            const memory::address_range &range) override {
+		memory::address_range r = has_range(range);
+		if (!r) {
+			return 0;
+		}
+		std::memcpy(data + (r.get_start() - range.get_start()),
+		            _data + (r.get_start() - get_range().get_start()),
+		            static_cast<std::size_t>(r.get_length()));
+		return static_cast<std::size_t>(r.get_length());
+	}
+
+private:
+	const std::uint8_t *_data;
+};
+
+} // namespace
+
+std::uint8_t *rewind_buffer::get_shadow(harpoon::memory::address start, bool allocate) {
+	auto page = start / page_length;
+	auto i = _shadow.find(page);
+	if (i != _shadow.end()) {
+		return i->second.get();
+	}
+	if (!allocate) {
+		return nullptr;
+	}
+	auto &data = _shadow[page];
+	data.reset(new std::uint8_t[page_length]());
+	return data.get();
+}
+
+void rewind_buffer::split(const std::vector<harpoon::memory::address_range> &ranges,
+                          std::vector<harpoon::memory::address_range> &pieces) const {
+	for (const auto &range : ranges) {
+		if (range.is_empty()) {
+			continue;
+		}
+		auto a = range.get_start();
+		for (;;) {
+			harpoon::memory::address page_end = a - a % page_length + (page_length - 1);
+			auto end = std::min(page_end, range.get_end());
+			pieces.emplace_back(a, end);
+			if (end == range.get_end()) {
+				break;
+			}
+			a = end + 1;
+		}
+	}
+}
+
+void rewind_buffer::capture(clock::tick_t tick, std::vector<std::uint8_t> &&components,
+                            harpoon::memory::memory &memory) {
+	/*
+	 * The first entry has nothing to go back to, so it only fills the shadow,
+	 * from all of the memory: what is not dirty now may still be written later.
+	 */
+	bool first = _entries.empty();
+	std::vector<harpoon::memory::address_range> ranges, pieces;
+	if (first) {
+		memory.get_mapped(ranges);
+	} else {
+		memory.get_dirty_since(_epoch, ranges);
+	}
+	split(ranges, pieces);
+	_epoch = harpoon::memory::memory::start_dirty_epoch();
+
+	entry e{tick, std::move(components), {}, 0};
+	for (const auto &piece : pieces) {
+		auto length = static_cast<std::size_t>(piece.get_length());
+		auto offset = piece.get_start() % page_length;
+		_current.resize(length);
+		memory.read(piece, _current.data());
+
+		std::uint8_t *shadow = get_shadow(piece.get_start(), false);
+		if (!first) {
+			_xor.resize(length);
+			for (std::size_t i = 0; i < length; i++) {
+				_xor[i] = shadow ? static_cast<std::uint8_t>(shadow[offset + i] ^ _current[i])
+				                 : _current[i];
+			}
+			if (!util::bytes::is_zero(_xor.data(), length)) {
+				delta d{piece.get_start(), length, false, {}};
+				util::lz::compress(_xor.data(), length, d.data);
+				if (d.data.size() >= length) {
+					d.raw = true;
+					d.data = _xor;
+				}
+				e.length += d.data.size();
+				e.deltas.push_back(std::move(d));
+			}
+		}
+
+		if (shadow || !util::bytes::is_zero(_current.data(), length)) {
+			shadow = get_shadow(piece.get_start(), true);
+			std::memcpy(shadow + offset, _current.data(), length);
+		}
+	}
+
+	e.length += e.components.size();
+	_used += e.length;
+	_entries.push_back(std::move(e));
+
+	while (_used > _budget && _entries.size() > 1) {
+		_used -= _entries.front().length;
+		_entries.pop_front();
+	}
+	/* Deltas of the oldest entry lead to a state that is gone. */
+	drop_deltas(_entries.front());
+}
+
+void rewind_buffer::drop_deltas(entry &entry) {
+	for (const auto &d : entry.deltas) {
+		entry.length -= d.data.size();
+		_used -= d.data.size();
+	}
+	entry.deltas.clear();
+}
+
+void rewind_buffer::apply(const delta &delta) {
+	_xor.resize(delta.length);
+	if (delta.raw) {
+		std::memcpy(_xor.data(), delta.data.data(), delta.length);
+	} else {
+		if (!util::lz::decompress(delta.data.data(), delta.data.size(), _xor.data(),
+		                          delta.length)) {
+			throw HARPOON_EXCEPTION(exception::bad_state, "Corrupt rewind delta");
+		}
+	}
+
+	std::uint8_t *shadow = get_shadow(delta.start, true) + delta.start % page_length;
+	for (std::size_t i = 0; i < delta.length; i++) {
+		shadow[i] ^= _xor[i];
+	}
+}
+
+bool rewind_buffer::restore(clock::tick_t tick, harpoon::memory::memory &memory,
+                            std::vector<std::uint8_t> &components) {
+	std::size_t target = _entries.size();
+	while (target > 0 && _entries[target - 1].tick > tick) {
+		target--;
+	}
+	if (target == 0) {
+		return false;
+	}
+	target--;
+
+	/* Ranges written since the newest entry are put back from the shadow too. */
+	std::vector<harpoon::memory::address_range> dirty, pieces;
+	memory.get_dirty_since(_epoch, dirty);
+	split(dirty, pieces);
+
+	/* XOR undoes itself, so a corrupt delta takes back the ones applied before it. */
+	std::vector<const delta *> applied;
+	try {
+		for (std::size_t i = _entries.size() - 1; i > target; i--) {
+			for (const auto &d : _entries[i].deltas) {
+				apply(d);
+				applied.push_back(&d);
+				pieces.emplace_back(d.start, d.start + (d.length - 1));
+			}
+		}
+	} catch (...) {
+		for (auto d = applied.rbegin(); d != applied.rend(); ++d) {
+			apply(**d);
+		}
+		throw;
+	}
+
+	for (std::size_t i = _entries.size() - 1; i > target; i--) {
+		_used -= _entries[i].length;
+	}
+	_entries.erase(_entries.begin() + static_cast<std::ptrdiff_t>(target + 1), _entries.end());
+
+	write(memory, pieces);
+	_epoch = harpoon::memory::memory::start_dirty_epoch();
+
+	components = _entries.back().components;
+	return true;
+}
+
+/* Pieces are written in runs of adjacent ones, each restored like a snapshot. */
+void rewind_buffer::write(harpoon::memory::memory &memory,
+                          std::vector<harpoon::memory::address_range> &pieces) {
+	std::sort(pieces.begin(), pieces.end(),
+	          [](const harpoon::memory::address_range &a, const harpoon::memory::address_range &b) {
+		          return a.get_start() < b.get_start();
+	          });
+
+	std::size_t i = 0;
+	while (i < pieces.size()) {
+		harpoon::memory::address start = pieces[i].get_start(), end = pieces[i].get_end();
+		_current.clear();
+		for (; i < pieces.size() && pieces[i].get_start() <= end + 1; i++) {
+			if (pieces[i].get_end() <= end && !_current.empty()) {
+				continue;
+			}
+			if (!_current.empty() && end - start + 1 >= max_run_length) {
+				break;
+			}
+
+			/* Pieces never cross a shadow page, so each is one copy. */
+			harpoon::memory::address from = _current.empty() ? start : end + 1;
+			end = std::max(end, pieces[i].get_end());
+			auto length = static_cast<std::size_t>(end - from + 1);
+			const std::uint8_t *shadow = get_shadow(from, false);
+			if (shadow) {
+				shadow += from % page_length;
+				_current.insert(_current.end(), shadow, shadow + length);
+			} else {
+				_current.resize(_current.size() + length);
+			}
+		}
+
+		run_reader reader({start, end}, _current.data());
+		memory.deserialize(reader);
+	}
+}
+
+void rewind_buffer::clear() {
+	_entries.clear();
+	_shadow.clear();
+	_used = 0;
+}
+
+} // namespace state
+} // namespace harpoon
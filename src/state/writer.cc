@@ -0,0 +1,31 @@
+#include "harpoon/state/writer.hh"
+
+namespace harpoon {
+namespace state {
+
+void writer::write(const void *data, std::size_t length) {
+	auto p = static_cast<const std::uint8_t *>(data);
+	_output.insert(_output.end(), p, p + length);
+}
+
+void writer::write(const std::string &value) {
+	write(static_cast<std::uint32_t>(value.size()));
+	write(value.data(), value.size());
+}
+
+std::size_t writer::begin_section(const std::string &name) {
+	write(name);
+	std::size_t mark = _output.size();
+	write(std::uint32_t{0});
+	return mark;
+}
+
+void writer::end_section(std::size_t mark) {
+	auto length = static_cast<std::uint32_t>(_output.size() - mark - sizeof(std::uint32_t));
+	for (std::size_t i = 0; i < sizeof(length); i++) {
+		_output[mark + i] = static_cast<std::uint8_t>(length >> (8 * i));
+	}
+}
+
+} // namespace state
+} // namespace harpoon
@@ -0,0 +1,38 @@
+#include "harpoon/util/buffer_pool.hh"
+
+namespace harpoon {
+namespace util {
+
+buffer_pool::~buffer_pool() {}
+
+buffer_pool::buffer buffer_pool::acquire() {
+	{
+		std::lock_guard<std::mutex> lk(_mutex);
+		if (!_free.empty()) {
+			buffer b = std::move(_free.back());
+			_free.pop_back();
+			return b;
+		}
+	}
+	return buffer(new std::uint8_t[_buffer_length]);
+}
+
+void buffer_pool::release(buffer &&buffer) {
+	std::lock_guard<std::mutex> lk(_mutex);
+	if (buffer && (_free.size() + 1) * _buffer_length <= _max_free_bytes) {
+		_free.push_back(std::move(buffer));
+	}
+}
+
+std::size_t buffer_pool::get_free() const {
+	std::lock_guard<std::mutex> lk(_mutex);
+	return _free.size();
+}
+
+const buffer_pool_ptr &get_buffer_pool() {
+	static const buffer_pool_ptr pool = make_buffer_pool();
+	return pool;
+}
+
+} // namespace util
+} // namespace harpoon
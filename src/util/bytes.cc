@@ -0,0 +1,288 @@
+#include "harpoon/util/bytes.hh"
+
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define HARPOON_UTIL_BYTES_X86
+#include <immintrin.h>
+#endif
+
+namespace harpoon {
+namespace util {
+namespace bytes {
+
+namespace {
+
+using first_nonzero_fn = std::size_t (*)(const std::uint8_t *, std::size_t);
+using first_difference_fn = std::size_t (*)(const std::uint8_t *, const std::uint8_t *,
+                                            std::size_t);
+using pattern_fn = std::size_t (*)(const std::uint8_t *, std::size_t, const std::uint8_t *,
+                                   const std::uint8_t *, std::size_t, std::size_t);
+
+struct kernels {
+	first_nonzero_fn first_nonzero;
+	first_difference_fn first_difference;
+	pattern_fn pattern;
+};
+
+inline std::uint8_t mask_at(const std::uint8_t *mask, std::size_t k) {
+	return mask ? mask[k] : 0xff;
+}
+
+inline bool matches(const std::uint8_t *data, const std::uint8_t *pattern,
+                    const std::uint8_t *mask, std::size_t pattern_length) {
+	for (std::size_t k = 0; k < pattern_length; k++) {
+		std::uint8_t m = mask_at(mask, k);
+		if ((data[k] & m) != (pattern[k] & m)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+std::size_t scalar_first_nonzero(const std::uint8_t *data, std::size_t length) {
+	std::size_t i = 0;
+	for (; i + sizeof(std::uint64_t) <= length; i += sizeof(std::uint64_t)) {
+		std::uint64_t w;
+		std::memcpy(&w, data + i, sizeof(w));
+		if (w) {
+			break;
+		}
+	}
+	for (; i < length; i++) {
+		if (data[i]) {
+			return i;
+		}
+	}
+	return length;
+}
+
+std::size_t scalar_first_difference(const std::uint8_t *a, const std::uint8_t *b,
+                                    std::size_t length) {
+	std::size_t i = 0;
+	for (; i + sizeof(std::uint64_t) <= length; i += sizeof(std::uint64_t)) {
+		std::uint64_t wa, wb;
+		std::memcpy(&wa, a + i, sizeof(wa));
+		std::memcpy(&wb, b + i, sizeof(wb));
+		if (wa != wb) {
+			break;
+		}
+	}
+	for (; i < length; i++) {
+		if (a[i] != b[i]) {
+			return i;
+		}
+	}
+	return length;
+}
+
+/* Candidates are located by the anchor byte, then verified in full. */
+std::size_t scalar_pattern(const std::uint8_t *data, std::size_t length,
+                           const std::uint8_t *pattern, const std::uint8_t *mask,
+                           std::size_t pattern_length, std::size_t anchor) {
+	std::uint8_t m = mask_at(mask, anchor);
+	std::uint8_t p = pattern[anchor] & m;
+	for (std::size_t i = 0; i + pattern_length <= length; i++) {
+		if ((data[i + anchor] & m) == p && matches(data + i, pattern, mask, pattern_length)) {
+			return i;
+		}
+	}
+	return length;
+}
+
+#ifdef HARPOON_UTIL_BYTES_X86
+
+__attribute__((target("sse2"))) std::size_t sse2_first_nonzero(const std::uint8_t *data,
+                                                               std::size_t length) {
+	const __m128i zero = _mm_setzero_si128();
+	std::size_t i = 0;
+	for (; i + 16 <= length; i += 16) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+		unsigned int m = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(v, zero)));
+		if (m != 0xffff) {
+			return i + static_cast<std::size_t>(__builtin_ctz(~m & 0xffff));
+		}
+	}
+	return i + scalar_first_nonzero(data + i, length - i);
+}
+
+__attribute__((target("sse2"))) std::size_t sse2_first_difference(const std::uint8_t *a,
+                                                                  const std::uint8_t *b,
+                                                                  std::size_t length) {
+	std::size_t i = 0;
+	for (; i + 16 <= length; i += 16) {
+		__m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i *>(a + i));
+		__m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i *>(b + i));
+		unsigned int m = static_cast<unsigned int>(_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)));
+		if (m != 0xffff) {
+			return i + static_cast<std::size_t>(__builtin_ctz(~m & 0xffff));
+		}
+	}
+	return i + scalar_first_difference(a + i, b + i, length - i);
+}
+
+__attribute__((target("sse2"))) std::size_t
+sse2_pattern(const std::uint8_t *data, std::size_t length, const std::uint8_t *pattern,
+             const std::uint8_t *mask, std::size_t pattern_length, std::size_t anchor) {
+	const std::uint8_t m = mask_at(mask, anchor);
+	const __m128i vm = _mm_set1_epi8(static_cast<char>(m));
+	const __m128i vp = _mm_set1_epi8(static_cast<char>(pattern[anchor] & m));
+	const std::size_t starts = length - pattern_length + 1;
+
+	std::size_t i = 0;
+	for (; i + 16 <= starts; i += 16) {
+		__m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i + anchor));
+		unsigned int bits = static_cast<unsigned int>(
+		    _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_and_si128(v, vm), vp)));
+		while (bits) {
+			std::size_t c = i + static_cast<std::size_t>(__builtin_ctz(bits));
+			if (matches(data + c, pattern, mask, pattern_length)) {
+				return c;
+			}
+			bits &= bits - 1;
+		}
+	}
+	std::size_t r = scalar_pattern(data + i, length - i, pattern, mask, pattern_length, anchor);
+	return r == length - i ? length : i + r;
+}
+
+__attribute__((target("avx2"))) std::size_t avx2_first_nonzero(const std::uint8_t *data,
+                                                               std::size_t length) {
+	const __m256i zero = _mm256_setzero_si256();
+	std::size_t i = 0;
+	for (; i + 64 <= length; i += 64) {
+		__m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+		__m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i + 32));
+		__m256i v = _mm256_or_si256(v0, v1);
+		if (!_mm256_testz_si256(v, v)) {
+			break;
+		}
+	}
+	for (; i + 32 <= length; i += 32) {
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+		unsigned int m
+		    = static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, zero)));
+		if (m != 0xffffffff) {
+			return i + static_cast<std::size_t>(__builtin_ctz(~m));
+		}
+	}
+	return i + scalar_first_nonzero(data + i, length - i);
+}
+
+__attribute__((target("avx2"))) std::size_t avx2_first_difference(const std::uint8_t *a,
+                                                                  const std::uint8_t *b,
+                                                                  std::size_t length) {
+	std::size_t i = 0;
+	for (; i + 32 <= length; i += 32) {
+		__m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(a + i));
+		__m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(b + i));
+		unsigned int m
+		    = static_cast<unsigned int>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(va, vb)));
+		if (m != 0xffffffff) {
+			return i + static_cast<std::size_t>(__builtin_ctz(~m));
+		}
+	}
+	return i + scalar_first_difference(a + i, b + i, length - i);
+}
+
+__attribute__((target("avx2"))) std::size_t
+avx2_pattern(const std::uint8_t *data, std::size_t length, const std::uint8_t *pattern,
+             const std::uint8_t *mask, std::size_t pattern_length, std::size_t anchor) {
+	const std::uint8_t m = mask_at(mask, anchor);
+	const __m256i vm = _mm256_set1_epi8(static_cast<char>(m));
+	const __m256i vp = _mm256_set1_epi8(static_cast<char>(pattern[anchor] & m));
+	const std::size_t starts = length - pattern_length + 1;
+
+	std::size_t i = 0;
+	for (; i + 32 <= starts; i += 32) {
+		__m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i + anchor));
+		unsigned int bits = static_cast<unsigned int>(
+		    _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_and_si256(v, vm), vp)));
+		while (bits) {
+			std::size_t c = i + static_cast<std::size_t>(__builtin_ctz(bits));
+			if (matches(data + c, pattern, mask, pattern_length)) {
+				return c;
+			}
+			bits &= bits - 1;
+		}
+	}
+	std::size_t r = scalar_pattern(data + i, length - i, pattern, mask, pattern_length, anchor);
+	return r == length - i ? length : i + r;
+}
+
+#endif
+
+kernels select_kernels() {
+#ifdef HARPOON_UTIL_BYTES_X86
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		return {avx2_first_nonzero, avx2_first_difference, avx2_pattern};
+	}
+	if (__builtin_cpu_supports("sse2")) {
+		return {sse2_first_nonzero, sse2_first_difference, sse2_pattern};
+	}
+#endif
+	return {scalar_first_nonzero, scalar_first_difference, scalar_pattern};
+}
+
+const kernels &get_kernels() {
+	static const kernels k = select_kernels();
+	return k;
+}
+
+} // namespace
+
+std::size_t find_first_nonzero(const std::uint8_t *data, std::size_t length) {
+	return get_kernels().first_nonzero(data, length);
+}
+
+std::size_t find_first_difference(const std::uint8_t *a, const std::uint8_t *b,
+                                  std::size_t length) {
+	return get_kernels().first_difference(a, b, length);
+}
+
+std::size_t find_pattern(const std::uint8_t *data, std::size_t length, const std::uint8_t *pattern,
+                         const std::uint8_t *mask, std::size_t pattern_length) {
+	if (pattern_length == 0) {
+		return 0;
+	}
+	if (pattern_length > length) {
+		return length;
+	}
+
+	/*
+	 * Anchor on the first fully significant byte other than 0x00 and 0xff,
+	 * which fill most of guest memory; failing that, on the first fully
+	 * significant byte, then on the first byte with any significant bits.
+	 */
+	std::size_t anchor = pattern_length, fixed = pattern_length, partial = pattern_length;
+	for (std::size_t k = 0; k < pattern_length; k++) {
+		std::uint8_t m = mask_at(mask, k);
+		if (m == 0xff && pattern[k] != 0x00 && pattern[k] != 0xff) {
+			anchor = k;
+			break;
+		}
+		if (m == 0xff && fixed == pattern_length) {
+			fixed = k;
+		}
+		if (m && partial == pattern_length) {
+			partial = k;
+		}
+	}
+	if (anchor == pattern_length) {
+		anchor = fixed != pattern_length ? fixed : partial;
+	}
+	if (anchor == pattern_length) {
+		return 0;
+	}
+
+	return get_kernels().pattern(data, length, pattern, mask, pattern_length, anchor);
+}
+
+void fill(std::uint8_t *data, std::size_t length, std::uint8_t value) {
+	std::memset(data, value, length);
+}
+
+} // namespace bytes
+} // namespace util
+} // namespace harpoon
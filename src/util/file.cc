@@ -0,0 +1,299 @@
+#include "harpoon/util/file.hh"
+
+#include <algorithm>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define HARPOON_UTIL_FILE_POSIX
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+namespace harpoon {
+namespace util {
+
+namespace {
+
+constexpr std::size_t zeros_length = 65536;
+
+#ifdef HARPOON_UTIL_FILE_POSIX
+constexpr std::size_t max_iovecs = 64;
+#endif
+
+} // namespace
+
+#ifdef HARPOON_UTIL_FILE_POSIX
+
+bool file::open(const std::string &name, Mode mode) {
+	close();
+	if (mode == Mode::WRITE) {
+		_fd = ::open(name.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+	} else {
+		_fd = ::open(name.c_str(), O_RDONLY | O_CLOEXEC);
+	}
+	_seek_data.store(true, std::memory_order_relaxed);
+	return _fd >= 0;
+}
+
+void file::close() {
+	if (_fd >= 0) {
+		::close(_fd);
+		_fd = -1;
+	}
+}
+
+bool file::is_open() const {
+	return _fd >= 0;
+}
+
+bool file::get_length(std::uint64_t &length) {
+	struct stat st;
+	if (::fstat(_fd, &st) != 0) {
+		return false;
+	}
+	length = static_cast<std::uint64_t>(st.st_size);
+	return true;
+}
+
+bool file::read(void *data, std::size_t length, std::size_t &done) {
+	for (;;) {
+		ssize_t n = ::read(_fd, data, length);
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n < 0) {
+			return false;
+		}
+		done = static_cast<std::size_t>(n);
+		return true;
+	}
+}
+
+bool file::read_at(void *data, std::size_t length, std::uint64_t offset, std::size_t &done) {
+	std::uint8_t *p = static_cast<std::uint8_t *>(data);
+	done = 0;
+	while (done < length) {
+		ssize_t n = ::pread(_fd, p + done, length - done, static_cast<off_t>(offset + done));
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n < 0) {
+			return false;
+		}
+		if (n == 0) {
+			break;
+		}
+		done += static_cast<std::size_t>(n);
+	}
+	return true;
+}
+
+bool file::write_at(const void *data, std::size_t length, std::uint64_t offset) {
+	const std::uint8_t *p = static_cast<const std::uint8_t *>(data);
+	while (length) {
+		ssize_t n = ::pwrite(_fd, p, length, static_cast<off_t>(offset));
+		if (n < 0 && errno == EINTR) {
+			continue;
+		}
+		if (n <= 0) {
+			return false;
+		}
+		p += n;
+		offset += static_cast<std::uint64_t>(n);
+		length -= static_cast<std::size_t>(n);
+	}
+	return true;
+}
+
+bool file::write_at(const piece *pieces, std::size_t count, std::uint64_t offset) {
+	struct iovec iov[max_iovecs];
+	std::size_t index = 0, skip = 0;
+	while (index < count) {
+		std::size_t n = 0;
+		for (std::size_t i = index; i < count && n < max_iovecs; i++, n++) {
+			std::size_t s = i == index ? skip : 0;
+			iov[n].iov_base = const_cast<std::uint8_t *>(
+			    static_cast<const std::uint8_t *>(pieces[i].data) + s);
+			iov[n].iov_len = pieces[i].length - s;
+		}
+
+		ssize_t w = ::pwritev(_fd, iov, static_cast<int>(n), static_cast<off_t>(offset));
+		if (w < 0 && errno == EINTR) {
+			continue;
+		}
+		if (w <= 0) {
+			return false;
+		}
+
+		std::size_t left = static_cast<std::size_t>(w);
+		offset += left;
+		while (index < count && left >= pieces[index].length - skip) {
+			left -= pieces[index].length - skip;
+			skip = 0;
+			index++;
+		}
+		skip += left;
+	}
+	return true;
+}
+
+bool file::extend(std::uint64_t length) {
+	std::uint64_t current;
+	if (!get_length(current)) {
+		return false;
+	}
+	return current >= length || ::ftruncate(_fd, static_cast<off_t>(length)) == 0;
+}
+
+bool file::zero(std::uint64_t offset, std::uint64_t length) {
+#ifdef FALLOC_FL_PUNCH_HOLE
+	if (::fallocate(_fd, FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE, static_cast<off_t>(offset),
+	                static_cast<off_t>(length))
+	    == 0) {
+		return true;
+	}
+#endif
+	return write_zeros(offset, length);
+}
+
+bool file::find_data(std::uint64_t &start, std::uint64_t &end, std::uint64_t limit) {
+	end = limit;
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+	if (_seek_data.load(std::memory_order_relaxed)) {
+		off_t data = ::lseek(_fd, static_cast<off_t>(start), SEEK_DATA);
+		if (data < 0) {
+			if (errno == ENXIO) {
+				return false;
+			}
+			_seek_data.store(false, std::memory_order_relaxed);
+			return true;
+		}
+		if (static_cast<std::uint64_t>(data) >= limit) {
+			return false;
+		}
+		start = static_cast<std::uint64_t>(data);
+
+		off_t hole = ::lseek(_fd, data, SEEK_HOLE);
+		if (hole >= 0) {
+			end = std::min(limit, static_cast<std::uint64_t>(hole));
+		}
+	}
+#endif
+	return true;
+}
+
+#else
+
+bool file::open(const std::string &name, Mode mode) {
+	close();
+	if (mode == Mode::WRITE) {
+		_stream.open(name, std::ios::binary | std::ios::in | std::ios::out | std::ios::trunc);
+	} else {
+		_stream.open(name, std::ios::binary | std::ios::in);
+	}
+	_position = 0;
+	return _stream.is_open();
+}
+
+void file::close() {
+	if (_stream.is_open()) {
+		_stream.close();
+	}
+	_stream.clear();
+}
+
+bool file::is_open() const {
+	return _stream.is_open();
+}
+
+bool file::get_length(std::uint64_t &length) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	_stream.clear();
+	_stream.seekg(0, std::ios::end);
+	std::streamoff end = _stream.tellg();
+	if (end < 0) {
+		return false;
+	}
+	length = static_cast<std::uint64_t>(end);
+	return true;
+}
+
+bool file::read(void *data, std::size_t length, std::size_t &done) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	_stream.clear();
+	_stream.seekg(static_cast<std::streamoff>(_position));
+	_stream.read(static_cast<char *>(data), static_cast<std::streamsize>(length));
+	done = static_cast<std::size_t>(_stream.gcount());
+	_position += done;
+	return !_stream.bad();
+}
+
+bool file::read_at(void *data, std::size_t length, std::uint64_t offset, std::size_t &done) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	_stream.clear();
+	_stream.seekg(static_cast<std::streamoff>(offset));
+	_stream.read(static_cast<char *>(data), static_cast<std::streamsize>(length));
+	done = static_cast<std::size_t>(_stream.gcount());
+	return !_stream.bad();
+}
+
+bool file::write_at(const void *data, std::size_t length, std::uint64_t offset) {
+	std::lock_guard<std::mutex> lock(_mutex);
+	_stream.clear();
+	_stream.seekp(static_cast<std::streamoff>(offset));
+	_stream.write(static_cast<const char *>(data), static_cast<std::streamsize>(length));
+	return !_stream.fail();
+}
+
+bool file::write_at(const piece *pieces, std::size_t count, std::uint64_t offset) {
+	for (std::size_t i = 0; i < count; i++) {
+		if (!write_at(pieces[i].data, pieces[i].length, offset)) {
+			return false;
+		}
+		offset += pieces[i].length;
+	}
+	return true;
+}
+
+bool file::extend(std::uint64_t length) {
+	std::uint64_t current;
+	if (!get_length(current)) {
+		return false;
+	}
+	const char zero = 0;
+	return current >= length || write_at(&zero, 1, length - 1);
+}
+
+bool file::zero(std::uint64_t offset, std::uint64_t length) {
+	return write_zeros(offset, length);
+}
+
+bool file::find_data(std::uint64_t &, std::uint64_t &end, std::uint64_t limit) {
+	end = limit;
+	return true;
+}
+
+#endif
+
+bool file::write_zeros(std::uint64_t offset, std::uint64_t length) {
+	static const std::vector<std::uint8_t> zeros(zeros_length);
+	while (length) {
+		std::size_t n = static_cast<std::size_t>(std::min<std::uint64_t>(length, zeros.size()));
+		if (!write_at(zeros.data(), n, offset)) {
+			return false;
+		}
+		offset += n;
+		length -= n;
+	}
+	return true;
+}
+
+file::~file() {
+	close();
+}
+
+} // namespace util
+} // namespace harpoon
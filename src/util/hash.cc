@@ -0,0 +1,102 @@
+#include "harpoon/util/hash.hh"
+
+#include <cstring>
+
+namespace harpoon {
+namespace util {
+namespace hash {
+
+namespace {
+
+constexpr std::uint64_t prime1 = 11400714785074694791ULL;
+constexpr std::uint64_t prime2 = 14029467366897019727ULL;
+constexpr std::uint64_t prime3 = 1609587929392839161ULL;
+constexpr std::uint64_t prime4 = 9650029242287828579ULL;
+constexpr std::uint64_t prime5 = 2870177450012600261ULL;
+
+inline std::uint64_t rotl(std::uint64_t v, unsigned int r) {
+	return (v << r) | (v >> (64 - r));
+}
+
+/* Little-endian loads, so the hash is the same on every host. */
+inline std::uint64_t read64(const std::uint8_t *p) {
+	std::uint64_t v = 0;
+	for (unsigned int i = 0; i < 8; i++) {
+		v |= static_cast<std::uint64_t>(p[i]) << (i * 8);
+	}
+	return v;
+}
+
+inline std::uint32_t read32(const std::uint8_t *p) {
+	return static_cast<std::uint32_t>(p[0]) | (static_cast<std::uint32_t>(p[1]) << 8)
+	       | (static_cast<std::uint32_t>(p[2]) << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+}
+
+inline std::uint64_t round(std::uint64_t acc, std::uint64_t input) {
+	acc += input * prime2;
+	acc = rotl(acc, 31);
+	return acc * prime1;
+}
+
+inline std::uint64_t merge_round(std::uint64_t acc, std::uint64_t value) {
+	acc ^= round(0, value);
+	return acc * prime1 + prime4;
+}
+
+} // namespace
+
+std::uint64_t hash64(const void *data, std::size_t length, std::uint64_t seed) {
+	const std::uint8_t *p = static_cast<const std::uint8_t *>(data);
+	const std::uint8_t *end = p + length;
+	std::uint64_t h;
+
+	if (length >= 32) {
+		std::uint64_t v1 = seed + prime1 + prime2;
+		std::uint64_t v2 = seed + prime2;
+		std::uint64_t v3 = seed;
+		std::uint64_t v4 = seed - prime1;
+		const std::uint8_t *limit = end - 32;
+		do {
+			v1 = round(v1, read64(p));
+			v2 = round(v2, read64(p + 8));
+			v3 = round(v3, read64(p + 16));
+			v4 = round(v4, read64(p + 24));
+			p += 32;
+		} while (p <= limit);
+
+		h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+		h = merge_round(h, v1);
+		h = merge_round(h, v2);
+		h = merge_round(h, v3);
+		h = merge_round(h, v4);
+	} else {
+		h = seed + prime5;
+	}
+
+	h += static_cast<std::uint64_t>(length);
+
+	for (; p + 8 <= end; p += 8) {
+		h ^= round(0, read64(p));
+		h = rotl(h, 27) * prime1 + prime4;
+	}
+	if (p + 4 <= end) {
+		h ^= static_cast<std::uint64_t>(read32(p)) * prime1;
+		h = rotl(h, 23) * prime2 + prime3;
+		p += 4;
+	}
+	for (; p < end; p++) {
+		h ^= *p * prime5;
+		h = rotl(h, 11) * prime1;
+	}
+
+	h ^= h >> 33;
+	h *= prime2;
+	h ^= h >> 29;
+	h *= prime3;
+	h ^= h >> 32;
+	return h;
+}
+
+} // namespace hash
+} // namespace util
+} // namespace harpoon
@@ -0,0 +1,171 @@
+#include "harpoon/util/lz.hh"
+
+#include <cstring>
+
+namespace harpoon {
+namespace util {
+namespace lz {
+
+namespace {
+
+constexpr unsigned int hash_bits = 14;
+constexpr std::size_t min_match = 4;
+constexpr std::size_t max_offset = 65535;
+
+/* Matches never start in the last 12 bytes and never cover the last 5. */
+constexpr std::size_t match_start_limit = 12;
+constexpr std::size_t match_end_limit = 5;
+
+inline std::uint32_t read32(const std::uint8_t *p) {
+	std::uint32_t v;
+	std::memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+inline std::uint32_t hash(std::uint32_t v) {
+	return (v * 2654435761U) >> (32 - hash_bits);
+}
+
+void write_length(std::vector<std::uint8_t> &output, std::size_t length) {
+	while (length >= 255) {
+		output.push_back(255);
+		length -= 255;
+	}
+	output.push_back(static_cast<std::uint8_t>(length));
+}
+
+void write_sequence(std::vector<std::uint8_t> &output, const std::uint8_t *literals,
+                    std::size_t literal_length, std::size_t offset, std::size_t match_length) {
+	std::size_t ml = match_length ? match_length - min_match : 0;
+	output.push_back(static_cast<std::uint8_t>(((literal_length < 15 ? literal_length : 15) << 4)
+	                                           | (ml < 15 ? ml : 15)));
+	if (literal_length >= 15) {
+		write_length(output, literal_length - 15);
+	}
+	output.insert(output.end(), literals, literals + literal_length);
+	if (!match_length) {
+		return;
+	}
+	output.push_back(static_cast<std::uint8_t>(offset & 0xff));
+	output.push_back(static_cast<std::uint8_t>((offset >> 8) & 0xff));
+	if (ml >= 15) {
+		write_length(output, ml - 15);
+	}
+}
+
+bool read_length(const std::uint8_t *data, std::size_t length, std::size_t &ip,
+                 std::size_t &value) {
+	std::uint8_t b;
+	do {
+		if (ip >= length) {
+			return false;
+		}
+		b = data[ip++];
+		value += b;
+	} while (b == 255);
+	return true;
+}
+
+} // namespace
+
+std::size_t compress_bound(std::size_t length) {
+	return length + length / 255 + 16;
+}
+
+std::size_t compress(const std::uint8_t *data, std::size_t length,
+                     std::vector<std::uint8_t> &output) {
+	std::size_t start = output.size();
+	output.reserve(start + compress_bound(length));
+
+	std::size_t anchor = 0;
+	if (length > match_start_limit) {
+		std::vector<std::uint32_t> table(std::size_t{1} << hash_bits, 0);
+		std::size_t limit = length - match_start_limit;
+		std::size_t ip = 0;
+
+		while (ip < limit) {
+			std::uint32_t sequence = read32(data + ip);
+			std::uint32_t &slot = table[hash(sequence)];
+			std::size_t ref = slot;
+			slot = static_cast<std::uint32_t>(ip + 1);
+
+			if (ref == 0 || ip + 1 - ref > max_offset || read32(data + ref - 1) != sequence) {
+				ip += 1 + ((ip - anchor) >> 6);
+				continue;
+			}
+			ref--;
+
+			std::size_t match_length = min_match;
+			while (ip + match_length < length - match_end_limit
+			       && data[ref + match_length] == data[ip + match_length]) {
+				match_length++;
+			}
+
+			write_sequence(output, data + anchor, ip - anchor, ip - ref, match_length);
+			ip += match_length;
+			anchor = ip;
+		}
+	}
+
+	write_sequence(output, data + anchor, length - anchor, 0, 0);
+	return output.size() - start;
+}
+
+bool decompress(const std::uint8_t *data, std::size_t length, std::uint8_t *output,
+                std::size_t output_length) {
+	std::size_t ip = 0;
+	std::size_t op = 0;
+
+	while (ip < length) {
+		std::uint8_t token = data[ip++];
+
+		std::size_t literal_length = token >> 4;
+		if (literal_length == 15 && !read_length(data, length, ip, literal_length)) {
+			return false;
+		}
+		if (literal_length > length - ip || literal_length > output_length - op) {
+			return false;
+		}
+		std::memcpy(output + op, data + ip, literal_length);
+		ip += literal_length;
+		op += literal_length;
+
+		if (ip == length) {
+			break;
+		}
+
+		if (length - ip < 2) {
+			return false;
+		}
+		std::size_t offset = data[ip] | (static_cast<std::size_t>(data[ip + 1]) << 8);
+		ip += 2;
+		if (offset == 0 || offset > op) {
+			return false;
+		}
+
+		std::size_t match_length = token & 0x0f;
+		if (match_length == 15 && !read_length(data, length, ip, match_length)) {
+			return false;
+		}
+		match_length += min_match;
+		if (match_length > output_length - op) {
+			return false;
+		}
+
+		const std::uint8_t *match = output + op - offset;
+		if (offset >= match_length) {
+			std::memcpy(output + op, match, match_length);
+		} else {
+			for (std::size_t i = 0; i < match_length; i++) {
+				output[op + i] = match[i];
+			}
+		}
+		op += match_length;
+	}
+
+	return op == output_length;
+}
+
+} // namespace lz
+} // namespace util
+} // namespace harpoon
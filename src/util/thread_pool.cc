@@ -0,0 +1,112 @@
+#include "harpoon/util/thread_pool.hh"
+
+namespace harpoon {
+namespace util {
+
+namespace {
+
+thread_local bool in_job = false;
+
+} // namespace
+
+thread_pool::thread_pool(std::size_t threads) {
+	if (!threads) {
+		threads = std::thread::hardware_concurrency();
+	}
+	for (std::size_t i = 1; i < threads; i++) {
+		_workers.emplace_back(&thread_pool::worker, this);
+	}
+}
+
+thread_pool::~thread_pool() {
+	{
+		std::lock_guard<std::mutex> lk(_mutex);
+		_stopping = true;
+	}
+	_start.notify_all();
+	for (auto &w : _workers) {
+		w.join();
+	}
+}
+
+void thread_pool::run(std::size_t count, const task &task) {
+	if (in_job || _workers.empty() || count < 2) {
+		for (std::size_t i = 0; i < count; i++) {
+			task(i);
+		}
+		return;
+	}
+
+	std::lock_guard<std::mutex> run_lk(_run_mutex);
+	{
+		std::lock_guard<std::mutex> lk(_mutex);
+		_task = &task;
+		_count = count;
+		_next = 0;
+		_active = _workers.size() + 1;
+		_error = nullptr;
+		_generation++;
+	}
+	_start.notify_all();
+
+	execute();
+
+	std::unique_lock<std::mutex> lk(_mutex);
+	_done.wait(lk, [this] { return _active == 0; });
+	_task = nullptr;
+	if (_error) {
+		std::rethrow_exception(_error);
+	}
+}
+
+void thread_pool::worker() {
+	std::uint64_t generation = 0;
+	for (;;) {
+		{
+			std::unique_lock<std::mutex> lk(_mutex);
+			_start.wait(lk, [this, generation] { return _stopping || _generation != generation; });
+			if (_stopping) {
+				return;
+			}
+			generation = _generation;
+		}
+		execute();
+	}
+}
+
+void thread_pool::execute() {
+	in_job = true;
+	for (;;) {
+		std::size_t index;
+		{
+			std::lock_guard<std::mutex> lk(_mutex);
+			if (_next >= _count || _error) {
+				break;
+			}
+			index = _next++;
+		}
+
+		try {
+			(*_task)(index);
+		} catch (...) {
+			std::lock_guard<std::mutex> lk(_mutex);
+			if (!_error) {
+				_error = std::current_exception();
+			}
+		}
+	}
+	in_job = false;
+
+	std::lock_guard<std::mutex> lk(_mutex);
+	if (--_active == 0) {
+		_done.notify_all();
+	}
+}
+
+const thread_pool_ptr &get_thread_pool() {
+	static const thread_pool_ptr pool = make_thread_pool();
+	return pool;
+}
+
+} // namespace util
+} // namespace harpoon
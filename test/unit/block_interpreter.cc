@@ -0,0 +1,298 @@
+#include <gtest/gtest.h>
+#include <harpoon/execution/block_interpreter.hh>
+#include <harpoon/execution/processing_unit.hh>
+#include <harpoon/memory/linear_random_access_memory.hh>
+#include <harpoon/memory/main_memory.hh>
+
+#include <vector>
+
+using harpoon::execution::threaded_op;
+using harpoon::memory::address_range;
+
+namespace {
+
+/*
+ * add n (01 n), st a (03 a a), jmp a (02 a a), out (04) and stl a (05 a a,
+ * st logging a after the store), taking 1, 1, 2, 1 and 1 cycles. Anything
+ * else is left to the single instruction path.
+ */
+class cpu : public harpoon::execution::processing_unit,
+            public harpoon::execution::block_translator {
+public:
+	cpu(const harpoon::memory::main_memory_ptr &main_memory)
+	    : harpoon::execution::processing_unit("cpu"), _main_memory(main_memory) {}
+
+	std::uint16_t pc{};
+	std::uint8_t acc{};
+	std::vector<std::uint8_t> output{};
+	std::vector<std::uint16_t> stores{};
+
+	virtual void step(harpoon::hardware_component *) override {}
+
+	virtual harpoon::memory::address get_program_counter() const override {
+		return pc;
+	}
+
+	virtual harpoon::memory::address get_block_address() const override {
+		return pc;
+	}
+
+	virtual std::size_t translate(harpoon::memory::address address,
+	                              harpoon::execution::block_cache::mode, threaded_op &op,
+	                              bool &ends_block) override {
+		std::uint8_t opcode = read(address), n = read(address + 1);
+		std::uint16_t a = static_cast<std::uint16_t>(n | read(address + 2) << 8);
+		switch (opcode) {
+		case 0x01:
+			op.execute = threaded_op::member_handler<cpu, &cpu::add>;
+			op.set_operands(n);
+			return 2;
+		case 0x02:
+			op.execute = threaded_op::member_handler<cpu, &cpu::jmp>;
+			op.set_operands(a);
+			ends_block = true;
+			return 3;
+		case 0x03:
+			op.execute = threaded_op::member_handler<cpu, &cpu::st>;
+			op.set_operands(a);
+			return 3;
+		case 0x04:
+			op.execute = threaded_op::member_handler<cpu, &cpu::out>;
+			return 1;
+		case 0x05:
+			op.execute = threaded_op::member_handler<cpu, &cpu::stl>;
+			op.set_operands(a);
+			return 3;
+		default:
+			return 0;
+		}
+	}
+
+	std::uint32_t add(const threaded_op &op) {
+		acc = static_cast<std::uint8_t>(acc + op.get_operands<std::uint8_t>());
+		pc = static_cast<std::uint16_t>(pc + 2);
+		return 1;
+	}
+
+	std::uint32_t jmp(const threaded_op &op) {
+		pc = op.get_operands<std::uint16_t>();
+		return 2;
+	}
+
+	std::uint32_t st(const threaded_op &op) {
+		_main_memory->set(op.get_operands<std::uint16_t>(), acc);
+		pc = static_cast<std::uint16_t>(pc + 3);
+		return 1;
+	}
+
+	/* Reads its operands again once the store may have dropped the block. */
+	std::uint32_t stl(const threaded_op &op) {
+		_main_memory->set(op.get_operands<std::uint16_t>(), acc);
+		stores.push_back(op.get_operands<std::uint16_t>());
+		pc = static_cast<std::uint16_t>(pc + 3);
+		return 1;
+	}
+
+	std::uint32_t out(const threaded_op &) {
+		output.push_back(acc);
+		pc = static_cast<std::uint16_t>(pc + 1);
+		return 1 | threaded_op::exit_block;
+	}
+
+private:
+	std::uint8_t read(harpoon::memory::address address) {
+		std::uint8_t value;
+		_main_memory->get(address, value);
+		return value;
+	}
+
+	harpoon::memory::main_memory_ptr _main_memory;
+};
+
+class block_interpreter_test : public ::testing::Test {
+protected:
+	harpoon::memory::main_memory_ptr _main_memory{};
+	harpoon::execution::block_interpreter_ptr _blocks{};
+
+	virtual void SetUp() {
+		_main_memory = harpoon::memory::make_main_memory("main-memory");
+		auto linear = harpoon::memory::make_linear_random_access_memory(
+		    "linear", address_range(0x0000, 0xffff));
+		_main_memory->add_memory(linear);
+		_main_memory->prepare();
+		linear->fill(linear->get_address_range(), 0);
+		_blocks = harpoon::execution::make_block_interpreter();
+		_blocks->attach(_main_memory);
+	}
+
+	virtual void TearDown() {
+		_blocks->detach();
+		_main_memory->cleanup();
+	}
+
+	void load(harpoon::memory::address address, const std::vector<std::uint8_t> &program) {
+		for (auto byte : program) {
+			_main_memory->set(address++, byte);
+		}
+	}
+};
+
+} // namespace
+
+TEST_F(block_interpreter_test, chaining) {
+	load(0x0100, {0x01, 0x01, 0x01, 0x02, 0x02, 0x00, 0x01});
+	cpu processing_unit(_main_memory);
+	processing_unit.set_block_interpreter(_blocks);
+	processing_unit.pc = 0x0100;
+	ASSERT_TRUE(processing_unit.can_run_blocks());
+
+	/*
+	 * Four cycles a round; the budget is checked between blocks. The first
+	 * round has no predecessor and the second links back to the cached block.
+	 */
+	EXPECT_EQ(processing_unit.run_blocks(processing_unit, 38), 40u);
+	EXPECT_EQ(processing_unit.acc, 30u);
+	EXPECT_EQ(processing_unit.pc, 0x0100u);
+	EXPECT_EQ(processing_unit.get_executed_instructions(), 30u);
+
+	const auto &statistics = _blocks->get_statistics();
+	EXPECT_EQ(statistics.translated, 1u);
+	EXPECT_EQ(statistics.executed, 10u);
+	EXPECT_EQ(statistics.chained, 8u);
+	EXPECT_EQ(statistics.instructions, 30u);
+	EXPECT_EQ(_blocks->get_block_cache().size(), 1u);
+}
+
+TEST_F(block_interpreter_test, exits_and_fallback) {
+	load(0x0200, {0x01, 0x07, 0x04, 0x01, 0x01, 0xff});
+	cpu processing_unit(_main_memory);
+	processing_unit.set_block_interpreter(_blocks);
+	processing_unit.pc = 0x0200;
+
+	/* out leaves the block at once. */
+	EXPECT_EQ(processing_unit.run_blocks(processing_unit, 100), 2u);
+	EXPECT_EQ(processing_unit.output, std::vector<std::uint8_t>{7});
+	EXPECT_EQ(processing_unit.pc, 0x0203u);
+
+	/* The block stops before the unknown opcode, which then runs no block at all. */
+	EXPECT_EQ(processing_unit.run_blocks(processing_unit, 100), 1u);
+	EXPECT_EQ(processing_unit.pc, 0x0205u);
+	EXPECT_EQ(processing_unit.run_blocks(processing_unit, 100), 0u);
+	EXPECT_EQ(processing_unit.run_blocks(processing_unit, 100), 0u);
+	EXPECT_EQ(_blocks->get_statistics().translated, 3u);
+	EXPECT_EQ(processing_unit.get_executed_instructions(), 3u);
+
+	/* Anything needing single instructions keeps the unit off the block tier. */
+	processing_unit.set_cycle_exact(true);
+	EXPECT_FALSE(processing_unit.can_run_blocks());
+	processing_unit.set_cycle_exact(false);
+	processing_unit.enable_disassemble();
+	EXPECT_FALSE(processing_unit.can_run_blocks());
+	processing_unit.disable_disassemble();
+	processing_unit.add_breakpoint(harpoon::execution::breakpoint(
+	    [](harpoon::execution::processing_unit *) { return false; },
+	    [](harpoon::execution::processing_unit *) {}));
+	EXPECT_FALSE(processing_unit.can_run_blocks());
+}
+
+TEST_F(block_interpreter_test, self_modifying_code) {
+	/* add n; st to n; jmp back: every round doubles acc, if the change is seen. */
+	load(0x0300, {0x01, 0x05, 0x03, 0x01, 0x03, 0x02, 0x00, 0x03});
+	cpu processing_unit(_main_memory);
+	processing_unit.set_block_interpreter(_blocks);
+	processing_unit.pc = 0x0300;
+
+	EXPECT_EQ(processing_unit.run_blocks(processing_unit, 12), 12u);
+	EXPECT_EQ(processing_unit.acc, 20u);
+	EXPECT_EQ(processing_unit.pc, 0x0300u);
+
+	/* Each store drops every block of the page, so nothing stays linked. */
+	EXPECT_EQ(_blocks->get_statistics().translated, 6u);
+	EXPECT_EQ(_blocks->get_block_cache().get_statistics().invalidations, 5u);
+	EXPECT_EQ(_blocks->get_statistics().chained, 0u);
+
+	/* Data writes elsewhere keep the blocks. */
+	_main_memory->set(0x1000, std::uint8_t{1});
+	EXPECT_EQ(_blocks->get_block_cache().size(), 1u);
+}
+
+TEST_F(block_interpreter_test, self_modifying_handler) {
+	/* stl to itself; add 1; out: the op the handler runs from outlives the dropped block. */
+	load(0x0400, {0x05, 0x01, 0x04, 0x01, 0x01, 0x04});
+	cpu processing_unit(_main_memory);
+	processing_unit.set_block_interpreter(_blocks);
+	processing_unit.pc = 0x0400;
+
+	EXPECT_EQ(processing_unit.run_blocks(processing_unit, 100), 3u);
+	EXPECT_EQ(processing_unit.stores, std::vector<std::uint16_t>{0x0401});
+	EXPECT_EQ(processing_unit.output, std::vector<std::uint8_t>{1});
+	EXPECT_EQ(_blocks->get_statistics().translated, 2u);
+	EXPECT_EQ(_blocks->get_block_cache().get_statistics().invalidations, 1u);
+}
+
+TEST_F(block_interpreter_test, address_breakpoints) {
+	/* add 1; add 2; jmp back */
+	load(0x0400, {0x01, 0x01, 0x01, 0x02, 0x02, 0x00, 0x04});
+	cpu processing_unit(_main_memory);
+	processing_unit.set_block_interpreter(_blocks);
+	processing_unit.pc = 0x0400;
+	EXPECT_EQ(processing_unit.run_blocks(processing_unit, 8), 8u);
+	EXPECT_EQ(_blocks->get_block_cache().size(), 1u);
+
+	std::vector<harpoon::memory::address> hits;
+	auto id = processing_unit.add_breakpoint(
+	    0x0402, [&hits](harpoon::execution::processing_unit *pu) {
+		    hits.push_back(pu->get_program_counter());
+	    });
+	EXPECT_EQ(_blocks->get_block_cache().size(), 0u);
+	EXPECT_TRUE(processing_unit.can_run_blocks());
+
+	/* The block now ends before the breakpoint, which is left to single instructions. */
+	EXPECT_EQ(processing_unit.run_blocks(processing_unit, 100), 1u);
+	EXPECT_EQ(processing_unit.pc, 0x0402u);
+	EXPECT_EQ(processing_unit.run_blocks(processing_unit, 100), 0u);
+	EXPECT_TRUE(hits.empty());
+	processing_unit.new_instruction();
+	processing_unit.start_instruction();
+	EXPECT_EQ(hits, std::vector<harpoon::memory::address>{0x0402});
+
+	processing_unit.pc = 0x0404;
+	EXPECT_EQ(processing_unit.run_blocks(processing_unit, 100), 3u);
+	EXPECT_EQ(processing_unit.pc, 0x0402u);
+	EXPECT_EQ(processing_unit.acc, 8u);
+
+	/* Other addresses never fire. */
+	processing_unit.pc = 0x0400;
+	processing_unit.new_instruction();
+	processing_unit.start_instruction();
+	EXPECT_EQ(hits.size(), 1u);
+
+	processing_unit.remove_breakpoint(id);
+	EXPECT_TRUE(processing_unit.get_address_breakpoints().empty());
+	EXPECT_EQ(processing_unit.run_blocks(processing_unit, 4), 4u);
+	EXPECT_EQ(processing_unit.pc, 0x0400u);
+	EXPECT_EQ(hits.size(), 1u);
+}
+
+TEST_F(block_interpreter_test, self_removing_breakpoint) {
+	load(0x0400, {0x01, 0x01});
+	cpu processing_unit(_main_memory);
+	processing_unit.pc = 0x0400;
+
+	std::vector<int> hits;
+	harpoon::execution::address_breakpoints::breakpoint_id once{};
+	once = processing_unit.add_breakpoint(
+	    0x0400, [&hits, &processing_unit, &once](harpoon::execution::processing_unit *) {
+		    hits.push_back(1);
+		    processing_unit.remove_breakpoint(once);
+	    });
+	processing_unit.add_breakpoint(0x0400, [&hits](harpoon::execution::processing_unit *) {
+		hits.push_back(2);
+	});
+
+	for (int i = 0; i < 2; i++) {
+		processing_unit.new_instruction();
+		processing_unit.start_instruction();
+	}
+	EXPECT_EQ(hits, (std::vector<int>{1, 2, 2}));
+}
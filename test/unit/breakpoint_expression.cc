@@ -0,0 +1,169 @@
+#include <gtest/gtest.h>
+#include <harpoon/execution/breakpoint_expression.hh>
+#include <harpoon/execution/exception/bad_breakpoint_expression.hh>
+#include <harpoon/execution/processing_unit.hh>
+#include <harpoon/memory/exception/read_access_violation.hh>
+#include <harpoon/memory/linear_random_access_memory.hh>
+#include <harpoon/memory/main_memory.hh>
+
+#include <string>
+#include <vector>
+
+using harpoon::execution::breakpoint_expression;
+using harpoon::execution::exception::bad_breakpoint_expression;
+using harpoon::memory::address_range;
+
+namespace {
+
+class cpu : public harpoon::execution::processing_unit {
+public:
+	cpu() : harpoon::execution::processing_unit("cpu") {}
+
+	std::uint16_t pc{};
+	std::uint8_t a{};
+	harpoon::execution::basic_register<std::uint32_t> counter{};
+
+	virtual void step(harpoon::hardware_component *) override {}
+
+	virtual harpoon::memory::address get_program_counter() const override {
+		return pc;
+	}
+
+	/* What a model does for each instruction on the single instruction path. */
+	void start() {
+		new_instruction();
+		start_instruction();
+	}
+};
+
+class breakpoint_expression_test : public ::testing::Test {
+protected:
+	harpoon::memory::main_memory_ptr _main_memory{};
+	cpu _cpu{};
+	breakpoint_expression::symbols _symbols{};
+
+	virtual void SetUp() {
+		_main_memory = harpoon::memory::make_main_memory("main-memory");
+		auto linear = harpoon::memory::make_linear_random_access_memory(
+		    "linear", address_range(0x0000, 0x7fff));
+		_main_memory->add_memory(linear);
+		_main_memory->prepare();
+		linear->fill(linear->get_address_range(), 0);
+
+		_symbols.add_register("pc", _cpu.pc);
+		_symbols.add_register("a", _cpu.a);
+		_symbols.add_register("counter", _cpu.counter);
+		_symbols.set_memory(_main_memory);
+	}
+
+	virtual void TearDown() {
+		_main_memory->cleanup();
+	}
+
+	std::uint64_t evaluate(const std::string &expression) {
+		return breakpoint_expression(expression, _symbols).evaluate(&_cpu);
+	}
+};
+
+} // namespace
+
+TEST_F(breakpoint_expression_test, operators) {
+	EXPECT_EQ(evaluate("1 + 2 * 3"), 7u);
+	EXPECT_EQ(evaluate("(1 + 2) * 3"), 9u);
+	EXPECT_EQ(evaluate("10 - 2 - 3"), 5u);
+	EXPECT_EQ(evaluate("0x10 >> 4 | 1 << 3"), 9u);
+	EXPECT_EQ(evaluate("0xF0 & 0x3C ^ 0x01"), 0x31u);
+	EXPECT_EQ(evaluate("1 << 64"), 0u);
+	EXPECT_EQ(evaluate("-1 == ~0 && ~0 == 0xffffffffffffffff"), 1u);
+	EXPECT_EQ(evaluate("!0 + !7"), 1u);
+	EXPECT_EQ(evaluate("3 < 5 && 5 <= 5 && 6 > 5 && 5 >= 6"), 0u);
+	EXPECT_EQ(evaluate("1 == 2 || 2 != 2 || 12"), 1u);
+	EXPECT_EQ(evaluate("2 && 3"), 1u);
+	EXPECT_EQ(evaluate("  18446744073709551615 "), ~std::uint64_t{});
+}
+
+TEST_F(breakpoint_expression_test, registers_and_counters) {
+	breakpoint_expression condition("a == 3 && counter > 0x10000 && pc == 0x1234", _symbols);
+	EXPECT_FALSE(condition(&_cpu));
+	_cpu.a = 3;
+	_cpu.counter = 0x10001;
+	_cpu.pc = 0x1234;
+	EXPECT_TRUE(condition(&_cpu));
+	_cpu.a = 0xff;
+	EXPECT_EQ(evaluate("a + 1"), 0x100u);
+
+	/* Without a register of that name, pc is the program counter. */
+	breakpoint_expression::symbols symbols;
+	EXPECT_EQ(breakpoint_expression("pc", symbols).evaluate(&_cpu), 0x1234u);
+	EXPECT_EQ(breakpoint_expression("instructions", symbols).evaluate(&_cpu), 0u);
+	_cpu.start();
+	_cpu.start();
+	EXPECT_EQ(breakpoint_expression("instructions", symbols).evaluate(&_cpu), 2u);
+}
+
+TEST_F(breakpoint_expression_test, memory) {
+	_main_memory->set(0x1000, std::uint32_t{0x12345678});
+	_cpu.pc = 0x0ffe;
+	EXPECT_EQ(evaluate("[0x1000]"), 0x78u);
+	EXPECT_EQ(evaluate("mem8[pc + 3]"), 0x56u);
+	EXPECT_EQ(evaluate("mem16[0x1000]"), 0x5678u);
+	EXPECT_EQ(evaluate("mem32[0x1000]"), 0x12345678u);
+	EXPECT_EQ(evaluate("mem64[0x1000]"), 0x12345678u);
+	EXPECT_EQ(evaluate("[[0x1000] + 0x0f8b]"), 0x12u);
+
+	/* Reads of unmapped memory fail, unless the other side of && or || decides. */
+	EXPECT_THROW(evaluate("[0x9000]"), harpoon::memory::exception::read_access_violation);
+	EXPECT_EQ(evaluate("a != 0 && [0x9000] == 1"), 0u);
+	EXPECT_EQ(evaluate("a == 0 || [0x9000] == 1"), 1u);
+}
+
+TEST_F(breakpoint_expression_test, errors) {
+	for (const char *expression :
+	     {"", "1 +", "a ==", "(1", "[1", "unknown", "12ab", "0x", "18446744073709551616",
+	      "1 2", "a = 1", "mem8(1)", "a @ 1"}) {
+		EXPECT_THROW(breakpoint_expression(expression, _symbols), bad_breakpoint_expression)
+		    << expression;
+	}
+
+	breakpoint_expression::symbols symbols;
+	EXPECT_THROW(breakpoint_expression("[0]", symbols), bad_breakpoint_expression);
+
+	std::string deep = "1";
+	for (std::size_t i = 0; i < breakpoint_expression::max_depth; i++) {
+		deep = "1 + (" + deep + ")";
+	}
+	EXPECT_THROW(breakpoint_expression(deep, _symbols), bad_breakpoint_expression);
+
+	/* Nesting which does not grow the value stack is bounded too. */
+	EXPECT_EQ(evaluate(std::string(100, '(') + "1" + std::string(100, ')')), 1u);
+	EXPECT_EQ(evaluate(std::string(100, '!') + "1"), 1u);
+	for (const char *prefix : {"!", "~", "-", "(", "["}) {
+		std::string nested;
+		for (std::size_t i = 0; i < 100000; i++) {
+			nested += prefix;
+		}
+		EXPECT_THROW(breakpoint_expression(nested + "1", _symbols), bad_breakpoint_expression)
+		    << prefix;
+	}
+}
+
+TEST_F(breakpoint_expression_test, breakpoints) {
+	std::vector<std::uint16_t> hits;
+	auto hit = [&hits](harpoon::execution::processing_unit *pu) {
+		hits.push_back(static_cast<std::uint16_t>(pu->get_program_counter()));
+	};
+
+	_cpu.add_breakpoint(0x0100, hit, breakpoint_expression("a == 2", _symbols));
+	_cpu.add_breakpoint(
+	    harpoon::execution::breakpoint(breakpoint_expression("[0x2000] == 0xaa", _symbols), hit));
+
+	_cpu.pc = 0x0100;
+	_cpu.start();
+	_cpu.a = 2;
+	_cpu.start();
+	_cpu.pc = 0x0102;
+	_cpu.start();
+	_main_memory->set(0x2000, std::uint8_t{0xaa});
+	_cpu.start();
+	EXPECT_EQ(hits, (std::vector<std::uint16_t>{0x0100, 0x0102}));
+}
@@ -2,7 +2,10 @@
 #include <gtest/gtest.h>
 #include <harpoon/clock/clock.hh>
 #include <harpoon/clock/exception/dead_clock.hh>
+#include <harpoon/clock/exception/clock_exception.hh>
 #include <harpoon/log/queue_log.hh>
+#include <harpoon/state/reader.hh>
+#include <harpoon/state/writer.hh>
 
 namespace {
 
@@ -176,4 +179,72 @@ TEST_F(clock, schedule_chain_phase) {
 	    harpoon::clock::exception::dead_clock);
 }
 
+TEST_F(clock, schedule_event) {
+	mocks::step h1;
+
+	auto event = _clock->register_event(
+	    [&h1](harpoon::clock::clock *c) { h1.do_call(c, c->get_cycle()); });
+	_clock->schedule(10, 0, event);
+
+	EXPECT_CALL(h1, do_call(_clock.get(), harpoon::clock::cycle{10, 0}));
+
+	EXPECT_THROW(
+	    {
+		    _clock->step(_clock.get());
+		    _clock->step(_clock.get());
+	    },
+	    harpoon::clock::exception::dead_clock);
+}
+
+TEST_F(clock, schedule_unknown_event) {
+	EXPECT_THROW(_clock->schedule(10, 0, 1), harpoon::clock::exception::clock_exception);
+}
+
+TEST_F(clock, save_restore_events) {
+	mocks::step h1, h2;
+
+	auto e1 = _clock->register_event(
+	    [&h1](harpoon::clock::clock *c) { h1.do_call(c, c->get_cycle()); });
+	auto e2 = _clock->register_event(
+	    [&h2](harpoon::clock::clock *c) { h2.do_call(c, c->get_cycle()); });
+	_clock->schedule(5, 0, e1);
+	_clock->schedule(20, 1, e2);
+	_clock->schedule(30, 0, e1);
+
+	EXPECT_CALL(h1, do_call(_clock.get(), harpoon::clock::cycle{5, 0}));
+	EXPECT_CALL(h1, do_call(_clock.get(), harpoon::clock::cycle{21, 0}));
+	EXPECT_CALL(h1, do_call(_clock.get(), harpoon::clock::cycle{30, 0}));
+	EXPECT_CALL(h2, do_call(_clock.get(), harpoon::clock::cycle{20, 1})).Times(2);
+
+	_clock->step(_clock.get());
+	_clock->step(_clock.get());
+	EXPECT_EQ(_clock->get_cycle().tick, 20u);
+
+	std::vector<std::uint8_t> saved;
+	harpoon::state::writer writer(saved);
+	_clock->save(writer);
+
+	/* Diverge, then go back to the saved point and replay. */
+	_clock->schedule(1, 0, e1);
+	_clock->step(_clock.get());
+	_clock->step(_clock.get());
+	EXPECT_EQ(_clock->get_cycle().tick, 30u);
+
+	harpoon::state::reader reader(saved.data(), saved.size());
+	_clock->restore(reader);
+	EXPECT_TRUE(reader.at_end());
+	EXPECT_EQ(_clock->get_cycle().tick, 20u);
+
+	_clock->step(_clock.get());
+	EXPECT_THROW(_clock->step(_clock.get()), harpoon::clock::exception::dead_clock);
+}
+
+TEST_F(clock, save_unregistered_event) {
+	_clock->schedule(10, 0, [](harpoon::clock::clock *) {});
+
+	std::vector<std::uint8_t> saved;
+	harpoon::state::writer writer(saved);
+	EXPECT_THROW(_clock->save(writer), harpoon::clock::exception::clock_exception);
+}
+
 } // namespace
@@ -0,0 +1,162 @@
+#include <gtest/gtest.h>
+#include <harpoon/execution/decode_cache.hh>
+#include <harpoon/execution/processing_unit.hh>
+#include <harpoon/memory/chunked_random_access_memory.hh>
+#include <harpoon/memory/deserializer/memory_buffer.hh>
+#include <harpoon/memory/linear_random_access_memory.hh>
+#include <harpoon/memory/main_memory.hh>
+#include <harpoon/memory/serializer/memory_buffer.hh>
+
+#include <vector>
+
+using harpoon::execution::decode_cache;
+using harpoon::execution::instruction;
+using harpoon::memory::address_range;
+
+namespace {
+
+class decode_cache_test : public ::testing::Test {
+protected:
+	harpoon::memory::main_memory_ptr _main_memory{};
+	harpoon::memory::memory_ptr _chunked{};
+	decode_cache _cache{};
+	unsigned int _decoded{};
+
+	virtual void SetUp() {
+		_main_memory = harpoon::memory::make_main_memory("main-memory");
+		auto linear = harpoon::memory::make_linear_random_access_memory(
+		    "linear", address_range(0x00000, 0x0ffff));
+		_chunked = harpoon::memory::make_chunked_random_access_memory(
+		    "chunked", address_range(0x10000, 0x1ffff), 0x1000);
+		_main_memory->add_memory(linear);
+		_main_memory->add_memory(_chunked);
+		_main_memory->prepare();
+		linear->fill(linear->get_address_range(), 0);
+		_cache.attach(_main_memory);
+	}
+
+	virtual void TearDown() {
+		_cache.detach();
+		_main_memory->cleanup();
+	}
+
+	/* Decode a dummy instruction of the given length at the address. */
+	const instruction *get(harpoon::memory::address address, std::size_t length = 1,
+	                       decode_cache::mode mode = 0) {
+		return &_cache.get(address, mode, [this, length](std::size_t &l) {
+			_decoded++;
+			l = length;
+			return instruction(nullptr);
+		});
+	}
+};
+
+class cpu : public harpoon::execution::processing_unit {
+public:
+	using harpoon::execution::processing_unit::processing_unit;
+
+	unsigned int executed{};
+
+	virtual void step(harpoon::hardware_component *) override {}
+
+	std::uint32_t execute(instruction &) {
+		executed++;
+		return 3;
+	}
+};
+
+} // namespace
+
+TEST_F(decode_cache_test, hits_and_misses) {
+	auto first = get(0x100);
+	EXPECT_EQ(get(0x100), first);
+	EXPECT_NE(get(0x100, 1, 1), first);
+	EXPECT_EQ(get(0x100, 1, 1), get(0x100, 1, 1));
+	EXPECT_EQ(_decoded, 2u);
+	EXPECT_EQ(_cache.size(), 2u);
+
+	const auto &statistics = _cache.get_statistics();
+	EXPECT_EQ(statistics.hits, 3u);
+	EXPECT_EQ(statistics.misses, 2u);
+	EXPECT_DOUBLE_EQ(statistics.get_hit_rate(), 3.0 / 5.0);
+
+	_cache.reset_statistics();
+	EXPECT_EQ(_cache.get_statistics().hits, 0u);
+	EXPECT_DOUBLE_EQ(_cache.get_statistics().get_hit_rate(), 0);
+}
+
+TEST_F(decode_cache_test, code_writes) {
+	get(0x0100, 2);
+	get(0x1ffe, 4);
+	get(0x3000);
+	get(0x10800);
+	ASSERT_EQ(_cache.size(), 4u);
+
+	/* Data pages are not code. */
+	_main_memory->set(0x5000, std::uint32_t{1});
+	_main_memory->fill(address_range(0x6000, 0x8fff), 0xff);
+	EXPECT_EQ(_cache.size(), 4u);
+
+	/* The instruction crossing into page 2 goes; others stay. */
+	_main_memory->set(0x2100, std::uint8_t{1});
+	EXPECT_EQ(_cache.size(), 3u);
+	get(0x0100, 2);
+	EXPECT_EQ(_decoded, 4u);
+
+	/* Bulk writes from a data page into a code page are caught as well. */
+	std::vector<std::uint8_t> data(0x200, 0x55);
+	_main_memory->write(address_range(0x2f00, 0x30ff), data.data());
+	EXPECT_EQ(_cache.size(), 2u);
+	_main_memory->write(address_range(0x10700, 0x108ff), data.data());
+	EXPECT_EQ(_cache.size(), 1u);
+
+	/* Decoding again marks the page again. */
+	get(0x3000);
+	_main_memory->set(0x3fff, std::uint8_t{1});
+	EXPECT_EQ(_cache.size(), 1u);
+
+	/* Clearing watchpoints keeps code marks. */
+	using harpoon::memory::watchpoint;
+	_main_memory->add_watchpoint(watchpoint(address_range(0x0100, 0x0100), watchpoint::Type::WRITE,
+	                                        [](const watchpoint &, const watchpoint::access &) {}));
+	_main_memory->clear_watchpoints();
+	_main_memory->set(0x0101, std::uint8_t{1});
+	EXPECT_EQ(_cache.size(), 0u);
+	EXPECT_EQ(_cache.get_statistics().invalidations, 5u);
+}
+
+TEST_F(decode_cache_test, restore) {
+	harpoon::memory::serializer::memory_buffer serializer(_main_memory->get_mapped_range());
+	_main_memory->serialize(serializer);
+
+	get(0x0100);
+	get(0x11000);
+	harpoon::memory::deserializer::memory_buffer deserializer(serializer.get_image());
+	_main_memory->deserialize(deserializer);
+	EXPECT_EQ(_cache.size(), 0u);
+
+	get(0x11000);
+	_main_memory->remove_memory(_chunked);
+	EXPECT_EQ(_cache.size(), 0u);
+	_chunked->cleanup();
+}
+
+TEST_F(decode_cache_test, prototypes) {
+	cpu processing_unit("cpu");
+	_cache.insert(0x0200, 0, 1,
+	              instruction(nullptr, nullptr,
+	                          {{instruction::no_delay, instruction::member_step<cpu, &cpu::execute>}}));
+
+	for (int i = 0; i < 3; i++) {
+		processing_unit.set_current_instruction(*_cache.find(0x0200, 0));
+		EXPECT_EQ(processing_unit.get_current_instruction().get_processing_unit(),
+		          &processing_unit);
+		EXPECT_EQ(processing_unit.execute_instruction(), 3u);
+		EXPECT_TRUE(processing_unit.get_current_instruction().done());
+	}
+	EXPECT_EQ(processing_unit.executed, 3u);
+	EXPECT_EQ(processing_unit.get_executed_instructions(), 3u);
+
+	/* The prototype itself is never run. */
+	EXPECT_EQ(_cache.find(0x0200, 0)->get_step(), 0u);
+}
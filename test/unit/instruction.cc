@@ -0,0 +1,119 @@
+#include <gtest/gtest.h>
+#include <harpoon/exception/harpoon_exception.hh>
+#include <harpoon/execution/instruction.hh>
+#include <harpoon/execution/processing_unit.hh>
+
+#include <sstream>
+#include <type_traits>
+
+using harpoon::execution::instruction;
+
+namespace {
+
+static_assert(!std::is_copy_constructible<instruction>::value, "Instructions are move-only");
+static_assert(std::is_nothrow_move_constructible<instruction>::value,
+              "Moving instructions is cheap");
+
+struct operands {
+	std::uint8_t reg;
+	std::uint16_t address;
+	std::uint32_t value;
+};
+
+/* Load value from address into reg, waiting two ticks for the memory. */
+class cpu : public harpoon::execution::processing_unit {
+public:
+	using harpoon::execution::processing_unit::processing_unit;
+
+	std::uint32_t registers[8]{};
+	unsigned int waits{};
+
+	virtual void step(harpoon::hardware_component *) override {}
+
+	std::uint32_t wait_memory(instruction &) {
+		return waits++ < 2 ? 1 : 0;
+	}
+
+	std::uint32_t read(instruction &i) {
+		auto &o = i.get_operands<operands>();
+		o.value = o.address * 2u;
+		return 1;
+	}
+
+	std::uint32_t write_back(instruction &i) {
+		const auto &o = i.get_operands<operands>();
+		registers[o.reg] = o.value;
+		return 2;
+	}
+
+	static void disassemble(const instruction &i, std::ostream &s) {
+		const auto &o = i.get_operands<operands>();
+		s << "ld r" << static_cast<int>(o.reg) << ", (" << o.address << ")";
+	}
+
+	void load(std::uint8_t reg, std::uint16_t address) {
+		auto &i = new_instruction();
+		i.set_disassemble_handler(&cpu::disassemble);
+		i.add_step(instruction::member_step<cpu, &cpu::wait_memory>,
+		           instruction::member_step<cpu, &cpu::read>);
+		i.add_step(instruction::no_delay, instruction::member_step<cpu, &cpu::write_back>);
+		i.set_operands(operands{reg, address, 0});
+		start_instruction();
+	}
+};
+
+} // namespace
+
+TEST(instruction, in_place) {
+	cpu processing_unit("cpu");
+	processing_unit.load(3, 0x1234);
+
+	const instruction &current = processing_unit.get_current_instruction();
+	EXPECT_EQ(current.get_step_count(), 2u);
+	EXPECT_EQ(current.get_processing_unit(), &processing_unit);
+	std::stringstream text;
+	current.disassemble(text);
+	EXPECT_EQ(text.str(), "ld r3, (4660)");
+
+	EXPECT_EQ(processing_unit.execute_instruction(), 1u);
+	EXPECT_EQ(processing_unit.execute_instruction(), 1u);
+	EXPECT_EQ(current.get_step(), 0u);
+	EXPECT_EQ(processing_unit.execute_instruction(), 1u);
+	EXPECT_EQ(current.get_step(), 1u);
+	EXPECT_EQ(current.get_operands<operands>().value, 0x2468u);
+	EXPECT_EQ(processing_unit.execute_instruction(), 2u);
+	EXPECT_TRUE(current.done());
+	EXPECT_EQ(processing_unit.registers[3], 0x2468u);
+	EXPECT_EQ(processing_unit.get_executed_instructions(), 1u);
+
+	/* The next instruction reuses the storage and starts from scratch. */
+	processing_unit.load(5, 1);
+	EXPECT_EQ(current.get_step(), 0u);
+	EXPECT_EQ(current.get_operands<operands>().reg, 5u);
+	EXPECT_EQ(processing_unit.get_executed_instructions(), 2u);
+}
+
+TEST(instruction, clone_and_move) {
+	instruction prototype(nullptr, nullptr,
+	                      {{instruction::no_delay, [](instruction &i) {
+		                        return i.get_operands<operands>().value;
+	                        }}});
+	prototype.set_operands(operands{1, 2, 7});
+
+	instruction copy = prototype.clone();
+	EXPECT_EQ(copy.step(), 7u);
+	EXPECT_TRUE(copy.done());
+	EXPECT_FALSE(prototype.done());
+
+	instruction moved = std::move(copy);
+	EXPECT_TRUE(moved.done());
+	EXPECT_EQ(moved.get_operands<operands>().address, 2u);
+
+	instruction full(nullptr);
+	for (std::size_t i = 0; i < instruction::max_steps; i++) {
+		full.add_step(instruction::no_delay, instruction::no_delay);
+	}
+	EXPECT_THROW(full.add_step(instruction::no_delay, instruction::no_delay),
+	             harpoon::exception::harpoon_exception);
+	EXPECT_TRUE(instruction().done());
+}
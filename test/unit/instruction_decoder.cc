@@ -0,0 +1,174 @@
+#include <gtest/gtest.h>
+#include <harpoon/execution/exception/bad_opcode_pattern.hh>
+#include <harpoon/execution/exception/decoder_error.hh>
+#include <harpoon/execution/instruction_decoder.hh>
+#include <harpoon/execution/instruction_invoker.hh>
+
+#include <string>
+#include <vector>
+
+using harpoon::execution::opcode_pattern;
+
+namespace {
+
+struct model {
+	std::string trace{};
+
+	void nop() {
+		trace += "nop;";
+	}
+
+	void halt() {
+		trace += "halt;";
+	}
+
+	void mov(unsigned int d, unsigned int s) {
+		trace += "mov " + std::to_string(d) + "," + std::to_string(s) + ";";
+	}
+
+	void mvi(unsigned int d, std::uint8_t n) {
+		trace += "mvi " + std::to_string(d) + "," + std::to_string(n) + ";";
+	}
+
+	void rlc(unsigned int r) {
+		trace += "rlc " + std::to_string(r) + ";";
+	}
+
+	void bit(unsigned int b, unsigned int r) {
+		trace += "bit " + std::to_string(b) + "," + std::to_string(r) + ";";
+	}
+
+	void rlc_indexed(std::int8_t d) {
+		trace += "rlc (ix" + std::to_string(d) + ");";
+	}
+};
+
+using invoker = harpoon::execution::instruction_invoker<model, std::uint8_t>;
+using decoder = harpoon::execution::instruction_decoder<std::uint8_t, invoker>;
+
+template<typename... Args>
+void add(decoder &d, const std::string &pattern, void (model::*method)(Args...),
+         const std::string &operands = {}) {
+	opcode_pattern p(pattern, 8);
+	d.add(p, invoker(method, p, operands));
+}
+
+/* Decode and run everything in the program; "?" marks undefined opcodes. */
+std::string run(const decoder &d, const std::vector<std::uint8_t> &program) {
+	model m;
+	std::uint8_t units[8];
+	std::size_t pc = 0;
+	while (pc < program.size()) {
+		auto e = d.decode(
+		    [&program, pc](std::size_t i) {
+			    return pc + i < program.size() ? program[pc + i] : std::uint8_t{0};
+		    },
+		    units);
+		if (!e) {
+			m.trace += "?;";
+			pc++;
+			continue;
+		}
+		e->value(m, units);
+		pc += e->pattern.get_length();
+	}
+	return m.trace;
+}
+
+} // namespace
+
+TEST(instruction_decoder, pattern) {
+	opcode_pattern p("1a0a_bb-a 11001011", 8);
+	EXPECT_EQ(p.get_length(), 2u);
+	EXPECT_EQ(p.get_mask(0), 0xa0u);
+	EXPECT_EQ(p.get_value(0), 0x80u);
+	EXPECT_EQ(p.get_mask(1), 0xffu);
+	EXPECT_EQ(p.get_value(1), 0xcbu);
+	EXPECT_EQ(p.get_specificity(), 10u);
+	ASSERT_EQ(p.get_fields().size(), 2u);
+	EXPECT_EQ(p.get_field('a').get_width(), 3u);
+	EXPECT_TRUE(p.has_field('b'));
+	EXPECT_FALSE(p.has_field('c'));
+
+	std::uint8_t units[] = {0xd5, 0xcb};
+	EXPECT_TRUE(p.matches(units));
+	EXPECT_EQ(p.extract('a', units), 0x7u);
+	EXPECT_EQ(p.extract('b', units), 0x1u);
+	units[1] = 0xcc;
+	EXPECT_FALSE(p.matches(units));
+
+	opcode_pattern wide("0001nnnn nnnnmmmm", 8);
+	std::uint8_t wide_units[] = {0x1a, 0xbc};
+	EXPECT_EQ(wide.extract('n', wide_units), 0xabu);
+	EXPECT_EQ(wide.extract('m', wide_units), 0xcu);
+
+	using harpoon::execution::exception::bad_opcode_pattern;
+	EXPECT_THROW(opcode_pattern("0101010", 8), bad_opcode_pattern);
+	EXPECT_THROW(opcode_pattern("010101010", 8), bad_opcode_pattern);
+	EXPECT_THROW(opcode_pattern("0101+010", 8), bad_opcode_pattern);
+	EXPECT_THROW(opcode_pattern("  ", 8), bad_opcode_pattern);
+	EXPECT_THROW(opcode_pattern(std::string(40, 'a'), 40), bad_opcode_pattern);
+	EXPECT_THROW(p.get_field('c'), bad_opcode_pattern);
+	EXPECT_THROW(invoker(&model::mov, p, "a"), bad_opcode_pattern);
+}
+
+TEST(instruction_decoder, prefixes_and_operands) {
+	decoder d;
+	add(d, "00000000", &model::nop);
+	add(d, "01dddsss", &model::mov, "ds");
+	add(d, "01110110", &model::halt);
+	add(d, "00ddd110 nnnnnnnn", &model::mvi, "dn");
+	add(d, "11001011 00000rrr", &model::rlc, "r");
+	add(d, "11001011 01bbbrrr", &model::bit, "br");
+	add(d, "11011101 11001011 dddddddd 00000110", &model::rlc_indexed, "d");
+	d.build();
+	EXPECT_TRUE(d.is_built());
+	EXPECT_EQ(d.get_max_length(), 4u);
+
+	EXPECT_EQ(run(d, {0x00, 0x41, 0x76, 0x7f, 0x3e, 0x99, 0x36, 0x07}),
+	          "nop;mov 0,1;halt;mov 7,7;mvi 7,153;mvi 6,7;");
+	EXPECT_EQ(run(d, {0xcb, 0x03, 0xcb, 0x7a, 0xcb, 0x10, 0xdd, 0xcb, 0xfe, 0x06}),
+	          "rlc 3;bit 7,2;?;?;rlc (ix-2);");
+	EXPECT_EQ(run(d, {0xdd, 0xcb, 0x05, 0x07, 0xff}), "?;rlc 5;?;?;");
+
+	/* The root table, the 0xcb table and three tables for the indexed form. */
+	EXPECT_EQ(d.get_table_count(), 5u);
+}
+
+TEST(instruction_decoder, partial_index) {
+	/* 16 bit units indexed by their top 4 bits; the rest is checked by lists. */
+	using wide_decoder = harpoon::execution::instruction_decoder<std::uint16_t, int, 4>;
+	wide_decoder d;
+	d.add("0001nnnn_nnnnnnnn", 1);
+	d.add("1111----_--------", 2);
+	d.add("11110000_00000000", 3);
+	d.add("1111----_-------1 iiiiiiii_iiiiiiii", 4);
+	d.build();
+	EXPECT_EQ(d.get_table_count(), 1u);
+
+	std::uint16_t units[2];
+	auto decode = [&d, &units](std::vector<std::uint16_t> program) {
+		program.resize(2);
+		auto e = d.decode_buffer(program.data(), units);
+		return e ? e->value : 0;
+	};
+	EXPECT_EQ(decode({0x1234}), 1);
+	EXPECT_EQ(decode({0xf000}), 3);
+	EXPECT_EQ(decode({0xf001, 0xabcd}), 4);
+	EXPECT_EQ(units[1], 0xabcd);
+	EXPECT_EQ(decode({0xf002}), 2);
+	EXPECT_EQ(decode({0x2000}), 0);
+}
+
+TEST(instruction_decoder, not_built) {
+	decoder d;
+	std::uint8_t program[1]{}, units[1];
+	EXPECT_THROW(d.decode_buffer(program, units), harpoon::execution::exception::decoder_error);
+
+	add(d, "00000000", &model::nop);
+	d.build();
+	EXPECT_EQ(run(d, {0x00}), "nop;");
+
+	add(d, "01110110", &model::halt);
+	EXPECT_THROW(d.decode_buffer(program, units), harpoon::execution::exception::decoder_error);
+}
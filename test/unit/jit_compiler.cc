@@ -0,0 +1,396 @@
+#include <gtest/gtest.h>
+#include <harpoon/execution/exception/jit_error.hh>
+#include <harpoon/execution/jit_compiler.hh>
+#include <harpoon/execution/processing_unit.hh>
+#include <harpoon/memory/chunked_random_access_memory.hh>
+#include <harpoon/memory/exception/read_access_violation.hh>
+#include <harpoon/memory/linear_random_access_memory.hh>
+#include <harpoon/memory/main_memory.hh>
+
+#include <cstddef>
+#include <vector>
+
+using harpoon::execution::jit_context;
+using harpoon::execution::threaded_op;
+using harpoon::execution::x86_64_assembler;
+using harpoon::memory::address_range;
+
+namespace {
+
+struct registers {
+	std::uint16_t pc;
+	std::uint8_t acc;
+};
+
+constexpr std::int32_t pc_offset = offsetof(registers, pc);
+constexpr std::int32_t acc_offset = offsetof(registers, acc);
+
+/*
+ * add n (01 n), jmp a (02 a a), st a (03 a a), out (04), ld a (05 a a) and
+ * poke a (06 a a, st through a helper), taking 1, 2, 1, 1, 1 and 1 cycles,
+ * both threaded and compiled.
+ */
+class cpu : public harpoon::execution::processing_unit,
+            public harpoon::execution::jit_translator {
+public:
+	cpu(const harpoon::memory::main_memory_ptr &main_memory)
+	    : harpoon::execution::processing_unit("cpu"), _main_memory(main_memory) {}
+
+	registers regs{};
+	std::vector<std::uint8_t> output{};
+
+	virtual void step(harpoon::hardware_component *) override {}
+
+	virtual harpoon::memory::address get_block_address() const override {
+		return regs.pc;
+	}
+
+	virtual void *get_jit_state() override {
+		return &regs;
+	}
+
+	virtual std::size_t translate(harpoon::memory::address address,
+	                              harpoon::execution::block_cache::mode, threaded_op &op,
+	                              bool &ends_block) override {
+		std::uint8_t n;
+		std::uint16_t a;
+		switch (decode(address, n, a)) {
+		case 0x01:
+			op.execute = threaded_op::member_handler<cpu, &cpu::add>;
+			op.set_operands(n);
+			return 2;
+		case 0x02:
+			op.execute = threaded_op::member_handler<cpu, &cpu::jmp>;
+			op.set_operands(a);
+			ends_block = true;
+			return 3;
+		case 0x03:
+			op.execute = threaded_op::member_handler<cpu, &cpu::st>;
+			op.set_operands(a);
+			return 3;
+		case 0x04:
+			op.execute = threaded_op::member_handler<cpu, &cpu::out>;
+			return 1;
+		case 0x05:
+			op.execute = threaded_op::member_handler<cpu, &cpu::ld>;
+			op.set_operands(a);
+			return 3;
+		case 0x06:
+			op.execute = threaded_op::member_handler<cpu, &cpu::st>;
+			op.set_operands(a);
+			return 3;
+		default:
+			return 0;
+		}
+	}
+
+	virtual std::size_t emit(harpoon::memory::address address,
+	                         harpoon::execution::block_cache::mode, jit_context &c) override {
+		using reg = x86_64_assembler::reg;
+		using alu = x86_64_assembler::alu;
+		const x86_64_assembler::mem pc{jit_context::state_register, pc_offset};
+		const x86_64_assembler::mem acc{jit_context::state_register, acc_offset};
+
+		std::uint8_t n;
+		std::uint16_t a;
+		switch (decode(address, n, a)) {
+		case 0x01:
+			c.op(alu::ADD, acc, n, 8);
+			c.op(alu::ADD, pc, 2, 16);
+			c.emit_cycles(1);
+			return 2;
+		case 0x02:
+			c.mov(pc, a, 16);
+			c.emit_cycles(2);
+			return 3;
+		case 0x03:
+			c.mov(reg::R13, a);
+			c.load(reg::R14, acc, 8);
+			c.emit_store(reg::R13, reg::R14, 8);
+			c.op(alu::ADD, pc, 3, 16);
+			c.emit_cycles(1);
+			return 3;
+		case 0x04:
+			c.load(reg::R13, acc, 8);
+			c.emit_call(&cpu::write_output, reg::R13);
+			c.op(alu::ADD, pc, 1, 16);
+			c.emit_cycles(1);
+			c.emit_exit();
+			return 1;
+		case 0x05:
+			c.mov(reg::R13, a);
+			c.emit_load(reg::R14, reg::R13, 8);
+			c.store(acc, reg::R14, 8);
+			c.op(alu::ADD, pc, 3, 16);
+			c.emit_cycles(1);
+			return 3;
+		case 0x06:
+			c.mov(reg::R13, a);
+			c.emit_call(&cpu::poke, reg::R13);
+			c.op(alu::ADD, pc, 3, 16);
+			c.emit_cycles(1);
+			return 3;
+		default:
+			return 0;
+		}
+	}
+
+private:
+	std::uint8_t decode(harpoon::memory::address address, std::uint8_t &n, std::uint16_t &a) {
+		std::uint8_t opcode, high;
+		_main_memory->get(address, opcode);
+		_main_memory->get(address + 1, n);
+		_main_memory->get(address + 2, high);
+		a = static_cast<std::uint16_t>(n | high << 8);
+		return opcode;
+	}
+
+	std::uint32_t add(const threaded_op &op) {
+		regs.acc = static_cast<std::uint8_t>(regs.acc + op.get_operands<std::uint8_t>());
+		regs.pc = static_cast<std::uint16_t>(regs.pc + 2);
+		return 1;
+	}
+
+	std::uint32_t jmp(const threaded_op &op) {
+		regs.pc = op.get_operands<std::uint16_t>();
+		return 2;
+	}
+
+	std::uint32_t st(const threaded_op &op) {
+		_main_memory->set(op.get_operands<std::uint16_t>(), regs.acc);
+		regs.pc = static_cast<std::uint16_t>(regs.pc + 3);
+		return 1;
+	}
+
+	std::uint32_t out(const threaded_op &) {
+		output.push_back(regs.acc);
+		regs.pc = static_cast<std::uint16_t>(regs.pc + 1);
+		return 1 | threaded_op::exit_block;
+	}
+
+	std::uint32_t ld(const threaded_op &op) {
+		_main_memory->get(op.get_operands<std::uint16_t>(), regs.acc);
+		regs.pc = static_cast<std::uint16_t>(regs.pc + 3);
+		return 1;
+	}
+
+	static std::uint64_t write_output(harpoon::execution::processing_unit &pu,
+	                                  std::uint64_t value) {
+		static_cast<cpu &>(pu).output.push_back(static_cast<std::uint8_t>(value));
+		return 0;
+	}
+
+	static std::uint64_t poke(harpoon::execution::processing_unit &pu, std::uint64_t address) {
+		cpu &c = static_cast<cpu &>(pu);
+		c._main_memory->set(address, c.regs.acc);
+		return 0;
+	}
+
+	harpoon::memory::main_memory_ptr _main_memory;
+};
+
+class jit_compiler_test : public ::testing::Test {
+protected:
+	harpoon::memory::main_memory_ptr _main_memory{};
+	harpoon::execution::block_interpreter_ptr _blocks{};
+	harpoon::execution::jit_compiler_ptr _jit{};
+
+	virtual void SetUp() {
+		if (!harpoon::execution::jit_compiler::is_supported()) {
+			GTEST_SKIP();
+		}
+		_main_memory = harpoon::memory::make_main_memory("main-memory");
+		auto linear = harpoon::memory::make_linear_random_access_memory(
+		    "linear", address_range(0x0000, 0x7fff));
+		_main_memory->add_memory(linear);
+		_main_memory->prepare();
+		linear->fill(linear->get_address_range(), 0);
+		_blocks = harpoon::execution::make_block_interpreter();
+		_blocks->attach(_main_memory);
+		_jit = harpoon::execution::make_jit_compiler(1 << 16);
+	}
+
+	virtual void TearDown() {
+		if (_blocks) {
+			_blocks->detach();
+			_main_memory->cleanup();
+		}
+	}
+
+	void load(harpoon::memory::address address, const std::vector<std::uint8_t> &program) {
+		for (auto byte : program) {
+			_main_memory->set(address++, byte);
+		}
+	}
+};
+
+} // namespace
+
+TEST(x86_64_assembler, encoding) {
+	using reg = x86_64_assembler::reg;
+	using mem = x86_64_assembler::mem;
+	x86_64_assembler a;
+	auto back = a.new_label();
+	a.bind(back);
+	a.mov(reg::RAX, reg::RBX);
+	a.load(reg::R14, mem{reg::RAX, 0, reg::RSI}, 8);
+	a.store(mem{reg::RAX, 0, reg::RSI}, reg::RDI, 8);
+	a.op(x86_64_assembler::alu::CMP, reg::RAX, mem{reg::RBX, 32, reg::RCX});
+	a.mov(mem{reg::R12, 300}, 7, 8);
+	a.set(x86_64_assembler::condition::NE, reg::RSI);
+	a.jump(back);
+	EXPECT_EQ(a.finish(), (std::vector<std::uint8_t>{
+	                          0x48, 0x89, 0xd8, 0x44, 0x0f, 0xb6, 0x34, 0x30, 0x40, 0x88, 0x3c,
+	                          0x30, 0x48, 0x3b, 0x44, 0x0b, 0x20, 0x41, 0xc6, 0x84, 0x24, 0x2c,
+	                          0x01, 0x00, 0x00, 0x07, 0x40, 0x0f, 0x95, 0xc6, 0x40, 0x0f, 0xb6,
+	                          0xf6, 0xe9, 0xd9, 0xff, 0xff, 0xff}));
+
+	a.jump(a.new_label());
+	EXPECT_THROW(a.finish(), harpoon::execution::exception::jit_error);
+}
+
+TEST_F(jit_compiler_test, hot_blocks) {
+	/* add 3; st 0x1400; ld 0x1400; jmp back */
+	load(0x0100, {0x01, 0x03, 0x03, 0x00, 0x14, 0x05, 0x00, 0x14, 0x02, 0x00, 0x01});
+	cpu processing_unit(_main_memory);
+	_blocks->set_jit_compiler(_jit, 2);
+	processing_unit.set_block_interpreter(_blocks);
+	processing_unit.regs.pc = 0x0100;
+
+	/* Five cycles a round; the first runs threaded, the second compiles the block. */
+	EXPECT_EQ(processing_unit.run_blocks(processing_unit, 50), 50u);
+	EXPECT_EQ(processing_unit.regs.acc, 30u);
+	EXPECT_EQ(processing_unit.regs.pc, 0x0100u);
+	std::uint8_t stored;
+	_main_memory->get(0x1400, stored);
+	EXPECT_EQ(stored, 30u);
+
+	const auto &statistics = _blocks->get_statistics();
+	EXPECT_EQ(statistics.executed, 10u);
+	EXPECT_EQ(statistics.native, 9u);
+	EXPECT_EQ(statistics.instructions, 40u);
+	EXPECT_EQ(processing_unit.get_executed_instructions(), 40u);
+	EXPECT_EQ(_jit->get_statistics().compiled, 1u);
+	EXPECT_GT(_jit->get_statistics().code_bytes, 0u);
+
+	/* Code written from outside between runs drops the compiled block. */
+	_main_memory->set(0x0101, std::uint8_t{5});
+	EXPECT_EQ(processing_unit.run_blocks(processing_unit, 5), 5u);
+	EXPECT_EQ(processing_unit.regs.acc, 35u);
+	EXPECT_EQ(statistics.translated, 2u);
+}
+
+TEST_F(jit_compiler_test, exits) {
+	/* add 7; out; add 1; jmp back */
+	load(0x0600, {0x01, 0x07, 0x04, 0x01, 0x01, 0x02, 0x00, 0x06});
+	cpu processing_unit(_main_memory);
+	_blocks->set_jit_compiler(_jit, 1);
+	processing_unit.set_block_interpreter(_blocks);
+	processing_unit.regs.pc = 0x0600;
+
+	EXPECT_EQ(processing_unit.run_blocks(processing_unit, 100), 2u);
+	EXPECT_EQ(processing_unit.output, std::vector<std::uint8_t>{7});
+	EXPECT_EQ(processing_unit.regs.pc, 0x0603u);
+	EXPECT_EQ(processing_unit.get_executed_instructions(), 2u);
+	EXPECT_EQ(_blocks->get_statistics().native, 1u);
+
+	EXPECT_EQ(processing_unit.run_blocks(processing_unit, 5), 5u);
+	EXPECT_EQ(processing_unit.output, (std::vector<std::uint8_t>{7, 15}));
+}
+
+TEST_F(jit_compiler_test, faults) {
+	/* add 1; ld 0x9000, which is not mapped */
+	load(0x0500, {0x01, 0x01, 0x05, 0x00, 0x90});
+	cpu processing_unit(_main_memory);
+	_blocks->set_jit_compiler(_jit, 1);
+	processing_unit.set_block_interpreter(_blocks);
+	processing_unit.regs.pc = 0x0500;
+
+	EXPECT_THROW(processing_unit.run_blocks(processing_unit, 100),
+	             harpoon::memory::exception::read_access_violation);
+	EXPECT_EQ(processing_unit.regs.acc, 1u);
+	EXPECT_EQ(processing_unit.regs.pc, 0x0502u);
+	EXPECT_EQ(_blocks->get_statistics().instructions, 1u);
+}
+
+TEST_F(jit_compiler_test, self_modifying_code) {
+	/* add n; st to n; jmp back: every round doubles acc, if the change is seen. */
+	load(0x0300, {0x01, 0x05, 0x03, 0x01, 0x03, 0x02, 0x00, 0x03});
+	cpu processing_unit(_main_memory);
+	_blocks->set_jit_compiler(_jit, 1);
+	processing_unit.set_block_interpreter(_blocks);
+	processing_unit.regs.pc = 0x0300;
+
+	EXPECT_EQ(processing_unit.run_blocks(processing_unit, 12), 12u);
+	EXPECT_EQ(processing_unit.regs.acc, 20u);
+	EXPECT_EQ(processing_unit.regs.pc, 0x0300u);
+	EXPECT_EQ(_jit->get_statistics().compiled, 6u);
+	EXPECT_EQ(_blocks->get_statistics().native, 6u);
+}
+
+TEST_F(jit_compiler_test, self_modifying_helper) {
+	/* add n; poke n; jmp back, as self_modifying_code with the store in a helper. */
+	load(0x0300, {0x01, 0x05, 0x06, 0x01, 0x03, 0x02, 0x00, 0x03});
+	cpu processing_unit(_main_memory);
+	_blocks->set_jit_compiler(_jit, 1);
+	processing_unit.set_block_interpreter(_blocks);
+	processing_unit.regs.pc = 0x0300;
+
+	EXPECT_EQ(processing_unit.run_blocks(processing_unit, 12), 12u);
+	EXPECT_EQ(processing_unit.regs.acc, 20u);
+	EXPECT_EQ(processing_unit.regs.pc, 0x0300u);
+	EXPECT_EQ(_blocks->get_statistics().native, 6u);
+}
+
+TEST_F(jit_compiler_test, full_buffer) {
+	/* add 1; jmp 0x0200 and add 2; jmp 0x0100, which compile to the same size. */
+	load(0x0100, {0x01, 0x01, 0x02, 0x00, 0x02});
+	load(0x0200, {0x01, 0x02, 0x02, 0x00, 0x01});
+	cpu processing_unit(_main_memory);
+	_blocks->set_jit_compiler(_jit, 1);
+	processing_unit.set_block_interpreter(_blocks);
+	processing_unit.regs.pc = 0x0100;
+	EXPECT_EQ(processing_unit.run_blocks(processing_unit, 3), 3u);
+	std::size_t block_size = _jit->get_statistics().code_bytes;
+	ASSERT_GT(block_size, 0u);
+
+	/* Room for one block only, so each compile starts the buffer over. */
+	_jit = harpoon::execution::make_jit_compiler(block_size + 8);
+	_blocks->set_jit_compiler(_jit, 1);
+	processing_unit.regs = {0x0100, 0};
+	EXPECT_EQ(processing_unit.run_blocks(processing_unit, 30), 30u);
+	EXPECT_EQ(processing_unit.regs.acc, 15u);
+	EXPECT_GT(_blocks->get_statistics().native, 0u);
+	EXPECT_GT(_jit->get_statistics().resets, 0u);
+
+	/* Blocks too large for the buffer stay threaded. */
+	_jit = harpoon::execution::make_jit_compiler(16);
+	_blocks->set_jit_compiler(_jit, 1);
+	EXPECT_EQ(processing_unit.run_blocks(processing_unit, 30), 30u);
+	EXPECT_EQ(processing_unit.regs.acc, 30u);
+	EXPECT_EQ(_jit->get_statistics().compiled, 0u);
+	EXPECT_EQ(_jit->get_statistics().resets, 0u);
+	EXPECT_GT(_jit->get_statistics().failed, 0u);
+}
+
+TEST_F(jit_compiler_test, frozen_pages) {
+	auto chunked = harpoon::memory::make_chunked_random_access_memory(
+	    "chunked", address_range(0x8000, 0xffff), 0x1000);
+	_main_memory->add_memory(chunked);
+	chunked->prepare();
+	_main_memory->set(0x9000, std::uint8_t{0x10});
+
+	/* ld 0x9000; add 1; st 0x9000; ld 0x9000; out */
+	load(0x0100, {0x05, 0x00, 0x90, 0x01, 0x01, 0x03, 0x00, 0x90, 0x05, 0x00, 0x90, 0x04});
+	cpu processing_unit(_main_memory);
+	_blocks->set_jit_compiler(_jit, 1);
+	processing_unit.set_block_interpreter(_blocks);
+	processing_unit.regs.pc = 0x0100;
+
+	/* The store copies the shared chunk; the second load has to see the copy. */
+	auto frozen = _main_memory->freeze();
+	EXPECT_EQ(processing_unit.run_blocks(processing_unit, 100), 5u);
+	EXPECT_EQ(processing_unit.output, std::vector<std::uint8_t>{0x11});
+	EXPECT_EQ(_blocks->get_statistics().native, 1u);
+	frozen.reset();
+}
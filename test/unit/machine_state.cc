@@ -0,0 +1,179 @@
+#include <gtest/gtest.h>
+#include <harpoon/clock/clock.hh>
+#include <harpoon/computer_system.hh>
+#include <harpoon/execution/basic_register.hh>
+#include <harpoon/execution/exception/execution_exception.hh>
+#include <harpoon/execution/processing_unit.hh>
+#include <harpoon/execution/up_execution_unit.hh>
+#include <harpoon/memory/chunked_random_access_memory.hh>
+#include <harpoon/memory/main_memory.hh>
+#include <harpoon/state/exception/bad_state.hh>
+#include <harpoon/state/reader.hh>
+#include <harpoon/state/writer.hh>
+
+using harpoon::memory::address_range;
+
+namespace {
+
+class cpu : public harpoon::execution::processing_unit {
+public:
+	using harpoon::execution::processing_unit::processing_unit;
+
+	harpoon::execution::basic_register<std::uint32_t> pc{};
+	harpoon::execution::basic_register<std::uint8_t> a{};
+
+	void issue_instruction() {
+		using harpoon::execution::instruction;
+		set_current_instruction(
+		    instruction(this, nullptr, {{instruction::no_delay, instruction::no_delay}}));
+	}
+
+protected:
+	virtual void save_state(harpoon::state::writer &writer) const override {
+		processing_unit::save_state(writer);
+		pc.save(writer);
+		a.save(writer);
+	}
+
+	virtual void restore_state(harpoon::state::reader &reader) override {
+		processing_unit::restore_state(reader);
+		pc.restore(reader);
+		a.restore(reader);
+	}
+};
+
+struct machine {
+	harpoon::computer_system_ptr system;
+	harpoon::clock::clock_ptr clock;
+	std::shared_ptr<cpu> processing_unit;
+	harpoon::memory::main_memory_ptr main_memory;
+
+	machine() {
+		system = harpoon::make_computer_system("system");
+		clock = harpoon::clock::make_clock(1000000, "clock");
+		processing_unit = std::make_shared<cpu>("cpu");
+
+		auto execution_unit = harpoon::execution::make_up_execution_unit("execution-unit");
+		execution_unit->set_clock(clock);
+		execution_unit->set_processing_unit(processing_unit);
+		system->set_main_execution_unit(execution_unit);
+
+		main_memory = harpoon::memory::make_main_memory("main-memory");
+		main_memory->add_memory(harpoon::memory::make_chunked_random_access_memory(
+		    "ram", address_range(0x0000, 0xffff), 0x1000));
+		system->set_main_memory(main_memory);
+
+		system->prepare();
+	}
+
+	~machine() {
+		system->cleanup();
+	}
+};
+
+} // namespace
+
+TEST(machine_state, round_trip) {
+	machine m;
+	m.processing_unit->pc = 0x1234;
+	m.processing_unit->a = 0x56;
+	m.processing_unit->issue_instruction();
+	m.processing_unit->execute_instruction();
+	m.main_memory->set(0x2000, std::uint32_t{0xdeadbeef});
+
+	auto saved = m.system->save_machine_state();
+	EXPECT_GE(saved->get_length(), 0x1000u);
+
+	m.processing_unit->pc = 0;
+	m.processing_unit->a = 0;
+	m.processing_unit->issue_instruction();
+	m.main_memory->set(0x2000, std::uint32_t{0});
+	m.main_memory->set(0x8000, std::uint8_t{0xff});
+
+	m.system->restore_machine_state(*saved);
+	EXPECT_EQ(m.processing_unit->pc.get(), 0x1234u);
+	EXPECT_EQ(m.processing_unit->a.get(), 0x56u);
+	EXPECT_EQ(m.processing_unit->get_executed_instructions(), 1u);
+	EXPECT_TRUE(m.processing_unit->get_current_instruction().done());
+
+	std::uint32_t value;
+	m.main_memory->get(0x2000, value);
+	EXPECT_EQ(value, 0xdeadbeefu);
+	std::uint8_t byte;
+	m.main_memory->get(0x8000, byte);
+	EXPECT_EQ(byte, 0u);
+}
+
+TEST(machine_state, other_machine) {
+	machine source;
+	source.processing_unit->pc = 0xcafe;
+	source.main_memory->set(0xfffc, std::uint32_t{0x01020304});
+	auto saved = source.system->save_machine_state();
+
+	machine target;
+	target.system->restore_machine_state(*saved);
+	EXPECT_EQ(target.processing_unit->pc.get(), 0xcafeu);
+
+	std::uint32_t value;
+	target.main_memory->get(0xfffc, value);
+	EXPECT_EQ(value, 0x01020304u);
+}
+
+TEST(machine_state, instruction_in_flight) {
+	machine m;
+	m.processing_unit->issue_instruction();
+	EXPECT_THROW(m.system->save_machine_state(),
+	             harpoon::execution::exception::execution_exception);
+}
+
+TEST(machine_state, component_mismatch) {
+	machine source;
+	auto saved = source.system->save_machine_state();
+
+	machine target;
+	target.processing_unit->set_name("other-cpu");
+	EXPECT_THROW(target.system->restore_machine_state(*saved),
+	             harpoon::state::exception::bad_state);
+}
+
+TEST(machine_state, truncated) {
+	std::vector<std::uint8_t> data;
+	harpoon::state::writer writer(data);
+	auto mark = writer.begin_section("component");
+	writer.write(std::uint64_t{42});
+	writer.end_section(mark);
+
+	harpoon::state::reader reader(data.data(), data.size() - 1);
+	EXPECT_THROW(reader.begin_section("component"), harpoon::state::exception::bad_state);
+}
+
+TEST(machine_state, digest_and_diff) {
+	machine first, second;
+	for (auto m : {&first, &second}) {
+		m->processing_unit->pc = 0x100;
+		m->main_memory->set(0x2000, std::uint32_t{0xdeadbeef});
+	}
+	EXPECT_EQ(first.system->get_digest(), second.system->get_digest());
+
+	auto saved = first.system->save_machine_state();
+	EXPECT_EQ(saved->get_digest(), first.system->get_digest());
+
+	std::vector<address_range> ranges;
+	EXPECT_TRUE(first.system->diff(*second.system, ranges));
+	EXPECT_TRUE(ranges.empty());
+
+	second.main_memory->set(0x8001, std::uint16_t{0xffff});
+	EXPECT_NE(first.system->get_digest(), second.system->get_digest());
+	EXPECT_TRUE(first.system->diff(*second.system, ranges));
+	EXPECT_EQ(ranges, std::vector<address_range>({{0x8001, 0x8002}}));
+
+	second.processing_unit->pc = 0x104;
+	ranges.clear();
+	EXPECT_FALSE(first.system->diff(*second.system, ranges));
+
+	first.main_memory->set(0xfff0, std::uint8_t{1});
+	ranges.clear();
+	EXPECT_TRUE(first.system->diff(*saved, ranges));
+	EXPECT_EQ(ranges, std::vector<address_range>({{0xfff0, 0xfff0}}));
+	EXPECT_FALSE(second.system->diff(*saved, ranges));
+}
@@ -0,0 +1,130 @@
+#include <gtest/gtest.h>
+#include <harpoon/memory/access_profiler.hh>
+#include <harpoon/memory/linear_random_access_memory.hh>
+#include <harpoon/memory/main_memory.hh>
+
+#include <sstream>
+
+using harpoon::memory::access_kind;
+using harpoon::memory::access_profiler;
+
+namespace {
+
+class access_profiler_test : public ::testing::Test {
+protected:
+	harpoon::memory::main_memory_ptr _main_memory;
+	harpoon::memory::access_profiler_ptr _profiler;
+
+	virtual void SetUp() {
+		_main_memory = harpoon::memory::make_main_memory("main-memory");
+		_main_memory->add_memory(
+		    harpoon::memory::make_linear_random_access_memory(
+		        "ram", harpoon::memory::address_range(0x0000, 0x3fff)));
+		_main_memory->prepare();
+	}
+
+	virtual void TearDown() {
+		_main_memory->cleanup();
+	}
+};
+
+} // namespace
+
+TEST_F(access_profiler_test, disabled) {
+	std::uint8_t v = 0;
+	_main_memory->set(0x10, v);
+	_main_memory->get(0x10, v);
+	EXPECT_EQ(_main_memory->get_access_profiler(), nullptr);
+}
+
+TEST_F(access_profiler_test, counts_per_page) {
+	_profiler = harpoon::memory::make_access_profiler(12);
+	_main_memory->set_access_profiler(_profiler);
+
+	std::uint8_t b;
+	std::uint16_t w;
+	_main_memory->set(0x0010, std::uint8_t{1});
+	_main_memory->get(0x0010, b);
+	_main_memory->get(0x0020, b);
+	_main_memory->fetch(0x1000, w);
+
+	EXPECT_EQ(_profiler->get_count(0x0000, access_kind::WRITE), 1u);
+	EXPECT_EQ(_profiler->get_count(0x0fff, access_kind::READ), 2u);
+	EXPECT_EQ(_profiler->get_count(0x0000, access_kind::FETCH), 0u);
+	EXPECT_EQ(_profiler->get_count(0x1000, access_kind::FETCH), 2u);
+	EXPECT_EQ(_profiler->get_count(0x2000, access_kind::READ), 0u);
+}
+
+TEST_F(access_profiler_test, sampling) {
+	_profiler = harpoon::memory::make_access_profiler(12, 4);
+	_main_memory->set_access_profiler(_profiler);
+
+	std::uint8_t b;
+	for (int i = 0; i < 16; i++) {
+		_main_memory->get(0x0100, b);
+	}
+
+	EXPECT_EQ(_profiler->get_count(0x0100, access_kind::READ), 16u);
+}
+
+TEST_F(access_profiler_test, per_source) {
+	_profiler = harpoon::memory::make_access_profiler(12, 1, true);
+	_main_memory->set_access_profiler(_profiler);
+
+	std::uint8_t b;
+	_profiler->set_source(1);
+	_main_memory->get(0x0100, b);
+	_profiler->set_source(2);
+	_main_memory->get(0x0100, b);
+	_main_memory->get(0x0101, b);
+
+	EXPECT_EQ(_profiler->get_count(0x0100, access_kind::READ, 1), 1u);
+	EXPECT_EQ(_profiler->get_count(0x0100, access_kind::READ, 2), 2u);
+	EXPECT_EQ(_profiler->get_count(0x0100, access_kind::READ, 0), 0u);
+}
+
+TEST_F(access_profiler_test, dump_csv) {
+	_profiler = harpoon::memory::make_access_profiler(12);
+	_main_memory->set_access_profiler(_profiler);
+
+	_main_memory->set(0x1234, std::uint8_t{1});
+
+	std::stringstream stream;
+	_profiler->dump(stream, access_profiler::Format::CSV);
+
+	EXPECT_EQ(stream.str(), "source,page_start,page_end,read_bytes,write_bytes,fetch_bytes\n"
+	                        "0,0x0000000000001000,0x0000000000001FFF,0,1,0\n");
+}
+
+TEST_F(access_profiler_test, dump_json) {
+	_profiler = harpoon::memory::make_access_profiler(12);
+	_main_memory->set_access_profiler(_profiler);
+
+	std::uint8_t b;
+	_main_memory->get(0x2000, b);
+
+	std::stringstream stream;
+	_profiler->dump(stream, access_profiler::Format::JSON);
+
+	EXPECT_NE(stream.str().find("\"page_start\": \"0x0000000000002000\", \"read_bytes\": 1, "
+	                            "\"write_bytes\": 0, \"fetch_bytes\": 0"),
+	          std::string::npos);
+}
+
+TEST_F(access_profiler_test, reset) {
+	_profiler = harpoon::memory::make_access_profiler(12);
+	_main_memory->set_access_profiler(_profiler);
+
+	std::uint32_t v;
+	_main_memory->get(0x1000, v);
+	EXPECT_EQ(_profiler->get_count(0x1000, access_kind::READ), 4u);
+
+	_profiler->reset();
+	EXPECT_EQ(_profiler->get_count(0x1000, access_kind::READ), 0u);
+	std::stringstream stream;
+	_profiler->dump(stream, access_profiler::Format::CSV);
+	EXPECT_EQ(stream.str(), "source,page_start,page_end,read_bytes,write_bytes,fetch_bytes\n");
+
+	_main_memory->get(0x1000, v);
+	EXPECT_EQ(_profiler->get_count(0x1000, access_kind::READ), 4u);
+}
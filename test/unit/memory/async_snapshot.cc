@@ -0,0 +1,151 @@
+#include <gtest/gtest.h>
+#include <harpoon/memory/async_snapshot.hh>
+#include <harpoon/memory/chunked_random_access_memory.hh>
+#include <harpoon/memory/deserializer/memory_buffer.hh>
+#include <harpoon/memory/linear_random_access_memory.hh>
+#include <harpoon/memory/main_memory.hh>
+#include <harpoon/memory/serializer/memory_buffer.hh>
+
+#include <future>
+#include <stdexcept>
+
+using harpoon::memory::address_range;
+
+namespace {
+
+class failing_serializer : public harpoon::memory::serializer::serializer {
+public:
+	using serializer::serializer;
+
+protected:
+	virtual void do_start_memory_block() override {}
+	virtual std::size_t do_write(uint8_t *, std::size_t, std::size_t, bool) override {
+		throw std::runtime_error("disk full");
+	}
+};
+
+/* Holds the background writer until the test opens the gate. */
+class gated_serializer : public harpoon::memory::serializer::memory_buffer {
+public:
+	gated_serializer(const address_range &range, std::shared_future<void> gate)
+	    : memory_buffer(range), _gate(gate) {}
+
+protected:
+	virtual std::size_t do_write(uint8_t *data, std::size_t offset, std::size_t length,
+	                             bool sparse) override {
+		_gate.wait();
+		return memory_buffer::do_write(data, offset, length, sparse);
+	}
+
+private:
+	std::shared_future<void> _gate;
+};
+
+class async_snapshot : public ::testing::Test {
+protected:
+	harpoon::memory::main_memory_ptr _main_memory{};
+	harpoon::memory::chunked_random_access_memory_ptr _chunked{};
+	harpoon::memory::linear_random_access_memory_ptr _linear{};
+
+	virtual void SetUp() {
+		_main_memory = harpoon::memory::make_main_memory("main-memory");
+		_chunked = harpoon::memory::make_chunked_random_access_memory(
+		    "chunked", address_range(0x0000, 0xffff), 0x1000);
+		_linear = harpoon::memory::make_linear_random_access_memory(
+		    "linear", address_range(0x10000, 0x10fff));
+		_main_memory->add_memory(_chunked);
+		_main_memory->add_memory(_linear);
+		_main_memory->prepare();
+
+		_main_memory->fill(address_range(0x1000, 0x2fff), 0x11);
+		_main_memory->fill(_linear->get_address_range(), 0x22);
+	}
+
+	virtual void TearDown() {
+		_main_memory->cleanup();
+	}
+
+	std::uint8_t *chunk_data(harpoon::memory::address address) {
+		harpoon::memory::memory::span span;
+		EXPECT_TRUE(_chunked->get_span(address, false, span));
+		return span.data;
+	}
+};
+
+} // namespace
+
+TEST_F(async_snapshot, copy_on_write) {
+	std::promise<void> gate;
+	auto serializer
+	    = std::make_shared<gated_serializer>(address_range(0, 0x10fff), gate.get_future().share());
+	auto image = serializer->get_image();
+
+	std::uint8_t *first = chunk_data(0x1000);
+	std::uint8_t *second = chunk_data(0x2000);
+
+	harpoon::memory::async_snapshot snapshot(_main_memory, serializer);
+	serializer.reset();
+
+	_main_memory->set(0x1000, std::uint8_t{0x33});
+	_main_memory->set(0x5000, std::uint8_t{0x44});
+	_main_memory->set(0x10000, std::uint8_t{0x55});
+	EXPECT_NE(chunk_data(0x1000), first);
+	EXPECT_EQ(chunk_data(0x2000), second);
+
+	gate.set_value();
+	snapshot.wait();
+	EXPECT_TRUE(snapshot.is_done());
+
+	_main_memory->set(0x2000, std::uint8_t{0x66});
+	EXPECT_EQ(chunk_data(0x2000), second);
+
+	harpoon::memory::deserializer::memory_buffer deserializer(image);
+	_main_memory->deserialize(deserializer);
+
+	std::uint8_t v;
+	_main_memory->get(0x1000, v);
+	EXPECT_EQ(v, 0x11);
+	_main_memory->get(0x2000, v);
+	EXPECT_EQ(v, 0x11);
+	_main_memory->get(0x5000, v);
+	EXPECT_EQ(v, 0x00);
+	_main_memory->get(0x10000, v);
+	EXPECT_EQ(v, 0x22);
+}
+
+TEST_F(async_snapshot, error) {
+	auto serializer = std::make_shared<failing_serializer>(address_range(0, 0x10fff));
+	harpoon::memory::async_snapshot snapshot(_main_memory, serializer);
+	EXPECT_THROW(snapshot.wait(), std::runtime_error);
+}
+
+TEST_F(async_snapshot, released_memory) {
+	auto memory = harpoon::memory::make_main_memory("released");
+	auto chunked = harpoon::memory::make_chunked_random_access_memory(
+	    "released-chunked", address_range(0x0000, 0x3fff), 0x1000);
+	memory->add_memory(chunked);
+	memory->prepare();
+	memory->fill(address_range(0x1000, 0x1fff), 0x77);
+
+	std::promise<void> gate;
+	auto serializer
+	    = std::make_shared<gated_serializer>(address_range(0, 0x3fff), gate.get_future().share());
+	auto image = serializer->get_image();
+
+	harpoon::memory::async_snapshot snapshot(memory, serializer);
+	serializer.reset();
+	chunked.reset();
+	memory.reset();
+
+	gate.set_value();
+	snapshot.wait();
+
+	harpoon::memory::deserializer::memory_buffer deserializer(image);
+	_main_memory->deserialize(deserializer);
+
+	std::uint8_t v;
+	_main_memory->get(0x1000, v);
+	EXPECT_EQ(v, 0x77);
+	_main_memory->get(0x2000, v);
+	EXPECT_EQ(v, 0x00);
+}
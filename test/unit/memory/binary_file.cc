@@ -0,0 +1,201 @@
+#include <gtest/gtest.h>
+#include <harpoon/memory/chunked_random_access_memory.hh>
+#include <harpoon/memory/deserializer/binary_file.hh>
+#include <harpoon/memory/linear_random_access_memory.hh>
+#include <harpoon/memory/serializer/binary_file.hh>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/stat.h>
+#endif
+
+using harpoon::memory::address_range;
+
+namespace {
+
+class binary_file : public ::testing::Test {
+protected:
+	std::string _file_name{};
+
+	virtual void SetUp() {
+		_file_name = ::testing::TempDir() + "harpoon_binary_file.bin";
+	}
+
+	virtual void TearDown() {
+		std::remove(_file_name.c_str());
+	}
+
+	std::vector<std::uint8_t> contents() const {
+		std::ifstream input(_file_name, std::ios::binary);
+		return {std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+	}
+
+	/* Bytes the file takes on disk; without holes there is nothing to check. */
+	std::size_t allocated() const {
+#if defined(__unix__) || defined(__APPLE__)
+		struct stat st;
+		::stat(_file_name.c_str(), &st);
+		return static_cast<std::size_t>(st.st_blocks) * 512;
+#else
+		return 0;
+#endif
+	}
+};
+
+} // namespace
+
+TEST_F(binary_file, chunked_memory_holes) {
+	auto memory = harpoon::memory::make_chunked_random_access_memory(
+	    "chunked", address_range(0x100000, 0x4fffff), 0x10000);
+	memory->prepare();
+	memory->set(0x100000, std::uint8_t{0x11});
+	memory->set(0x3fffff, std::uint8_t{0x22});
+	memory->set(0x4fffff, std::uint8_t{0x33});
+	memory->set(0x200000, std::uint8_t{0x00});
+
+	{
+		harpoon::memory::serializer::binary_file serializer(memory->get_address_range(),
+		                                                    _file_name);
+		memory->serialize(serializer);
+	}
+
+	auto data = contents();
+	ASSERT_EQ(data.size(), 0x400000u);
+	EXPECT_EQ(data[0x000000], 0x11);
+	EXPECT_EQ(data[0x2fffff], 0x22);
+	EXPECT_EQ(data[0x3fffff], 0x33);
+	EXPECT_EQ(std::count(data.begin(), data.end(), 0), 0x400000 - 3);
+	EXPECT_LT(allocated(), 0x100000u);
+
+	auto restored = harpoon::memory::make_chunked_random_access_memory(
+	    "restored", address_range(0x100000, 0x4fffff), 0x10000);
+	restored->prepare();
+	harpoon::memory::deserializer::binary_file deserializer(0x100000, _file_name);
+	restored->deserialize(deserializer);
+
+	harpoon::memory::address difference;
+	EXPECT_TRUE(memory->compare(memory->get_address_range(), *restored, 0x100000, difference));
+}
+
+TEST_F(binary_file, linear_memory_zero_pages) {
+	auto memory = harpoon::memory::make_linear_random_access_memory("linear",
+	                                                                address_range(0, 0x3fffff));
+	memory->prepare();
+	memory->fill(memory->get_address_range(), 0);
+	memory->fill(address_range(0x1ff0, 0x200f), 0x5a);
+
+	{
+		harpoon::memory::serializer::binary_file serializer(memory->get_address_range(),
+		                                                    _file_name);
+		memory->serialize(serializer);
+	}
+
+	auto data = contents();
+	ASSERT_EQ(data.size(), 0x400000u);
+	EXPECT_EQ(data[0x1fef], 0x00);
+	EXPECT_EQ(data[0x1ff0], 0x5a);
+	EXPECT_EQ(data[0x200f], 0x5a);
+	EXPECT_EQ(data[0x2010], 0x00);
+	EXPECT_LT(allocated(), 0x100000u);
+}
+
+TEST_F(binary_file, overwrite_with_hole) {
+	auto memory = harpoon::memory::make_linear_random_access_memory("linear",
+	                                                                address_range(0, 0x2fff));
+	memory->prepare();
+	memory->fill(memory->get_address_range(), 0xff);
+
+	harpoon::memory::serializer::binary_file serializer(memory->get_address_range(), _file_name);
+	memory->serialize(serializer);
+	memory->fill(address_range(0x1000, 0x1fff), 0);
+	memory->serialize(serializer);
+
+	auto data = contents();
+	ASSERT_EQ(data.size(), 0x3000u);
+	EXPECT_EQ(data[0x0fff], 0xff);
+	EXPECT_EQ(data[0x1000], 0x00);
+	EXPECT_EQ(data[0x1fff], 0x00);
+	EXPECT_EQ(data[0x2000], 0xff);
+}
+
+TEST_F(binary_file, restore_keeps_holes_unallocated) {
+	auto memory = harpoon::memory::make_chunked_random_access_memory(
+	    "chunked", address_range(0, 0xfffff), 0x10000);
+	memory->prepare();
+	memory->set(0x10000, std::uint8_t{0x11});
+	memory->set(0x9ffff, std::uint8_t{0x22});
+
+	{
+		harpoon::memory::serializer::binary_file serializer(memory->get_address_range(),
+		                                                    _file_name);
+		memory->serialize(serializer);
+	}
+
+	auto restored = harpoon::memory::make_chunked_random_access_memory(
+	    "restored", address_range(0, 0xfffff), 0x10000);
+	restored->prepare();
+	restored->set(0x30000, std::uint8_t{0x33});
+
+	harpoon::memory::deserializer::binary_file deserializer(0, _file_name);
+	EXPECT_TRUE(deserializer.has_data(address_range(0x10000, 0x1ffff)));
+	EXPECT_FALSE(deserializer.has_data(address_range(0x20000, 0x8ffff)));
+	restored->deserialize(deserializer);
+
+	harpoon::memory::address difference;
+	EXPECT_TRUE(memory->compare(memory->get_address_range(), *restored, 0, difference));
+
+	harpoon::memory::memory::span span;
+	for (harpoon::memory::address a = 0; a < 0x100000; a += 0x10000) {
+		ASSERT_TRUE(restored->get_span(a, false, span));
+		EXPECT_EQ(span.data != nullptr, a == 0x10000 || a == 0x90000) << a;
+	}
+}
+
+TEST_F(binary_file, restore_zero_data) {
+	std::vector<char> zeros(0x20000);
+	zeros[0x1ffff] = 1;
+	std::ofstream(_file_name, std::ios::binary).write(zeros.data(), 0x20000);
+
+	auto restored = harpoon::memory::make_chunked_random_access_memory(
+	    "restored", address_range(0, 0x1ffff), 0x10000);
+	restored->prepare();
+	harpoon::memory::deserializer::binary_file deserializer(0, _file_name);
+	restored->deserialize(deserializer);
+
+	harpoon::memory::memory::span span;
+	ASSERT_TRUE(restored->get_span(0, false, span));
+	EXPECT_EQ(span.data, nullptr);
+	ASSERT_TRUE(restored->get_span(0x10000, false, span));
+	ASSERT_NE(span.data, nullptr);
+	EXPECT_EQ(span.data[0xffff], 1);
+}
+
+TEST_F(binary_file, buffers_released_on_finalize) {
+	auto memory = harpoon::memory::make_linear_random_access_memory("linear",
+	                                                                address_range(0, 0x1fff));
+	std::vector<std::uint8_t> first(0x1000, 0x11);
+	std::vector<std::uint8_t> second(0x1000, 0x22);
+
+	{
+		harpoon::memory::serializer::binary_file serializer(memory->get_address_range(),
+		                                                    _file_name);
+		serializer.start_memory_block(memory.get());
+		serializer.write(first.data(), 0, first.size());
+		serializer.write(second.data(), 0x1000, second.size());
+		serializer.finalize_memory_block();
+
+		/* Nothing written may refer to the buffers once the block is finalized. */
+		std::fill(first.begin(), first.end(), 0x33);
+		second.clear();
+		second.shrink_to_fit();
+	}
+
+	auto data = contents();
+	ASSERT_EQ(data.size(), 0x2000u);
+	EXPECT_EQ(std::count(data.begin(), data.begin() + 0x1000, 0x11), 0x1000);
+	EXPECT_EQ(std::count(data.begin() + 0x1000, data.end(), 0x22), 0x1000);
+}
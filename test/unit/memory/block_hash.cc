@@ -0,0 +1,166 @@
+#include <gtest/gtest.h>
+#include <harpoon/memory/chunked_random_access_memory.hh>
+#include <harpoon/memory/linear_random_access_memory.hh>
+#include <harpoon/memory/main_memory.hh>
+#include <harpoon/memory/memory_image.hh>
+#include <harpoon/memory/serializer/memory_buffer.hh>
+
+#include <vector>
+
+using harpoon::memory::address_range;
+using harpoon::memory::memory;
+
+namespace {
+
+const address_range ram_range(0x00000, 0x3ffff);
+
+harpoon::memory::chunked_random_access_memory_ptr make_chunked() {
+	auto m = harpoon::memory::make_chunked_random_access_memory("chunked", ram_range, 0x1000);
+	m->prepare();
+	return m;
+}
+
+harpoon::memory::linear_random_access_memory_ptr make_linear(
+    const harpoon::util::thread_pool_ptr &pool) {
+	auto m = harpoon::memory::make_linear_random_access_memory("linear", ram_range);
+	m->set_thread_pool(pool);
+	m->prepare();
+	m->fill(ram_range, 0);
+	return m;
+}
+
+void populate(harpoon::memory::memory &m) {
+	for (harpoon::memory::address a = 0x10000; a < 0x20000; a += 0x40) {
+		m.set(a, static_cast<std::uint32_t>(a * 3));
+	}
+}
+
+} // namespace
+
+TEST(block_hash, chunked_cache) {
+	auto m = make_chunked();
+	populate(*m);
+
+	std::vector<memory::block_hash> first, second;
+	m->get_block_hashes(first);
+	ASSERT_EQ(first.size(), 0x40u);
+	EXPECT_EQ(first[0x11].range, address_range(0x11000, 0x11fff));
+
+	/* Unallocated chunks hash like allocated zero chunks. */
+	EXPECT_EQ(first[0].hash, first[0x3f].hash);
+	m->set(0x3f000, std::uint8_t{0});
+	m->get_block_hashes(second);
+	EXPECT_EQ(second[0x3f].hash, first[0].hash);
+
+	m->set(0x11004, std::uint8_t{0x55});
+	second.clear();
+	m->get_block_hashes(second);
+	for (std::size_t i = 0; i < first.size(); i++) {
+		EXPECT_EQ(first[i].hash == second[i].hash, i != 0x11) << i;
+	}
+
+	/* Dirty tracking is not disturbed by hashing. */
+	m->clear_dirty();
+	second.clear();
+	m->get_block_hashes(second);
+	std::vector<address_range> dirty;
+	m->get_dirty(dirty);
+	EXPECT_TRUE(dirty.empty());
+	m->cleanup();
+}
+
+TEST(block_hash, linear_parallel) {
+	auto sequential = make_linear(nullptr);
+	auto parallel = make_linear(harpoon::util::make_thread_pool(4));
+	populate(*sequential);
+	populate(*parallel);
+
+	std::vector<memory::block_hash> a, b;
+	sequential->get_block_hashes(a);
+	parallel->get_block_hashes(b);
+	ASSERT_EQ(a.size(), 4u);
+	ASSERT_EQ(b.size(), a.size());
+	for (std::size_t i = 0; i < a.size(); i++) {
+		EXPECT_EQ(a[i].range, b[i].range);
+		EXPECT_EQ(a[i].hash, b[i].hash);
+	}
+	EXPECT_EQ(sequential->get_digest(), parallel->get_digest());
+
+	sequential->cleanup();
+	parallel->cleanup();
+}
+
+TEST(block_hash, diff) {
+	auto a = make_chunked();
+	auto b = make_chunked();
+	auto c = make_linear(nullptr);
+	for (auto m : std::vector<harpoon::memory::memory *>{a.get(), b.get(), c.get()}) {
+		populate(*m);
+	}
+	EXPECT_EQ(a->get_digest(), b->get_digest());
+
+	std::vector<address_range> ranges;
+	a->diff(*b, ranges);
+	EXPECT_TRUE(ranges.empty());
+	a->diff(*c, ranges);
+	EXPECT_TRUE(ranges.empty());
+
+	b->set(0x01234, std::uint8_t{1});
+	b->set(0x11ffe, std::uint32_t{0xffffffff});
+	b->set(0x3ffff, std::uint8_t{2});
+	c->set(0x01234, std::uint8_t{1});
+	c->set(0x11ffe, std::uint32_t{0xffffffff});
+	c->set(0x3ffff, std::uint8_t{2});
+	EXPECT_NE(a->get_digest(), b->get_digest());
+
+	std::vector<address_range> expected{
+	    {0x01234, 0x01234}, {0x11ffe, 0x12001}, {0x3ffff, 0x3ffff}};
+	a->diff(*b, ranges);
+	EXPECT_EQ(ranges, expected);
+
+	ranges.clear();
+	a->diff(*c, ranges);
+	EXPECT_EQ(ranges, expected);
+
+	ranges.clear();
+	c->diff(*a, ranges);
+	EXPECT_EQ(ranges, expected);
+
+	a->cleanup();
+	b->cleanup();
+	c->cleanup();
+}
+
+TEST(block_hash, diff_image) {
+	auto main_memory = harpoon::memory::make_main_memory("main-memory");
+	auto chunked = harpoon::memory::make_chunked_random_access_memory(
+	    "chunked", address_range(0x00000, 0x1ffff), 0x1000);
+	auto linear = harpoon::memory::make_linear_random_access_memory(
+	    "linear", address_range(0x20000, 0x2ffff));
+	main_memory->add_memory(chunked);
+	main_memory->add_memory(linear);
+	main_memory->prepare();
+	linear->fill(linear->get_address_range(), 0);
+	populate(*main_memory);
+
+	address_range mapped = main_memory->get_mapped_range();
+	harpoon::memory::serializer::memory_buffer serializer(mapped);
+	main_memory->serialize(serializer);
+	std::vector<memory::block_hash> hashes;
+	main_memory->get_block_hashes(hashes);
+	EXPECT_EQ(hashes.size(), 0x21u);
+
+	main_memory->set(0x18000, std::uint16_t{0x1234});
+	main_memory->set(0x2fff0, std::uint8_t{0x56});
+
+	std::vector<address_range> expected{{0x18000, 0x18001}, {0x2fff0, 0x2fff0}};
+	std::vector<address_range> ranges;
+	main_memory->diff(*serializer.get_image(), hashes, ranges);
+	EXPECT_EQ(ranges, expected);
+
+	ranges.clear();
+	main_memory->diff(*serializer.get_image(), {}, ranges);
+	EXPECT_EQ(ranges, expected);
+
+	main_memory->cleanup();
+}
@@ -0,0 +1,132 @@
+#include <gtest/gtest.h>
+#include <harpoon/memory/chunked_random_access_memory.hh>
+#include <harpoon/memory/deserializer/container_file.hh>
+#include <harpoon/memory/deserializer/exception/bad_container.hh>
+#include <harpoon/memory/linear_random_access_memory.hh>
+#include <harpoon/memory/main_memory.hh>
+#include <harpoon/memory/serializer/container_file.hh>
+
+#include <fstream>
+
+#include <sys/stat.h>
+
+using harpoon::memory::address_range;
+
+namespace {
+
+class container_file : public ::testing::Test {
+protected:
+	std::string _file_name{};
+	harpoon::memory::main_memory_ptr _main_memory{};
+	harpoon::memory::chunked_random_access_memory_ptr _chunked{};
+	harpoon::memory::linear_random_access_memory_ptr _linear{};
+
+	virtual void SetUp() {
+		_file_name = ::testing::TempDir() + "harpoon_container_file.snp";
+
+		_main_memory = harpoon::memory::make_main_memory("main-memory");
+		_chunked = harpoon::memory::make_chunked_random_access_memory(
+		    "chunked", address_range(0x000000, 0x7fffff), 0x4000);
+		_linear = harpoon::memory::make_linear_random_access_memory(
+		    "linear", address_range(0x800000, 0x83ffff));
+		_main_memory->add_memory(_chunked);
+		_main_memory->add_memory(_linear);
+		_main_memory->prepare();
+		_linear->fill(_linear->get_address_range(), 0);
+
+		for (harpoon::memory::address a = 0x10000; a < 0x30000; a += 4) {
+			_main_memory->set(a, static_cast<std::uint32_t>(a >> 8));
+		}
+		for (harpoon::memory::address a = 0x800000; a < 0x801000; a++) {
+			_main_memory->set(a, static_cast<std::uint8_t>(a * 13));
+		}
+		_main_memory->set(0x7fffff, std::uint8_t{0x77});
+	}
+
+	virtual void TearDown() {
+		_main_memory->cleanup();
+		std::remove(_file_name.c_str());
+	}
+
+	void save() {
+		harpoon::memory::serializer::container_file serializer(address_range(0, 0x83ffff),
+		                                                       _file_name);
+		_main_memory->serialize(serializer);
+	}
+};
+
+} // namespace
+
+TEST_F(container_file, round_trip) {
+	save();
+
+	struct stat st;
+	ASSERT_EQ(::stat(_file_name.c_str(), &st), 0);
+	EXPECT_LT(st.st_size, 0x20000);
+
+	auto restored = harpoon::memory::make_main_memory("restored");
+	auto chunked = harpoon::memory::make_chunked_random_access_memory(
+	    "chunked", address_range(0x000000, 0x7fffff), 0x4000);
+	auto linear = harpoon::memory::make_linear_random_access_memory(
+	    "linear", address_range(0x800000, 0x83ffff));
+	restored->add_memory(chunked);
+	restored->add_memory(linear);
+	restored->prepare();
+
+	harpoon::memory::deserializer::container_file deserializer(_file_name);
+	EXPECT_EQ(deserializer.get_range(), address_range(0, 0x83ffff));
+	restored->deserialize(deserializer);
+
+	harpoon::memory::address difference;
+	EXPECT_TRUE(_main_memory->compare(address_range(0, 0x83ffff), *restored, 0, difference));
+
+	harpoon::memory::memory::span span;
+	ASSERT_TRUE(chunked->get_span(0x400000, false, span));
+	EXPECT_EQ(span.data, nullptr);
+
+	restored->cleanup();
+}
+
+TEST_F(container_file, random_access) {
+	save();
+
+	harpoon::memory::deserializer::container_file deserializer(_file_name);
+	EXPECT_TRUE(deserializer.has_data(address_range(0x2fff0, 0x3ffff)));
+	EXPECT_FALSE(deserializer.has_data(address_range(0x30000, 0x7fbfff)));
+	EXPECT_TRUE(deserializer.has_data(address_range(0x30000, 0x7fffff)));
+
+	std::vector<std::uint8_t> buffer(16, 0xff);
+	deserializer.read(_chunked.get(), buffer.data(), address_range(0x2fff8, 0x30007));
+	EXPECT_EQ(buffer[0], 0xff);
+	EXPECT_EQ(buffer[1], 0x02);
+	EXPECT_EQ(buffer[2], 0x00);
+	EXPECT_EQ(buffer[8], 0x00);
+	EXPECT_EQ(buffer[15], 0x00);
+}
+
+TEST_F(container_file, corruption) {
+	save();
+
+	harpoon::memory::deserializer::container_file reference(_file_name);
+	ASSERT_FALSE(reference.get_index().empty());
+	auto offset = reference.get_index().front().offset;
+
+	{
+		std::fstream file(_file_name, std::ios::binary | std::ios::in | std::ios::out);
+		file.seekp(static_cast<std::streamoff>(offset + 2));
+		file.put('\x5a');
+	}
+
+	harpoon::memory::deserializer::container_file deserializer(_file_name);
+	std::vector<std::uint8_t> buffer(0x10000);
+	EXPECT_THROW(deserializer.read(_chunked.get(), buffer.data(), address_range(0x10000, 0x1ffff)),
+	             harpoon::memory::deserializer::exception::bad_container);
+
+	{
+		std::ofstream file(_file_name, std::ios::binary);
+		file << "not a snapshot container, not at all";
+		file << std::string(64, ' ');
+	}
+	EXPECT_THROW(harpoon::memory::deserializer::container_file{_file_name},
+	             harpoon::memory::deserializer::exception::bad_container);
+}
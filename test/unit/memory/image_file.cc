@@ -0,0 +1,306 @@
+#include <gtest/gtest.h>
+#include <harpoon/memory/chunked_random_access_memory.hh>
+#include <harpoon/memory/deserializer/elf_file.hh>
+#include <harpoon/memory/deserializer/exception/bad_image_file.hh>
+#include <harpoon/memory/deserializer/exception/io.hh>
+#include <harpoon/memory/deserializer/hex_file.hh>
+#include <harpoon/memory/deserializer/srec_file.hh>
+#include <harpoon/memory/linear_random_access_memory.hh>
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+#include <vector>
+
+using harpoon::memory::address_range;
+using harpoon::memory::deserializer::exception::bad_image_file;
+
+namespace {
+
+std::string hex_record(std::uint8_t type, std::uint16_t offset, std::vector<std::uint8_t> data) {
+	std::vector<std::uint8_t> bytes{static_cast<std::uint8_t>(data.size()),
+	                                static_cast<std::uint8_t>(offset >> 8),
+	                                static_cast<std::uint8_t>(offset), type};
+	bytes.insert(bytes.end(), data.begin(), data.end());
+
+	std::ostringstream line;
+	unsigned int sum = 0;
+	line << ':' << std::hex << std::uppercase << std::setfill('0');
+	for (auto b : bytes) {
+		line << std::setw(2) << static_cast<unsigned int>(b);
+		sum += b;
+	}
+	line << std::setw(2) << ((0x100 - (sum & 0xff)) & 0xff) << "\r\n";
+	return line.str();
+}
+
+std::string srec_record(int type, std::uint32_t address, int address_bytes,
+                        std::vector<std::uint8_t> data) {
+	std::vector<std::uint8_t> bytes{static_cast<std::uint8_t>(address_bytes + data.size() + 1)};
+	for (int i = address_bytes - 1; i >= 0; i--) {
+		bytes.push_back(static_cast<std::uint8_t>(address >> (8 * i)));
+	}
+	bytes.insert(bytes.end(), data.begin(), data.end());
+
+	std::ostringstream line;
+	unsigned int sum = 0;
+	line << 'S' << type << std::hex << std::uppercase << std::setfill('0');
+	for (auto b : bytes) {
+		line << std::setw(2) << static_cast<unsigned int>(b);
+		sum += b;
+	}
+	line << std::setw(2) << (~sum & 0xff) << "\n";
+	return line.str();
+}
+
+struct elf_segment {
+	std::uint64_t address;
+	std::vector<std::uint8_t> data;
+	std::uint64_t memory_size;
+};
+
+class elf_builder {
+public:
+	elf_builder(bool wide, bool big_endian) : _wide(wide), _big_endian(big_endian) {}
+
+	std::vector<std::uint8_t> build(std::uint64_t entry, const std::vector<elf_segment> &segments) {
+		std::size_t w = _wide ? 8 : 4;
+		std::size_t header_length = _wide ? 64 : 52;
+		std::size_t entry_length = _wide ? 56 : 32;
+
+		_data.assign(header_length + (segments.size() + 1) * entry_length, 0);
+		std::uint8_t ident[] = {0x7f, 'E', 'L', 'F', static_cast<std::uint8_t>(_wide ? 2 : 1),
+		                        static_cast<std::uint8_t>(_big_endian ? 2 : 1), 1};
+		std::copy(std::begin(ident), std::end(ident), _data.begin());
+		put(24, entry, w);
+		put(24 + w, header_length, w);
+		put(30 + 3 * w, entry_length, 2);
+		put(32 + 3 * w, segments.size() + 1, 2);
+
+		/* A non-loadable entry first. */
+		std::size_t p = header_length;
+		put(p, 4, 4);
+		p += entry_length;
+
+		/* Data is stored in reverse order to check the offset sort. */
+		std::size_t offset = _data.size();
+		for (auto s = segments.rbegin(); s != segments.rend(); ++s) {
+			offset += s->data.size();
+		}
+		for (const auto &s : segments) {
+			offset -= s.data.size();
+			std::size_t q = p + (_wide ? 8 : 4);
+			put(p, 1, 4);
+			put(q, offset, w);
+			put(q + w, s.address | 0x80000000, w);
+			put(q + 2 * w, s.address, w);
+			put(q + 3 * w, s.data.size(), w);
+			put(q + 4 * w, s.memory_size, w);
+			p += entry_length;
+
+			if (_data.size() < offset + s.data.size()) {
+				_data.resize(offset + s.data.size());
+			}
+			std::copy(s.data.begin(), s.data.end(), _data.begin() + offset);
+		}
+		return _data;
+	}
+
+private:
+	void put(std::size_t position, std::uint64_t value, std::size_t length) {
+		for (std::size_t i = 0; i < length; i++) {
+			std::size_t b = _big_endian ? length - 1 - i : i;
+			_data[position + b] = static_cast<std::uint8_t>(value >> (8 * i));
+		}
+	}
+
+	bool _wide;
+	bool _big_endian;
+	std::vector<std::uint8_t> _data{};
+};
+
+class image_file : public ::testing::Test {
+protected:
+	std::string _file_name{};
+	harpoon::memory::chunked_random_access_memory_ptr _memory{};
+
+	virtual void SetUp() {
+		_file_name = ::testing::TempDir() + "harpoon_image_file";
+		_memory = harpoon::memory::make_chunked_random_access_memory(
+		    "rom", address_range(0x00000, 0x3ffff), 0x1000);
+		_memory->prepare();
+	}
+
+	virtual void TearDown() {
+		_memory->cleanup();
+		std::remove(_file_name.c_str());
+	}
+
+	void write(const std::string &contents) {
+		std::ofstream output(_file_name, std::ios::binary);
+		output << contents;
+	}
+
+	void write(const std::vector<std::uint8_t> &contents) {
+		write(std::string(contents.begin(), contents.end()));
+	}
+
+	std::uint8_t get(harpoon::memory::address address) {
+		std::uint8_t value;
+		_memory->get(address, value);
+		return value;
+	}
+};
+
+std::vector<std::uint8_t> sequence(std::size_t length, std::uint8_t first) {
+	std::vector<std::uint8_t> data(length);
+	for (std::size_t i = 0; i < length; i++) {
+		data[i] = static_cast<std::uint8_t>(first + i);
+	}
+	return data;
+}
+
+} // namespace
+
+TEST_F(image_file, hex) {
+	write(hex_record(0x00, 0x0100, sequence(16, 0x00))
+	      + hex_record(0x00, 0x0110, sequence(16, 0x10))
+	      + hex_record(0x04, 0x0000, {0x00, 0x02}) + hex_record(0x00, 0xfff0, sequence(4, 0xa0))
+	      + hex_record(0x02, 0x0000, {0x1f, 0xff}) + hex_record(0x00, 0x000e, {0x55, 0x66})
+	      + hex_record(0x05, 0x0000, {0x00, 0x00, 0x01, 0x00}) + hex_record(0x01, 0x0000, {}));
+
+	harpoon::memory::deserializer::hex_file loader(_file_name);
+	ASSERT_EQ(loader.get_segments().size(), 3u);
+	EXPECT_EQ(loader.get_segments()[0], address_range(0x00100, 0x0011f));
+	EXPECT_EQ(loader.get_segments()[1], address_range(0x1fffe, 0x1ffff));
+	EXPECT_EQ(loader.get_segments()[2], address_range(0x2fff0, 0x2fff3));
+	EXPECT_EQ(loader.get_range(), address_range(0x00100, 0x2fff3));
+	ASSERT_TRUE(loader.has_entry());
+	EXPECT_EQ(loader.get_entry(), 0x100u);
+
+	_memory->set(0x10000, std::uint8_t{0xff});
+	_memory->deserialize(loader);
+	EXPECT_EQ(get(0x000ff), 0x00);
+	EXPECT_EQ(get(0x00100), 0x00);
+	EXPECT_EQ(get(0x0011f), 0x1f);
+	EXPECT_EQ(get(0x10000), 0x00);
+	EXPECT_EQ(get(0x1fffe), 0x55);
+	EXPECT_EQ(get(0x1ffff), 0x66);
+	EXPECT_EQ(get(0x2fff3), 0xa3);
+
+	harpoon::memory::memory::span span;
+	ASSERT_TRUE(_memory->get_span(0x20000, false, span));
+	EXPECT_EQ(span.data, nullptr);
+}
+
+TEST_F(image_file, hex_errors) {
+	std::string record = hex_record(0x00, 0x0000, {0x01, 0x02});
+	std::string end = hex_record(0x01, 0x0000, {});
+
+	write(record);
+	EXPECT_THROW(harpoon::memory::deserializer::hex_file{_file_name}, bad_image_file);
+
+	std::string bad = record;
+	bad[10] = bad[10] == '0' ? '1' : '0';
+	write(bad + end);
+	EXPECT_THROW(harpoon::memory::deserializer::hex_file{_file_name}, bad_image_file);
+
+	write(record + hex_record(0x00, 0x0001, {0x03}) + end);
+	EXPECT_THROW(harpoon::memory::deserializer::hex_file{_file_name}, bad_image_file);
+
+	write("01000000" + end);
+	EXPECT_THROW(harpoon::memory::deserializer::hex_file{_file_name}, bad_image_file);
+
+	EXPECT_THROW(harpoon::memory::deserializer::hex_file{_file_name + ".missing"},
+	             harpoon::memory::deserializer::exception::io);
+}
+
+TEST_F(image_file, srec) {
+	write(srec_record(0, 0x0000, 2, {'f', 'w'}) + srec_record(1, 0x0200, 2, sequence(32, 0x40))
+	      + srec_record(2, 0x010000, 3, sequence(8, 0x80)) + srec_record(3, 0x00010008, 4, {0x99})
+	      + srec_record(5, 0x0003, 2, {}) + srec_record(8, 0x000200, 3, {}));
+
+	harpoon::memory::deserializer::srec_file loader(_file_name);
+	ASSERT_EQ(loader.get_segments().size(), 2u);
+	EXPECT_EQ(loader.get_segments()[0], address_range(0x00200, 0x0021f));
+	EXPECT_EQ(loader.get_segments()[1], address_range(0x10000, 0x10008));
+	EXPECT_EQ(loader.get_entry(), 0x200u);
+
+	_memory->deserialize(loader);
+	EXPECT_EQ(get(0x00200), 0x40);
+	EXPECT_EQ(get(0x0021f), 0x5f);
+	EXPECT_EQ(get(0x10007), 0x87);
+	EXPECT_EQ(get(0x10008), 0x99);
+
+	std::string bad = srec_record(1, 0x0000, 2, {0x01});
+	bad[bad.size() - 2] = bad[bad.size() - 2] == '0' ? '1' : '0';
+	write(bad);
+	EXPECT_THROW(harpoon::memory::deserializer::srec_file{_file_name}, bad_image_file);
+}
+
+TEST_F(image_file, elf) {
+	for (bool wide : {false, true}) {
+		for (bool big_endian : {false, true}) {
+			elf_builder builder(wide, big_endian);
+			write(builder.build(0x1234, {{0x08000, sequence(0x2000, 0x10), 0x2000},
+			                             {0x20000, sequence(0x100, 0x70), 0x1000}}));
+
+			_memory->fill(address_range(0x08000, 0x20fff), 0xee);
+			harpoon::memory::deserializer::elf_file loader(_file_name);
+			EXPECT_EQ(loader.get_entry(), 0x1234u);
+			ASSERT_EQ(loader.get_segments().size(), 2u);
+			EXPECT_EQ(loader.get_segments()[1], address_range(0x20000, 0x20fff));
+
+			_memory->deserialize(loader);
+			EXPECT_EQ(get(0x08000), 0x10);
+			EXPECT_EQ(get(0x09fff), 0x0f);
+			EXPECT_EQ(get(0x0a000), 0x00);
+			EXPECT_EQ(get(0x20000), 0x70);
+			EXPECT_EQ(get(0x200ff), 0x6f);
+			EXPECT_EQ(get(0x20100), 0x00);
+			EXPECT_EQ(get(0x20fff), 0x00);
+
+			harpoon::memory::deserializer::elf_file virtual_loader(_file_name, true);
+			EXPECT_EQ(virtual_loader.get_segments()[0].get_start(), 0x80008000u);
+		}
+	}
+
+	write(std::string("\x7f"
+	                  "ELF\x03\x01",
+	                  6)
+	      + std::string(58, '\0'));
+	EXPECT_THROW(harpoon::memory::deserializer::elf_file{_file_name}, bad_image_file);
+}
+
+TEST_F(image_file, large_linear_load) {
+	auto memory = harpoon::memory::make_linear_random_access_memory(
+	    "ram", address_range(0x000000, 0x0fffff));
+	memory->prepare();
+
+	std::string contents;
+	for (std::uint32_t a = 0; a < 0x100000; a += 0x20) {
+		if ((a & 0xffff) == 0) {
+			contents += hex_record(0x04, 0x0000,
+			                       {static_cast<std::uint8_t>(a >> 24),
+			                        static_cast<std::uint8_t>(a >> 16)});
+		}
+		contents += hex_record(0x00, static_cast<std::uint16_t>(a),
+		                       sequence(0x20, static_cast<std::uint8_t>(a >> 5)));
+	}
+	write(contents + hex_record(0x01, 0x0000, {}));
+
+	harpoon::memory::deserializer::hex_file loader(_file_name);
+	ASSERT_EQ(loader.get_segments().size(), 1u);
+	EXPECT_EQ(loader.get_segments()[0], memory->get_address_range());
+	/* Records are coalesced into blocks. */
+	EXPECT_LE(loader.get_image()->get_extents().size(), 2u);
+
+	memory->deserialize(loader);
+	for (std::uint32_t a = 0; a < 0x100000; a += 0x1234) {
+		std::uint8_t value;
+		memory->get(a, value);
+		EXPECT_EQ(value, static_cast<std::uint8_t>((a >> 5) + (a & 0x1f))) << std::hex << a;
+	}
+	memory->cleanup();
+}
@@ -0,0 +1,160 @@
+#include <gtest/gtest.h>
+#include <harpoon/memory/chunked_random_access_memory.hh>
+#include <harpoon/memory/deserializer/binary_file.hh>
+#include <harpoon/memory/deserializer/container_file.hh>
+#include <harpoon/memory/serializer/container_file.hh>
+
+#include <fstream>
+
+using harpoon::memory::address_range;
+
+namespace {
+
+/* Counts the reads passed on to the source, optionally from one thread only. */
+class counting : public harpoon::memory::deserializer::deserializer {
+public:
+	counting(const harpoon::memory::deserializer::deserializer_ptr &source, bool concurrent)
+	    : deserializer(source->get_range()), _source(source), _concurrent(concurrent) {}
+
+	std::size_t reads{};
+
+	virtual bool has_data(const address_range &range) override {
+		return _source->has_data(range);
+	}
+
+	virtual bool is_concurrent() const override {
+		return _concurrent && _source->is_concurrent();
+	}
+
+protected:
+	virtual std::size_t do_read(const harpoon::memory::memory *memory, std::uint8_t *data,
+	                            const address_range &range) override {
+		reads++;
+		return _source->read(memory, data, range);
+	}
+
+private:
+	harpoon::memory::deserializer::deserializer_ptr _source{};
+	bool _concurrent{};
+};
+
+class lazy_restore : public ::testing::Test {
+protected:
+	std::string _file_name{};
+	harpoon::memory::chunked_random_access_memory_ptr _memory{};
+	harpoon::memory::chunked_random_access_memory_ptr _restored{};
+
+	virtual void SetUp() {
+		_file_name = ::testing::TempDir() + "harpoon_lazy_restore.snp";
+
+		_memory = harpoon::memory::make_chunked_random_access_memory(
+		    "chunked", address_range(0x10000, 0x4ffff), 0x1000);
+		_memory->prepare();
+		for (harpoon::memory::address a = 0x10000; a < 0x18000; a++) {
+			_memory->set(a, static_cast<std::uint8_t>(a ^ (a >> 8)));
+		}
+		_memory->set(0x4ffff, std::uint8_t{0x99});
+
+		harpoon::memory::serializer::container_file serializer(_memory->get_address_range(),
+		                                                       _file_name);
+		_memory->serialize(serializer);
+
+		_restored = harpoon::memory::make_chunked_random_access_memory(
+		    "restored", address_range(0x10000, 0x4ffff), 0x1000);
+		_restored->prepare();
+	}
+
+	virtual void TearDown() {
+		_restored->cleanup();
+		_memory->cleanup();
+		std::remove(_file_name.c_str());
+	}
+};
+
+} // namespace
+
+TEST_F(lazy_restore, loads_on_access) {
+	_restored->set(0x30000, std::uint8_t{0x55});
+	_restored->deserialize_lazily(
+	    std::make_shared<harpoon::memory::deserializer::container_file>(_file_name));
+	EXPECT_EQ(_restored->get_lazy_chunks(), 9u);
+
+	std::uint8_t v;
+	_restored->get(0x30000, v);
+	EXPECT_EQ(v, 0x00);
+	EXPECT_EQ(_restored->get_lazy_chunks(), 9u);
+
+	_restored->get(0x11234, v);
+	EXPECT_EQ(v, static_cast<std::uint8_t>(0x11234 ^ 0x112));
+	EXPECT_EQ(_restored->get_lazy_chunks(), 8u);
+
+	_restored->set(0x12000, std::uint8_t{0xaa});
+	EXPECT_EQ(_restored->get_lazy_chunks(), 7u);
+	_restored->get(0x12001, v);
+	EXPECT_EQ(v, static_cast<std::uint8_t>(0x12001 ^ 0x120));
+	_memory->set(0x12000, std::uint8_t{0xaa});
+
+	harpoon::memory::address difference;
+	EXPECT_TRUE(_memory->compare(_memory->get_address_range(), *_restored, 0x10000, difference));
+	EXPECT_EQ(_restored->get_lazy_chunks(), 0u);
+}
+
+TEST_F(lazy_restore, partial_range) {
+	auto image = ::testing::TempDir() + "harpoon_lazy_restore.bin";
+	{
+		std::ofstream file(image, std::ios::binary);
+		file << std::string(0x1800, '\x42');
+	}
+
+	_restored->deserialize_lazily(
+	    std::make_shared<harpoon::memory::deserializer::container_file>(_file_name));
+	_restored->deserialize_lazily(
+	    std::make_shared<harpoon::memory::deserializer::binary_file>(0x10800, image));
+	EXPECT_EQ(_restored->get_lazy_chunks(), 8u);
+
+	std::uint8_t v;
+	_restored->get(0x107ff, v);
+	EXPECT_EQ(v, static_cast<std::uint8_t>(0x107ff ^ 0x107));
+	_restored->get(0x10800, v);
+	EXPECT_EQ(v, 0x42);
+	_restored->get(0x11fff, v);
+	EXPECT_EQ(v, 0x42);
+	_restored->get(0x12000, v);
+	EXPECT_EQ(v, static_cast<std::uint8_t>(0x12000 ^ 0x120));
+	_restored->get(0x4ffff, v);
+	EXPECT_EQ(v, 0x99);
+
+	std::remove(image.c_str());
+}
+
+TEST_F(lazy_restore, overwritten_chunks_not_loaded) {
+	auto image = ::testing::TempDir() + "harpoon_lazy_restore.bin";
+	{
+		std::ofstream file(image, std::ios::binary);
+		file << std::string(0x1800, '\x42');
+	}
+
+	for (bool concurrent : {false, true}) {
+		auto lazy = std::make_shared<counting>(
+		    std::make_shared<harpoon::memory::deserializer::container_file>(_file_name), false);
+		_restored->deserialize_lazily(lazy);
+		EXPECT_EQ(_restored->get_lazy_chunks(), 9u);
+
+		/* Covers 0x11000-0x11fff and half of the next chunk. */
+		counting source(
+		    std::make_shared<harpoon::memory::deserializer::binary_file>(0x11000, image),
+		    concurrent);
+		_restored->deserialize(source);
+		EXPECT_EQ(lazy->reads, 1u);
+		EXPECT_EQ(_restored->get_lazy_chunks(), 7u);
+
+		std::uint8_t v;
+		_restored->get(0x11000, v);
+		EXPECT_EQ(v, 0x42);
+		_restored->get(0x12800, v);
+		EXPECT_EQ(v, static_cast<std::uint8_t>(0x12800 ^ 0x128));
+		EXPECT_EQ(lazy->reads, 1u);
+	}
+
+	std::remove(image.c_str());
+}
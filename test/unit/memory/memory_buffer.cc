@@ -0,0 +1,105 @@
+#include <gtest/gtest.h>
+#include <harpoon/memory/chunked_random_access_memory.hh>
+#include <harpoon/memory/deserializer/memory_buffer.hh>
+#include <harpoon/memory/linear_random_access_memory.hh>
+#include <harpoon/memory/main_memory.hh>
+#include <harpoon/memory/serializer/memory_buffer.hh>
+
+using harpoon::memory::address_range;
+
+namespace {
+
+class memory_buffer : public ::testing::Test {
+protected:
+	harpoon::util::buffer_pool_ptr _pool{};
+	harpoon::memory::main_memory_ptr _main_memory{};
+	harpoon::memory::chunked_random_access_memory_ptr _chunked{};
+	harpoon::memory::linear_random_access_memory_ptr _linear{};
+
+	virtual void SetUp() {
+		_pool = harpoon::util::make_buffer_pool(0x3000);
+
+		_main_memory = harpoon::memory::make_main_memory("main-memory");
+		_chunked = harpoon::memory::make_chunked_random_access_memory(
+		    "chunked", address_range(0x0000, 0xffff), 0x1000);
+		_linear = harpoon::memory::make_linear_random_access_memory(
+		    "linear", address_range(0x10000, 0x17fff));
+		_main_memory->add_memory(_linear);
+		_main_memory->add_memory(_chunked);
+		_main_memory->prepare();
+		_linear->fill(_linear->get_address_range(), 0x11);
+
+		_main_memory->set(0x1000, std::uint32_t{0xdeadbeef});
+		_main_memory->set(0xfffc, std::uint32_t{0xcafef00d});
+	}
+
+	virtual void TearDown() {
+		_main_memory->cleanup();
+	}
+
+	harpoon::memory::memory_image_ptr save() {
+		harpoon::memory::serializer::memory_buffer serializer(address_range(0, 0x17fff), _pool);
+		_main_memory->serialize(serializer);
+		return serializer.get_image();
+	}
+};
+
+} // namespace
+
+TEST_F(memory_buffer, image) {
+	auto image = save();
+	EXPECT_EQ(image->get_stored(), 0x2000u + 0x8000u);
+
+	const auto &extents = image->get_extents();
+	/* The linear memory is saved first and split across three pooled buffers. */
+	ASSERT_EQ(extents.size(), 16u + 3u);
+	EXPECT_EQ(extents[0].range, address_range(0x0000, 0x0fff));
+	EXPECT_EQ(extents[0].data, nullptr);
+	EXPECT_NE(extents[1].data, nullptr);
+	for (std::size_t i = 1; i < extents.size(); i++) {
+		EXPECT_EQ(extents[i].range.get_start(), extents[i - 1].range.get_end() + 1);
+	}
+}
+
+TEST_F(memory_buffer, restore) {
+	auto image = save();
+
+	_main_memory->set(0x1000, std::uint32_t{0});
+	_main_memory->set(0x5000, std::uint8_t{1});
+	_main_memory->set(0x10000, std::uint8_t{2});
+
+	harpoon::memory::deserializer::memory_buffer deserializer(image);
+	EXPECT_FALSE(deserializer.has_data(address_range(0x2000, 0xefff)));
+	EXPECT_TRUE(deserializer.has_data(address_range(0x2000, 0xf000)));
+	_main_memory->deserialize(deserializer);
+
+	std::uint32_t v;
+	_main_memory->get(0x1000, v);
+	EXPECT_EQ(v, 0xdeadbeef);
+	_main_memory->get(0xfffc, v);
+	EXPECT_EQ(v, 0xcafef00d);
+	_main_memory->get(0x10000, v);
+	EXPECT_EQ(v, 0x11111111u);
+
+	harpoon::memory::memory::span span;
+	ASSERT_TRUE(_chunked->get_span(0x5000, false, span));
+	EXPECT_EQ(span.data, nullptr);
+}
+
+TEST_F(memory_buffer, pooled_buffers) {
+	save();
+	std::size_t free = _pool->get_free();
+	EXPECT_GT(free, 0u);
+
+	{
+		auto image = save();
+		EXPECT_EQ(_pool->get_free(), 0u);
+	}
+	EXPECT_EQ(_pool->get_free(), free);
+}
+
+TEST_F(memory_buffer, pool_budget) {
+	_pool = harpoon::util::make_buffer_pool(0x3000, 0x6000);
+	save();
+	EXPECT_EQ(_pool->get_free(), 2u);
+}
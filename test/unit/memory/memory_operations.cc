@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+#include <harpoon/memory/chunked_random_access_memory.hh>
+#include <harpoon/memory/linear_random_access_memory.hh>
+#include <harpoon/memory/main_memory.hh>
+
+using harpoon::memory::address;
+using harpoon::memory::address_range;
+
+namespace {
+
+class memory_operations : public ::testing::Test {
+protected:
+	harpoon::memory::main_memory_ptr _main_memory;
+	harpoon::memory::chunked_random_access_memory_ptr _chunked;
+	harpoon::memory::linear_random_access_memory_ptr _linear;
+
+	virtual void SetUp() {
+		_main_memory = harpoon::memory::make_main_memory("main-memory");
+		_chunked = harpoon::memory::make_chunked_random_access_memory(
+		    "chunked", address_range(0x0000, 0xffff), 0x1000);
+		_linear = harpoon::memory::make_linear_random_access_memory(
+		    "linear", address_range(0x10000, 0x1ffff));
+		_main_memory->add_memory(_chunked);
+		_main_memory->add_memory(_linear);
+		_main_memory->prepare();
+		_linear->fill(_linear->get_address_range(), 0);
+	}
+
+	virtual void TearDown() {
+		_main_memory->cleanup();
+	}
+};
+
+} // namespace
+
+TEST_F(memory_operations, unallocated_reads_zero) {
+	std::uint32_t v = 0xffffffff;
+	_chunked->get(0x1234, v);
+	EXPECT_EQ(v, 0u);
+
+	harpoon::memory::memory::span span;
+	ASSERT_TRUE(_chunked->get_span(0x1234, false, span));
+	EXPECT_EQ(span.range, address_range(0x1000, 0x1fff));
+	EXPECT_EQ(span.data, nullptr);
+}
+
+TEST_F(memory_operations, fill) {
+	_main_memory->fill(address_range(0x0ff0, 0x2010), 0xaa);
+
+	std::uint8_t v;
+	_main_memory->get(0x0fef, v);
+	EXPECT_EQ(v, 0x00);
+	_main_memory->get(0x0ff0, v);
+	EXPECT_EQ(v, 0xaa);
+	_main_memory->get(0x2010, v);
+	EXPECT_EQ(v, 0xaa);
+	_main_memory->get(0x2011, v);
+	EXPECT_EQ(v, 0x00);
+
+	harpoon::memory::memory::span span;
+	_main_memory->fill(address_range(0x5000, 0x7fff), 0);
+	ASSERT_TRUE(_chunked->get_span(0x6000, false, span));
+	EXPECT_EQ(span.data, nullptr);
+}
+
+TEST_F(memory_operations, find) {
+	const std::uint8_t pattern[] = {0x12, 0x34, 0x56, 0x78};
+	address found;
+
+	EXPECT_FALSE(_main_memory->find(address_range(0, 0x1ffff), pattern, nullptr, 4, found));
+
+	_main_memory->set(0x3ffe, std::uint32_t{0x78563412});
+	ASSERT_TRUE(_main_memory->find(address_range(0, 0x1ffff), pattern, nullptr, 4, found));
+	EXPECT_EQ(found, 0x3ffeu);
+
+	_main_memory->set(0xfffe, std::uint32_t{0x78563412});
+	ASSERT_TRUE(_main_memory->find(address_range(0x3fff, 0x1ffff), pattern, nullptr, 4, found));
+	EXPECT_EQ(found, 0xfffeu);
+
+	_main_memory->set(0x18000, std::uint32_t{0x78563400});
+	const std::uint8_t mask[] = {0x00, 0xff, 0xff, 0xff};
+	ASSERT_TRUE(_main_memory->find(address_range(0x10000, 0x1ffff), pattern, mask, 4, found));
+	EXPECT_EQ(found, 0x18000u);
+
+	const std::uint8_t zeros[] = {0, 0, 0};
+	ASSERT_TRUE(_main_memory->find(address_range(0x4000, 0x1ffff), zeros, nullptr, 3, found));
+	EXPECT_EQ(found, 0x4002u);
+}
+
+TEST_F(memory_operations, compare) {
+	address difference;
+	EXPECT_TRUE(_main_memory->compare(address_range(0x0000, 0xffff), *_main_memory, 0x10000,
+	                                  difference));
+
+	_main_memory->set(0x12345, std::uint8_t{1});
+	EXPECT_FALSE(_main_memory->compare(address_range(0x0000, 0xffff), *_main_memory, 0x10000,
+	                                   difference));
+	EXPECT_EQ(difference, 0x2345u);
+
+	_main_memory->set(0x2345, std::uint8_t{1});
+	EXPECT_TRUE(_main_memory->compare(address_range(0x0000, 0xffff), *_main_memory, 0x10000,
+	                                  difference));
+
+	_main_memory->set(0x0010, std::uint8_t{2});
+	EXPECT_FALSE(_main_memory->compare(address_range(0x0000, 0xffff), *_main_memory, 0x10000,
+	                                   difference));
+	EXPECT_EQ(difference, 0x0010u);
+}
+
+TEST_F(memory_operations, unmapped_gaps) {
+	auto other = harpoon::memory::make_linear_random_access_memory(
+	    "other", address_range(0x30000, 0x30fff));
+	_main_memory->add_memory(other);
+	other->prepare();
+	other->fill(other->get_address_range(), 0);
+
+	/* Nothing is read from 0x20000-0x2ffff, and matches do not span it. */
+	const std::uint8_t pattern[] = {0x12, 0x34, 0x56, 0x78};
+	address found;
+	_main_memory->set(0x1fffe, std::uint16_t{0x3412});
+	_main_memory->set(0x30000, std::uint16_t{0x7856});
+	EXPECT_FALSE(_main_memory->find(address_range(0x0000, 0x3ffff), pattern, nullptr, 4, found));
+	_main_memory->set(0x30010, std::uint32_t{0x78563412});
+	ASSERT_TRUE(_main_memory->find(address_range(0x1000, 0x3ffff), pattern, nullptr, 4, found));
+	EXPECT_EQ(found, 0x30010u);
+
+	/* Only addresses mapped on both sides are compared. */
+	address difference;
+	EXPECT_TRUE(_main_memory->compare(address_range(0x20000, 0x2ffff), *_main_memory, 0x20000,
+	                                  difference));
+	EXPECT_FALSE(_main_memory->compare(address_range(0x10000, 0x30fff), *_main_memory, 0x00000,
+	                                   difference));
+	EXPECT_EQ(difference, 0x1fffeu);
+	_main_memory->fill(address_range(0x0000, 0xffff), 0);
+	_main_memory->fill(address_range(0x10000, 0x1ffff), 0);
+	EXPECT_TRUE(_main_memory->compare(address_range(0x00000, 0x2ffff), *_main_memory, 0x10000,
+	                                  difference));
+	EXPECT_FALSE(_main_memory->compare(address_range(0x00000, 0x2ffff), *_main_memory, 0x20000,
+	                                   difference));
+	EXPECT_EQ(difference, 0x10000u);
+}
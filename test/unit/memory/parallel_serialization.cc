@@ -0,0 +1,165 @@
+#include <gtest/gtest.h>
+#include <harpoon/memory/chunked_random_access_memory.hh>
+#include <harpoon/memory/deserializer/memory_buffer.hh>
+#include <harpoon/memory/deserializer/record_stream.hh>
+#include <harpoon/memory/linear_random_access_memory.hh>
+#include <harpoon/memory/main_memory.hh>
+#include <harpoon/memory/serializer/memory_buffer.hh>
+#include <harpoon/memory/serializer/record_stream.hh>
+
+#include <sstream>
+#include <vector>
+
+using harpoon::memory::address_range;
+
+namespace {
+
+const address_range snapshot_range(0, 0x13ffff);
+
+struct machine {
+	harpoon::memory::main_memory_ptr main_memory;
+	std::vector<harpoon::memory::memory_ptr> regions;
+	harpoon::memory::chunked_random_access_memory_ptr chunked;
+
+	machine(const harpoon::util::thread_pool_ptr &pool) {
+		main_memory = harpoon::memory::make_main_memory("main-memory");
+		chunked = harpoon::memory::make_chunked_random_access_memory(
+		    "chunked", address_range(0x000000, 0x0fffff), 0x1000);
+		regions.push_back(chunked);
+		for (harpoon::memory::address a = 0x100000; a < 0x140000; a += 0x10000) {
+			regions.push_back(harpoon::memory::make_linear_random_access_memory(
+			    "linear", address_range(a, a + 0xffff)));
+		}
+
+		main_memory->set_thread_pool(pool);
+		for (const auto &region : regions) {
+			region->set_thread_pool(pool);
+			main_memory->add_memory(region);
+		}
+		main_memory->prepare();
+		for (std::size_t i = 1; i < regions.size(); i++) {
+			regions[i]->fill(regions[i]->get_address_range(), 0);
+		}
+	}
+
+	~machine() {
+		main_memory->cleanup();
+	}
+
+	void populate() {
+		for (harpoon::memory::address a = 0x10000; a < 0x90000; a += 0x100) {
+			main_memory->set(a, static_cast<std::uint32_t>(a * 7));
+		}
+		/* Allocated but zero: written as sparse. */
+		main_memory->set(0xa0000, std::uint8_t{0x00});
+		for (harpoon::memory::address a = 0x100000; a < 0x130000; a += 4) {
+			main_memory->set(a, static_cast<std::uint32_t>(a ^ 0x5a5a5a5a));
+		}
+		main_memory->set(0x13fffc, std::uint32_t{0xcafef00d});
+	}
+
+	std::string save() {
+		std::ostringstream stream;
+		harpoon::memory::serializer::record_stream serializer(snapshot_range, stream);
+		main_memory->serialize(serializer);
+		serializer.close();
+		return stream.str();
+	}
+};
+
+harpoon::util::thread_pool_ptr make_pool() {
+	return harpoon::util::make_thread_pool(4);
+}
+
+} // namespace
+
+TEST(parallel_serialization, deterministic_layout) {
+	machine sequential(nullptr);
+	sequential.populate();
+
+	machine parallel(make_pool());
+	parallel.populate();
+
+	std::string expected = sequential.save();
+	for (int i = 0; i < 4; i++) {
+		EXPECT_EQ(parallel.save(), expected);
+	}
+}
+
+TEST(parallel_serialization, sparse_chunks) {
+	machine source(make_pool());
+	source.populate();
+
+	harpoon::memory::serializer::memory_buffer serializer(snapshot_range);
+	source.main_memory->serialize(serializer);
+
+	auto image = serializer.get_image();
+	auto e = image->find(0xa0000);
+	ASSERT_NE(e, image->get_extents().end());
+	EXPECT_TRUE(e->range.has_address(0xa0000));
+	EXPECT_EQ(e->data, nullptr);
+	EXPECT_EQ(image->get_stored(), 0x80000u + 0x30000u + 0x10000u);
+}
+
+TEST(parallel_serialization, concurrent_restore) {
+	auto pool = make_pool();
+
+	machine source(pool);
+	source.populate();
+
+	harpoon::memory::serializer::memory_buffer serializer(snapshot_range);
+	source.main_memory->serialize(serializer);
+
+	machine target(pool);
+	target.main_memory->set(0xc0000, std::uint8_t{0xff});
+	target.main_memory->set(0x135000, std::uint8_t{0xff});
+	harpoon::memory::deserializer::memory_buffer deserializer(serializer.get_image());
+	ASSERT_TRUE(deserializer.is_concurrent());
+	target.main_memory->deserialize(deserializer);
+
+	harpoon::memory::address difference;
+	EXPECT_TRUE(source.main_memory->compare(snapshot_range, *target.main_memory, 0, difference))
+	    << std::hex << difference;
+
+	harpoon::memory::memory::span span;
+	ASSERT_TRUE(target.chunked->get_span(0xc0000, false, span));
+	EXPECT_EQ(span.data, nullptr);
+}
+
+TEST(parallel_serialization, sequential_restore) {
+	auto pool = make_pool();
+
+	machine source(pool);
+	source.populate();
+	std::istringstream stream(source.save());
+
+	machine target(pool);
+	harpoon::memory::deserializer::record_stream deserializer(stream);
+	ASSERT_FALSE(deserializer.is_concurrent());
+	target.main_memory->deserialize(deserializer);
+
+	harpoon::memory::address difference;
+	EXPECT_TRUE(source.main_memory->compare(snapshot_range, *target.main_memory, 0, difference))
+	    << std::hex << difference;
+}
+
+TEST(parallel_serialization, thread_pool_opt_in) {
+	auto main_memory = harpoon::memory::make_main_memory("main-memory");
+	auto first = harpoon::memory::make_linear_random_access_memory(
+	    "first", address_range(0x0000, 0x0fff));
+	auto second = harpoon::memory::make_linear_random_access_memory(
+	    "second", address_range(0x1000, 0x1fff));
+	main_memory->add_memory(first);
+	EXPECT_EQ(main_memory->get_thread_pool(), nullptr);
+	EXPECT_EQ(first->get_thread_pool(), nullptr);
+
+	auto pool = make_pool();
+	main_memory->set_thread_pool(pool);
+	main_memory->add_memory(second);
+	EXPECT_EQ(first->get_thread_pool(), pool);
+	EXPECT_EQ(second->get_thread_pool(), pool);
+
+	main_memory->set_thread_pool(nullptr);
+	EXPECT_EQ(first->get_thread_pool(), nullptr);
+	EXPECT_EQ(second->get_thread_pool(), nullptr);
+}
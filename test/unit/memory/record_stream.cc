@@ -0,0 +1,177 @@
+#include <gtest/gtest.h>
+#include <harpoon/memory/chunked_random_access_memory.hh>
+#include <harpoon/memory/deserializer/exception/bad_stream.hh>
+#include <harpoon/memory/deserializer/record_stream.hh>
+#include <harpoon/memory/linear_random_access_memory.hh>
+#include <harpoon/memory/main_memory.hh>
+#include <harpoon/memory/serializer/record_stream.hh>
+
+#include <fstream>
+#include <sstream>
+#include <thread>
+
+#include <sys/stat.h>
+
+using harpoon::memory::address_range;
+
+namespace {
+
+struct machine {
+	harpoon::memory::main_memory_ptr main_memory;
+	harpoon::memory::linear_random_access_memory_ptr linear;
+	harpoon::memory::chunked_random_access_memory_ptr chunked;
+
+	machine() {
+		main_memory = harpoon::memory::make_main_memory("main-memory");
+		linear = harpoon::memory::make_linear_random_access_memory(
+		    "linear", address_range(0x100000, 0x10ffff));
+		chunked = harpoon::memory::make_chunked_random_access_memory(
+		    "chunked", address_range(0x00000, 0xfffff), 0x1000);
+		main_memory->add_memory(linear);
+		main_memory->add_memory(chunked);
+		main_memory->prepare();
+		linear->fill(linear->get_address_range(), 0);
+	}
+
+	~machine() {
+		main_memory->cleanup();
+	}
+};
+
+void populate(machine &m) {
+	for (harpoon::memory::address a = 0x100000; a < 0x108000; a += 4) {
+		m.main_memory->set(a, static_cast<std::uint32_t>(a * 3));
+	}
+	m.main_memory->set(0x00000, std::uint8_t{0x01});
+	m.main_memory->set(0x7ffff, std::uint8_t{0x02});
+	m.main_memory->set(0xfffff, std::uint8_t{0x03});
+}
+
+const address_range snapshot_range(0, 0x10ffff);
+
+} // namespace
+
+TEST(record_stream, round_trip) {
+	machine source;
+	populate(source);
+
+	std::stringstream stream;
+	{
+		harpoon::memory::serializer::record_stream serializer(snapshot_range, stream);
+		source.main_memory->serialize(serializer);
+	}
+	EXPECT_LT(stream.str().size(), 0x8000u + 0x3000u + 0x2000u);
+
+	machine target;
+	target.main_memory->set(0x50000, std::uint8_t{0xff});
+	harpoon::memory::deserializer::record_stream deserializer(stream);
+	EXPECT_EQ(deserializer.get_range(), snapshot_range);
+	target.main_memory->deserialize(deserializer);
+
+	harpoon::memory::address difference;
+	EXPECT_TRUE(
+	    source.main_memory->compare(snapshot_range, *target.main_memory, 0, difference))
+	    << std::hex << difference;
+
+	harpoon::memory::memory::span span;
+	ASSERT_TRUE(target.chunked->get_span(0x50000, false, span));
+	EXPECT_EQ(span.data, nullptr);
+}
+
+TEST(record_stream, pipe) {
+	std::string fifo = ::testing::TempDir() + "harpoon_record_stream.fifo";
+	std::remove(fifo.c_str());
+	ASSERT_EQ(::mkfifo(fifo.c_str(), 0600), 0);
+
+	machine source;
+	populate(source);
+
+	std::thread writer([&source, &fifo] {
+		std::ofstream output(fifo, std::ios::binary);
+		harpoon::memory::serializer::record_stream serializer(snapshot_range, output);
+		source.main_memory->serialize(serializer);
+	});
+
+	machine target;
+	{
+		std::ifstream input(fifo, std::ios::binary);
+		harpoon::memory::deserializer::record_stream deserializer(input, 512);
+		target.main_memory->deserialize(deserializer);
+	}
+	writer.join();
+	std::remove(fifo.c_str());
+
+	harpoon::memory::address difference;
+	EXPECT_TRUE(
+	    source.main_memory->compare(snapshot_range, *target.main_memory, 0, difference))
+	    << std::hex << difference;
+}
+
+TEST(record_stream, partial_restore) {
+	machine source;
+	populate(source);
+
+	std::stringstream stream;
+	{
+		harpoon::memory::serializer::record_stream serializer(snapshot_range, stream);
+		source.main_memory->serialize(serializer);
+	}
+
+	auto memory = harpoon::memory::make_linear_random_access_memory(
+	    "window", address_range(0x103ffe, 0x104001));
+	memory->prepare();
+	harpoon::memory::deserializer::record_stream deserializer(stream);
+	memory->deserialize(deserializer);
+
+	std::uint32_t v;
+	memory->get(0x103ffe, v);
+	EXPECT_EQ(v, static_cast<std::uint32_t>(0x104000 * 3) << 16 | ((0x103ffc * 3) >> 16));
+}
+
+TEST(record_stream, skip_blocks) {
+	machine source;
+	populate(source);
+
+	std::stringstream stream;
+	{
+		harpoon::memory::serializer::record_stream serializer(snapshot_range, stream);
+		source.main_memory->serialize(serializer);
+	}
+
+	/* The linear memory comes first in the stream and is not restored. */
+	auto memory = harpoon::memory::make_chunked_random_access_memory(
+	    "chunked", address_range(0x00000, 0xfffff), 0x1000);
+	memory->prepare();
+	harpoon::memory::deserializer::record_stream deserializer(stream);
+	memory->deserialize(deserializer);
+
+	std::uint8_t v;
+	memory->get(0x00000, v);
+	EXPECT_EQ(v, 0x01);
+	memory->get(0x7ffff, v);
+	EXPECT_EQ(v, 0x02);
+	memory->get(0xfffff, v);
+	EXPECT_EQ(v, 0x03);
+	memory->cleanup();
+}
+
+TEST(record_stream, truncated) {
+	machine source;
+	populate(source);
+
+	std::stringstream stream;
+	{
+		harpoon::memory::serializer::record_stream serializer(snapshot_range, stream);
+		source.main_memory->serialize(serializer);
+	}
+
+	std::stringstream truncated(stream.str().substr(0, 0x4000));
+	machine target;
+	harpoon::memory::deserializer::record_stream deserializer(truncated);
+	EXPECT_THROW(target.main_memory->deserialize(deserializer),
+	             harpoon::memory::deserializer::exception::bad_stream);
+
+	std::stringstream garbage("not a record stream at all, really not");
+	EXPECT_THROW(harpoon::memory::deserializer::record_stream{garbage},
+	             harpoon::memory::deserializer::exception::bad_stream);
+}
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include <harpoon/memory/chunked_random_access_memory.hh>
+#include <harpoon/memory/deserializer/memory_buffer.hh>
+#include <harpoon/memory/exception/shared_memory_error.hh>
+#include <harpoon/memory/frozen_memory.hh>
+#include <harpoon/memory/linear_random_access_memory.hh>
+#include <harpoon/memory/main_memory.hh>
+#include <harpoon/memory/serializer/memory_buffer.hh>
+#include <harpoon/memory/shared_memory_descriptor.hh>
+#include <harpoon/memory/shared_storage.hh>
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <unistd.h>
+#endif
+
+using harpoon::memory::address_range;
+
+namespace {
+
+std::string make_name(const std::string &suffix) {
+#if defined(__unix__) || defined(__APPLE__)
+	return "/harpoon-test-" + std::to_string(getpid()) + "-" + suffix;
+#else
+	return "/harpoon-test-" + suffix;
+#endif
+}
+
+} // namespace
+
+TEST(shared_memory, storage) {
+	std::string name = make_name("storage");
+	if (!harpoon::memory::shared_storage::is_supported()) {
+		EXPECT_THROW(harpoon::memory::shared_storage(name, 0x1000),
+		             harpoon::memory::exception::shared_memory_error);
+		GTEST_SKIP();
+	}
+
+	{
+		harpoon::memory::shared_storage owner(name.substr(1), 0x1000);
+		EXPECT_EQ(owner.get_name(), name);
+		EXPECT_TRUE(owner.is_owner());
+		owner.get_data()[0x123] = 0x45;
+
+		EXPECT_THROW(harpoon::memory::shared_storage(name, 0x1000),
+		             harpoon::memory::exception::shared_memory_error);
+
+		harpoon::memory::shared_storage observer(name);
+		EXPECT_FALSE(observer.is_owner());
+		EXPECT_EQ(observer.get_length(), 0x1000u);
+		EXPECT_EQ(observer.get_data()[0x123], 0x45);
+		EXPECT_EQ(observer.get_data()[0x124], 0);
+	}
+
+	EXPECT_THROW(harpoon::memory::shared_storage{name},
+	             harpoon::memory::exception::shared_memory_error);
+}
+
+TEST(shared_memory, descriptor) {
+	std::string file_name = ::testing::TempDir() + "harpoon_shared_memory.desc";
+	harpoon::memory::shared_memory_descriptor descriptor;
+	descriptor.add({address_range(0x0000, 0x7fff), "/ram", "main ram"});
+	descriptor.add({address_range(0xc000, 0xffff), "/rom", {}});
+	descriptor.write(file_name);
+
+	auto regions = harpoon::memory::shared_memory_descriptor::read(file_name).get_regions();
+	ASSERT_EQ(regions.size(), 2u);
+	EXPECT_EQ(regions[0].range, address_range(0x0000, 0x7fff));
+	EXPECT_EQ(regions[0].object, "/ram");
+	EXPECT_EQ(regions[0].name, "main ram");
+	EXPECT_EQ(regions[1].range, address_range(0xc000, 0xffff));
+	EXPECT_EQ(regions[1].object, "/rom");
+	EXPECT_EQ(regions[1].name, "");
+
+	{
+		std::ofstream output(file_name);
+		output << "# comment\n\nregion 0x0000 zzzz /ram\n";
+	}
+	EXPECT_THROW(harpoon::memory::shared_memory_descriptor::read(file_name),
+	             harpoon::memory::exception::shared_memory_error);
+	std::remove(file_name.c_str());
+}
+
+TEST(shared_memory, export) {
+	if (!harpoon::memory::shared_storage::is_supported()) {
+		GTEST_SKIP();
+	}
+	auto main_memory = harpoon::memory::make_main_memory("main-memory");
+	auto chunked = harpoon::memory::make_chunked_random_access_memory(
+	    "chunked", address_range(0x00000, 0x1ffff), 0x1000);
+	auto linear = harpoon::memory::make_linear_random_access_memory(
+	    "linear", address_range(0x20000, 0x2ffff));
+	auto plain = harpoon::memory::make_linear_random_access_memory(
+	    "plain", address_range(0x30000, 0x30fff));
+	chunked->set_shared_memory_name(make_name("chunked"));
+	linear->set_shared_memory_name(make_name("linear"));
+	main_memory->add_memory(chunked);
+	main_memory->add_memory(linear);
+	main_memory->add_memory(plain);
+	main_memory->prepare();
+
+	std::string file_name = ::testing::TempDir() + "harpoon_shared_memory_export.desc";
+	main_memory->get_shared_memory_descriptor().write(file_name);
+	auto regions = harpoon::memory::shared_memory_descriptor::read(file_name).get_regions();
+	std::remove(file_name.c_str());
+	ASSERT_EQ(regions.size(), 2u);
+
+	std::vector<harpoon::memory::shared_storage_ptr> views;
+	for (const auto &region : regions) {
+		views.push_back(harpoon::memory::make_shared_storage(region.object));
+		EXPECT_EQ(views.back()->get_length(), region.range.get_length());
+	}
+	EXPECT_EQ(regions[0].name, "chunked");
+	EXPECT_EQ(regions[1].name, "linear");
+
+	main_memory->set(0x01234, std::uint8_t{0x12});
+	main_memory->set(0x1ffff, std::uint8_t{0x34});
+	main_memory->set(0x20010, std::uint8_t{0x78});
+	EXPECT_EQ(views[0]->get_data()[0x01234], 0x12);
+	EXPECT_EQ(views[0]->get_data()[0x1ffff], 0x34);
+	EXPECT_EQ(views[1]->get_data()[0x10], 0x78);
+
+	/* Snapshots and restores keep writing through to the shared objects. */
+	auto frozen = chunked->freeze();
+	main_memory->set(0x01234, std::uint8_t{0x9a});
+	EXPECT_EQ(views[0]->get_data()[0x01234], 0x9a);
+
+	harpoon::memory::serializer::memory_buffer serializer(chunked->get_address_range());
+	frozen->serialize(serializer);
+	chunked->deserialize(*std::make_shared<harpoon::memory::deserializer::memory_buffer>(
+	    serializer.get_image()));
+	EXPECT_EQ(views[0]->get_data()[0x01234], 0x12);
+
+	chunked->fill(address_range(0x01000, 0x01fff), 0);
+	EXPECT_EQ(views[0]->get_data()[0x01234], 0);
+
+	main_memory->cleanup();
+	EXPECT_THROW(harpoon::memory::shared_storage{regions[0].object},
+	             harpoon::memory::exception::shared_memory_error);
+
+	/* Existing mappings outlive the exported memory. */
+	EXPECT_EQ(views[1]->get_data()[0x10], 0x78);
+}
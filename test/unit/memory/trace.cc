@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+#include <harpoon/memory/linear_random_access_memory.hh>
+#include <harpoon/memory/trace/exception/bad_trace.hh>
+#include <harpoon/memory/trace/reader.hh>
+#include <harpoon/memory/trace/recorder.hh>
+
+#include <cstdio>
+#include <fstream>
+
+using harpoon::memory::access_kind;
+using harpoon::memory::trace::record;
+
+namespace {
+
+class trace : public ::testing::Test {
+protected:
+	std::string _file_name;
+	harpoon::memory::linear_random_access_memory_ptr _memory;
+
+	virtual void SetUp() {
+		_file_name = ::testing::TempDir() + "harpoon_trace_test.trc";
+		_memory = harpoon::memory::make_linear_random_access_memory(
+		    "ram", harpoon::memory::address_range(0x1000, 0x1fff));
+		_memory->prepare();
+	}
+
+	virtual void TearDown() {
+		_memory->cleanup();
+		std::remove(_file_name.c_str());
+	}
+};
+
+} // namespace
+
+TEST_F(trace, encode_decode) {
+	std::vector<record> records = {{10, 0x1000, 0xff, 0, 1, access_kind::READ},
+	                               {12, 0x0ffe, 0x1234, 1, 2, access_kind::WRITE},
+	                               {12, 0xffffffffffffff00, 0xdeadbeefcafe, 1, 8,
+	                                access_kind::FETCH},
+	                               {3, 0x10, 0x12345678, 7, 4, access_kind::READ}};
+	std::vector<std::uint8_t> encoded;
+	harpoon::memory::trace::encode_block(records.data(), records.size(), encoded);
+
+	std::vector<record> decoded;
+	EXPECT_TRUE(harpoon::memory::trace::decode_block(encoded.data(), encoded.size(),
+	                                                 records.size(), decoded));
+	EXPECT_EQ(decoded, records);
+
+	decoded.clear();
+	EXPECT_FALSE(harpoon::memory::trace::decode_block(encoded.data(), encoded.size() - 1,
+	                                                  records.size(), decoded));
+}
+
+TEST_F(trace, record_accesses) {
+	auto recorder = harpoon::memory::trace::make_recorder(_file_name, 16, 5);
+	_memory->set_access_recorder(recorder);
+
+	recorder->set_unit(3);
+	_memory->set(0x1000, std::uint32_t{0xaabbccdd});
+	std::uint16_t w;
+	_memory->get(0x1002, w);
+	std::uint8_t b;
+	for (int i = 0; i < 100; i++) {
+		_memory->fetch(static_cast<harpoon::memory::address>(0x1100 + i), b);
+	}
+	recorder->close();
+	EXPECT_EQ(recorder->get_recorded(), 102u);
+
+	harpoon::memory::trace::reader reader(_file_name);
+	record r;
+
+	ASSERT_TRUE(reader.next(r));
+	EXPECT_EQ(r, (record{0, 0x1000, 0xaabbccdd, 3, 4, access_kind::WRITE}));
+	ASSERT_TRUE(reader.next(r));
+	EXPECT_EQ(r, (record{0, 0x1002, 0xaabb, 3, 2, access_kind::READ}));
+	for (int i = 0; i < 100; i++) {
+		ASSERT_TRUE(reader.next(r));
+		EXPECT_EQ(r.kind, access_kind::FETCH);
+		EXPECT_EQ(r.address, static_cast<harpoon::memory::address>(0x1100 + i));
+	}
+	EXPECT_FALSE(reader.next(r));
+}
+
+TEST_F(trace, bad_file) {
+	{
+		std::ofstream output(_file_name, std::ios::binary);
+		output << "not a trace file";
+	}
+	EXPECT_THROW(harpoon::memory::trace::reader reader(_file_name),
+	             harpoon::memory::trace::exception::bad_trace);
+}
@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+#include <harpoon/memory/linear_random_access_memory.hh>
+#include <harpoon/memory/main_memory.hh>
+
+#include <vector>
+
+using harpoon::memory::access_kind;
+using harpoon::memory::address_range;
+using harpoon::memory::watchpoint;
+
+namespace {
+
+class watchpoints : public ::testing::Test {
+protected:
+	harpoon::memory::main_memory_ptr _main_memory;
+	std::vector<watchpoint::access> _hits;
+
+	virtual void SetUp() {
+		_main_memory = harpoon::memory::make_main_memory("main-memory");
+		_main_memory->add_memory(harpoon::memory::make_linear_random_access_memory(
+		    "ram1", address_range(0x0000, 0x17ff)));
+		_main_memory->add_memory(harpoon::memory::make_linear_random_access_memory(
+		    "ram2", address_range(0x1800, 0x3fff)));
+		_main_memory->prepare();
+	}
+
+	virtual void TearDown() {
+		_main_memory->cleanup();
+	}
+
+	watchpoint::action record() {
+		return [this](const watchpoint &, const watchpoint::access &access) {
+			_hits.push_back(access);
+		};
+	}
+};
+
+} // namespace
+
+TEST_F(watchpoints, shared_page) {
+	_main_memory->set(0x17ff, std::uint16_t{0xaabb});
+
+	std::uint8_t lo, hi;
+	_main_memory->get(0x17ff, lo);
+	_main_memory->get(0x1800, hi);
+	EXPECT_EQ(lo, 0xbb);
+	EXPECT_EQ(hi, 0xaa);
+}
+
+TEST_F(watchpoints, write) {
+	_main_memory->add_watchpoint(
+	    watchpoint(address_range(0x100, 0x103), watchpoint::Type::WRITE, record()));
+
+	std::uint32_t v;
+	_main_memory->set(0x0ff, std::uint32_t{0x11223344});
+	_main_memory->get(0x100, v);
+	_main_memory->set(0x2000, std::uint32_t{0x11223344});
+
+	ASSERT_EQ(_hits.size(), 3u);
+	EXPECT_EQ(_hits[0].address, 0x100u);
+	EXPECT_EQ(_hits[0].value, 0x33);
+	EXPECT_EQ(_hits[0].kind, access_kind::WRITE);
+	EXPECT_EQ(_hits[0].memory, _main_memory.get());
+	EXPECT_EQ(_hits[2].address, 0x102u);
+}
+
+TEST_F(watchpoints, read_value) {
+	_main_memory->set(0x1800, std::uint16_t{0x0102});
+	_main_memory->add_watchpoint(
+	    watchpoint(address_range(0x1800, 0x1801), watchpoint::Type::READ, 0x02, record()));
+
+	std::uint16_t v;
+	_main_memory->get(0x1800, v);
+	_main_memory->set(0x1800, v);
+
+	ASSERT_EQ(_hits.size(), 1u);
+	EXPECT_EQ(_hits[0].address, 0x1800u);
+	EXPECT_EQ(_hits[0].kind, access_kind::READ);
+}
+
+TEST_F(watchpoints, remove) {
+	auto id = _main_memory->add_watchpoint(
+	    watchpoint(address_range(0x0000, 0x3fff), watchpoint::Type::ACCESS, record()));
+
+	std::uint8_t v;
+	_main_memory->get(0x3000, v);
+	EXPECT_EQ(_hits.size(), 1u);
+
+	_main_memory->remove_watchpoint(id);
+	_main_memory->get(0x3000, v);
+	_main_memory->set(0x3000, v);
+	EXPECT_EQ(_hits.size(), 1u);
+}
+
+TEST_F(watchpoints, fetch) {
+	_main_memory->set(0x0200, std::uint16_t{0x0102});
+	_main_memory->add_watchpoint(
+	    watchpoint(address_range(0x0200, 0x0200), watchpoint::Type::READ, record()));
+	_main_memory->add_watchpoint(
+	    watchpoint(address_range(0x0201, 0x0201), watchpoint::Type::WRITE, record()));
+
+	std::uint16_t v;
+	_main_memory->fetch(0x0200, v);
+	EXPECT_EQ(v, 0x0102);
+	ASSERT_EQ(_hits.size(), 1u);
+	EXPECT_EQ(_hits[0].address, 0x0200u);
+	EXPECT_EQ(_hits[0].kind, access_kind::FETCH);
+}
+
+TEST_F(watchpoints, changed_by_action) {
+	harpoon::memory::main_memory::watchpoint_id once{};
+	once = _main_memory->add_watchpoint(watchpoint(
+	    address_range(0x0300, 0x0300), watchpoint::Type::WRITE,
+	    [this, &once](const watchpoint &, const watchpoint::access &access) {
+		    _hits.push_back(access);
+		    _main_memory->remove_watchpoint(once);
+		    _main_memory->add_watchpoint(
+		        watchpoint(address_range(0x0300, 0x0300), watchpoint::Type::READ, record()));
+	    }));
+	_main_memory->add_watchpoint(
+	    watchpoint(address_range(0x0300, 0x0300), watchpoint::Type::ACCESS, record()));
+
+	std::uint8_t v;
+	_main_memory->set(0x0300, std::uint8_t{1});
+	EXPECT_EQ(_hits.size(), 2u);
+	_main_memory->set(0x0300, std::uint8_t{2});
+	EXPECT_EQ(_hits.size(), 3u);
+	_main_memory->get(0x0300, v);
+	EXPECT_EQ(_hits.size(), 5u);
+}
+
+TEST_F(watchpoints, whole_address_space) {
+	auto all = _main_memory->add_watchpoint(watchpoint(
+	    address_range(0, address_range::max()), watchpoint::Type::WRITE, record()));
+	auto reads = _main_memory->add_watchpoint(
+	    watchpoint(address_range(0x2000, address_range::max()), watchpoint::Type::READ, record()));
+
+	std::uint8_t v;
+	_main_memory->set(0x0010, std::uint8_t{1});
+	_main_memory->get(0x0010, v);
+	_main_memory->get(0x3fff, v);
+	EXPECT_EQ(_hits.size(), 2u);
+
+	_main_memory->remove_watchpoint(all);
+	_main_memory->set(0x0010, std::uint8_t{1});
+	_main_memory->get(0x3fff, v);
+	EXPECT_EQ(_hits.size(), 3u);
+
+	_main_memory->remove_watchpoint(reads);
+	_main_memory->get(0x3fff, v);
+	EXPECT_EQ(_hits.size(), 3u);
+}
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+#include <harpoon/execution/processing_unit.hh>
+#include <harpoon/memory/linear_random_access_memory.hh>
+#include <harpoon/memory/write_journal.hh>
+
+namespace {
+
+class write_journal : public ::testing::Test {
+protected:
+	harpoon::memory::linear_random_access_memory_ptr _memory;
+	harpoon::execution::processing_unit_ptr _processing_unit;
+
+	virtual void SetUp() {
+		_memory = harpoon::memory::make_linear_random_access_memory(
+		    "ram", harpoon::memory::address_range(0x0000, 0x0fff));
+		_memory->prepare();
+		for (harpoon::memory::address a = 0; a < 0x1000; a++) {
+			_memory->set(a, std::uint8_t{0});
+		}
+		_processing_unit = std::make_shared<harpoon::execution::processing_unit>("cpu");
+	}
+
+	virtual void TearDown() {
+		_memory->cleanup();
+	}
+
+	void execute(harpoon::memory::address address, std::uint32_t value) {
+		_processing_unit->set_current_instruction(harpoon::execution::instruction{});
+		_memory->set(address, value);
+	}
+
+	std::uint32_t get(harpoon::memory::address address) {
+		std::uint32_t value;
+		_memory->get(address, value);
+		return value;
+	}
+};
+
+} // namespace
+
+TEST_F(write_journal, undo) {
+	auto journal = harpoon::memory::make_write_journal();
+	journal->set_processing_unit(_processing_unit);
+	_memory->set_write_journal(journal);
+
+	execute(0x10, 0x11111111);
+	execute(0x10, 0x22222222);
+	execute(0x20, 0x33333333);
+	EXPECT_EQ(journal->get_size(), 12u);
+
+	EXPECT_TRUE(journal->undo(*_memory, 1));
+	EXPECT_EQ(get(0x10), 0x22222222u);
+	EXPECT_EQ(get(0x20), 0u);
+
+	EXPECT_TRUE(journal->undo_to(*_memory, 0));
+	EXPECT_EQ(get(0x10), 0u);
+	EXPECT_EQ(journal->get_size(), 0u);
+}
+
+TEST_F(write_journal, bounded) {
+	auto journal = harpoon::memory::make_write_journal(8);
+	journal->set_processing_unit(_processing_unit);
+	_memory->set_write_journal(journal);
+
+	execute(0x10, 0x11111111);
+	execute(0x10, 0x22222222);
+	execute(0x10, 0x33333333);
+	EXPECT_EQ(journal->get_size(), 8u);
+	EXPECT_EQ(journal->get_oldest_instruction(), 1u);
+
+	EXPECT_FALSE(journal->undo(*_memory, 3));
+	EXPECT_EQ(get(0x10), 0x33333333u);
+
+	EXPECT_TRUE(journal->undo(*_memory, 2));
+	EXPECT_EQ(get(0x10), 0x11111111u);
+}
+
+TEST_F(write_journal, processing_unit_released) {
+	auto journal = harpoon::memory::make_write_journal();
+	journal->set_processing_unit(_processing_unit);
+	_memory->set_write_journal(journal);
+
+	execute(0x10, 0x11111111);
+	EXPECT_EQ(journal->get_current_instruction(), 1u);
+
+	_processing_unit.reset();
+	_memory->set(0x10, std::uint32_t{0x22222222});
+	EXPECT_EQ(journal->get_current_instruction(), 0u);
+	EXPECT_EQ(journal->get_size(), 8u);
+}
@@ -0,0 +1,217 @@
+#include <gtest/gtest.h>
+#include <harpoon/clock/clock.hh>
+#include <harpoon/computer_system.hh>
+#include <harpoon/execution/basic_register.hh>
+#include <harpoon/execution/processing_unit.hh>
+#include <harpoon/execution/up_execution_unit.hh>
+#include <harpoon/memory/chunked_random_access_memory.hh>
+#include <harpoon/memory/linear_random_access_memory.hh>
+#include <harpoon/memory/main_memory.hh>
+#include <harpoon/state/reader.hh>
+#include <harpoon/state/writer.hh>
+
+#include <algorithm>
+
+using harpoon::memory::address_range;
+
+namespace {
+
+/* Every 10 ticks: bump pc, store it at pc * 0x100 and in the linear memory. */
+class cpu : public harpoon::execution::processing_unit {
+public:
+	using harpoon::execution::processing_unit::processing_unit;
+
+	harpoon::execution::basic_register<std::uint32_t> pc{};
+	harpoon::memory::main_memory *main_memory{};
+	harpoon::clock::clock *clock{};
+	harpoon::clock::clock::event_id event{};
+
+	virtual void step(harpoon::hardware_component *) override {
+		pc++;
+		main_memory->set(pc * 0x100, static_cast<std::uint32_t>(pc));
+		main_memory->set(0x20000 + (pc % 0x100), static_cast<std::uint8_t>(pc));
+		clock->schedule(10, 0, event);
+	}
+
+protected:
+	virtual void save_state(harpoon::state::writer &writer) const override {
+		processing_unit::save_state(writer);
+		pc.save(writer);
+	}
+
+	virtual void restore_state(harpoon::state::reader &reader) override {
+		processing_unit::restore_state(reader);
+		pc.restore(reader);
+	}
+};
+
+struct machine {
+	harpoon::computer_system_ptr system;
+	harpoon::clock::clock_ptr clock;
+	std::shared_ptr<cpu> processing_unit;
+	harpoon::memory::main_memory_ptr main_memory;
+
+	machine() {
+		system = harpoon::make_computer_system("system");
+		clock = harpoon::clock::make_clock(10000000, "clock");
+		processing_unit = std::make_shared<cpu>("cpu");
+
+		auto execution_unit = harpoon::execution::make_up_execution_unit("execution-unit");
+		execution_unit->set_clock(clock);
+		execution_unit->set_processing_unit(processing_unit);
+		system->set_main_execution_unit(execution_unit);
+
+		main_memory = harpoon::memory::make_main_memory("main-memory");
+		main_memory->add_memory(harpoon::memory::make_chunked_random_access_memory(
+		    "ram", address_range(0x0000, 0xffff), 0x1000));
+		main_memory->add_memory(harpoon::memory::make_linear_random_access_memory(
+		    "vram", address_range(0x20000, 0x200ff)));
+		system->set_main_memory(main_memory);
+
+		system->prepare();
+		main_memory->fill(address_range(0x20000, 0x200ff), 0);
+
+		processing_unit->main_memory = main_memory.get();
+		processing_unit->clock = clock.get();
+		auto p = processing_unit.get();
+		processing_unit->event
+		    = clock->register_event([p](harpoon::clock::clock *) { p->step(nullptr); });
+	}
+
+	~machine() {
+		system->cleanup();
+	}
+
+	void run(int steps) {
+		for (int i = 0; i < steps; i++) {
+			system->step(nullptr);
+		}
+	}
+
+	std::uint32_t get(harpoon::memory::address address) {
+		std::uint32_t value;
+		main_memory->get(address, value);
+		return value;
+	}
+};
+
+} // namespace
+
+TEST(rewind, dirty_chunks) {
+	machine m;
+	m.main_memory->clear_dirty();
+	m.main_memory->set(0x1234, std::uint8_t{1});
+	m.main_memory->set(0x5000, std::uint8_t{1});
+	m.main_memory->set(0x5fff, std::uint8_t{1});
+
+	std::vector<address_range> dirty;
+	m.main_memory->get_dirty(dirty);
+	ASSERT_EQ(dirty.size(), 3u);
+	EXPECT_EQ(dirty[0], address_range(0x1000, 0x1fff));
+	EXPECT_EQ(dirty[1], address_range(0x5000, 0x5fff));
+	/* The linear memory does not track writes. */
+	EXPECT_EQ(dirty[2], address_range(0x20000, 0x200ff));
+}
+
+TEST(rewind, rewind_and_replay) {
+	machine m;
+	m.system->enable_rewind(20, 1 << 20);
+	m.run(30);
+
+	const auto &buffer = m.system->get_rewind_buffer();
+	ASSERT_EQ(buffer->get_entries(), 15u);
+	EXPECT_EQ(buffer->get_oldest_tick(), 10u);
+	EXPECT_EQ(buffer->get_newest_tick(), 290u);
+	EXPECT_EQ(m.processing_unit->pc.get(), 30u);
+
+	/* Lands on the newest point at or before the tick. */
+	ASSERT_TRUE(m.system->rewind(125));
+	EXPECT_EQ(m.clock->get_cycle().tick, 110u);
+	EXPECT_EQ(buffer->get_entries(), 6u);
+	EXPECT_EQ(m.processing_unit->pc.get(), 11u);
+	EXPECT_EQ(m.get(11 * 0x100), 11u);
+	EXPECT_EQ(m.get(12 * 0x100), 0u);
+	EXPECT_EQ(m.get(29 * 0x100), 0u);
+	EXPECT_EQ(m.get(0x20000 + 11) & 0xff, 11u);
+	EXPECT_EQ(m.get(0x20000 + 12) & 0xff, 0u);
+
+	/* Execution continues from the restored point. */
+	m.run(5);
+	EXPECT_EQ(m.processing_unit->pc.get(), 16u);
+	EXPECT_EQ(m.get(16 * 0x100), 16u);
+	EXPECT_EQ(m.get(17 * 0x100), 0u);
+
+	EXPECT_FALSE(m.system->rewind(5));
+}
+
+TEST(rewind, budget) {
+	machine m;
+	m.system->enable_rewind(10, 2048);
+	m.run(200);
+
+	const auto &buffer = m.system->get_rewind_buffer();
+	EXPECT_LE(buffer->get_used(), buffer->get_budget());
+	EXPECT_GT(buffer->get_entries(), 2u);
+	EXPECT_LT(buffer->get_entries(), 200u);
+	EXPECT_GT(buffer->get_oldest_tick(), 10u);
+
+	auto oldest = buffer->get_oldest_tick();
+	ASSERT_TRUE(m.system->rewind(oldest));
+	EXPECT_EQ(m.processing_unit->pc.get(), oldest / 10);
+	EXPECT_EQ(m.get(static_cast<std::uint32_t>(oldest / 10) * 0x100), oldest / 10);
+	EXPECT_EQ(m.get(static_cast<std::uint32_t>(oldest / 10 + 1) * 0x100), 0u);
+}
+
+TEST(rewind, reenable) {
+	machine m;
+	m.system->enable_rewind(20, 1 << 20);
+	m.main_memory->set(0x8000, std::uint32_t{0x12345678});
+	m.run(10);
+	m.system->disable_rewind();
+
+	/* 0x8000 is clean when the new buffer takes its first point, and written after. */
+	m.system->enable_rewind(20, 1 << 20);
+	m.run(10);
+	const auto &buffer = m.system->get_rewind_buffer();
+	auto first = buffer->get_oldest_tick();
+	m.main_memory->set(0x8004, std::uint32_t{1});
+	m.run(10);
+
+	ASSERT_TRUE(m.system->rewind(first));
+	auto pc = m.processing_unit->pc.get();
+	EXPECT_EQ(pc, first / 10);
+	EXPECT_EQ(m.get(0x8000), 0x12345678u);
+	EXPECT_EQ(m.get(0x8004), 0u);
+	for (std::uint32_t i = 1; i <= pc; i++) {
+		EXPECT_EQ(m.get(i * 0x100), i);
+	}
+	EXPECT_EQ(m.get((pc + 1) * 0x100), 0u);
+}
+
+TEST(rewind, quiet_restore) {
+	machine m;
+	m.system->enable_rewind(20, 1 << 20);
+	m.run(10);
+	auto first = m.system->get_rewind_buffer()->get_oldest_tick();
+	m.run(10);
+
+	/* Whoever else tracks dirty ranges keeps seeing the writes. */
+	m.main_memory->clear_dirty();
+	m.main_memory->set(0xf000, std::uint8_t{1});
+	m.run(10);
+	std::vector<address_range> dirty;
+	m.main_memory->get_dirty(dirty);
+	EXPECT_TRUE(std::any_of(dirty.begin(), dirty.end(),
+	                        [](const address_range &r) { return r.has_address(0xf000); }));
+
+	int hits = 0;
+	m.main_memory->add_watchpoint(harpoon::memory::watchpoint(
+	    address_range(0x0000, 0xffff), harpoon::memory::watchpoint::Type::ACCESS,
+	    [&hits](const harpoon::memory::watchpoint &,
+	            const harpoon::memory::watchpoint::access &) { hits++; }));
+
+	ASSERT_TRUE(m.system->rewind(first));
+	EXPECT_EQ(hits, 0);
+	EXPECT_EQ(m.get(0xf000), 0u);
+	EXPECT_EQ(hits, 4);
+}
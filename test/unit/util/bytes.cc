@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+#include <harpoon/util/bytes.hh>
+
+#include <random>
+#include <vector>
+
+using namespace harpoon::util;
+
+TEST(bytes, find_first_nonzero) {
+	std::vector<std::uint8_t> data(1000, 0);
+	EXPECT_EQ(bytes::find_first_nonzero(data.data(), data.size()), data.size());
+	EXPECT_TRUE(bytes::is_zero(data.data(), data.size()));
+
+	for (std::size_t i : {0, 1, 15, 16, 31, 32, 63, 64, 100, 999}) {
+		data[i] = 1;
+		EXPECT_EQ(bytes::find_first_nonzero(data.data(), data.size()), i);
+		EXPECT_EQ(bytes::find_first_nonzero(data.data() + 1, i), i ? i - 1 : 0u);
+		data[i] = 0;
+	}
+}
+
+TEST(bytes, find_first_difference) {
+	std::vector<std::uint8_t> a(777, 5), b(777, 5);
+	EXPECT_EQ(bytes::find_first_difference(a.data(), b.data(), a.size()), a.size());
+
+	for (std::size_t i : {0, 7, 8, 16, 33, 500, 776}) {
+		b[i] = 6;
+		EXPECT_EQ(bytes::find_first_difference(a.data(), b.data(), a.size()), i);
+		b[i] = 5;
+	}
+}
+
+TEST(bytes, find_pattern) {
+	std::mt19937 generator(7);
+	std::vector<std::uint8_t> data(5000);
+	for (auto &b : data) {
+		b = static_cast<std::uint8_t>(generator() % 3);
+	}
+
+	const std::uint8_t pattern[] = {0xde, 0xad, 0xbe, 0xef};
+	EXPECT_EQ(bytes::find_pattern(data.data(), data.size(), pattern, nullptr, 4), data.size());
+
+	std::copy(pattern, pattern + 4, data.begin() + 4093);
+	EXPECT_EQ(bytes::find_pattern(data.data(), data.size(), pattern, nullptr, 4), 4093u);
+	EXPECT_EQ(bytes::find_pattern(data.data(), 4096, pattern, nullptr, 4), 4096u);
+
+	const std::uint8_t masked[] = {0x00, 0x0d, 0xb0, 0x00};
+	const std::uint8_t mask[] = {0x00, 0x0f, 0xf0, 0x00};
+	EXPECT_EQ(bytes::find_pattern(data.data(), data.size(), masked, mask, 4), 4093u);
+
+	const std::uint8_t any[] = {0x00, 0x00};
+	EXPECT_EQ(bytes::find_pattern(data.data() + 10, 100, any, any, 2), 0u);
+
+	/* Leading zeros are matched too, though the search anchors on a later byte. */
+	std::vector<std::uint8_t> zeros(300);
+	const std::uint8_t padded[] = {0x00, 0x00, 0xff, 0x42, 0x00};
+	EXPECT_EQ(bytes::find_pattern(zeros.data(), zeros.size(), padded, nullptr, 5), zeros.size());
+	zeros[3] = 0xff;
+	zeros[4] = 0x42;
+	EXPECT_EQ(bytes::find_pattern(zeros.data(), zeros.size(), padded, nullptr, 5), 1u);
+	zeros[2] = 0xff;
+	zeros[3] = 0x42;
+	zeros[4] = 0x00;
+	EXPECT_EQ(bytes::find_pattern(zeros.data(), zeros.size(), padded, nullptr, 5), 0u);
+	zeros[0] = 1;
+	zeros[257] = 0xff;
+	zeros[258] = 0x42;
+	EXPECT_EQ(bytes::find_pattern(zeros.data(), zeros.size(), padded, nullptr, 5), 255u);
+}
@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+#include <harpoon/util/file.hh>
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using harpoon::util::file;
+
+namespace {
+
+class file_test : public ::testing::Test {
+protected:
+	std::string _file_name{};
+
+	virtual void SetUp() {
+		_file_name = ::testing::TempDir() + "harpoon_util_file.bin";
+	}
+
+	virtual void TearDown() {
+		std::remove(_file_name.c_str());
+	}
+};
+
+} // namespace
+
+TEST_F(file_test, write_and_read) {
+	std::vector<std::uint8_t> data(300000);
+	for (std::size_t i = 0; i < data.size(); i++) {
+		data[i] = static_cast<std::uint8_t>(i * 7);
+	}
+
+	/* More pieces than one gathering write takes. */
+	std::vector<file::piece> pieces;
+	for (std::size_t i = 0; i < 150; i++) {
+		pieces.push_back({data.data() + i * 2000, 2000});
+	}
+
+	file output;
+	ASSERT_TRUE(output.open(_file_name, file::Mode::WRITE));
+	ASSERT_TRUE(output.write_at(pieces.data(), pieces.size(), 100));
+	ASSERT_TRUE(output.write_at("ab", 2, 0));
+	ASSERT_TRUE(output.extend(400000));
+	ASSERT_TRUE(output.zero(1100, 1000));
+	output.close();
+	EXPECT_FALSE(output.is_open());
+
+	file input;
+	ASSERT_TRUE(input.open(_file_name, file::Mode::READ));
+	std::uint64_t length;
+	ASSERT_TRUE(input.get_length(length));
+	EXPECT_EQ(length, 400000u);
+
+	std::vector<std::uint8_t> read(data.size());
+	std::size_t done;
+	ASSERT_TRUE(input.read_at(read.data(), read.size(), 100, done));
+	EXPECT_EQ(done, read.size());
+	for (std::size_t i = 0; i < read.size(); i++) {
+		std::uint8_t expected = i >= 1000 && i < 2000 ? 0 : data[i];
+		ASSERT_EQ(read[i], expected) << i;
+	}
+	ASSERT_TRUE(input.read_at(read.data(), 100, 399950, done));
+	EXPECT_EQ(done, 50u);
+	EXPECT_EQ(read[0], 0);
+
+	ASSERT_TRUE(input.read(read.data(), 2, done));
+	EXPECT_EQ(done, 2u);
+	EXPECT_EQ(read[0], 'a');
+	EXPECT_EQ(read[1], 'b');
+
+	std::uint64_t start = 0, end;
+	ASSERT_TRUE(input.find_data(start, end, length));
+	EXPECT_EQ(start, 0u);
+	EXPECT_GT(end, 0u);
+}
+
+TEST_F(file_test, missing) {
+	file input;
+	EXPECT_FALSE(input.open(_file_name, file::Mode::READ));
+	EXPECT_FALSE(input.is_open());
+}
@@ -0,0 +1,29 @@
+#include <gtest/gtest.h>
+#include <harpoon/util/hash.hh>
+
+#include <vector>
+
+using namespace harpoon::util;
+
+TEST(hash, reference_values) {
+	EXPECT_EQ(hash::hash64("", 0), 0xef46db3751d8e999ULL);
+	EXPECT_EQ(hash::hash64("abc", 3), 0x44bc2cf5ad770999ULL);
+}
+
+TEST(hash, sensitivity) {
+	std::vector<std::uint8_t> data(1000);
+	for (std::size_t i = 0; i < data.size(); i++) {
+		data[i] = static_cast<std::uint8_t>(i * 7);
+	}
+
+	std::uint64_t h = hash::hash64(data.data(), data.size());
+	EXPECT_EQ(h, hash::hash64(data.data(), data.size()));
+	EXPECT_NE(h, hash::hash64(data.data(), data.size(), 1));
+	EXPECT_NE(h, hash::hash64(data.data(), data.size() - 1));
+
+	for (std::size_t i : {0, 31, 32, 500, 999}) {
+		data[i] ^= 1;
+		EXPECT_NE(h, hash::hash64(data.data(), data.size()));
+		data[i] ^= 1;
+	}
+}
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+#include <harpoon/util/lz.hh>
+
+#include <random>
+
+namespace {
+
+std::vector<std::uint8_t> round_trip(const std::vector<std::uint8_t> &data) {
+	std::vector<std::uint8_t> compressed;
+	harpoon::util::lz::compress(data.data(), data.size(), compressed);
+	EXPECT_LE(compressed.size(), harpoon::util::lz::compress_bound(data.size()));
+
+	std::vector<std::uint8_t> output(data.size());
+	EXPECT_TRUE(harpoon::util::lz::decompress(compressed.data(), compressed.size(), output.data(),
+	                                          output.size()));
+	return output;
+}
+
+} // namespace
+
+TEST(lz, empty) {
+	std::vector<std::uint8_t> data;
+	EXPECT_EQ(round_trip(data), data);
+}
+
+TEST(lz, short_input) {
+	std::vector<std::uint8_t> data = {1, 2, 3, 4, 5};
+	EXPECT_EQ(round_trip(data), data);
+}
+
+TEST(lz, zeros) {
+	std::vector<std::uint8_t> data(100000, 0);
+	std::vector<std::uint8_t> compressed;
+	harpoon::util::lz::compress(data.data(), data.size(), compressed);
+
+	EXPECT_LT(compressed.size(), data.size() / 100);
+	EXPECT_EQ(round_trip(data), data);
+}
+
+TEST(lz, random) {
+	std::mt19937 generator(1);
+	std::vector<std::uint8_t> data(70000);
+	for (auto &b : data) {
+		b = static_cast<std::uint8_t>(generator() % 4);
+	}
+	EXPECT_EQ(round_trip(data), data);
+
+	for (auto &b : data) {
+		b = static_cast<std::uint8_t>(generator());
+	}
+	EXPECT_EQ(round_trip(data), data);
+}
+
+TEST(lz, corrupted) {
+	std::vector<std::uint8_t> data(1000, 7);
+	std::vector<std::uint8_t> compressed;
+	harpoon::util::lz::compress(data.data(), data.size(), compressed);
+
+	std::vector<std::uint8_t> output(data.size());
+	EXPECT_FALSE(harpoon::util::lz::decompress(compressed.data(), compressed.size() - 1,
+	                                           output.data(), output.size()));
+	EXPECT_FALSE(harpoon::util::lz::decompress(compressed.data(), compressed.size(), output.data(),
+	                                           output.size() - 1));
+}
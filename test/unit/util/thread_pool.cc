@@ -0,0 +1,45 @@
+#include <gtest/gtest.h>
+#include <harpoon/util/thread_pool.hh>
+
+#include <atomic>
+#include <stdexcept>
+#include <vector>
+
+using namespace harpoon::util;
+
+TEST(thread_pool, runs_every_index) {
+	thread_pool pool(4);
+	EXPECT_EQ(pool.get_threads(), 4u);
+
+	for (std::size_t count : {0, 1, 3, 1000}) {
+		std::vector<std::atomic<int>> hits(count);
+		pool.run(count, [&hits](std::size_t i) { hits[i]++; });
+		for (auto &h : hits) {
+			EXPECT_EQ(h.load(), 1);
+		}
+	}
+}
+
+TEST(thread_pool, nested_run) {
+	thread_pool pool(3);
+	std::atomic<int> total{0};
+	pool.run(8, [&pool, &total](std::size_t) {
+		pool.run(8, [&total](std::size_t) { total++; });
+	});
+	EXPECT_EQ(total.load(), 64);
+}
+
+TEST(thread_pool, exception) {
+	thread_pool pool(2);
+	EXPECT_THROW(pool.run(100,
+	                      [](std::size_t i) {
+		                      if (i == 42) {
+			                      throw std::runtime_error("failed");
+		                      }
+	                      }),
+	             std::runtime_error);
+
+	std::atomic<int> total{0};
+	pool.run(10, [&total](std::size_t) { total++; });
+	EXPECT_EQ(total.load(), 10);
+}
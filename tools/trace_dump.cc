@@ -0,0 +1,30 @@
+#include "harpoon/memory/trace/reader.hh"
+
+#include <iomanip>
+#include <iostream>
+
+int main(int argc, char *argv[]) {
+	if (argc != 2) {
+		std::cerr << "Usage: " << argv[0] << " <trace file>" << std::endl;
+		return 1;
+	}
+
+	try {
+		harpoon::memory::trace::reader reader(argv[1]);
+		harpoon::memory::trace::record record;
+
+		std::cout << "tick,unit,kind,address,width,value\n";
+		while (reader.next(record)) {
+			std::cout << std::dec << record.tick << "," << record.unit << "," << record.kind
+			          << ",0x" << std::hex << std::uppercase << std::setfill('0')
+			          << std::setw(sizeof(record.address) * 2) << record.address << ","
+			          << std::dec << static_cast<unsigned int>(record.width) << ",0x"
+			          << std::hex << std::setw(record.width * 2) << record.value << "\n";
+		}
+	} catch (std::exception &error) {
+		std::cerr << error.what() << std::endl;
+		return 1;
+	}
+
+	return 0;
+}